@@ -154,6 +154,26 @@ avs_coap_streaming_setup_response(avs_coap_streaming_request_ctx_t *ctx,
  * message is handled internally without calling @p handle_request . Otherwise,
  * incoming message is passed to @p handle_request .
  *
+ * Unless a request is too large to be buffered (see below), this function
+ * never waits for further packets of a BLOCK-wise transfer. Request payload
+ * chunks are buffered and acknowledged as they arrive, and
+ * @p handle_request is called only once the whole request has been received,
+ * i.e. during the call that receives its last chunk. Similarly, the whole
+ * response payload is buffered and subsequent BLOCK2 chunks are sent as they
+ * are requested, during subsequent calls to this function. Multiple such
+ * transfers may be in progress at the same time.
+ *
+ * The memory used this way is bounded by the limits set with
+ * @ref avs_coap_streaming_set_request_limits . When the chunk that crosses the
+ * payload limit of a request arrives, @p handle_request is called right away
+ * with the data received so far, and further chunks are received and
+ * acknowledged as it reads them from the stream. This function then blocks
+ * until the whole request is handled, and any other request that arrives in
+ * the meantime is rejected with 5.03 Service Unavailable. A response whose
+ * payload would exceed the limit results in 5.00 Internal Server Error. A new
+ * request received while the maximum number of requests is already being
+ * handled is rejected with 5.03 Service Unavailable.
+ *
  * @param ctx            CoAP context associated with the socket to receive
  *                       the message from.
  *
@@ -173,6 +193,33 @@ avs_error_t avs_coap_streaming_handle_incoming_packet(
         avs_coap_streaming_request_handler_t *handle_request,
         void *handler_arg);
 
+/**
+ * Sets limits on resources used by
+ * @ref avs_coap_streaming_handle_incoming_packet for buffering incoming
+ * requests and their responses. The defaults are set at compile time with
+ * COAP_STREAMING_MAX_PAYLOAD_SIZE and COAP_STREAMING_MAX_PENDING_REQUESTS.
+ *
+ * New limits do not affect payload that has already been buffered.
+ *
+ * @param ctx                  CoAP context to set the limits for.
+ *
+ * @param max_payload_size     Maximum size of request payload, and separately
+ *                             of response payload, buffered for a single
+ *                             request. 0 means the compile-time default.
+ *
+ * @param max_pending_requests Maximum number of requests handled at the same
+ *                             time, including ones waiting for further
+ *                             BLOCK1 chunks and ones whose response is still
+ *                             being sent in BLOCK2 chunks. 0 means the
+ *                             compile-time default.
+ *
+ * @returns @ref AVS_OK for success, or an error condition for which the
+ *          operation failed.
+ */
+avs_error_t avs_coap_streaming_set_request_limits(avs_coap_ctx_t *ctx,
+                                                  size_t max_payload_size,
+                                                  size_t max_pending_requests);
+
 #    ifdef WITH_AVS_COAP_OBSERVE
 
 /**
@@ -95,10 +95,14 @@ avs_coap_udp_exchange_lifetime(const avs_coap_udp_tx_params_t *tx_params);
 /**
  * Creates a response cache object.
  *
- * @param capacity Number of bytes the cache should be able to hold.
+ * @param capacity Number of bytes the cache should be able to hold. This
+ *                 covers the cached messages and their per-entry headers.
+ *                 To find cached responses in constant time, the cache also
+ *                 allocates an index of message IDs. The index takes at most
+ *                 0.6 * @p capacity + 16 additional bytes.
  *
- * @return Created response cache object, or NULL if there is not enough memory
- *         or @p capacity is 0.
+ * @return Created response cache object, or NULL if there is not enough memory,
+ *         or @p capacity is 0 or larger than 2^32-1.
  *
  * NOTE: NULL @ref avs_coap_udp_response_cache_t object is equivalent to a
  * correct, always-empty cache object.
@@ -154,6 +158,16 @@ void avs_coap_udp_response_cache_release(
  *                      objects, but MUST outlive all CoAP context objects it
  *                      is passed to.
  *
+ * @param notify_cache_size Number of recently sent Observe notifications
+ *                      remembered by the context, so that Reset responses to
+ *                      them can be recognized as observation cancellations.
+ *                      It should be large enough to cover all notifications
+ *                      sent during the time a Reset response may arrive.
+ *
+ *                      If 0, the compile-time default
+ *                      (COAP_UDP_NOTIFY_CACHE_SIZE) is used. Ignored if
+ *                      observations support is disabled.
+ *
  * @returns Created CoAP/UDP context on success, NULL on error.
  *
  * NOTE: @p in_buffer and @p out_buffer may be reused across different CoAP
@@ -164,7 +178,8 @@ avs_coap_udp_ctx_create(avs_sched_t *sched,
                         const avs_coap_udp_tx_params_t *udp_tx_params,
                         avs_shared_buffer_t *in_buffer,
                         avs_shared_buffer_t *out_buffer,
-                        avs_coap_udp_response_cache_t *cache);
+                        avs_coap_udp_response_cache_t *cache,
+                        size_t notify_cache_size);
 
 #endif // WITH_AVS_COAP_UDP
 
@@ -61,9 +61,8 @@ static inline state_with_error_t failure_state(avs_error_t error) {
 static avs_error_t
 client_exchange_send_next_chunk(avs_coap_ctx_t *ctx,
                                 avs_coap_exchange_t *exchange) {
-    AVS_ASSERT(AVS_LIST_FIND_PTR(&_avs_coap_get_base(ctx)->client_exchanges,
-                                 exchange)
-                       != NULL,
+    AVS_ASSERT(_avs_coap_find_client_exchange_by_id(ctx, exchange->id)
+                       == exchange,
                "not a started client exchange");
 
     // every request needs to have an unique token
@@ -94,13 +93,18 @@ static avs_error_t client_exchange_send_all(avs_coap_ctx_t *ctx,
 
 static avs_error_t
 client_exchange_start(avs_coap_ctx_t *ctx,
-                      AVS_LIST(avs_coap_exchange_t) *exchange_ptr,
+                      AVS_RBTREE_ELEM(avs_coap_exchange_t) *exchange_ptr,
                       avs_coap_exchange_id_t *out_id) {
     assert(exchange_ptr);
     assert(*exchange_ptr);
 
-    AVS_LIST_INSERT(&_avs_coap_get_base(ctx)->client_exchanges, *exchange_ptr);
+    // ID needs to be set before insertion, as it is the key
     (*exchange_ptr)->id = _avs_coap_generate_exchange_id(ctx);
+    AVS_RBTREE_ELEM(avs_coap_exchange_t) inserted =
+            AVS_RBTREE_INSERT(_avs_coap_get_base(ctx)->client_exchanges,
+                              *exchange_ptr);
+    assert(inserted == *exchange_ptr);
+    (void) inserted;
 
     avs_error_t err;
     if ((*exchange_ptr)->by_type.client.handle_response) {
@@ -216,14 +220,14 @@ static void cleanup_exchange(avs_coap_ctx_t *ctx,
                              state_with_error_t request_state) {
     assert(ctx);
     assert(exchange);
-    AVS_ASSERT(!AVS_LIST_FIND_PTR(&_avs_coap_get_base(ctx)->client_exchanges,
-                                  exchange),
+    AVS_ASSERT(_avs_coap_find_client_exchange_by_id(ctx, exchange->id)
+                       != exchange,
                "exchange must be detached");
     AVS_ASSERT(request_state.state != AVS_COAP_CLIENT_REQUEST_PARTIAL_CONTENT,
                "cleanup_exchange must not be used for intermediate responses");
 
     call_exchange_response_handler(ctx, exchange, final_msg, request_state);
-    AVS_LIST_DELETE(&exchange);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&exchange);
 }
 
 #ifdef WITH_AVS_COAP_BLOCK
@@ -673,16 +677,16 @@ on_request_delivery_finished(avs_coap_ctx_t *ctx,
     assert(!response || avs_coap_code_is_response(response->code));
 
     avs_coap_exchange_id_t exchange_id = ((avs_coap_exchange_t *) exchange)->id;
-    AVS_LIST(avs_coap_exchange_t) *exchange_ptr =
-            _avs_coap_find_client_exchange_ptr_by_id(ctx, exchange_id);
-    if (!exchange_ptr) {
+    AVS_RBTREE_ELEM(avs_coap_exchange_t) found =
+            _avs_coap_find_client_exchange_by_id(ctx, exchange_id);
+    if (!found) {
         assert(result == AVS_COAP_SEND_RESULT_CANCEL);
         return AVS_COAP_RESPONSE_ACCEPTED;
     }
-    assert(*exchange_ptr == exchange);
+    assert(found == exchange);
 
     if (response) {
-        (*exchange_ptr)->by_type.client.next_response_payload_offset +=
+        found->by_type.client.next_response_payload_offset +=
                 response->payload_size;
     }
 
@@ -693,11 +697,11 @@ on_request_delivery_finished(avs_coap_ctx_t *ctx,
         break;
 
     case AVS_COAP_SEND_RESULT_OK:
-        request_state = handle_response(*exchange_ptr, response);
+        request_state = handle_response(found, response);
         break;
 
     case AVS_COAP_SEND_RESULT_FAIL:
-        request_state = handle_failure(ctx, *exchange_ptr, response, fail_err);
+        request_state = handle_failure(ctx, found, response, fail_err);
         if (request_state.state == AVS_COAP_CLIENT_REQUEST_OK) {
             // we recovered from failure
             return AVS_COAP_RESPONSE_ACCEPTED;
@@ -709,8 +713,8 @@ on_request_delivery_finished(avs_coap_ctx_t *ctx,
         break;
     }
 
-    exchange_ptr = _avs_coap_find_client_exchange_ptr_by_id(ctx, exchange_id);
-    if (!exchange_ptr) {
+    found = _avs_coap_find_client_exchange_by_id(ctx, exchange_id);
+    if (!found) {
         return AVS_COAP_RESPONSE_ACCEPTED;
     }
 
@@ -720,24 +724,21 @@ on_request_delivery_finished(avs_coap_ctx_t *ctx,
         // do not report PARTIAL_CONTENT unless there is some actual content
         // this avoids calling the handler for empty 2.31 Continue responses
         if (response->payload && response->payload_size > 0) {
-            call_exchange_response_handler(ctx, *exchange_ptr, response,
+            call_exchange_response_handler(ctx, found, response,
                                            request_state);
             // the call might have canceled the exchange
-            exchange_ptr =
-                    _avs_coap_find_client_exchange_ptr_by_id(ctx, exchange_id);
+            found = _avs_coap_find_client_exchange_by_id(ctx, exchange_id);
         }
 
-        if (exchange_ptr && result == AVS_COAP_SEND_RESULT_OK) {
+        if (found && result == AVS_COAP_SEND_RESULT_OK) {
             // We're finished with a single response packet, but not with the
             // whole exchange. Request more data from the server.
-            avs_error_t err =
-                    client_exchange_send_next_chunk(ctx, *exchange_ptr);
+            avs_error_t err = client_exchange_send_next_chunk(ctx, found);
             if (avs_is_err(err)) {
                 request_state = failure_state(err);
             }
             // the call might have canceled the exchange
-            exchange_ptr =
-                    _avs_coap_find_client_exchange_ptr_by_id(ctx, exchange_id);
+            found = _avs_coap_find_client_exchange_by_id(ctx, exchange_id);
         }
     }
 
@@ -748,16 +749,19 @@ on_request_delivery_finished(avs_coap_ctx_t *ctx,
         response = NULL;
     }
 
-    if (exchange_ptr
+    if (found
             && request_state.state != AVS_COAP_CLIENT_REQUEST_PARTIAL_CONTENT) {
-        cleanup_exchange(ctx, AVS_LIST_DETACH(exchange_ptr), response,
-                         request_state);
+        cleanup_exchange(ctx,
+                         AVS_RBTREE_DETACH(
+                                 _avs_coap_get_base(ctx)->client_exchanges,
+                                 found),
+                         response, request_state);
     }
 
     return AVS_COAP_RESPONSE_ACCEPTED;
 }
 
-static AVS_LIST(avs_coap_exchange_t) client_exchange_create(
+static AVS_RBTREE_ELEM(avs_coap_exchange_t) client_exchange_create(
         uint8_t code,
         const avs_coap_options_t *options,
         avs_coap_payload_writer_t *payload_writer,
@@ -770,8 +774,8 @@ static AVS_LIST(avs_coap_exchange_t) client_exchange_create(
     // to be large
     size_t options_capacity = options->capacity + AVS_COAP_OPT_BLOCK_MAX_SIZE;
 
-    AVS_LIST(avs_coap_exchange_t) exchange =
-            (AVS_LIST(avs_coap_exchange_t)) AVS_LIST_NEW_BUFFER(
+    AVS_RBTREE_ELEM(avs_coap_exchange_t) exchange =
+            (AVS_RBTREE_ELEM(avs_coap_exchange_t)) AVS_RBTREE_ELEM_NEW_BUFFER(
                     sizeof(avs_coap_exchange_t) + options_capacity);
     if (!exchange) {
         return NULL;
@@ -862,7 +866,7 @@ avs_error_t avs_coap_client_send_async_request(
         return avs_errno(AVS_EINVAL);
     }
 
-    AVS_LIST(avs_coap_exchange_t) exchange =
+    AVS_RBTREE_ELEM(avs_coap_exchange_t) exchange =
             client_exchange_create(req->code, &req->options, request_writer,
                                    request_writer_arg, response_handler,
                                    response_handler_arg);
@@ -876,13 +880,15 @@ avs_error_t avs_coap_client_send_async_request(
 
     if (avs_is_err(err)) {
         if (avs_coap_exchange_id_valid(exchange_id)) {
-            AVS_LIST(avs_coap_exchange_t) *exchange_ptr =
-                    _avs_coap_find_client_exchange_ptr_by_id(ctx, exchange_id);
-            if (exchange_ptr) {
+            AVS_RBTREE_ELEM(avs_coap_exchange_t) found =
+                    _avs_coap_find_client_exchange_by_id(ctx, exchange_id);
+            if (found) {
                 // Not using _avs_coap_client_exchange_cleanup() or
                 // cleanup_exchange(), because this function's docs say that
                 // response_handler is not called on error.
-                AVS_LIST_DELETE(exchange_ptr);
+                AVS_RBTREE_DETACH(_avs_coap_get_base(ctx)->client_exchanges,
+                                  found);
+                AVS_RBTREE_ELEM_DELETE_DETACHED(&found);
             }
         }
         return err;
@@ -896,8 +902,8 @@ avs_error_t avs_coap_client_send_async_request(
 
 void _avs_coap_client_exchange_cleanup(avs_coap_ctx_t *ctx,
                                        avs_coap_exchange_t *exchange) {
-    AVS_ASSERT(!AVS_LIST_FIND_PTR(&_avs_coap_get_base(ctx)->client_exchanges,
-                                  exchange),
+    AVS_ASSERT(_avs_coap_find_client_exchange_by_id(ctx, exchange->id)
+                       != exchange,
                "exchange must be detached");
     assert(avs_coap_code_is_request(exchange->code));
 
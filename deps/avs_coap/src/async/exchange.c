@@ -40,8 +40,8 @@ static inline bool is_pointer_part_of_enqueued_exchange(avs_coap_ctx_t *ctx,
                                                         const void *buffer) {
     const uint8_t *u8_buf = (const uint8_t *) buffer;
 
-    AVS_LIST(avs_coap_exchange_t) it;
-    AVS_LIST_FOREACH(it, _avs_coap_get_base(ctx)->client_exchanges) {
+    AVS_RBTREE_ELEM(avs_coap_exchange_t) it;
+    AVS_RBTREE_FOREACH(it, _avs_coap_get_base(ctx)->client_exchanges) {
         avs_coap_exchange_t *exchange = (avs_coap_exchange_t *) it;
         const uint8_t *exchange_begin = (const uint8_t *) exchange;
         const uint8_t *exchange_end = (exchange_begin + sizeof(*exchange)
@@ -277,8 +277,7 @@ avs_error_t _avs_coap_exchange_get_next_outgoing_chunk_payload_size(
                "message when no exchange object is available, use "
                "_avs_coap_get_next_outgoing_chunk_payload_size instead");
 
-    AVS_LIST(avs_coap_exchange_t) exchange =
-            _avs_coap_find_exchange_by_id(ctx, id);
+    avs_coap_exchange_t *exchange = _avs_coap_find_exchange_by_id(ctx, id);
     if (!exchange) {
         return avs_errno(AVS_EINVAL);
     }
@@ -19,6 +19,8 @@
 #define MODULE_NAME coap
 #include <x_log_config.h>
 
+#include <string.h>
+
 #include <avsystem/commons/utils.h>
 
 #include <avsystem/coap/code.h>
@@ -32,6 +34,74 @@
 
 VISIBILITY_SOURCE_BEGIN
 
+static int client_exchange_cmp(const void *left_, const void *right_) {
+    const avs_coap_exchange_t *left = (const avs_coap_exchange_t *) left_;
+    const avs_coap_exchange_t *right = (const avs_coap_exchange_t *) right_;
+    if (left->id.value < right->id.value) {
+        return -1;
+    }
+    return left->id.value > right->id.value;
+}
+
+#ifdef WITH_AVS_COAP_OBSERVE
+static int observe_cmp(const void *left_, const void *right_) {
+    const avs_coap_token_t *left =
+            &((const avs_coap_observe_t *) left_)->id.token;
+    const avs_coap_token_t *right =
+            &((const avs_coap_observe_t *) right_)->id.token;
+    if (left->size != right->size) {
+        return left->size < right->size ? -1 : 1;
+    }
+    return memcmp(left->bytes, right->bytes, left->size);
+}
+#endif // WITH_AVS_COAP_OBSERVE
+
+avs_error_t _avs_coap_base_init(avs_coap_base_t *base,
+                                avs_coap_ctx_t *coap_ctx,
+                                avs_shared_buffer_t *in_buffer,
+                                avs_shared_buffer_t *out_buffer,
+                                avs_sched_t *sched) {
+    avs_time_real_t now = avs_time_real_now();
+
+    base->last_exchange_id = AVS_COAP_EXCHANGE_ID_INVALID;
+    if (!(base->client_exchanges =
+                  AVS_RBTREE_NEW(avs_coap_exchange_t, client_exchange_cmp))) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    base->server_exchanges = NULL;
+#ifdef WITH_AVS_COAP_OBSERVE
+    if (!(base->observes = AVS_RBTREE_NEW(avs_coap_observe_t, observe_cmp))) {
+        LOG(ERROR, _("out of memory"));
+        AVS_RBTREE_DELETE(&base->client_exchanges);
+        return avs_errno(AVS_ENOMEM);
+    }
+#endif // WITH_AVS_COAP_OBSERVE
+    base->rand_seed = (avs_rand_seed_t) (now.since_real_epoch.seconds
+                                         ^ now.since_real_epoch.nanoseconds);
+    base->socket = NULL;
+    base->in_buffer = in_buffer;
+    base->out_buffer = out_buffer;
+    base->sched = sched;
+#ifdef WITH_AVS_COAP_STREAMING_API
+    _avs_coap_stream_init(&base->coap_stream, coap_ctx);
+    base->streaming_max_payload_size = COAP_STREAMING_MAX_PAYLOAD_SIZE;
+    base->streaming_max_pending_requests = COAP_STREAMING_MAX_PENDING_REQUESTS;
+#else  // WITH_AVS_COAP_STREAMING_API
+    (void) coap_ctx;
+#endif // WITH_AVS_COAP_STREAMING_API
+    return AVS_OK;
+}
+
+void _avs_coap_base_cleanup(avs_coap_base_t *base) {
+    assert(!AVS_RBTREE_SIZE(base->client_exchanges));
+    AVS_RBTREE_DELETE(&base->client_exchanges);
+#ifdef WITH_AVS_COAP_OBSERVE
+    assert(!AVS_RBTREE_SIZE(base->observes));
+    AVS_RBTREE_DELETE(&base->observes);
+#endif // WITH_AVS_COAP_OBSERVE
+}
+
 avs_error_t _avs_coap_in_buffer_acquire(avs_coap_ctx_t *ctx,
                                         uint8_t **out_in_buffer,
                                         size_t *out_in_buffer_size) {
@@ -57,15 +127,19 @@ void avs_coap_ctx_cleanup(avs_coap_ctx_t **ctx) {
 
         avs_coap_base_t *coap_base = _avs_coap_get_base(*ctx);
 
-        while (coap_base->client_exchanges) {
-            avs_coap_exchange_cancel(*ctx, coap_base->client_exchanges->id);
+        // cancel the most recently started exchanges first
+        AVS_RBTREE_ELEM(avs_coap_exchange_t) client_exchange;
+        while ((client_exchange =
+                        AVS_RBTREE_LAST(coap_base->client_exchanges))) {
+            avs_coap_exchange_cancel(*ctx, client_exchange->id);
         }
         while (coap_base->server_exchanges) {
             avs_coap_exchange_cancel(*ctx, coap_base->server_exchanges->id);
         }
 #ifdef WITH_AVS_COAP_OBSERVE
-        while (coap_base->observes) {
-            _avs_coap_observe_cancel(*ctx, &coap_base->observes->id);
+        AVS_RBTREE_ELEM(avs_coap_observe_t) observe;
+        while ((observe = AVS_RBTREE_FIRST(coap_base->observes))) {
+            _avs_coap_observe_cancel(*ctx, &observe->id);
         }
 #endif // WITH_AVS_COAP_OBSERVE
 #ifdef WITH_AVS_COAP_STREAMING_API
@@ -73,6 +147,7 @@ void avs_coap_ctx_cleanup(avs_coap_ctx_t **ctx) {
 #endif // WITH_AVS_COAP_STREAMING_API
 
         avs_sched_del(&coap_base->retry_or_request_expired_job);
+        _avs_coap_base_cleanup(coap_base);
 
         (*ctx)->vtable->cleanup(*ctx);
         *ctx = NULL;
@@ -120,20 +195,40 @@ _avs_coap_find_exchange_ptr_by_id(AVS_LIST(avs_coap_exchange_t) *list_ptr,
     return NULL;
 }
 
+AVS_RBTREE_ELEM(avs_coap_exchange_t)
+_avs_coap_find_client_exchange_by_id(avs_coap_ctx_t *ctx,
+                                     avs_coap_exchange_id_t id) {
+    avs_coap_exchange_t query;
+    query.id = id;
+    return AVS_RBTREE_FIND(_avs_coap_get_base(ctx)->client_exchanges, &query);
+}
+
+#ifdef WITH_AVS_COAP_OBSERVE
+AVS_RBTREE_ELEM(avs_coap_observe_t)
+_avs_coap_find_observe_by_token(avs_coap_ctx_t *ctx,
+                                const avs_coap_token_t *token) {
+    avs_coap_observe_t query;
+    query.id.token = *token;
+    return AVS_RBTREE_FIND(_avs_coap_get_base(ctx)->observes, &query);
+}
+#endif // WITH_AVS_COAP_OBSERVE
+
 void avs_coap_exchange_cancel(avs_coap_ctx_t *ctx, avs_coap_exchange_id_t id) {
     if (!avs_coap_exchange_id_valid(id)) {
         return;
     }
 
-    AVS_LIST(avs_coap_exchange_t) *exchange_ptr;
-
-    exchange_ptr = _avs_coap_find_client_exchange_ptr_by_id(ctx, id);
-    if (exchange_ptr) {
-        _avs_coap_client_exchange_cleanup(ctx, AVS_LIST_DETACH(exchange_ptr));
+    AVS_RBTREE_ELEM(avs_coap_exchange_t) client_exchange =
+            _avs_coap_find_client_exchange_by_id(ctx, id);
+    if (client_exchange) {
+        AVS_RBTREE_DETACH(_avs_coap_get_base(ctx)->client_exchanges,
+                          client_exchange);
+        _avs_coap_client_exchange_cleanup(ctx, client_exchange);
         return;
     }
 
-    exchange_ptr = _avs_coap_find_server_exchange_ptr_by_id(ctx, id);
+    AVS_LIST(avs_coap_exchange_t) *exchange_ptr =
+            _avs_coap_find_server_exchange_ptr_by_id(ctx, id);
     if (exchange_ptr) {
         _avs_coap_server_exchange_cleanup(
                 ctx, AVS_LIST_DETACH(exchange_ptr),
@@ -19,6 +19,7 @@
 
 #include <avsystem/commons/errno.h>
 #include <avsystem/commons/list.h>
+#include <avsystem/commons/rbtree.h>
 #include <avsystem/commons/shared_buffer.h>
 
 #include <avsystem/coap/async.h>
@@ -63,19 +64,23 @@ struct avs_coap_base {
 
     /**
      * All unfinished asynchronous request exchanges initiated by us acting
-     * as a CoAP client (outgoing requests/incoming responses).
+     * as a CoAP client (outgoing requests/incoming responses), ordered by
+     * exchange ID - which, as IDs are generated sequentially, is also the order
+     * in which the exchanges were started.
      */
-    AVS_LIST(struct avs_coap_exchange) client_exchanges;
+    AVS_RBTREE(struct avs_coap_exchange) client_exchanges;
 
     /**
      * All unfinished asynchronous request exchanges initiated by remote CoAP
-     * client (incoming requests/outgoing responses).
+     * client (incoming requests/outgoing responses), sorted by exchange
+     * deadline. There is normally at most a handful of these, as they only
+     * exist during BLOCK-wise transfers, so a list is sufficient.
      */
     AVS_LIST(struct avs_coap_exchange) server_exchanges;
 
 #ifdef WITH_AVS_COAP_OBSERVE
-    /** Active observations. */
-    AVS_LIST(avs_coap_observe_t) observes;
+    /** Active observations, ordered by token. */
+    AVS_RBTREE(avs_coap_observe_t) observes;
 #endif // WITH_AVS_COAP_OBSERVE
 
     /** PRNG seed. */
@@ -84,6 +89,13 @@ struct avs_coap_base {
 #ifdef WITH_AVS_COAP_STREAMING_API
     /** Stream object used by streaming API. */
     coap_stream_t coap_stream;
+
+    /**
+     * Limits on incoming requests handled by the streaming API, see
+     * @ref avs_coap_streaming_set_request_limits .
+     */
+    size_t streaming_max_payload_size;
+    size_t streaming_max_pending_requests;
 #endif // WITH_AVS_COAP_STREAMING_API
 
     avs_net_socket_t *socket;
@@ -134,26 +146,23 @@ static inline void _avs_coap_in_buffer_release(avs_coap_ctx_t *ctx) {
  * @{
  */
 
-static inline void _avs_coap_base_init(avs_coap_base_t *base,
-                                       avs_coap_ctx_t *coap_ctx,
-                                       avs_shared_buffer_t *in_buffer,
-                                       avs_shared_buffer_t *out_buffer,
-                                       avs_sched_t *sched) {
-    avs_time_real_t now = avs_time_real_now();
-
-    base->last_exchange_id = AVS_COAP_EXCHANGE_ID_INVALID;
-    base->client_exchanges = NULL;
-    base->server_exchanges = NULL;
-    base->rand_seed = (avs_rand_seed_t) (now.since_real_epoch.seconds
-                                         ^ now.since_real_epoch.nanoseconds);
-    base->socket = NULL;
-    base->in_buffer = in_buffer;
-    base->out_buffer = out_buffer;
-    base->sched = sched;
-#ifdef WITH_AVS_COAP_STREAMING_API
-    _avs_coap_stream_init(&base->coap_stream, coap_ctx);
-#endif // WITH_AVS_COAP_STREAMING_API
-}
+/**
+ * Initializes the transport-independent part of the CoAP context.
+ *
+ * @returns AVS_OK for success, or an error condition for which the operation
+ *          failed - in which case @p base does not need to be cleaned up.
+ */
+avs_error_t _avs_coap_base_init(avs_coap_base_t *base,
+                                avs_coap_ctx_t *coap_ctx,
+                                avs_shared_buffer_t *in_buffer,
+                                avs_shared_buffer_t *out_buffer,
+                                avs_sched_t *sched);
+
+/**
+ * Releases resources allocated by @ref _avs_coap_base_init . All exchanges and
+ * observations are expected to be canceled beforehand.
+ */
+void _avs_coap_base_cleanup(avs_coap_base_t *base);
 
 static inline avs_coap_ctx_t *
 _avs_coap_ctx_from_request_ctx(avs_coap_request_ctx_t *request_ctx) {
@@ -183,16 +192,9 @@ AVS_LIST(struct avs_coap_exchange) *
 _avs_coap_find_exchange_ptr_by_id(AVS_LIST(struct avs_coap_exchange) *list_ptr,
                                   avs_coap_exchange_id_t id);
 
-AVS_LIST(struct avs_coap_exchange) *_avs_coap_find_exchange_ptr_by_token(
-        AVS_LIST(struct avs_coap_exchange) *list_ptr,
-        const avs_coap_token_t *token);
-
-static inline AVS_LIST(struct avs_coap_exchange) *
-_avs_coap_find_client_exchange_ptr_by_id(avs_coap_ctx_t *ctx,
-                                         avs_coap_exchange_id_t id) {
-    return _avs_coap_find_exchange_ptr_by_id(
-            &_avs_coap_get_base(ctx)->client_exchanges, id);
-}
+AVS_RBTREE_ELEM(struct avs_coap_exchange)
+_avs_coap_find_client_exchange_by_id(avs_coap_ctx_t *ctx,
+                                     avs_coap_exchange_id_t id);
 
 static inline AVS_LIST(struct avs_coap_exchange) *
 _avs_coap_find_server_exchange_ptr_by_id(avs_coap_ctx_t *ctx,
@@ -201,17 +203,6 @@ _avs_coap_find_server_exchange_ptr_by_id(avs_coap_ctx_t *ctx,
             &_avs_coap_get_base(ctx)->server_exchanges, id);
 }
 
-static inline AVS_LIST(struct avs_coap_exchange)
-_avs_coap_find_client_exchange_by_id(avs_coap_ctx_t *ctx,
-                                     avs_coap_exchange_id_t id) {
-    AVS_LIST(struct avs_coap_exchange) *ptr =
-            _avs_coap_find_client_exchange_ptr_by_id(ctx, id);
-    if (ptr) {
-        return *ptr;
-    }
-    return NULL;
-}
-
 static inline AVS_LIST(struct avs_coap_exchange)
 _avs_coap_find_server_exchange_by_id(avs_coap_ctx_t *ctx,
                                      avs_coap_exchange_id_t id) {
@@ -224,21 +215,19 @@ _avs_coap_find_server_exchange_by_id(avs_coap_ctx_t *ctx,
 }
 
 #ifdef WITH_AVS_COAP_OBSERVE
+AVS_RBTREE_ELEM(avs_coap_observe_t)
+_avs_coap_find_observe_by_token(avs_coap_ctx_t *ctx,
+                                const avs_coap_token_t *token);
+
 static inline bool _avs_coap_is_observe(avs_coap_ctx_t *ctx,
                                         const avs_coap_token_t *token) {
-    AVS_LIST(avs_coap_observe_t) it;
-    AVS_LIST_FOREACH(it, _avs_coap_get_base(ctx)->observes) {
-        if (avs_coap_token_equal(&it->id.token, token)) {
-            return true;
-        }
-    }
-    return false;
+    return _avs_coap_find_observe_by_token(ctx, token) != NULL;
 }
 #endif // WITH_AVS_COAP_OBSERVE
 
-static inline AVS_LIST(struct avs_coap_exchange)
+static inline struct avs_coap_exchange *
 _avs_coap_find_exchange_by_id(avs_coap_ctx_t *ctx, avs_coap_exchange_id_t id) {
-    AVS_LIST(struct avs_coap_exchange) exchange =
+    struct avs_coap_exchange *exchange =
             _avs_coap_find_client_exchange_by_id(ctx, id);
     if (!exchange) {
         exchange = _avs_coap_find_server_exchange_by_id(ctx, id);
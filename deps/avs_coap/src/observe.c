@@ -30,7 +30,7 @@
 
 VISIBILITY_SOURCE_BEGIN
 
-static AVS_LIST(avs_coap_observe_t)
+static AVS_RBTREE_ELEM(avs_coap_observe_t)
 create_observe(avs_coap_observe_id_t id,
                const avs_coap_request_header_t *req,
                avs_coap_observe_cancel_handler_t *cancel_handler,
@@ -38,8 +38,8 @@ create_observe(avs_coap_observe_id_t id,
     const size_t options_capacity =
             _avs_coap_options_request_key_size(&req->options);
 
-    AVS_LIST(avs_coap_observe_t) observe =
-            (AVS_LIST(avs_coap_observe_t)) AVS_LIST_NEW_BUFFER(
+    AVS_RBTREE_ELEM(avs_coap_observe_t) observe =
+            (AVS_RBTREE_ELEM(avs_coap_observe_t)) AVS_RBTREE_ELEM_NEW_BUFFER(
                     sizeof(avs_coap_observe_t) + options_capacity);
     if (!observe) {
         LOG(ERROR, _("out of memory"));
@@ -63,16 +63,9 @@ create_observe(avs_coap_observe_id_t id,
     return observe;
 }
 
-static AVS_LIST(avs_coap_observe_t) *
-find_observe_ptr_by_id(avs_coap_ctx_t *ctx, const avs_coap_observe_id_t *id) {
-    AVS_LIST(avs_coap_observe_t) *observe_ptr;
-    AVS_LIST_FOREACH_PTR(observe_ptr, &_avs_coap_get_base(ctx)->observes) {
-        if (avs_coap_token_equal(&(*observe_ptr)->id.token, &id->token)) {
-            return observe_ptr;
-        }
-    }
-
-    return NULL;
+static avs_coap_observe_t *find_observe_by_id(avs_coap_ctx_t *ctx,
+                                              const avs_coap_observe_id_t *id) {
+    return _avs_coap_find_observe_by_token(ctx, &id->token);
 }
 
 avs_error_t
@@ -87,7 +80,7 @@ avs_coap_observe_start(avs_coap_ctx_t *ctx,
         return avs_errno(AVS_EINVAL);
     }
 
-    AVS_LIST(avs_coap_observe_t) observe =
+    AVS_RBTREE_ELEM(avs_coap_observe_t) observe =
             create_observe(id, req, cancel_handler, handler_arg);
     if (!observe) {
         return avs_errno(AVS_ENOMEM);
@@ -96,7 +89,7 @@ avs_coap_observe_start(avs_coap_ctx_t *ctx,
     avs_error_t err = ctx->vtable->accept_observation(ctx, observe);
 
     if (avs_is_err(err)) {
-        avs_free(observe);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&observe);
         return err;
     }
 
@@ -105,16 +98,13 @@ avs_coap_observe_start(avs_coap_ctx_t *ctx,
 
     LOG(DEBUG, _("Observe start: ") "%s", AVS_COAP_TOKEN_HEX(&id.token));
 
-    AVS_LIST_INSERT(&_avs_coap_get_base(ctx)->observes, observe);
+    AVS_RBTREE_ELEM(avs_coap_observe_t) inserted =
+            AVS_RBTREE_INSERT(_avs_coap_get_base(ctx)->observes, observe);
+    assert(inserted == observe);
+    (void) inserted;
     return AVS_OK;
 }
 
-static avs_coap_observe_t *find_observe_by_id(avs_coap_ctx_t *ctx,
-                                              const avs_coap_observe_id_t *id) {
-    AVS_LIST(avs_coap_observe_t) *observe_ptr = find_observe_ptr_by_id(ctx, id);
-    return observe_ptr ? *observe_ptr : NULL;
-}
-
 avs_error_t
 _avs_coap_observe_setup_notify(avs_coap_ctx_t *ctx,
                                const avs_coap_observe_id_t *id,
@@ -136,8 +126,8 @@ _avs_coap_observe_setup_notify(avs_coap_ctx_t *ctx,
 
 void _avs_coap_observe_cancel(avs_coap_ctx_t *ctx,
                               const avs_coap_observe_id_t *id) {
-    AVS_LIST(avs_coap_observe_t) *observe_ptr = find_observe_ptr_by_id(ctx, id);
-    if (!observe_ptr) {
+    AVS_RBTREE_ELEM(avs_coap_observe_t) observe = find_observe_by_id(ctx, id);
+    if (!observe) {
         LOG(TRACE, _("observation ") "%s" _(" does not exist"),
             AVS_COAP_TOKEN_HEX(&id->token));
         return;
@@ -145,11 +135,11 @@ void _avs_coap_observe_cancel(avs_coap_ctx_t *ctx,
 
     LOG(DEBUG, _("Observe cancel: ") "%s", AVS_COAP_TOKEN_HEX(&id->token));
 
-    avs_coap_observe_t *observe = AVS_LIST_DETACH(observe_ptr);
+    AVS_RBTREE_DETACH(_avs_coap_get_base(ctx)->observes, observe);
     if (observe->cancel_handler) {
         observe->cancel_handler(*id, observe->cancel_handler_arg);
     }
-    AVS_LIST_DELETE(&observe);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&observe);
 }
 
 #ifdef WITH_AVS_COAP_OBSERVE_PERSISTENCE
@@ -230,7 +220,7 @@ avs_coap_observe_restore(avs_coap_ctx_t *ctx,
     uint32_t last_observe_option_value;
     uint8_t request_code;
     uint16_t options_size = 0;
-    AVS_LIST(avs_coap_observe_t) observe;
+    AVS_RBTREE_ELEM(avs_coap_observe_t) observe;
     avs_error_t err = persistence_common_fields(persistence, &id.token,
                                                 &last_observe_option_value,
                                                 &request_code, &options_size);
@@ -245,7 +235,7 @@ avs_coap_observe_restore(avs_coap_ctx_t *ctx,
         return avs_errno(AVS_EBADMSG);
     }
 
-    observe = (AVS_LIST(avs_coap_observe_t)) AVS_LIST_NEW_BUFFER(
+    observe = (AVS_RBTREE_ELEM(avs_coap_observe_t)) AVS_RBTREE_ELEM_NEW_BUFFER(
             sizeof(avs_coap_observe_t) + options_size);
     if (!observe) {
         LOG(ERROR, _("Out of memory"));
@@ -264,12 +254,15 @@ avs_coap_observe_restore(avs_coap_ctx_t *ctx,
     if (avs_is_err((err = avs_persistence_bytes(persistence,
                                                 observe->options_storage,
                                                 options_size)))) {
-        AVS_LIST_DELETE(&observe);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&observe);
         return err;
     }
     LOG(DEBUG, _("Observe (restored) start: ") "%s",
         AVS_COAP_TOKEN_HEX(&id.token));
-    AVS_LIST_INSERT(&coap_base->observes, observe);
+    AVS_RBTREE_ELEM(avs_coap_observe_t) inserted =
+            AVS_RBTREE_INSERT(coap_base->observes, observe);
+    assert(inserted == observe);
+    (void) inserted;
 
     return AVS_OK;
 }
@@ -20,6 +20,7 @@
 #include <x_log_config.h>
 
 #include <avsystem/commons/errno.h>
+#include <avsystem/commons/memory.h>
 
 #include <avsystem/coap/code.h>
 #include <avsystem/coap/streaming.h>
@@ -45,38 +46,76 @@ is_sending_response_chunk(const avs_coap_streaming_server_ctx_t *ctx) {
            || ctx->state == AVS_COAP_STREAMING_SERVER_SENDING_RESPONSE_CHUNK;
 }
 
-static int feed_payload_chunk(size_t payload_offset,
-                              void *payload_buf,
-                              size_t payload_buf_size,
-                              size_t *out_payload_chunk_size,
-                              void *streaming_server_ctx_) {
-    (void) payload_offset;
+static int feed_buffered_response(size_t payload_offset,
+                                  void *payload_buf,
+                                  size_t payload_buf_size,
+                                  size_t *out_payload_chunk_size,
+                                  void *streaming_req_ctx_) {
+    avs_coap_streaming_request_ctx_t *streaming_req_ctx =
+            (avs_coap_streaming_request_ctx_t *) streaming_req_ctx_;
+    // Unlike feed_payload_chunk(), the whole response is buffered, so blocks
+    // may be requested in any order, and retransmitted if necessary.
+    if (payload_offset >= streaming_req_ctx->payload_size) {
+        *out_payload_chunk_size = 0;
+        return 0;
+    }
+    *out_payload_chunk_size =
+            AVS_MIN(payload_buf_size,
+                    streaming_req_ctx->payload_size - payload_offset);
+    memcpy(payload_buf, streaming_req_ctx->payload + payload_offset,
+           *out_payload_chunk_size);
+    return 0;
+}
 
-    avs_coap_streaming_server_ctx_t *streaming_server_ctx =
-            (avs_coap_streaming_server_ctx_t *) streaming_server_ctx_;
-    AVS_ASSERT(streaming_server_ctx->expected_next_outgoing_chunk_offset
-                       == payload_offset,
-               "payload is supposed to be read sequentially");
-    assert(is_sending_response_chunk(streaming_server_ctx));
+static size_t
+get_max_payload_size(avs_coap_streaming_request_ctx_t *streaming_req_ctx) {
+    return _avs_coap_get_base(streaming_req_ctx->server_ctx.coap_ctx)
+            ->streaming_max_payload_size;
+}
 
-    *out_payload_chunk_size =
-            avs_buffer_data_size(streaming_server_ctx->chunk_buffer);
-    if (payload_buf_size <= *out_payload_chunk_size) {
-        *out_payload_chunk_size = payload_buf_size;
-        streaming_server_ctx->state =
-                AVS_COAP_STREAMING_SERVER_SENDING_RESPONSE_CHUNK;
-    } else {
-        streaming_server_ctx->state =
-                AVS_COAP_STREAMING_SERVER_SENT_LAST_RESPONSE_CHUNK;
+static avs_error_t
+ensure_payload_capacity(avs_coap_streaming_request_ctx_t *streaming_req_ctx,
+                        size_t required_capacity) {
+    if (required_capacity <= streaming_req_ctx->payload_capacity) {
+        return AVS_OK;
     }
-    memcpy(payload_buf, avs_buffer_data(streaming_server_ctx->chunk_buffer),
-           *out_payload_chunk_size);
-    streaming_server_ctx->expected_next_outgoing_chunk_offset +=
-            *out_payload_chunk_size;
-    avs_buffer_consume_bytes(streaming_server_ctx->chunk_buffer,
-                             *out_payload_chunk_size);
+    // grow geometrically, but not beyond the limit unless necessary
+    const size_t max_size = get_max_payload_size(streaming_req_ctx);
+    size_t new_capacity = streaming_req_ctx->payload_capacity > max_size / 2
+                                  ? max_size
+                                  : 2 * streaming_req_ctx->payload_capacity;
+    new_capacity = AVS_MAX(new_capacity, required_capacity);
+    char *new_payload =
+            (char *) avs_realloc(streaming_req_ctx->payload, new_capacity);
+    if (!new_payload) {
+        LOG(ERROR, _("could not allocate ") "%" PRIu64 _(" bytes of payload"),
+            (uint64_t) new_capacity);
+        return avs_errno(AVS_ENOMEM);
+    }
+    streaming_req_ctx->payload = new_payload;
+    streaming_req_ctx->payload_capacity = new_capacity;
+    return AVS_OK;
+}
 
-    return 0;
+/**
+ * Makes room for @p additional_size more bytes of payload.
+ *
+ * @returns @li @ref AVS_OK on success,
+ *          @li <c>avs_errno(AVS_EMSGSIZE)</c> if the payload would exceed
+ *              the configured limit,
+ *          @li <c>avs_errno(AVS_ENOMEM)</c> on allocation failure.
+ */
+static avs_error_t
+reserve_payload(avs_coap_streaming_request_ctx_t *streaming_req_ctx,
+                size_t additional_size) {
+    const size_t max_size = get_max_payload_size(streaming_req_ctx);
+    if (streaming_req_ctx->payload_size > max_size
+            || additional_size > max_size - streaming_req_ctx->payload_size) {
+        return avs_errno(AVS_EMSGSIZE);
+    }
+    return ensure_payload_capacity(streaming_req_ctx,
+                                   streaming_req_ctx->payload_size
+                                           + additional_size);
 }
 
 avs_stream_t *
@@ -120,99 +159,45 @@ try_enter_sending_state(avs_coap_streaming_request_ctx_t *ctx) {
         LOG(WARNING, _("Response not set up"));
         return avs_errno(AVS_EINVAL);
     }
-    // Note: this is supposed to be called after the calls to
-    // called _avs_coap_async_incoming_packet_handle() and
-    // _avs_coap_async_incoming_packet_call_request_handler() (supposedly from
-    // within handle_incoming_packet()), but before
-    // _avs_coap_async_incoming_packet_send_response(). So effectively, we are
-    // in the middle of the logic that would usually be handled through
-    // _avs_coap_async_incoming_packet_simple_handle().
-    // This function is called either from coap_write(), or after returning from
-    // the user-provided request handler if the user has not called coap_write()
-    // at all. So we know for sure that we're done with the receiving phase,
-    // thus we're setting up the response - this code can be treated as the
-    // continuation of request_handler(), now that the necessary data from the
-    // user is available.
+    // Note: this is supposed to be called from within the user-provided
+    // request handler (via coap_write()), or right after it returns - in
+    // either case, from finish_request(), after the calls to
+    // _avs_coap_async_incoming_packet_handle_single() and
+    // _avs_coap_async_incoming_packet_call_request_handler() for the last
+    // request chunk, but before
+    // _avs_coap_async_incoming_packet_send_response(). So the base request_ctx
+    // still refers to the exchange this request belongs to.
     // Note: _avs_coap_server_setup_async_response() does not call
-    // feed_payload_chunk(). It will be called by the following call to
-    // _avs_coap_async_incoming_packet_send_response().
+    // feed_buffered_response(). It will be called by the following call to
+    // _avs_coap_async_incoming_packet_send_response(), and then by the async
+    // server itself whenever the peer asks for a subsequent BLOCK2 chunk.
     avs_error_t err = avs_coap_server_setup_async_response(
             &_avs_coap_get_base(ctx->server_ctx.coap_ctx)->request_ctx,
-            &ctx->response_header, feed_payload_chunk, &ctx->server_ctx);
+            &ctx->response_header, feed_buffered_response, ctx);
     if (avs_is_ok(err)) {
-        if (avs_buffer_data_size(ctx->server_ctx.chunk_buffer) > 0) {
+        if (ctx->payload_offset < ctx->payload_size) {
             LOG(WARNING,
                 _("Ignoring ") "%" PRIu64 _(" unread bytes of request"),
-                (uint64_t) avs_buffer_data_size(ctx->server_ctx.chunk_buffer));
-            avs_buffer_reset(ctx->server_ctx.chunk_buffer);
+                (uint64_t) (ctx->payload_size - ctx->payload_offset));
         }
+        // the payload buffer is reused for the response
+        ctx->payload_size = 0;
+        ctx->payload_offset = 0;
         ctx->server_ctx.state =
                 AVS_COAP_STREAMING_SERVER_SENDING_FIRST_RESPONSE_CHUNK;
     }
     return err;
 }
 
-static avs_error_t
-init_chunk_buffer(avs_coap_ctx_t *ctx,
-                  avs_buffer_t **out_buffer,
-                  const avs_coap_server_async_request_t *request,
-                  const avs_coap_response_header_t *response) {
-    /**
-     * In case of incoming requests, the buffer must be able to hold either
-     * request or response payload, so we need to take maximum of:
-     * - maximum estimated request chunk size - for BLOCK transfers, this will
-     *   be the BLOCK1 size of a first request chunk (it can never grow during
-     *   the transfer); for non-BLOCK transfers, we need to take in_buffer_size
-     *   instead,
-     * - maximum estimated response chunk size - here we use @ref
-     *   _avs_coap_get_next_outgoing_chunk_payload_size , assuming an arbitrary
-     *   response code and empty options list (effectively calculating the
-     *   biggest possible response payload chunk size).
-     *
-     * In case of notifications, we know the response headers in advance, so
-     * we use this information instead of dummy values. In this case, we will
-     * never receive any request payload, so @p request is NULL.
-     */
-    size_t max_request_chunk_size = 0;
-    if (request) {
-        max_request_chunk_size = _avs_coap_get_base(ctx)->in_buffer->capacity;
-#ifdef WITH_AVS_COAP_BLOCK
-        avs_coap_option_block_t req_block1;
-        switch (avs_coap_options_get_block(&request->header.options,
-                                           AVS_COAP_BLOCK1, &req_block1)) {
-        case 0:
-            max_request_chunk_size =
-                    AVS_MIN(req_block1.size, max_request_chunk_size);
-            break;
-        case AVS_COAP_OPTION_MISSING:
-            break;
-        default:
-            AVS_UNREACHABLE("malformed options got through packet validation");
-            return _avs_coap_err(AVS_COAP_ERR_MALFORMED_OPTIONS);
-        }
-#endif // WITH_AVS_COAP_BLOCK
-    }
-
-    size_t max_response_chunk_size;
-    avs_coap_options_t empty_opts = avs_coap_options_create_empty(NULL, 0);
-    avs_error_t err = _avs_coap_get_first_outgoing_chunk_payload_size(
-            ctx,
-            response ? response->code : AVS_COAP_CODE_CONTENT,
-            response ? &response->options : &empty_opts,
-            &max_response_chunk_size);
-    if (avs_is_err(err)) {
-        LOG(DEBUG, _("get_next_outgoing_chunk_payload_size failed: ") "%s",
-            AVS_COAP_STRERROR(err));
-        return err;
-    }
-
-    avs_buffer_free(out_buffer);
-    if (avs_buffer_create(out_buffer, AVS_MAX(max_request_chunk_size,
-                                              max_response_chunk_size))) {
-        return avs_errno(AVS_ENOMEM);
+static void
+release_request_ctx(avs_coap_streaming_request_ctx_t *streaming_req_ctx) {
+    assert(streaming_req_ctx->in_use);
+    streaming_req_ctx->in_use = false;
+    if (streaming_req_ctx->server_ctx.state
+            == AVS_COAP_STREAMING_SERVER_FINISHED) {
+        // request_handler() was called with CLEANUP while we were using it
+        avs_free(streaming_req_ctx);
     }
-
-    return AVS_OK;
 }
 
 static int request_handler(avs_coap_request_ctx_t *request_ctx,
@@ -232,37 +217,48 @@ static int request_handler(avs_coap_request_ctx_t *request_ctx,
         // the client that should be concerned about delivering the whole
         // request or receiving the whole response. It should be fine to handle
         // any kind of cleanup as success.
-        avs_buffer_free(&streaming_req_ctx->server_ctx.chunk_buffer);
+        avs_free(streaming_req_ctx->payload);
+        streaming_req_ctx->payload = NULL;
+        streaming_req_ctx->payload_capacity = 0;
+        streaming_req_ctx->payload_size = 0;
+        streaming_req_ctx->payload_offset = 0;
+        streaming_req_ctx->payload_start_offset = 0;
         avs_coap_options_cleanup(&streaming_req_ctx->request_header.options);
         avs_coap_options_cleanup(&streaming_req_ctx->response_header.options);
         streaming_req_ctx->server_ctx.exchange_id =
                 AVS_COAP_EXCHANGE_ID_INVALID;
         streaming_req_ctx->server_ctx.state =
                 AVS_COAP_STREAMING_SERVER_FINISHED;
+        if (!streaming_req_ctx->in_use) {
+            // The context is owned by the exchange, which has just finished.
+            // Otherwise, it will be freed in release_request_ctx().
+            avs_free(streaming_req_ctx);
+        }
         // return value is ignored for CLEANUP anyway
         return 0;
     }
 
-    if (streaming_req_ctx->error_response_code) {
-        return streaming_req_ctx->error_response_code;
+    assert(request_ctx
+           == &_avs_coap_get_base(streaming_req_ctx->server_ctx.coap_ctx)
+                       ->request_ctx);
+    assert(streaming_req_ctx->server_ctx.state
+           == AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST);
+
+    if (request->payload_offset != streaming_req_ctx->payload_start_offset
+                                            + streaming_req_ctx->payload_size) {
+        // Some earlier chunk of the request has not been received, most likely
+        // including the first one.
+        return AVS_COAP_CODE_REQUEST_ENTITY_INCOMPLETE;
     }
 
     if (request->payload_offset == 0) {
         // This means that it's the first chunk of the request.
-        assert(!streaming_req_ctx->server_ctx.chunk_buffer);
         assert(!streaming_req_ctx->request_has_observe_id);
         if (observe_id) {
             streaming_req_ctx->request_has_observe_id = true;
             streaming_req_ctx->request_observe_id = *observe_id;
         }
 
-        if (avs_is_err(init_chunk_buffer(
-                    streaming_req_ctx->server_ctx.coap_ctx,
-                    &streaming_req_ctx->server_ctx.chunk_buffer, request,
-                    NULL))) {
-            return AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
-        }
-
         assert(!streaming_req_ctx->request_header.options.allocated);
         streaming_req_ctx->request_header.code = request->header.code;
         if (avs_is_err(_avs_coap_options_copy_as_dynamic(
@@ -272,33 +268,65 @@ static int request_handler(avs_coap_request_ctx_t *request_ctx,
         }
     }
 
-    if (!streaming_req_ctx->server_ctx.chunk_buffer) {
-        // The buffer was never created, meaning that we never received a
-        // request with payload_offset == 0.
-        return AVS_COAP_CODE_REQUEST_ENTITY_INCOMPLETE;
+    if (streaming_req_ctx->streamed) {
+        // The user handler asks for another chunk only after consuming all the
+        // data received before - see ensure_data_is_available_to_read().
+        assert(streaming_req_ctx->payload_offset
+               == streaming_req_ctx->payload_size);
+        streaming_req_ctx->payload_start_offset +=
+                streaming_req_ctx->payload_size;
+        streaming_req_ctx->payload_size = 0;
+        streaming_req_ctx->payload_offset = 0;
+    }
+
+    avs_error_t err = reserve_payload(streaming_req_ctx, request->payload_size);
+    if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_EMSGSIZE) {
+        // The request is too large to be buffered as a whole. The user handler
+        // will be called with the data received so far, and further chunks
+        // will be received as it reads them, so at most one chunk more than
+        // the limit is ever buffered.
+        if (!streaming_req_ctx->streamed) {
+            LOG(DEBUG,
+                _("request exceeds the buffering limit of ") "%" PRIu64 _(
+                        " bytes, passing it to the handler as it arrives"),
+                (uint64_t) get_max_payload_size(streaming_req_ctx));
+            streaming_req_ctx->streamed = true;
+        }
+        err = ensure_payload_capacity(streaming_req_ctx,
+                                      streaming_req_ctx->payload_size
+                                              + request->payload_size);
+    }
+    if (avs_is_err(err)) {
+        return AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
+    }
+    if (request->payload_size) {
+        memcpy(streaming_req_ctx->payload + streaming_req_ctx->payload_size,
+               request->payload, request->payload_size);
+        streaming_req_ctx->payload_size += request->payload_size;
     }
-    assert(request->payload_size
-           <= avs_buffer_space_left(
-                      streaming_req_ctx->server_ctx.chunk_buffer));
-    avs_buffer_append_bytes(streaming_req_ctx->server_ctx.chunk_buffer,
-                            request->payload, request->payload_size);
-    assert(request_ctx
-           == &_avs_coap_get_base(streaming_req_ctx->server_ctx.coap_ctx)
-                       ->request_ctx);
-    assert(streaming_req_ctx->server_ctx.state
-           == AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST);
 
     switch (state) {
     case AVS_COAP_SERVER_REQUEST_PARTIAL_CONTENT:
-        streaming_req_ctx->server_ctx.state =
-                AVS_COAP_STREAMING_SERVER_RECEIVED_REQUEST_CHUNK;
-        // This will be continued in ensure_data_is_available_to_read()
+        if (streaming_req_ctx->streamed) {
+            streaming_req_ctx->server_ctx.state =
+                    AVS_COAP_STREAMING_SERVER_RECEIVED_REQUEST_CHUNK;
+            // This will be continued in finish_request(), or in
+            // receive_next_request_chunk() if the user handler is already
+            // running. 2.31 Continue is sent only once the user handler
+            // consumes the chunk.
+            return 0;
+        }
+        // The chunk is buffered, so 2.31 Continue may be sent right away. The
+        // exchange (and this context with it) is now parked until the next
+        // chunk arrives - possibly in another call to
+        // avs_coap_streaming_handle_incoming_packet().
         return 0;
 
     case AVS_COAP_SERVER_REQUEST_RECEIVED:
         streaming_req_ctx->server_ctx.state =
                 AVS_COAP_STREAMING_SERVER_RECEIVED_LAST_REQUEST_CHUNK;
-        // This will be continued in ensure_data_is_available_to_read()
+        // This will be continued in finish_request(), or in
+        // receive_next_request_chunk() if the user handler is already running
         return 0;
 
     case AVS_COAP_SERVER_REQUEST_CLEANUP:;
@@ -308,41 +336,6 @@ static int request_handler(avs_coap_request_ctx_t *request_ctx,
     return -1;
 }
 
-static int handle_new_request(avs_coap_server_ctx_t *server_ctx,
-                              const avs_coap_request_header_t *request,
-                              void *streaming_req_ctx_) {
-    (void) request;
-
-    avs_coap_streaming_request_ctx_t *streaming_req_ctx =
-            (avs_coap_streaming_request_ctx_t *) streaming_req_ctx_;
-
-    assert(avs_coap_exchange_id_valid(streaming_req_ctx->server_ctx.exchange_id)
-           == !!streaming_req_ctx->server_ctx.chunk_buffer);
-    if (!streaming_req_ctx->server_ctx.chunk_buffer) {
-        if (!avs_coap_exchange_id_valid(
-                    (streaming_req_ctx->server_ctx.exchange_id =
-                             avs_coap_server_accept_async_request(
-                                     server_ctx, request_handler,
-                                     streaming_req_ctx)))) {
-            LOG(ERROR, _("accept_async_request failed"));
-            return AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
-        }
-        return 0;
-    } else {
-        // another request is being handled
-        return AVS_COAP_CODE_SERVICE_UNAVAILABLE;
-    }
-}
-
-static int reject_new_request(avs_coap_server_ctx_t *server_ctx,
-                              const avs_coap_request_header_t *request,
-                              void *args_) {
-    (void) server_ctx;
-    (void) request;
-    (void) args_;
-    return AVS_COAP_CODE_SERVICE_UNAVAILABLE;
-}
-
 static avs_error_t
 update_recv_timeout(avs_net_socket_t *socket,
                     avs_time_duration_t next_timeout,
@@ -362,80 +355,6 @@ update_recv_timeout(avs_net_socket_t *socket,
     return err;
 }
 
-static avs_error_t
-try_wait_for_next_chunk_request(const avs_coap_streaming_server_ctx_t *ctx,
-                                const avs_error_t *abort_request_reason) {
-    avs_time_monotonic_t next_deadline =
-            _avs_coap_retry_or_request_expired_job(ctx->coap_ctx);
-
-    if (abort_request_reason && avs_is_err(*abort_request_reason)) {
-        return *abort_request_reason;
-    }
-
-    if (!avs_coap_exchange_id_valid(ctx->exchange_id)) {
-        // exchange failed e.g. due to not receiving request for another block
-        assert(ctx->state == AVS_COAP_STREAMING_SERVER_FINISHED);
-        return _avs_coap_err(AVS_COAP_ERR_TIMEOUT);
-    }
-
-    avs_net_socket_t *socket = _avs_coap_get_base(ctx->coap_ctx)->socket;
-    avs_net_socket_opt_value_t orig_recv_timeout;
-    avs_error_t err = update_recv_timeout(
-            socket,
-            avs_time_monotonic_diff(next_deadline, avs_time_monotonic_now()),
-            &orig_recv_timeout);
-    if (avs_is_ok(err)) {
-        // In a normal flow, this will receive the request for another BLOCK2
-        // chunk, and send the response. This does not require interaction with
-        // user code in the middle, so
-        // _avs_coap_async_incoming_packet_simple_handle() can be used, unlike
-        // handle_incoming_packet().
-        err = _avs_coap_async_incoming_packet_simple_handle_single(
-                ctx->coap_ctx, ctx->acquired_in_buffer,
-                ctx->acquired_in_buffer_size, reject_new_request, NULL);
-        if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ETIMEDOUT) {
-            // timeout is expected; ignore
-            err = AVS_OK;
-        }
-
-        if (avs_is_err(avs_net_socket_set_opt(socket,
-                                              AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
-                                              orig_recv_timeout))) {
-            LOG(ERROR, _("could not restore socket timeout"));
-        }
-    }
-    return err;
-}
-
-static avs_error_t flush_response_chunk(avs_coap_streaming_request_ctx_t *ctx) {
-    switch (ctx->server_ctx.state) {
-    case AVS_COAP_STREAMING_SERVER_RECEIVED_REQUEST_CHUNK:
-    case AVS_COAP_STREAMING_SERVER_RECEIVED_LAST_REQUEST_CHUNK:
-    case AVS_COAP_STREAMING_SERVER_SENDING_FIRST_RESPONSE_CHUNK:
-        // This call concludes the replication of
-        // _avs_coap_async_incoming_packet_simple_handle(). Note that in the
-        // AVS_COAP_STREAMING_SERVER_SENDING_FIRST_RESPONSE_CHUNK case,
-        // feed_payload_chunk() will be called here.
-        return _avs_coap_async_incoming_packet_send_response(
-                ctx->server_ctx.coap_ctx, ctx->error_response_code);
-
-    case AVS_COAP_STREAMING_SERVER_SENDING_RESPONSE_CHUNK:
-        // For the non-first chunk, we are not in the middle of
-        // incoming_packet_handle logic, so we need to handle this case
-        // differently.
-        return try_wait_for_next_chunk_request(&ctx->server_ctx, NULL);
-
-    default:
-        assert(avs_is_err(ctx->err));
-        LOG(ERROR,
-            _("invalid state for flush_request_chunk(), aborting exchange"));
-        avs_coap_exchange_cancel(ctx->server_ctx.coap_ctx,
-                                 ctx->server_ctx.exchange_id);
-        return avs_is_err(ctx->err) ? _avs_coap_err(AVS_COAP_ERR_ASSERT_FAILED)
-                                    : ctx->err;
-    }
-}
-
 static avs_error_t
 coap_write(avs_stream_t *stream_, const void *data, size_t *data_length) {
     avs_coap_streaming_request_ctx_t *streaming_req_ctx =
@@ -449,165 +368,218 @@ coap_write(avs_stream_t *stream_, const void *data, size_t *data_length) {
         LOG(ERROR, _("CoAP server stream not ready for writing"));
         return err;
     }
-
-    size_t bytes_written = 0;
-    while (bytes_written < *data_length) {
-        size_t bytes_to_write =
-                AVS_MIN(*data_length - bytes_written,
-                        avs_buffer_space_left(
-                                streaming_req_ctx->server_ctx.chunk_buffer));
-        avs_buffer_append_bytes(streaming_req_ctx->server_ctx.chunk_buffer,
-                                (const char *) data + bytes_written,
-                                bytes_to_write);
-        bytes_written += bytes_to_write;
-        // Once the buffer is full, flush_response_chunk() needs to be called.
-        if (!is_sending_response_chunk(&streaming_req_ctx->server_ctx)) {
-            return avs_errno(AVS_ENOBUFS);
-        }
-        if (avs_buffer_space_left(streaming_req_ctx->server_ctx.chunk_buffer)
-                        == 0
-                && avs_is_err((streaming_req_ctx->err = flush_response_chunk(
-                                       streaming_req_ctx)))) {
-            return streaming_req_ctx->err;
+    // The whole response is buffered, so that subsequent BLOCK2 chunks may be
+    // served by the async server without calling the user code again.
+    if (avs_is_err((err = reserve_payload(streaming_req_ctx, *data_length)))) {
+        if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_EMSGSIZE) {
+            LOG(WARNING,
+                _("response payload exceeds the limit of ") "%" PRIu64 _(
+                        " bytes"),
+                (uint64_t) get_max_payload_size(streaming_req_ctx));
         }
+        return (streaming_req_ctx->err = err);
+    }
+    if (*data_length) {
+        memcpy(streaming_req_ctx->payload + streaming_req_ctx->payload_size,
+               data, *data_length);
+        streaming_req_ctx->payload_size += *data_length;
     }
     return AVS_OK;
 }
 
 static avs_error_t
-handle_incoming_packet(avs_coap_streaming_request_ctx_t *streaming_req_ctx,
-                       avs_time_duration_t recv_timeout) {
-    assert(streaming_req_ctx->server_ctx.state
-           == AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST);
-    avs_net_socket_t *socket =
-            _avs_coap_get_base(streaming_req_ctx->server_ctx.coap_ctx)->socket;
-    avs_net_socket_opt_value_t orig_recv_timeout;
+finish_request(avs_coap_streaming_request_ctx_t *streaming_req_ctx,
+               avs_coap_streaming_request_handler_t *handle_request,
+               void *handler_arg) {
+    assert(has_received_request_chunk(&streaming_req_ctx->server_ctx));
+    // The whole request payload is now available, unless the request is
+    // streamed. The user-provided request handler is supposed to call
+    // coap_read(), possibly followed by coap_write(); only coap_read() on a
+    // streamed request may need to wait for network traffic.
+    streaming_req_ctx->error_response_code =
+            handle_request(streaming_req_ctx, &streaming_req_ctx->request_header,
+                           (avs_stream_t *) streaming_req_ctx,
+                           streaming_req_ctx->request_has_observe_id
+                                   ? &streaming_req_ctx->request_observe_id
+                                   : NULL,
+                           handler_arg);
+    avs_coap_base_t *coap_base =
+            _avs_coap_get_base(streaming_req_ctx->server_ctx.coap_ctx);
+    if (streaming_req_ctx->server_ctx.state
+                    == AVS_COAP_STREAMING_SERVER_FINISHED
+            || !avs_coap_exchange_id_equal(
+                       coap_base->request_ctx.exchange_id,
+                       streaming_req_ctx->server_ctx.exchange_id)) {
+        // Receiving further chunks of a streamed request failed, so there is
+        // no request chunk to respond to anymore.
+        assert(avs_is_err(streaming_req_ctx->err));
+        if (avs_coap_exchange_id_valid(
+                    streaming_req_ctx->server_ctx.exchange_id)) {
+            avs_coap_exchange_cancel(streaming_req_ctx->server_ctx.coap_ctx,
+                                     streaming_req_ctx->server_ctx.exchange_id);
+        }
+        return streaming_req_ctx->err;
+    }
+    // Update state if the response has been set up, but coap_write() has not
+    // been called
+    try_enter_sending_state(streaming_req_ctx);
+    if (!streaming_req_ctx->error_response_code
+            && (has_received_request_chunk(&streaming_req_ctx->server_ctx)
+                || avs_is_err(streaming_req_ctx->err))) {
+        // request handler returned success, but either
+        // _avs_coap_streaming_setup_response() has not been successfully
+        // called, or the response payload could not be buffered
+        streaming_req_ctx->error_response_code =
+                AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
+    }
+    // This concludes the replication of
+    // _avs_coap_async_incoming_packet_simple_handle(). feed_buffered_response()
+    // will be called here to send the first (or only) response chunk. If there
+    // are more, the async server will send them when requested, during
+    // subsequent calls to avs_coap_streaming_handle_incoming_packet().
+    return _avs_coap_async_incoming_packet_send_response(
+            streaming_req_ctx->server_ctx.coap_ctx,
+            streaming_req_ctx->error_response_code);
+}
+
+static int reject_new_request(avs_coap_server_ctx_t *server_ctx,
+                              const avs_coap_request_header_t *request,
+                              void *args_) {
+    (void) server_ctx;
+    (void) request;
+    (void) args_;
+    return AVS_COAP_CODE_SERVICE_UNAVAILABLE;
+}
+
+static avs_error_t
+handle_other_exchange(avs_coap_ctx_t *coap_ctx,
+                      avs_coap_exchange_t *exchange) {
+    avs_coap_streaming_request_ctx_t *other_req_ctx = NULL;
+    if (exchange->by_type.server.request_handler == request_handler) {
+        other_req_ctx = (avs_coap_streaming_request_ctx_t *)
+                                exchange->by_type.server.request_handler_arg;
+        other_req_ctx->in_use = true;
+    }
+    int call_result =
+            _avs_coap_async_incoming_packet_call_request_handler(coap_ctx,
+                                                                 exchange);
+    if (!call_result && other_req_ctx
+            && has_received_request_chunk(&other_req_ctx->server_ctx)) {
+        // The user handler is already running, and cannot be called again
+        // for another request until it returns.
+        call_result = AVS_COAP_CODE_SERVICE_UNAVAILABLE;
+    }
     avs_error_t err =
-            update_recv_timeout(socket, recv_timeout, &orig_recv_timeout);
+            _avs_coap_async_incoming_packet_send_response(coap_ctx,
+                                                          call_result);
+    if (other_req_ctx) {
+        release_request_ctx(other_req_ctx);
+    }
+    return err;
+}
+
+/**
+ * Sends 2.31 Continue for the already consumed chunk of a streamed request and
+ * waits for the next one. Other traffic received in the meantime is handled,
+ * but any request that would require calling the user handler is rejected with
+ * 5.03 Service Unavailable.
+ *
+ * The response to the received chunk is deferred in the same way as in
+ * handle_incoming_packet(), so base request_ctx refers to it on success.
+ */
+static avs_error_t
+receive_next_request_chunk(avs_coap_streaming_request_ctx_t *streaming_req_ctx) {
+    avs_coap_ctx_t *coap_ctx = streaming_req_ctx->server_ctx.coap_ctx;
+    avs_error_t err = _avs_coap_async_incoming_packet_send_response(coap_ctx, 0);
     if (avs_is_err(err)) {
         return err;
     }
-    avs_coap_exchange_t *exchange = NULL;
-    // The possible cases to be handled here:
-    // - The first packet of the incoming request is received. In this case,
-    //   streaming_req_ctx->server_ctx.exchange_id is invalid,
-    //   handle_new_request() will actually call
-    //   _avs_coap_server_accept_async_request().
-    // - Any following packet of the incoming request is received.
-    // - Concurrect incoming request is received while another one is already
-    //   being handled. 5.03 Service Unavailable will be sent.
-    err = _avs_coap_async_incoming_packet_handle_single(
-            streaming_req_ctx->server_ctx.coap_ctx,
-            streaming_req_ctx->server_ctx.acquired_in_buffer,
-            streaming_req_ctx->server_ctx.acquired_in_buffer_size,
-            handle_new_request, streaming_req_ctx, &exchange);
-    if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ETIMEDOUT) {
-        // timeout is expected; ignore
-        err = AVS_OK;
-    }
-    if (exchange) {
-        // Note that we've just called _avs_coap_async_incoming_packet_handle(),
-        // not _avs_coap_async_incoming_packet_simple_handle(). That function
-        // was created in D8245 by splitting the old
-        // _avs_coap_async_handle_incoming_packet(), which was equivalent to the
-        // modern "simple" version, i.e. always called the request handler and
-        // sent the response immediately after receiving the incoming response.
-        // The whole reason why we needed the "non-simple" version is that in
-        // this streaming server API, we sometimes want to defer calling
-        // _avs_coap_async_incoming_packet_send_response() until we actually
-        // get the contents of that response from the user. And since we might
-        // be called from _within_ the user code (via coap_read()), we cannot
-        // _call_ user code, we need to _return_, which makes the whole logic
-        // somewhat complicated.
-        // Note: is_streaming_request will be false if a message pertaining to
-        // another exchange (some "background" async exchange) is received.
-        bool is_streaming_request =
-                (exchange->by_type.server.request_handler == request_handler);
-        // If is_streaming_request == true, this will call request_handler().
-        int call_result = _avs_coap_async_incoming_packet_call_request_handler(
-                streaming_req_ctx->server_ctx.coap_ctx, exchange);
-        if (!call_result && is_streaming_request
-                && has_received_request_chunk(&streaming_req_ctx->server_ctx)) {
-            // This is supposed to correspond with the "This will be continued
-            // in ensure_data_is_available_to_read()" cases, as commented in
-            // request_handler(). Note that this mean that the whole request
-            // handling logic is not finished yet, we're just waiting for
-            // interaction with the user. ensure_data_is_available_to_read() may
-            // be called from coap_read() or coap_peek() - see there for more
-            // information on what it does.
+    streaming_req_ctx->server_ctx.state =
+            AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST;
+
+    avs_net_socket_t *socket = _avs_coap_get_base(coap_ctx)->socket;
+    while (streaming_req_ctx->server_ctx.state
+           == AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST) {
+        avs_time_monotonic_t next_deadline =
+                _avs_coap_retry_or_request_expired_job(coap_ctx);
+        if (streaming_req_ctx->server_ctx.state
+                != AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST) {
+            // The exchange has been cleaned up by
+            // _avs_coap_retry_or_request_expired_job()
+            break;
+        }
+        avs_net_socket_opt_value_t orig_recv_timeout;
+        if (avs_is_err((err = update_recv_timeout(
+                                socket,
+                                avs_time_monotonic_diff(
+                                        next_deadline,
+                                        avs_time_monotonic_now()),
+                                &orig_recv_timeout)))) {
+            return err;
+        }
+        avs_coap_exchange_t *exchange = NULL;
+        err = _avs_coap_async_incoming_packet_handle_single(
+                coap_ctx, streaming_req_ctx->server_ctx.acquired_in_buffer,
+                streaming_req_ctx->server_ctx.acquired_in_buffer_size,
+                reject_new_request, NULL, &exchange);
+        if (exchange
+                && exchange->by_type.server.request_handler == request_handler
+                && exchange->by_type.server.request_handler_arg
+                               == streaming_req_ctx) {
+            int call_result =
+                    _avs_coap_async_incoming_packet_call_request_handler(
+                            coap_ctx, exchange);
+            if (call_result
+                    || !has_received_request_chunk(
+                               &streaming_req_ctx->server_ctx)) {
+                err = _avs_coap_async_incoming_packet_send_response(
+                        coap_ctx, call_result);
+            }
+            // Otherwise, the response is deferred until the user handler
+            // consumes the chunk, or returns.
+        } else if (exchange) {
+            err = handle_other_exchange(coap_ctx, exchange);
+        }
+        if (avs_is_err(avs_net_socket_set_opt(socket,
+                                              AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                              orig_recv_timeout))) {
+            LOG(ERROR, _("could not restore socket timeout"));
+        }
+        if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ETIMEDOUT) {
+            // timeout is expected; ignore
             err = AVS_OK;
-        } else {
-            // Otherwise, we just replicate the logic of
-            // _avs_coap_async_incoming_packet_simple_handle().
-            err = _avs_coap_async_incoming_packet_send_response(
-                    streaming_req_ctx->server_ctx.coap_ctx, call_result);
+        }
+        if (avs_is_err(err)) {
+            return err;
         }
     }
-    if (avs_is_err(avs_net_socket_set_opt(
-                socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, orig_recv_timeout))) {
-        LOG(ERROR, _("could not restore socket timeout"));
+
+    if (streaming_req_ctx->server_ctx.state
+            == AVS_COAP_STREAMING_SERVER_FINISHED) {
+        // Either the exchange expired, or an error response has been sent
+        return _avs_coap_err(AVS_COAP_ERR_TIMEOUT);
     }
-    return err;
+    return AVS_OK;
 }
 
 static avs_error_t ensure_data_is_available_to_read(
         avs_coap_streaming_request_ctx_t *streaming_req_ctx) {
+    // Unless the request is streamed, the user-provided request handler is
+    // only called after the whole request has been received, so there is
+    // never any need to wait for data.
     if (avs_is_err(streaming_req_ctx->err)) {
         return streaming_req_ctx->err;
     }
-    // Note: there is a distinct
-    // AVS_COAP_STREAMING_SERVER_RECEIVED_LAST_REQUEST_CHUNK state, so if we
-    // enter the condition below, we know that the next packet to receive is
-    // supposed to be another chunk of request.
     if (streaming_req_ctx->server_ctx.state
                     == AVS_COAP_STREAMING_SERVER_RECEIVED_REQUEST_CHUNK
-            && avs_buffer_data_size(streaming_req_ctx->server_ctx.chunk_buffer)
-                           == 0) {
-        // All data from the previously received chunk has been consumed by the
-        // user. We now can send the response, concluding the replication of
-        // _avs_coap_async_incoming_packet_simple_handle() logic. We could do it
-        // earlier, but that would require further differentiating logic between
-        // the RECEIVED_REQUEST_CHUNK and RECEIVED_LAST_REQUEST_CHUNK cases.
-        // flush_response_chunk() may be called instead of this function, and we
-        // want the states in which the two functions may be called to be
-        // equivalent.
-        if (avs_is_err((streaming_req_ctx->err =
-                                _avs_coap_async_incoming_packet_send_response(
-                                        streaming_req_ctx->server_ctx.coap_ctx,
-                                        0)))) {
+            && streaming_req_ctx->payload_offset
+                           == streaming_req_ctx->payload_size) {
+        if (avs_is_err((streaming_req_ctx->err = receive_next_request_chunk(
+                                streaming_req_ctx)))) {
             return streaming_req_ctx->err;
         }
-        // Now we need to receive the next chunk of the request. This replicates
-        // the logic in handle_incoming_packet_with_acquired_in_buffer().
-        streaming_req_ctx->server_ctx.state =
-                AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST;
-        while (streaming_req_ctx->server_ctx.state
-               == AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST) {
-            avs_time_monotonic_t next_deadline =
-                    _avs_coap_retry_or_request_expired_job(
-                            streaming_req_ctx->server_ctx.coap_ctx);
-            if (streaming_req_ctx->server_ctx.state
-                    != AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST) {
-                // The exchange has been cleaned up by
-                // _avs_coap_retry_or_request_expired_job()
-                assert(streaming_req_ctx->server_ctx.state
-                       == AVS_COAP_STREAMING_SERVER_FINISHED);
-                streaming_req_ctx->err = _avs_coap_err(AVS_COAP_ERR_TIMEOUT);
-                return streaming_req_ctx->err;
-            }
-            if (avs_is_err((streaming_req_ctx->err = handle_incoming_packet(
-                                    streaming_req_ctx,
-                                    avs_time_monotonic_diff(
-                                            next_deadline,
-                                            avs_time_monotonic_now()))))) {
-                return streaming_req_ctx->err;
-            }
-        }
     }
-
-    if (avs_is_err(streaming_req_ctx->err)) {
-        return streaming_req_ctx->err;
-    } else if (!has_received_request_chunk(&streaming_req_ctx->server_ctx)) {
+    if (!has_received_request_chunk(&streaming_req_ctx->server_ctx)) {
         LOG(ERROR, _("CoAP streaming_server read called in invalid state"));
         return avs_errno(AVS_EBADF);
     }
@@ -626,23 +598,24 @@ static avs_error_t coap_read(avs_stream_t *stream_,
         return err;
     }
 
-    size_t bytes_to_read = AVS_MIN(
-            buffer_length,
-            avs_buffer_data_size(streaming_req_ctx->server_ctx.chunk_buffer));
-    memcpy(buffer, avs_buffer_data(streaming_req_ctx->server_ctx.chunk_buffer),
-           bytes_to_read);
-    avs_buffer_consume_bytes(streaming_req_ctx->server_ctx.chunk_buffer,
-                             bytes_to_read);
+    size_t bytes_to_read =
+            AVS_MIN(buffer_length, streaming_req_ctx->payload_size
+                                           - streaming_req_ctx->payload_offset);
+    if (bytes_to_read) {
+        memcpy(buffer,
+               streaming_req_ctx->payload + streaming_req_ctx->payload_offset,
+               bytes_to_read);
+        streaming_req_ctx->payload_offset += bytes_to_read;
+    }
     if (out_bytes_read) {
         *out_bytes_read = bytes_to_read;
     }
     if (out_message_finished) {
         *out_message_finished =
-                (avs_buffer_data_size(
-                         streaming_req_ctx->server_ctx.chunk_buffer)
-                         == 0
-                 && streaming_req_ctx->server_ctx.state
-                            == AVS_COAP_STREAMING_SERVER_RECEIVED_LAST_REQUEST_CHUNK);
+                (streaming_req_ctx->server_ctx.state
+                         != AVS_COAP_STREAMING_SERVER_RECEIVED_REQUEST_CHUNK
+                 && streaming_req_ctx->payload_offset
+                            == streaming_req_ctx->payload_size);
     }
     return AVS_OK;
 }
@@ -656,12 +629,12 @@ coap_peek(avs_stream_t *stream_, size_t offset, char *out_value) {
         return err;
     }
 
-    if (offset >= avs_buffer_data_size(
-                          streaming_req_ctx->server_ctx.chunk_buffer)) {
+    if (offset >= streaming_req_ctx->payload_size
+                          - streaming_req_ctx->payload_offset) {
         return AVS_EOF;
     }
-    *out_value =
-            avs_buffer_data(streaming_req_ctx->server_ctx.chunk_buffer)[offset];
+    *out_value = streaming_req_ctx
+                         ->payload[streaming_req_ctx->payload_offset + offset];
     return AVS_OK;
 }
 
@@ -672,6 +645,138 @@ static const avs_stream_v_table_t _AVS_COAP_STREAMING_REQUEST_CTX_VTABLE = {
     .extension_list = AVS_STREAM_V_TABLE_NO_EXTENSIONS
 };
 
+static size_t count_pending_requests(avs_coap_ctx_t *coap_ctx) {
+    size_t count = 0;
+    AVS_LIST(avs_coap_exchange_t) exchange;
+    AVS_LIST_FOREACH(exchange, _avs_coap_get_base(coap_ctx)->server_exchanges) {
+        if (exchange->by_type.server.request_handler == request_handler) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+static int handle_new_request(avs_coap_server_ctx_t *server_ctx,
+                              const avs_coap_request_header_t *request,
+                              void *coap_ctx_) {
+    (void) request;
+
+    // Each pending request may hold up to streaming_max_payload_size bytes,
+    // so their number needs to be limited as well.
+    const size_t max_pending_requests =
+            _avs_coap_get_base((avs_coap_ctx_t *) coap_ctx_)
+                    ->streaming_max_pending_requests;
+    if (count_pending_requests((avs_coap_ctx_t *) coap_ctx_)
+            >= max_pending_requests) {
+        LOG(WARNING,
+            _("rejecting request: ") "%" PRIu64 _(" requests already pending"),
+            (uint64_t) max_pending_requests);
+        return AVS_COAP_CODE_SERVICE_UNAVAILABLE;
+    }
+
+    avs_coap_streaming_request_ctx_t *streaming_req_ctx =
+            (avs_coap_streaming_request_ctx_t *) avs_calloc(
+                    1, sizeof(avs_coap_streaming_request_ctx_t));
+    if (!streaming_req_ctx) {
+        LOG(ERROR, _("out of memory"));
+        return AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
+    }
+    streaming_req_ctx->vtable = &_AVS_COAP_STREAMING_REQUEST_CTX_VTABLE;
+    streaming_req_ctx->server_ctx.coap_ctx = (avs_coap_ctx_t *) coap_ctx_;
+    streaming_req_ctx->server_ctx.state =
+            AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST;
+
+    // From now on, streaming_req_ctx is owned by the exchange, and will be
+    // freed when request_handler() is called with CLEANUP.
+    if (!avs_coap_exchange_id_valid(
+                (streaming_req_ctx->server_ctx.exchange_id =
+                         avs_coap_server_accept_async_request(
+                                 server_ctx, request_handler,
+                                 streaming_req_ctx)))) {
+        LOG(ERROR, _("accept_async_request failed"));
+        avs_free(streaming_req_ctx);
+        return AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
+    }
+    return 0;
+}
+
+static avs_error_t
+handle_incoming_packet(avs_coap_ctx_t *coap_ctx,
+                       uint8_t *acquired_in_buffer,
+                       size_t acquired_in_buffer_size,
+                       avs_time_duration_t recv_timeout,
+                       avs_coap_streaming_request_handler_t *handle_request,
+                       void *handler_arg) {
+    avs_net_socket_t *socket = _avs_coap_get_base(coap_ctx)->socket;
+    avs_net_socket_opt_value_t orig_recv_timeout;
+    avs_error_t err =
+            update_recv_timeout(socket, recv_timeout, &orig_recv_timeout);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    avs_coap_exchange_t *exchange = NULL;
+    // The possible cases to be handled here:
+    // - The first packet of the incoming request is received. In this case,
+    //   handle_new_request() will allocate a new streaming request context and
+    //   call _avs_coap_server_accept_async_request().
+    // - Any following packet of some incoming request is received. The context
+    //   allocated for it is then available as the request handler argument of
+    //   the exchange. Any number of such requests may be in progress at once.
+    // - A request for a subsequent BLOCK2 chunk of a response is received.
+    //   This is handled internally by the async server, using
+    //   feed_buffered_response(), and no exchange is returned.
+    err = _avs_coap_async_incoming_packet_handle_single(
+            coap_ctx, acquired_in_buffer, acquired_in_buffer_size,
+            handle_new_request, coap_ctx, &exchange);
+    if (exchange) {
+        // Note that we've just called _avs_coap_async_incoming_packet_handle(),
+        // not _avs_coap_async_incoming_packet_simple_handle(). The whole
+        // reason why we need the "non-simple" version is that when the last
+        // chunk of the request is received, we want to call the user-provided
+        // request handler between request_handler() and
+        // _avs_coap_async_incoming_packet_send_response(), so that the
+        // response is sent in reply to that last chunk.
+        // Note: streaming_req_ctx will be NULL if a message pertaining to
+        // another exchange (some "background" async exchange) is received.
+        avs_coap_streaming_request_ctx_t *streaming_req_ctx = NULL;
+        if (exchange->by_type.server.request_handler == request_handler) {
+            streaming_req_ctx = (avs_coap_streaming_request_ctx_t *)
+                                        exchange->by_type.server
+                                                .request_handler_arg;
+            // prevent the context from being freed under our feet if the
+            // exchange is cleaned up while we're handling it
+            streaming_req_ctx->in_use = true;
+            // needed to receive further chunks if the request is streamed
+            streaming_req_ctx->server_ctx.acquired_in_buffer =
+                    acquired_in_buffer;
+            streaming_req_ctx->server_ctx.acquired_in_buffer_size =
+                    acquired_in_buffer_size;
+        }
+        // If streaming_req_ctx != NULL, this will call request_handler().
+        int call_result = _avs_coap_async_incoming_packet_call_request_handler(
+                coap_ctx, exchange);
+        if (!call_result && streaming_req_ctx
+                && has_received_request_chunk(&streaming_req_ctx->server_ctx)) {
+            err = finish_request(streaming_req_ctx, handle_request,
+                                 handler_arg);
+        } else {
+            // Otherwise, we just replicate the logic of
+            // _avs_coap_async_incoming_packet_simple_handle(). For non-last
+            // request chunks, this sends 2.31 Continue.
+            err = _avs_coap_async_incoming_packet_send_response(coap_ctx,
+                                                                call_result);
+        }
+        if (streaming_req_ctx) {
+            release_request_ctx(streaming_req_ctx);
+        }
+    }
+    if (avs_is_err(avs_net_socket_set_opt(
+                socket, AVS_NET_SOCKET_OPT_RECV_TIMEOUT, orig_recv_timeout))) {
+        LOG(ERROR, _("could not restore socket timeout"));
+    }
+    return err;
+}
+
 static avs_error_t handle_incoming_packet_with_acquired_in_buffer(
         avs_coap_ctx_t *coap_ctx,
         uint8_t *acquired_in_buffer,
@@ -686,72 +791,26 @@ static avs_error_t handle_incoming_packet_with_acquired_in_buffer(
             _avs_coap_retry_or_request_expired_job(coap_ctx),
             avs_time_monotonic_now());
     while (true) {
-        avs_coap_streaming_request_ctx_t streaming_req_ctx = {
-            .vtable = &_AVS_COAP_STREAMING_REQUEST_CTX_VTABLE,
-            .server_ctx = {
-                .coap_ctx = coap_ctx,
-                .acquired_in_buffer = acquired_in_buffer,
-                .acquired_in_buffer_size = acquired_in_buffer_size,
-                .state = AVS_COAP_STREAMING_SERVER_RECEIVING_REQUEST
-            }
-        };
         // While this function "handles incoming packet" in a generic way, the
         // only case it handles that actually requires some interaction with the
-        // user code is handling an incoming _request_. See inside for more
-        // details.
-        if (avs_is_ok((streaming_req_ctx.err = handle_incoming_packet(
-                               &streaming_req_ctx, next_timeout)))) {
-            if (!streaming_req_ctx.server_ctx.chunk_buffer) {
-                // Timeout - as the contract of this function does not mandate
-                // that we must always receive anything, we just return success.
-                // Also, because we loop, wanting to flush internal socket
-                // buffers, this is actually the only success return point of
-                // this function.
-                return AVS_OK;
-            }
-            if (has_received_request_chunk(&streaming_req_ctx.server_ctx)) {
-                // We have successfully received some data, so passing
-                // AVS_OK as error code makes sense here.
-                // The user-provided request handler is supposed to call
-                // coap_read(), possibly followed by coap_write().
-                streaming_req_ctx.error_response_code = handle_request(
-                        &streaming_req_ctx,
-                        &streaming_req_ctx.request_header,
-                        (avs_stream_t *) &streaming_req_ctx,
-                        streaming_req_ctx.request_has_observe_id
-                                ? &streaming_req_ctx.request_observe_id
-                                : NULL,
-                        handler_arg);
-                // Update state if the response has been set up, but
-                // coap_write() has not been called
-                try_enter_sending_state(&streaming_req_ctx);
-                if (!streaming_req_ctx.error_response_code
-                        && has_received_request_chunk(
-                                   &streaming_req_ctx.server_ctx)) {
-                    // request handler returned success, but
-                    // _avs_coap_streaming_setup_response() has not been
-                    // successfully called
-                    streaming_req_ctx.error_response_code =
-                            AVS_COAP_CODE_INTERNAL_SERVER_ERROR;
-                }
-            }
-            // We might have some data buffered to be sent, but not send yet -
-            // send it here. This is done in a loop, because we might end up
-            // receiving messages unrelated to this exchange in between.
-            while (streaming_req_ctx.server_ctx.state
-                   != AVS_COAP_STREAMING_SERVER_FINISHED) {
-                streaming_req_ctx.err =
-                        flush_response_chunk(&streaming_req_ctx);
-            }
+        // user code is handling the last chunk of an incoming _request_. See
+        // inside for more details. In particular, this never waits for further
+        // chunks of a BLOCK-wise transfer - those will be handled by subsequent
+        // calls, as they arrive - unless the request is too large to be
+        // buffered, see receive_next_request_chunk().
+        avs_error_t err = handle_incoming_packet(
+                coap_ctx, acquired_in_buffer, acquired_in_buffer_size,
+                next_timeout, handle_request, handler_arg);
+        if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ETIMEDOUT) {
+            // Timeout - as the contract of this function does not mandate
+            // that we must always receive anything, we just return success.
+            // Also, because we loop, wanting to flush internal socket
+            // buffers, this is actually the only success return point of
+            // this function.
+            return AVS_OK;
         }
-
-        // make sure everything is cleaned up
-        assert(!streaming_req_ctx.server_ctx.chunk_buffer);
-        assert(!streaming_req_ctx.request_header.options.allocated);
-        assert(!streaming_req_ctx.response_header.options.allocated);
-        if (avs_is_err(streaming_req_ctx.err)) {
-            // error
-            return streaming_req_ctx.err;
+        if (avs_is_err(err)) {
+            return err;
         }
         // We might handle more packets, but after the initial blocking receive,
         // now we only want to flush the internal socket buffers, if any, so we
@@ -760,6 +819,19 @@ static avs_error_t handle_incoming_packet_with_acquired_in_buffer(
     }
 }
 
+avs_error_t avs_coap_streaming_set_request_limits(avs_coap_ctx_t *ctx,
+                                                  size_t max_payload_size,
+                                                  size_t max_pending_requests) {
+    avs_coap_base_t *coap_base = _avs_coap_get_base(ctx);
+    coap_base->streaming_max_payload_size =
+            max_payload_size ? max_payload_size
+                             : COAP_STREAMING_MAX_PAYLOAD_SIZE;
+    coap_base->streaming_max_pending_requests =
+            max_pending_requests ? max_pending_requests
+                                 : COAP_STREAMING_MAX_PENDING_REQUESTS;
+    return AVS_OK;
+}
+
 avs_error_t avs_coap_streaming_handle_incoming_packet(
         avs_coap_ctx_t *coap_ctx,
         avs_coap_streaming_request_handler_t *handle_request,
@@ -788,6 +860,111 @@ avs_error_t avs_coap_observe_streaming_start(
             cancel_handler, handler_arg);
 }
 
+static int feed_payload_chunk(size_t payload_offset,
+                              void *payload_buf,
+                              size_t payload_buf_size,
+                              size_t *out_payload_chunk_size,
+                              void *streaming_server_ctx_) {
+    (void) payload_offset;
+
+    avs_coap_streaming_server_ctx_t *streaming_server_ctx =
+            (avs_coap_streaming_server_ctx_t *) streaming_server_ctx_;
+    AVS_ASSERT(streaming_server_ctx->expected_next_outgoing_chunk_offset
+                       == payload_offset,
+               "payload is supposed to be read sequentially");
+    assert(is_sending_response_chunk(streaming_server_ctx));
+
+    *out_payload_chunk_size =
+            avs_buffer_data_size(streaming_server_ctx->chunk_buffer);
+    if (payload_buf_size <= *out_payload_chunk_size) {
+        *out_payload_chunk_size = payload_buf_size;
+        streaming_server_ctx->state =
+                AVS_COAP_STREAMING_SERVER_SENDING_RESPONSE_CHUNK;
+    } else {
+        streaming_server_ctx->state =
+                AVS_COAP_STREAMING_SERVER_SENT_LAST_RESPONSE_CHUNK;
+    }
+    memcpy(payload_buf, avs_buffer_data(streaming_server_ctx->chunk_buffer),
+           *out_payload_chunk_size);
+    streaming_server_ctx->expected_next_outgoing_chunk_offset +=
+            *out_payload_chunk_size;
+    avs_buffer_consume_bytes(streaming_server_ctx->chunk_buffer,
+                             *out_payload_chunk_size);
+
+    return 0;
+}
+
+static avs_error_t
+init_chunk_buffer(avs_coap_ctx_t *ctx,
+                  avs_buffer_t **out_buffer,
+                  const avs_coap_response_header_t *response) {
+    /**
+     * The buffer is only used for notifications, which never carry any
+     * request payload, and whose response headers are known in advance, so
+     * we can calculate the exact size of the first outgoing chunk.
+     */
+    size_t max_response_chunk_size;
+    avs_error_t err = _avs_coap_get_first_outgoing_chunk_payload_size(
+            ctx, response->code, &response->options, &max_response_chunk_size);
+    if (avs_is_err(err)) {
+        LOG(DEBUG, _("get_next_outgoing_chunk_payload_size failed: ") "%s",
+            AVS_COAP_STRERROR(err));
+        return err;
+    }
+
+    avs_buffer_free(out_buffer);
+    if (avs_buffer_create(out_buffer, max_response_chunk_size)) {
+        return avs_errno(AVS_ENOMEM);
+    }
+
+    return AVS_OK;
+}
+
+static avs_error_t
+try_wait_for_next_chunk_request(const avs_coap_streaming_server_ctx_t *ctx,
+                                const avs_error_t *abort_request_reason) {
+    avs_time_monotonic_t next_deadline =
+            _avs_coap_retry_or_request_expired_job(ctx->coap_ctx);
+
+    if (abort_request_reason && avs_is_err(*abort_request_reason)) {
+        return *abort_request_reason;
+    }
+
+    if (!avs_coap_exchange_id_valid(ctx->exchange_id)) {
+        // exchange failed e.g. due to not receiving request for another block
+        assert(ctx->state == AVS_COAP_STREAMING_SERVER_FINISHED);
+        return _avs_coap_err(AVS_COAP_ERR_TIMEOUT);
+    }
+
+    avs_net_socket_t *socket = _avs_coap_get_base(ctx->coap_ctx)->socket;
+    avs_net_socket_opt_value_t orig_recv_timeout;
+    avs_error_t err = update_recv_timeout(
+            socket,
+            avs_time_monotonic_diff(next_deadline, avs_time_monotonic_now()),
+            &orig_recv_timeout);
+    if (avs_is_ok(err)) {
+        // In a normal flow, this will receive the request for another BLOCK2
+        // chunk, and send the response. This does not require interaction with
+        // user code in the middle, so
+        // _avs_coap_async_incoming_packet_simple_handle() can be used, unlike
+        // handle_incoming_packet().
+        err = _avs_coap_async_incoming_packet_simple_handle_single(
+                ctx->coap_ctx, ctx->acquired_in_buffer,
+                ctx->acquired_in_buffer_size, reject_new_request, NULL);
+        if (err.category == AVS_ERRNO_CATEGORY && err.code == AVS_ETIMEDOUT) {
+            // timeout is expected; ignore
+            err = AVS_OK;
+        }
+
+        if (avs_is_err(avs_net_socket_set_opt(socket,
+                                              AVS_NET_SOCKET_OPT_RECV_TIMEOUT,
+                                              orig_recv_timeout))) {
+            LOG(ERROR, _("could not restore socket timeout"));
+        }
+    }
+    return err;
+}
+
 typedef struct {
     const avs_stream_v_table_t *vtable;
     avs_coap_streaming_server_ctx_t server_ctx;
@@ -919,7 +1096,6 @@ avs_coap_notify_streaming(avs_coap_ctx_t *ctx,
     if (avs_is_err((err = init_chunk_buffer(
                             ctx,
                             &notify_streaming_ctx.server_ctx.chunk_buffer,
-                            NULL,
                             response_header)))) {
         goto finish;
     }
@@ -48,11 +48,9 @@ typedef struct {
     size_t expected_next_outgoing_chunk_offset;
 
     /**
-     * Depending on stream state, this buffer may be used either for *request*
-     * payload (RECEIVING_REQUEST, RECEIVING_REQUEST_CHUNK,
-     * RECEIVED_LAST_REQUEST_CHUNK) or *response* payload
-     * (SENDING_FIRST_RESPONSE_CHUNK, SENDING_RESPONSE_CHUNK,
-     * SENT_LAST_RESPONSE_CHUNK)
+     * Buffer for a single chunk of notification payload. Not used for
+     * handling incoming requests - see avs_coap_streaming_request_ctx::payload
+     * instead.
      */
     avs_buffer_t *chunk_buffer;
 } avs_coap_streaming_server_ctx_t;
@@ -74,6 +72,50 @@ struct avs_coap_streaming_request_ctx {
 
     avs_coap_request_header_t request_header;
     avs_coap_response_header_t response_header;
+
+    /**
+     * Whole payload of the request (RECEIVING_REQUEST, RECEIVED_*) or of the
+     * response (SENDING_*_CHUNK).
+     *
+     * Request chunks are appended as they arrive, so that the exchange may be
+     * parked between them without blocking, and the user handler is called
+     * only once the whole request is available. Likewise, the whole response
+     * is kept until the exchange finishes, so that subsequent BLOCK2 chunks
+     * may be served without calling the user handler again.
+     *
+     * If the request turns out to be too large to be buffered, see
+     * @ref streamed, this only holds the request chunks that have not been
+     * consumed by the user handler yet.
+     */
+    char *payload;
+    size_t payload_size;
+    size_t payload_capacity;
+    /**
+     * Number of request payload bytes already consumed by the user handler.
+     */
+    size_t payload_offset;
+    /**
+     * Offset of the first byte of @ref payload within the whole request
+     * payload. May be non-zero only if @ref streamed is set.
+     */
+    size_t payload_start_offset;
+
+    /**
+     * Set if the request payload exceeds the configured buffering limit. The
+     * user handler is then called before the whole request is received, and
+     * further chunks are received while it reads them, which blocks
+     * avs_coap_streaming_handle_incoming_packet() until the request is
+     * complete.
+     */
+    bool streamed;
+
+    /**
+     * The context is allocated when a new request is accepted and owned by
+     * its exchange. This flag is set while a packet pertaining to that
+     * exchange is being handled, so that the context is not freed if the
+     * exchange is cleaned up in the meantime.
+     */
+    bool in_use;
 };
 
 VISIBILITY_PRIVATE_HEADER_END
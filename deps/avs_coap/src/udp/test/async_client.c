@@ -464,6 +464,145 @@ AVS_UNIT_TEST(udp_async_client, cancels_all_exchanges_on_cleanup) {
     // in test_teardown.
 }
 
+AVS_UNIT_TEST(udp_async_client, cancel_exchange_between_others) {
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, GET, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(CON, PUT, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(CON, POST, ID(2), TOKEN(nth_token(2)))
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTENT, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(ACK, CHANGED, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(ACK, CREATED, ID(2), TOKEN(nth_token(2)))
+    };
+    avs_coap_exchange_id_t ids[AVS_ARRAY_SIZE(requests)];
+
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        expect_send(&env, requests[i]);
+        ASSERT_OK(avs_coap_client_send_async_request(
+                env.coap_ctx, &ids[i], &requests[i]->request_header, NULL, NULL,
+                test_response_handler, &env.expects_list));
+        ASSERT_TRUE(avs_coap_exchange_id_valid(ids[i]));
+    }
+
+    expect_handler_call(&env, &ids[1], AVS_COAP_CLIENT_REQUEST_CANCEL, NULL);
+    avs_coap_exchange_cancel(env.coap_ctx, ids[1]);
+    // cancelling it again is a no-op
+    avs_coap_exchange_cancel(env.coap_ctx, ids[1]);
+
+    // exchanges on both sides of the removed one are still matched, in any
+    // order
+    expect_recv(&env, responses[2]);
+    expect_handler_call(&env, &ids[2], AVS_COAP_CLIENT_REQUEST_OK,
+                        responses[2]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+
+    expect_recv(&env, responses[0]);
+    expect_handler_call(&env, &ids[0], AVS_COAP_CLIENT_REQUEST_OK,
+                        responses[0]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+}
+
+AVS_UNIT_TEST(udp_async_client, retransmissions_in_deadline_order) {
+    avs_coap_udp_tx_params_t tx_params = AVS_COAP_DEFAULT_UDP_TX_PARAMS;
+    tx_params.ack_random_factor = 1.0;
+    tx_params.nstart = 3;
+    test_env_t env __attribute__((cleanup(test_teardown_late_expects_check))) =
+            test_setup(&tx_params, 4096, 4096, NULL);
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, GET, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(CON, PUT, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(CON, POST, ID(2), TOKEN(nth_token(2)))
+    };
+    avs_coap_exchange_id_t ids[AVS_ARRAY_SIZE(requests)];
+
+    // requests[0] is sent 1s before the others, which are sent at the same
+    // time
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        if (i == 1) {
+            _avs_mock_clock_advance(
+                    avs_time_duration_from_scalar(1, AVS_TIME_S));
+        }
+        expect_send(&env, requests[i]);
+        ASSERT_OK(avs_coap_client_send_async_request(
+                env.coap_ctx, &ids[i], &requests[i]->request_header, NULL, NULL,
+                test_response_handler, &env.expects_list));
+    }
+
+    // With ACK_TIMEOUT = 2s, retransmissions are due at:
+    // - requests[0]: 2s, 6s after the first send,
+    // - requests[1] and requests[2]: 3s, 7s; ties keep the sending order.
+    const size_t expected_order[][2] = { { 0, SIZE_MAX }, { 1, 2 },
+                                         { 0, SIZE_MAX }, { 1, 2 } };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(expected_order); ++i) {
+        _avs_mock_clock_advance(avs_sched_time_to_next(env.sched));
+        for (size_t j = 0; j < AVS_ARRAY_SIZE(expected_order[i]); ++j) {
+            if (expected_order[i][j] != SIZE_MAX) {
+                expect_send(&env, requests[expected_order[i][j]]);
+            }
+        }
+        avs_sched_run(env.sched);
+    }
+    ASSERT_EQ(avs_coap_get_stats(env.coap_ctx).outgoing_retransmissions_count,
+              6);
+
+    // IMPLEMENTATION DETAIL: exchanges are cleaned up in reverse order
+    expect_handler_call(&env, &ids[2], AVS_COAP_CLIENT_REQUEST_CANCEL, NULL);
+    expect_handler_call(&env, &ids[1], AVS_COAP_CLIENT_REQUEST_CANCEL, NULL);
+    expect_handler_call(&env, &ids[0], AVS_COAP_CLIENT_REQUEST_CANCEL, NULL);
+}
+
+AVS_UNIT_TEST(udp_async_client, held_requests_resumed_oldest_first) {
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_with_nstart(2);
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, GET, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(CON, GET, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(CON, GET, ID(2), TOKEN(nth_token(2))),
+        COAP_MSG(CON, GET, ID(3), TOKEN(nth_token(3)))
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTENT, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(ACK, CONTENT, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(ACK, CONTENT, ID(2), TOKEN(nth_token(2))),
+        COAP_MSG(ACK, CONTENT, ID(3), TOKEN(nth_token(3)))
+    };
+    avs_coap_exchange_id_t ids[AVS_ARRAY_SIZE(requests)];
+
+    // only the first NSTART requests are sent, the rest is held
+    expect_send(&env, requests[0]);
+    expect_send(&env, requests[1]);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        ASSERT_OK(avs_coap_client_send_async_request(
+                env.coap_ctx, &ids[i], &requests[i]->request_header, NULL, NULL,
+                test_response_handler, &env.expects_list));
+    }
+
+    // responses arrive in reverse order, but held requests are still resumed
+    // in the order they were created
+    const size_t response_order[] = { 1, 0, 3, 2 };
+    const size_t resumed[] = { 2, 3, SIZE_MAX, SIZE_MAX };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(response_order); ++i) {
+        const size_t idx = response_order[i];
+        expect_recv(&env, responses[idx]);
+        if (resumed[i] != SIZE_MAX) {
+            expect_send(&env, requests[resumed[i]]);
+        }
+        expect_handler_call(&env, &ids[idx], AVS_COAP_CLIENT_REQUEST_OK,
+                            responses[idx]);
+        expect_timeout(&env);
+        ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL,
+                                                        NULL));
+    }
+}
+
 AVS_UNIT_TEST(udp_async_client,
               send_request_piggybacked_response_matched_by_id_and_token) {
     test_env_t env __attribute__((cleanup(test_teardown))) =
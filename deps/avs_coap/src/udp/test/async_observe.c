@@ -139,6 +139,74 @@ AVS_UNIT_TEST(udp_observe, cancel_with_observe_option) {
             env.coap_ctx, test_accept_new_request, &env));
 }
 
+AVS_UNIT_TEST(udp_observe, cancel_token_with_common_prefix) {
+    test_env_t env __attribute__((cleanup(test_teardown_late_expects_check))) =
+            test_setup_default();
+
+    // one token is a prefix of the other, so only a comparison of the whole
+    // tokens tells the observations apart
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, GET, ID(0), MAKE_TOKEN("Obs"), OBSERVE(0), NO_PAYLOAD),
+        COAP_MSG(CON, GET, ID(1), MAKE_TOKEN("Obserw"), OBSERVE(0), NO_PAYLOAD),
+        COAP_MSG(CON, GET, ID(2), MAKE_TOKEN("Obs"), OBSERVE(1), NO_PAYLOAD),
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTENT, ID(0), MAKE_TOKEN("Obs"), OBSERVE(0),
+                 NO_PAYLOAD),
+        COAP_MSG(ACK, CONTENT, ID(1), MAKE_TOKEN("Obserw"), OBSERVE(0),
+                 NO_PAYLOAD),
+        COAP_MSG(ACK, CONTENT, ID(2), MAKE_TOKEN("Obs"), NO_PAYLOAD),
+    };
+
+    expect_recv(&env, requests[0]);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_RECEIVED,
+                                requests[0],
+                                &(avs_coap_response_header_t) {
+                                    .code = responses[0]->response_header.code
+                                },
+                                NULL);
+    expect_observe_start(&env, MAKE_TOKEN("Obs"));
+    expect_send(&env, responses[0]);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_CLEANUP, NULL,
+                                NULL, NULL);
+
+    expect_recv(&env, requests[1]);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_RECEIVED,
+                                requests[1],
+                                &(avs_coap_response_header_t) {
+                                    .code = responses[1]->response_header.code
+                                },
+                                NULL);
+    expect_observe_start(&env, MAKE_TOKEN("Obserw"));
+    expect_send(&env, responses[1]);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_CLEANUP, NULL,
+                                NULL, NULL);
+
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(
+            env.coap_ctx, test_accept_new_request, &env));
+
+    // only the observation with the shorter token is cancelled
+    expect_recv(&env, requests[2]);
+    expect_observe_cancel(&env, MAKE_TOKEN("Obs"));
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_RECEIVED,
+                                requests[2],
+                                &(avs_coap_response_header_t) {
+                                    .code = responses[2]->response_header.code
+                                },
+                                NULL);
+    expect_send(&env, responses[2]);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_CLEANUP, NULL,
+                                NULL, NULL);
+
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(
+            env.coap_ctx, test_accept_new_request, &env));
+
+    // the other one is cancelled by cleanup
+    expect_observe_cancel(&env, MAKE_TOKEN("Obserw"));
+}
+
 AVS_UNIT_TEST(udp_observe, notify_async) {
 #define NOTIFY_PAYLOAD "Notifaj"
     test_env_t env __attribute__((cleanup(test_teardown_late_expects_check))) =
@@ -535,6 +603,81 @@ AVS_UNIT_TEST(udp_observe, notify_async_delayed_reset_response) {
 #undef NOTIFY_PAYLOAD
 }
 
+AVS_UNIT_TEST(udp_observe, notify_async_delayed_reset_response_large_cache) {
+#define NOTIFY_PAYLOAD "Notifaj"
+#define NOTIFY_CACHE_SIZE 256
+#define NUM_NOTIFICATIONS 1000
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_with_notify_cache(NULL, 4096, 4096, NULL,
+                                         NOTIFY_CACHE_SIZE);
+
+    const test_msg_t *request =
+            COAP_MSG(CON, GET, ID(100), MAKE_TOKEN("Obserw"), OBSERVE(0),
+                     NO_PAYLOAD);
+    const test_msg_t *response =
+            COAP_MSG(ACK, CONTENT, ID(100), MAKE_TOKEN("Obserw"), OBSERVE(0),
+                     NO_PAYLOAD);
+
+    expect_recv(&env, request);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_RECEIVED, request,
+                                &(avs_coap_response_header_t) {
+                                    .code = response->response_header.code
+                                },
+                                NULL);
+    expect_observe_start(&env, MAKE_TOKEN("Obserw"));
+    expect_send(&env, response);
+    expect_request_handler_call(&env, AVS_COAP_SERVER_REQUEST_CLEANUP, NULL,
+                                NULL, NULL);
+
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(
+            env.coap_ctx, test_accept_new_request, &env));
+
+    avs_coap_observe_id_t observe_id = {
+        .token = request->msg.token
+    };
+    test_payload_writer_args_t test_payload = {
+        .payload = NOTIFY_PAYLOAD,
+        .payload_size = sizeof(NOTIFY_PAYLOAD) - 1
+    };
+
+    // Send many more notifications than the cache can hold, so that the ring
+    // buffer wraps around multiple times
+    for (size_t i = 0; i < NUM_NOTIFICATIONS; ++i) {
+        const test_msg_t *notify =
+                COAP_MSG(NON, CONTENT, ID((uint16_t) i), MAKE_TOKEN("Obserw"),
+                         OBSERVE((uint32_t) (i + 1)), PAYLOAD(NOTIFY_PAYLOAD));
+
+        expect_send(&env, notify);
+
+        avs_coap_exchange_id_t id;
+        test_payload.expected_payload_offset = 0;
+        ASSERT_OK(avs_coap_notify_async(
+                env.coap_ctx, &id, observe_id, &notify->response_header,
+                AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE, test_payload_writer,
+                &test_payload, NULL, NULL));
+        ASSERT_FALSE(avs_coap_exchange_id_valid(id));
+    }
+
+    const uint16_t oldest_id_in_cache = NUM_NOTIFICATIONS - NOTIFY_CACHE_SIZE;
+
+    // Reset to an already evicted Notify should be ignored
+    expect_recv(&env, COAP_MSG(RST, EMPTY, ID(oldest_id_in_cache - 1),
+                               NO_PAYLOAD));
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+
+    // Reset response to the oldest cached Notify should trigger observe
+    // cancellation
+    expect_recv(&env, COAP_MSG(RST, EMPTY, ID(oldest_id_in_cache), NO_PAYLOAD));
+    expect_observe_cancel(&env, MAKE_TOKEN("Obserw"));
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_async_handle_incoming_packet(env.coap_ctx, NULL, NULL));
+#undef NUM_NOTIFICATIONS
+#undef NOTIFY_CACHE_SIZE
+#undef NOTIFY_PAYLOAD
+}
+
 AVS_UNIT_TEST(udp_observe, notify_async_send_error) {
 #define NOTIFY_PAYLOAD "Notifaj"
     test_env_t env __attribute__((cleanup(test_teardown_late_expects_check))) =
@@ -420,3 +420,110 @@ AVS_UNIT_TEST(coap_msg_cache, multiple_hosts_same_ids) {
 
     avs_coap_udp_response_cache_release(&cache);
 }
+
+static avs_coap_udp_msg_t msg_with_payload(uint16_t msg_id,
+                                           const char *payload,
+                                           size_t payload_size) {
+    return (avs_coap_udp_msg_t) {
+        .header = _avs_coap_udp_header_init(AVS_COAP_UDP_TYPE_ACKNOWLEDGEMENT,
+                                            0, AVS_COAP_CODE(2, 5), msg_id),
+        .payload = payload,
+        .payload_size = payload_size
+    };
+}
+
+static const char VARIED_PAYLOAD[] = "0123456789abcdef";
+
+static avs_coap_udp_msg_t varied_size_msg(uint16_t msg_id) {
+    return msg_with_payload(msg_id, VARIED_PAYLOAD,
+                            (msg_id * 7u) % sizeof(VARIED_PAYLOAD));
+}
+
+AVS_UNIT_TEST(coap_msg_cache, lookup_after_buffer_wraps) {
+    // Entries of different sizes make the buffer wrap around, and evict one or
+    // more entries at a time. Every cached entry must still be found at its
+    // current position, and only the oldest ones may be missing.
+    const avs_coap_udp_msg_t largest = msg_with_payload(
+            0, VARIED_PAYLOAD, sizeof(VARIED_PAYLOAD) - 1);
+    avs_coap_udp_response_cache_t *cache = avs_coap_udp_response_cache_create(
+            (_avs_coap_udp_response_cache_overhead(&largest)
+             + _avs_coap_udp_msg_size(&largest))
+            * 4);
+    ASSERT_NOT_NULL(cache);
+
+    for (uint16_t id = 0; id < 40; ++id) {
+        const avs_coap_udp_msg_t msg = varied_size_msg(id);
+        ASSERT_OK(_avs_coap_udp_response_cache_add(cache, "host", "port", &msg,
+                                                   &tx_params));
+
+        size_t found = 0;
+        for (uint16_t older = (uint16_t) (id + 1); older-- > 0;) {
+            avs_coap_udp_cached_response_t cached_msg;
+            if (avs_is_err(_avs_coap_udp_response_cache_get(
+                        cache, "host", "port", older, &cached_msg))) {
+                break;
+            }
+            assert_udp_msg_equal(varied_size_msg(older), cached_msg.msg);
+            ++found;
+        }
+        ASSERT_TRUE(found >= AVS_MIN((size_t) id + 1, 4));
+        for (uint16_t evicted = 0; evicted + found <= id; ++evicted) {
+            ASSERT_FAIL(_avs_coap_udp_response_cache_get(
+                    cache, "host", "port", evicted,
+                    &(avs_coap_udp_cached_response_t) { 0 }));
+        }
+    }
+
+    avs_coap_udp_response_cache_release(&cache);
+}
+
+#define CLUSTERED_WINDOW 16
+
+static const char *clustered_host(uint16_t seq) {
+    return seq % 2 ? "host1" : "host2";
+}
+
+static avs_coap_udp_msg_t clustered_msg(uint16_t seq) {
+    // consecutive pairs of entries share the message ID, and differ by host;
+    // the one-byte payload tells them apart
+    return msg_with_payload((uint16_t) (seq / 2), seq % 2 ? "1" : "2", 1);
+}
+
+AVS_UNIT_TEST(coap_msg_cache, evict_from_probe_sequences) {
+    // With entries this small, the index is nearly as full as it gets, so
+    // evicting an entry often leaves others after it in the same probe
+    // sequence. They need to remain reachable after it is removed.
+    const avs_coap_udp_msg_t first_msg = clustered_msg(0);
+    avs_coap_udp_response_cache_t *cache = avs_coap_udp_response_cache_create(
+            (_avs_coap_udp_response_cache_overhead(&first_msg)
+             + _avs_coap_udp_msg_size(&first_msg))
+            * CLUSTERED_WINDOW);
+    ASSERT_NOT_NULL(cache);
+
+    for (uint16_t seq = 0; seq < 4 * CLUSTERED_WINDOW; ++seq) {
+        const avs_coap_udp_msg_t msg = clustered_msg(seq);
+        ASSERT_OK(_avs_coap_udp_response_cache_add(cache, clustered_host(seq),
+                                                   "port", &msg, &tx_params));
+
+        const uint16_t oldest =
+                seq >= CLUSTERED_WINDOW ? seq - (CLUSTERED_WINDOW - 1) : 0;
+        for (uint16_t cached = oldest; cached <= seq; ++cached) {
+            const avs_coap_udp_msg_t cached_expected = clustered_msg(cached);
+            avs_coap_udp_cached_response_t cached_msg;
+            ASSERT_OK(_avs_coap_udp_response_cache_get(
+                    cache, clustered_host(cached), "port",
+                    _avs_coap_udp_header_get_id(&cached_expected.header),
+                    &cached_msg));
+            assert_udp_msg_equal(cached_expected, cached_msg.msg);
+        }
+        if (oldest > 0) {
+            const avs_coap_udp_msg_t evicted = clustered_msg(oldest - 1);
+            ASSERT_FAIL(_avs_coap_udp_response_cache_get(
+                    cache, clustered_host(oldest - 1), "port",
+                    _avs_coap_udp_header_get_id(&evicted.header),
+                    &(avs_coap_udp_cached_response_t) { 0 }));
+        }
+    }
+
+    avs_coap_udp_response_cache_release(&cache);
+}
@@ -34,6 +34,8 @@ typedef struct {
     avs_coap_response_header_t response_header;
     const char *response_data;
     size_t response_data_size;
+
+    size_t calls;
 } streaming_handle_request_args_t;
 
 static int streaming_handle_request(avs_coap_streaming_request_ctx_t *ctx,
@@ -46,6 +48,7 @@ static int streaming_handle_request(avs_coap_streaming_request_ctx_t *ctx,
 
     (void) observe_id;
 
+    ++args->calls;
     ASSERT_NOT_NULL(ctx);
     ASSERT_NOT_NULL(request);
     ASSERT_NOT_NULL(payload_stream);
@@ -566,6 +569,314 @@ AVS_UNIT_TEST(udp_streaming_server, incorrect_block2_in_block1_request) {
 #    undef REQUEST_PAYLOAD
 }
 
+AVS_UNIT_TEST(udp_streaming_server, block1_across_calls) {
+#    define REQUEST_PAYLOAD DATA_1KB "?"
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, PUT, ID(0), TOKEN(nth_token(0)),
+                 BLOCK1_REQ(0, 512, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(1), TOKEN(nth_token(1)),
+                 BLOCK1_REQ(1, 512, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(2), TOKEN(nth_token(2)),
+                 BLOCK1_REQ(2, 512, REQUEST_PAYLOAD)),
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTINUE, ID(0), TOKEN(nth_token(0)),
+                 BLOCK1_RES(0, 512, true)),
+        COAP_MSG(ACK, CONTINUE, ID(1), TOKEN(nth_token(1)),
+                 BLOCK1_RES(1, 512, true)),
+        COAP_MSG(ACK, CHANGED, ID(2), TOKEN(nth_token(2)),
+                 BLOCK1_RES(2, 512, false)),
+    };
+
+    streaming_handle_request_args_t args = {
+        // NOTE: user handler is given the first BLOCK1 request header
+        .expected_request_header = requests[0]->request_header,
+        .expected_request_data = REQUEST_PAYLOAD,
+        .expected_request_data_size = sizeof(REQUEST_PAYLOAD) - 1,
+        .response_header = {
+            .code = responses[2]->response_header.code
+        },
+    };
+
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            env.mocksock, avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    // each chunk arrives in a separate call; the user handler is called only
+    // after the last one
+    AVS_STATIC_ASSERT(AVS_ARRAY_SIZE(requests) == AVS_ARRAY_SIZE(responses),
+                      mismatched_request_response_count);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        ASSERT_EQ(args.calls, 0);
+        expect_recv(&env, requests[i]);
+        expect_send(&env, responses[i]);
+        expect_timeout(&env);
+        ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+                env.coap_ctx, streaming_handle_request, &args));
+    }
+    ASSERT_EQ(args.calls, 1);
+#    undef REQUEST_PAYLOAD
+}
+
+AVS_UNIT_TEST(udp_streaming_server, block2_across_calls) {
+#    define RESPONSE_PAYLOAD DATA_1KB "!"
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, GET, ID(0), TOKEN(nth_token(0))),
+        COAP_MSG(CON, GET, ID(1), TOKEN(nth_token(1)), BLOCK2_REQ(1, 1024)),
+        // retransmitted requests for already sent blocks are also served
+        // from the buffer
+        COAP_MSG(CON, GET, ID(2), TOKEN(nth_token(2)), BLOCK2_REQ(1, 1024)),
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTENT, ID(0), TOKEN(nth_token(0)),
+                 BLOCK2_RES(0, 1024, RESPONSE_PAYLOAD)),
+        COAP_MSG(ACK, CONTENT, ID(1), TOKEN(nth_token(1)),
+                 BLOCK2_RES(1, 1024, RESPONSE_PAYLOAD)),
+        COAP_MSG(ACK, CONTENT, ID(2), TOKEN(nth_token(2)),
+                 BLOCK2_RES(1, 1024, RESPONSE_PAYLOAD)),
+    };
+
+    streaming_handle_request_args_t args = {
+        .expected_request_header = requests[0]->request_header,
+        .response_header = {
+            .code = responses[0]->response_header.code
+        },
+        .response_data = RESPONSE_PAYLOAD,
+        .response_data_size = sizeof(RESPONSE_PAYLOAD) - 1
+    };
+
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            env.mocksock, avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    AVS_STATIC_ASSERT(AVS_ARRAY_SIZE(requests) == AVS_ARRAY_SIZE(responses),
+                      mismatched_request_response_count);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        expect_recv(&env, requests[i]);
+        expect_send(&env, responses[i]);
+        expect_timeout(&env);
+        ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+                env.coap_ctx, streaming_handle_request, &args));
+        // the response is generated once, in the first call
+        ASSERT_EQ(args.calls, 1);
+    }
+#    undef RESPONSE_PAYLOAD
+}
+
+AVS_UNIT_TEST(udp_streaming_server, interleaved_requests) {
+#    define REQUEST_PAYLOAD DATA_1KB "?"
+#    define RESPONSE_PAYLOAD DATA_1KB "!"
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *requests_a[] = {
+        COAP_MSG(CON, PUT, ID(0), TOKEN(nth_token(0)), PATH("a"),
+                 BLOCK1_REQ(0, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(3), TOKEN(nth_token(3)), PATH("a"),
+                 BLOCK1_REQ(1, 1024, REQUEST_PAYLOAD)),
+    };
+    const test_msg_t *responses_a[] = {
+        COAP_MSG(ACK, CONTINUE, ID(0), TOKEN(nth_token(0)),
+                 BLOCK1_RES(0, 1024, true)),
+        COAP_MSG(ACK, CHANGED, ID(3), TOKEN(nth_token(3)),
+                 BLOCK1_RES(1, 1024, false)),
+    };
+    const test_msg_t *requests_b[] = {
+        COAP_MSG(CON, PUT, ID(1), TOKEN(nth_token(1)), PATH("b"),
+                 BLOCK1_REQ(0, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(2), TOKEN(nth_token(2)), PATH("b"),
+                 BLOCK1_REQ(1, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(4), TOKEN(nth_token(4)), PATH("b"),
+                 BLOCK2_REQ(1, 1024)),
+    };
+    const test_msg_t *responses_b[] = {
+        COAP_MSG(ACK, CONTINUE, ID(1), TOKEN(nth_token(1)),
+                 BLOCK1_RES(0, 1024, true)),
+        COAP_MSG(ACK, CONTENT, ID(2), TOKEN(nth_token(2)),
+                 BLOCK1_AND_2_RES(1, 1024, 1024, RESPONSE_PAYLOAD)),
+        COAP_MSG(ACK, CONTENT, ID(4), TOKEN(nth_token(4)),
+                 BLOCK2_RES(1, 1024, RESPONSE_PAYLOAD)),
+    };
+
+    streaming_handle_request_args_t args_a = {
+        .expected_request_header = requests_a[0]->request_header,
+        .expected_request_data = REQUEST_PAYLOAD,
+        .expected_request_data_size = sizeof(REQUEST_PAYLOAD) - 1,
+        .response_header = {
+            .code = responses_a[1]->response_header.code
+        },
+    };
+    streaming_handle_request_args_t args_b = {
+        .expected_request_header = requests_b[0]->request_header,
+        .expected_request_data = REQUEST_PAYLOAD,
+        .expected_request_data_size = sizeof(REQUEST_PAYLOAD) - 1,
+        .response_header = {
+            .code = responses_b[1]->response_header.code
+        },
+        .response_data = RESPONSE_PAYLOAD,
+        .response_data_size = sizeof(RESPONSE_PAYLOAD) - 1
+    };
+
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            env.mocksock, avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    // both requests are parked after their first chunks
+    expect_recv(&env, requests_a[0]);
+    expect_send(&env, responses_a[0]);
+    expect_recv(&env, requests_b[0]);
+    expect_send(&env, responses_b[0]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+            env.coap_ctx, streaming_handle_request, &args_a));
+    ASSERT_EQ(args_a.calls, 0);
+
+    // B completes first, with A still parked
+    expect_recv(&env, requests_b[1]);
+    expect_send(&env, responses_b[1]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+            env.coap_ctx, streaming_handle_request, &args_b));
+    ASSERT_EQ(args_b.calls, 1);
+
+    // A completes, then the rest of B's response is served from its buffer
+    expect_recv(&env, requests_a[1]);
+    expect_send(&env, responses_a[1]);
+    expect_recv(&env, requests_b[2]);
+    expect_send(&env, responses_b[2]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+            env.coap_ctx, streaming_handle_request, &args_a));
+    ASSERT_EQ(args_a.calls, 1);
+    ASSERT_EQ(args_b.calls, 1);
+#    undef REQUEST_PAYLOAD
+#    undef RESPONSE_PAYLOAD
+}
+
+AVS_UNIT_TEST(udp_streaming_server, request_larger_than_buffer) {
+#    define REQUEST_PAYLOAD DATA_1KB DATA_1KB "?"
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, PUT, ID(0), TOKEN(nth_token(0)),
+                 BLOCK1_REQ(0, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(1), TOKEN(nth_token(1)),
+                 BLOCK1_REQ(1, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, GET, ID(2), TOKEN(nth_token(2))),
+        COAP_MSG(CON, PUT, ID(3), TOKEN(nth_token(3)),
+                 BLOCK1_REQ(2, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, GET, ID(4), TOKEN(nth_token(4))),
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTINUE, ID(0), TOKEN(nth_token(0)),
+                 BLOCK1_RES(0, 1024, true)),
+        COAP_MSG(ACK, CONTINUE, ID(1), TOKEN(nth_token(1)),
+                 BLOCK1_RES(1, 1024, true)),
+        COAP_MSG(ACK, SERVICE_UNAVAILABLE, ID(2), TOKEN(nth_token(2))),
+        COAP_MSG(ACK, CHANGED, ID(3), TOKEN(nth_token(3)),
+                 BLOCK1_RES(2, 1024, false)),
+        COAP_MSG(ACK, CONTENT, ID(4), TOKEN(nth_token(4))),
+    };
+
+    streaming_handle_request_args_t args = {
+        .expected_request_header = requests[0]->request_header,
+        .expected_request_data = REQUEST_PAYLOAD,
+        .expected_request_data_size = sizeof(REQUEST_PAYLOAD) - 1,
+        .response_header = {
+            .code = responses[3]->response_header.code
+        },
+    };
+
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            env.mocksock, avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    ASSERT_OK(avs_coap_streaming_set_request_limits(env.coap_ctx, 1024, 1));
+
+    // The first chunk fills the limit exactly. The second one crosses it, so
+    // the handler is called right away, and the remaining chunk is received
+    // while it reads the payload. A new request arriving in the meantime is
+    // rejected.
+    AVS_STATIC_ASSERT(AVS_ARRAY_SIZE(requests) == AVS_ARRAY_SIZE(responses),
+                      mismatched_request_response_count);
+    for (size_t i = 0; i < 4; ++i) {
+        expect_recv(&env, requests[i]);
+        expect_send(&env, responses[i]);
+    }
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+            env.coap_ctx, streaming_handle_request, &args));
+    ASSERT_EQ(args.calls, 1);
+
+    // the streamed request no longer counts as pending
+    streaming_handle_request_args_t get_args = {
+        .expected_request_header = requests[4]->request_header,
+        .response_header = {
+            .code = responses[4]->response_header.code
+        },
+    };
+    expect_recv(&env, requests[4]);
+    expect_send(&env, responses[4]);
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+            env.coap_ctx, streaming_handle_request, &get_args));
+    ASSERT_EQ(get_args.calls, 1);
+#    undef REQUEST_PAYLOAD
+}
+
+AVS_UNIT_TEST(udp_streaming_server, too_many_pending_requests) {
+#    define REQUEST_PAYLOAD DATA_1KB "?"
+    test_env_t env __attribute__((cleanup(test_teardown))) =
+            test_setup_default();
+
+    const test_msg_t *requests[] = {
+        COAP_MSG(CON, PUT, ID(0), TOKEN(nth_token(0)), PATH("a"),
+                 BLOCK1_REQ(0, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(1), TOKEN(nth_token(1)), PATH("b"),
+                 BLOCK1_REQ(0, 1024, REQUEST_PAYLOAD)),
+        COAP_MSG(CON, PUT, ID(2), TOKEN(nth_token(2)), PATH("a"),
+                 BLOCK1_REQ(1, 1024, REQUEST_PAYLOAD)),
+    };
+    const test_msg_t *responses[] = {
+        COAP_MSG(ACK, CONTINUE, ID(0), TOKEN(nth_token(0)),
+                 BLOCK1_RES(0, 1024, true)),
+        COAP_MSG(ACK, SERVICE_UNAVAILABLE, ID(1), TOKEN(nth_token(1))),
+        COAP_MSG(ACK, CHANGED, ID(2), TOKEN(nth_token(2)),
+                 BLOCK1_RES(1, 1024, false)),
+    };
+
+    streaming_handle_request_args_t args = {
+        .expected_request_header = requests[0]->request_header,
+        .expected_request_data = REQUEST_PAYLOAD,
+        .expected_request_data_size = sizeof(REQUEST_PAYLOAD) - 1,
+        .response_header = {
+            .code = responses[2]->response_header.code
+        },
+    };
+
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            env.mocksock, avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    ASSERT_OK(avs_coap_streaming_set_request_limits(env.coap_ctx, 4096, 1));
+
+    // a new request is rejected while the first one is parked, which is not
+    // affected by that
+    AVS_STATIC_ASSERT(AVS_ARRAY_SIZE(requests) == AVS_ARRAY_SIZE(responses),
+                      mismatched_request_response_count);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(requests); ++i) {
+        expect_recv(&env, requests[i]);
+        expect_send(&env, responses[i]);
+    }
+    expect_timeout(&env);
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
+            env.coap_ctx, streaming_handle_request, &args));
+    ASSERT_EQ(args.calls, 1);
+#    undef REQUEST_PAYLOAD
+}
+
 static void advance_mockclock(avs_net_socket_t *socket, void *timeout) {
     (void) socket;
     _avs_mock_clock_advance(*(const avs_time_duration_t *) timeout);
@@ -605,9 +916,15 @@ AVS_UNIT_TEST(udp_streaming_server, block1_receive_timed_out) {
                                      .seconds = 300
                                  });
 
-    ASSERT_FAIL(avs_coap_streaming_handle_incoming_packet(
+    // the exchange is parked waiting for further chunks
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
             env.coap_ctx, streaming_handle_request, &args));
 
+    // and then cleaned up by the scheduler, without calling the user handler
+    avs_sched_run(env.sched);
+    ASSERT_FALSE(avs_time_duration_valid(avs_sched_time_to_next(env.sched)));
+    ASSERT_EQ(args.calls, 0);
+
 #    undef REQUEST_PAYLOAD
 }
 
@@ -644,9 +961,14 @@ AVS_UNIT_TEST(udp_streaming_server, block2_receive_timed_out) {
                                      .seconds = 300
                                  });
 
-    ASSERT_FAIL(avs_coap_streaming_handle_incoming_packet(
+    // the buffered response waits for requests for further BLOCK2 chunks
+    ASSERT_OK(avs_coap_streaming_handle_incoming_packet(
             env.coap_ctx, streaming_handle_request, &args));
 
+    avs_sched_run(env.sched);
+    ASSERT_FALSE(avs_time_duration_valid(avs_sched_time_to_next(env.sched)));
+    ASSERT_EQ(args.calls, 1);
+
 #    undef RESPONSE_PAYLOAD
 }
 
@@ -531,10 +531,12 @@ typedef struct {
 } test_env_t;
 
 static inline test_env_t
-test_setup_without_socket(const avs_coap_udp_tx_params_t *tx_params,
-                          size_t in_buffer_size,
-                          size_t out_buffer_size,
-                          avs_coap_udp_response_cache_t *cache) {
+test_setup_without_socket_with_notify_cache(
+        const avs_coap_udp_tx_params_t *tx_params,
+        size_t in_buffer_size,
+        size_t out_buffer_size,
+        avs_coap_udp_response_cache_t *cache,
+        size_t notify_cache_size) {
     reset_token_generator();
     avs_shared_buffer_t *in_buf = avs_shared_buffer_new(in_buffer_size);
     avs_shared_buffer_t *out_buf = avs_shared_buffer_new(out_buffer_size);
@@ -551,7 +553,7 @@ test_setup_without_socket(const avs_coap_udp_tx_params_t *tx_params,
         .in_buffer = in_buf,
         .out_buffer = out_buf,
         .coap_ctx = avs_coap_udp_ctx_create(sched, &env.tx_params, in_buf,
-                                            out_buf, cache),
+                                            out_buf, cache, notify_cache_size),
         .response_cache = cache
     };
 
@@ -562,12 +564,24 @@ test_setup_without_socket(const avs_coap_udp_tx_params_t *tx_params,
     return env;
 }
 
-static inline test_env_t test_setup(const avs_coap_udp_tx_params_t *tx_params,
-                                    size_t in_buffer_size,
-                                    size_t out_buffer_size,
-                                    avs_coap_udp_response_cache_t *cache) {
-    test_env_t env = test_setup_without_socket(tx_params, in_buffer_size,
-                                               out_buffer_size, cache);
+static inline test_env_t
+test_setup_without_socket(const avs_coap_udp_tx_params_t *tx_params,
+                          size_t in_buffer_size,
+                          size_t out_buffer_size,
+                          avs_coap_udp_response_cache_t *cache) {
+    return test_setup_without_socket_with_notify_cache(
+            tx_params, in_buffer_size, out_buffer_size, cache, 0);
+}
+
+static inline test_env_t
+test_setup_with_notify_cache(const avs_coap_udp_tx_params_t *tx_params,
+                             size_t in_buffer_size,
+                             size_t out_buffer_size,
+                             avs_coap_udp_response_cache_t *cache,
+                             size_t notify_cache_size) {
+    test_env_t env = test_setup_without_socket_with_notify_cache(
+            tx_params, in_buffer_size, out_buffer_size, cache,
+            notify_cache_size);
 
     avs_net_socket_t *socket = NULL;
     avs_unit_mocksock_create_datagram(&socket);
@@ -587,6 +601,14 @@ static inline test_env_t test_setup(const avs_coap_udp_tx_params_t *tx_params,
     return env;
 }
 
+static inline test_env_t test_setup(const avs_coap_udp_tx_params_t *tx_params,
+                                    size_t in_buffer_size,
+                                    size_t out_buffer_size,
+                                    avs_coap_udp_response_cache_t *cache) {
+    return test_setup_with_notify_cache(tx_params, in_buffer_size,
+                                        out_buffer_size, cache, 0);
+}
+
 static inline test_env_t test_setup_with_nstart(size_t nstart) {
     avs_coap_udp_tx_params_t tx_params = AVS_COAP_DEFAULT_UDP_TX_PARAMS;
     tx_params.nstart = nstart;
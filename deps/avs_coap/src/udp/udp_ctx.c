@@ -21,8 +21,11 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include <avsystem/commons/errno.h>
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/rbtree.h>
 #include <avsystem/commons/shared_buffer.h>
 #include <avsystem/commons/socket.h>
 #include <avsystem/commons/utils.h>
@@ -44,22 +47,31 @@
 
 VISIBILITY_SOURCE_BEGIN
 
+typedef struct avs_coap_udp_unconfirmed_msg_struct
+        avs_coap_udp_unconfirmed_msg_t;
+
 /**
  * Owning wrapper around an unconfirmed outgoing CoAP/UDP message.
  *
- * List of CoAP/UDP exchanges is kept sorted by (hold, next_retransmit) tuple:
+ * Unconfirmed CoAP/UDP exchanges are logically ordered by
+ * (hold, next_retransmit) tuple, but are stored in two separate queues:
  *
- * - up to NSTART first entries are "not held", i.e. are currently being
- *   retransmitted,
+ * - up to NSTART entries are "not held", i.e. are currently being
+ *   retransmitted. These are kept in a binary min-heap ordered by
+ *   (next_retransmit, enqueue_seq),
  *
  * - if more than NSTART exchanges were created, the rest is "held",
- *   i.e. not transmitted at all to honor NSTART defined by RFC7252.
+ *   i.e. not transmitted at all to honor NSTART defined by RFC7252. These are
+ *   kept in a FIFO queue, so that they are resumed in creation order.
  *
  * Whenever an exchange is retransmitted, next_retransmit is updated to the
- * time of a next retransmission, and the exchange entry moved to appropriate
- * place in the exchange list to keep described ordering.
+ * time of a next retransmission, and the exchange entry is moved to
+ * appropriate place in the heap to keep described ordering.
+ *
+ * All enqueued messages are additionally indexed by message ID and by token,
+ * so that incoming messages can be matched without scanning the queues.
  */
-typedef struct {
+struct avs_coap_udp_unconfirmed_msg_struct {
     /** Handler to call when context is done with the message */
     avs_coap_send_result_handler_t *send_result_handler;
     /** Opaque argument to pass to send_result_handler */
@@ -73,6 +85,39 @@ typedef struct {
     /** Time at which this packet has to be retransmitted next time. */
     avs_time_monotonic_t next_retransmit;
 
+    /**
+     * Sequence number assigned whenever the message is put into one of the
+     * queues. Keeps FIFO order among messages with equal next_retransmit.
+     */
+    uint64_t enqueue_seq;
+
+    /**
+     * Immutable sequence number assigned at creation. Used to order index
+     * entries with equal keys (message ID or token).
+     */
+    uint64_t serial;
+
+    /** Message ID of @ref avs_coap_udp_unconfirmed_msg_t#msg . */
+    uint16_t msg_id;
+
+    /** True if the message is currently enqueued and indexed. */
+    bool enqueued;
+
+    /** Position in the retransmission heap. Valid only if enqueued and not
+     * held. */
+    size_t heap_index;
+
+    /** Neighbours in the held messages queue. Valid only if enqueued and
+     * held. */
+    avs_coap_udp_unconfirmed_msg_t *held_prev;
+    avs_coap_udp_unconfirmed_msg_t *held_next;
+
+    /**
+     * Entry of the token index pointing to this message. Owned by this
+     * object; attached to the index only while the message is enqueued.
+     */
+    AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t *) token_index_entry;
+
     /** CoAP message view. Points to @ref avs_coap_udp_exchange_t#packet . */
     avs_coap_udp_msg_t msg;
 
@@ -81,16 +126,18 @@ typedef struct {
 
     /** Serialized packet data. */
     uint8_t packet[];
-} avs_coap_udp_unconfirmed_msg_t;
+};
 
 #ifdef WITH_AVS_COAP_OBSERVE
 typedef struct {
     uint16_t msg_id;
     avs_coap_token_t token;
+    /** False if the entry was dropped before being evicted from the ring. */
+    bool valid;
 } avs_coap_udp_sent_notify_t;
 
 /**
- * Fixed-size cache with queue semantics used to store (message ID, token)
+ * Fixed-capacity cache with queue semantics used to store (message ID, token)
  * pairs of recently sent notification messages.
  *
  * RFC 7641 defines Reset response to sent notification to be a preferred
@@ -98,77 +145,171 @@ typedef struct {
  * match incoming Reset messages to established observations so that we can
  * cancel them.
  *
+ * Entries are stored in a ring buffer, so that the oldest one may be evicted
+ * in O(1), and indexed by message ID in an open-addressing hash table, so
+ * that lookups are O(1) as well. The capacity is configured at context
+ * creation time, and should be large enough to hold all notifications sent
+ * during the time a Reset response may be expected.
+ *
  * Technically, entries in this cache should expire after MAX_TRANSMIT_WAIT
  * since the first retransmission, but we keep them around as long as there
  * is enough space and we don't try to reuse the same message ID. That means
  * some Reset messages may not cancel observations if notifications are
- * generated at a high rate, or that Reset messages that come later are still
- * handled as valid observe cancellation.
- *
- * This implementation trades correctness in all cases for simplicity.
+ * generated at a rate too high for the configured capacity, or that Reset
+ * messages that come later are still handled as valid observe cancellation.
  */
 typedef struct {
-    avs_coap_udp_sent_notify_t entries[COAP_UDP_NOTIFY_CACHE_SIZE];
+    /** Ring buffer of @ref capacity entries. */
+    avs_coap_udp_sent_notify_t *entries;
+    size_t capacity;
+    /** Position of the oldest entry in @ref entries . */
+    size_t head;
+    /** Number of occupied ring positions, including dropped entries. */
     size_t size;
+
+    /**
+     * Hash table with linear probing, mapping message IDs to positions in
+     * @ref entries ; SIZE_MAX marks an empty slot. Its size is a power of two
+     * at least twice as large as @ref capacity .
+     */
+    size_t *index;
+    size_t index_mask;
 } avs_coap_udp_notify_cache_t;
 
 AVS_STATIC_ASSERT(COAP_UDP_NOTIFY_CACHE_SIZE > 0,
                   notify_cache_must_have_at_least_one_element);
 
-static inline const avs_coap_token_t *
-coap_udp_notify_cache_get(const avs_coap_udp_notify_cache_t *cache,
-                          uint16_t msg_id) {
-    for (size_t i = 0; i < cache->size; ++i) {
-        if (cache->entries[i].msg_id == msg_id) {
-            return &cache->entries[i].token;
-        }
+static avs_error_t
+coap_udp_notify_cache_init(avs_coap_udp_notify_cache_t *cache,
+                           size_t capacity) {
+    if (!capacity) {
+        capacity = COAP_UDP_NOTIFY_CACHE_SIZE;
+    }
+    size_t index_size = 1;
+    while (index_size < 2 * capacity) {
+        index_size *= 2;
+    }
+
+    *cache = (avs_coap_udp_notify_cache_t) {
+        .entries = (avs_coap_udp_sent_notify_t *) avs_calloc(
+                capacity, sizeof(avs_coap_udp_sent_notify_t)),
+        .capacity = capacity,
+        .index = (size_t *) avs_malloc(index_size * sizeof(size_t)),
+        .index_mask = index_size - 1
+    };
+    if (!cache->entries || !cache->index) {
+        avs_free(cache->entries);
+        avs_free(cache->index);
+        return avs_errno(AVS_ENOMEM);
     }
+    for (size_t i = 0; i < index_size; ++i) {
+        cache->index[i] = SIZE_MAX;
+    }
+    return AVS_OK;
+}
 
-    return NULL;
+static void coap_udp_notify_cache_cleanup(avs_coap_udp_notify_cache_t *cache) {
+    avs_free(cache->entries);
+    avs_free(cache->index);
 }
 
-static inline void
-coap_udp_notify_cache_drop_entry(avs_coap_udp_notify_cache_t *cache,
-                                 avs_coap_udp_sent_notify_t *entry) {
-    const avs_coap_udp_sent_notify_t *end = cache->entries + cache->size;
+static inline size_t coap_udp_notify_cache_hash(uint16_t msg_id) {
+    uint32_t hash = (uint32_t) msg_id * UINT32_C(2654435761);
+    return (size_t) (hash ^ (hash >> 16));
+}
 
-    assert(cache->entries <= entry && entry < cache->entries + cache->size);
-    assert(entry < end);
+static size_t *
+coap_udp_notify_cache_find_slot(const avs_coap_udp_notify_cache_t *cache,
+                                uint16_t msg_id) {
+    for (size_t i = coap_udp_notify_cache_hash(msg_id) & cache->index_mask;;
+         i = (i + 1) & cache->index_mask) {
+        if (cache->index[i] == SIZE_MAX) {
+            return NULL;
+        }
+        if (cache->entries[cache->index[i]].msg_id == msg_id) {
+            return &cache->index[i];
+        }
+    }
+}
 
-    memmove(entry, entry + 1,
-            (size_t) (end - entry - 1) * sizeof(cache->entries[0]));
-    --cache->size;
+static void
+coap_udp_notify_cache_remove_slot(avs_coap_udp_notify_cache_t *cache,
+                                  size_t *slot) {
+    size_t hole = (size_t) (slot - cache->index);
+    // backward shift deletion: move subsequent entries of the probe sequence
+    // into the hole, so that no tombstones are necessary
+    for (size_t i = (hole + 1) & cache->index_mask;
+         cache->index[i] != SIZE_MAX;
+         i = (i + 1) & cache->index_mask) {
+        size_t home = coap_udp_notify_cache_hash(
+                              cache->entries[cache->index[i]].msg_id)
+                      & cache->index_mask;
+        // move the entry only if its home slot is not within (hole, i]
+        if (((i - home) & cache->index_mask)
+                >= ((i - hole) & cache->index_mask)) {
+            cache->index[hole] = cache->index[i];
+            hole = i;
+        }
+    }
+    cache->index[hole] = SIZE_MAX;
+}
+
+static inline const avs_coap_token_t *
+coap_udp_notify_cache_get(const avs_coap_udp_notify_cache_t *cache,
+                          uint16_t msg_id) {
+    const size_t *slot = coap_udp_notify_cache_find_slot(cache, msg_id);
+    if (slot) {
+        return &cache->entries[*slot].token;
+    }
+    return NULL;
 }
 
 static inline void
 coap_udp_notify_cache_drop(avs_coap_udp_notify_cache_t *cache,
                            uint16_t msg_id) {
-    for (size_t i = 0; i < cache->size; ++i) {
-        if (cache->entries[i].msg_id == msg_id) {
-            coap_udp_notify_cache_drop_entry(cache, &cache->entries[i]);
-
-            // cache is not supposed to have more than one entry with the same
-            // ID at the same time
-            assert(coap_udp_notify_cache_get(cache, msg_id) == NULL);
-            return;
-        }
+    size_t *slot = coap_udp_notify_cache_find_slot(cache, msg_id);
+    if (slot) {
+        // the ring position stays occupied until evicted
+        cache->entries[*slot].valid = false;
+        coap_udp_notify_cache_remove_slot(cache, slot);
+
+        // cache is not supposed to have more than one entry with the same
+        // ID at the same time
+        assert(coap_udp_notify_cache_get(cache, msg_id) == NULL);
     }
 }
 
 static inline void coap_udp_notify_cache_put(avs_coap_udp_notify_cache_t *cache,
                                              uint16_t msg_id,
                                              const avs_coap_token_t *token) {
-    if (cache->size == AVS_ARRAY_SIZE(cache->entries)) {
-        coap_udp_notify_cache_drop_entry(cache, &cache->entries[0]);
+    assert(!coap_udp_notify_cache_get(cache, msg_id));
+
+    if (cache->size == cache->capacity) {
+        avs_coap_udp_sent_notify_t *oldest = &cache->entries[cache->head];
+        if (oldest->valid) {
+            size_t *slot =
+                    coap_udp_notify_cache_find_slot(cache, oldest->msg_id);
+            assert(slot && *slot == cache->head);
+            coap_udp_notify_cache_remove_slot(cache, slot);
+        }
+        cache->head = (cache->head + 1) % cache->capacity;
+        --cache->size;
     }
-    assert(cache->size < AVS_ARRAY_SIZE(cache->entries));
+    assert(cache->size < cache->capacity);
 
-    cache->entries[cache->size] = (avs_coap_udp_sent_notify_t) {
+    const size_t pos = (cache->head + cache->size) % cache->capacity;
+    cache->entries[pos] = (avs_coap_udp_sent_notify_t) {
         .msg_id = msg_id,
-        .token = *token
+        .token = *token,
+        .valid = true
     };
-
     ++cache->size;
+
+    size_t i = coap_udp_notify_cache_hash(msg_id) & cache->index_mask;
+    while (cache->index[i] != SIZE_MAX) {
+        i = (i + 1) & cache->index_mask;
+    }
+    cache->index[i] = pos;
 }
 #endif // WITH_AVS_COAP_OBSERVE
 
@@ -177,7 +318,34 @@ typedef struct {
 
     avs_coap_base_t base;
 
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed_messages;
+    /**
+     * Unconfirmed messages. See avs_coap_udp_unconfirmed_msg_t for description
+     * of the ordering.
+     */
+    struct {
+        /** Binary min-heap of started (not held) messages. */
+        avs_coap_udp_unconfirmed_msg_t **heap;
+        size_t heap_size;
+        /**
+         * Allocated size of @ref heap. Never less than num_allocated, so that
+         * moving messages between queues never needs to allocate memory.
+         */
+        size_t heap_capacity;
+
+        /** FIFO queue of held messages. */
+        avs_coap_udp_unconfirmed_msg_t *held_head;
+        avs_coap_udp_unconfirmed_msg_t *held_tail;
+        size_t held_count;
+
+        /** Enqueued messages, ordered by (msg_id, serial). */
+        AVS_RBTREE(avs_coap_udp_unconfirmed_msg_t) by_msg_id;
+        /** Enqueued messages, ordered by (token, serial). */
+        AVS_RBTREE(avs_coap_udp_unconfirmed_msg_t *) by_token;
+
+        /** Number of existing messages, including detached ones. */
+        size_t num_allocated;
+        uint64_t last_seq;
+    } unconfirmed;
 
     avs_net_socket_t *socket;
     size_t last_mtu;
@@ -270,18 +438,11 @@ static uint16_t generate_id(avs_coap_udp_ctx_t *ctx) {
 }
 
 static size_t current_nstart(const avs_coap_udp_ctx_t *ctx) {
-    size_t started = 0;
-
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) msg;
-    AVS_LIST_FOREACH(msg, ctx->unconfirmed_messages) {
-        if (!msg->hold) {
-            ++started;
-        } else {
-            break;
-        }
-    }
+    return ctx->unconfirmed.heap_size;
+}
 
-    return started;
+static size_t unconfirmed_count(const avs_coap_udp_ctx_t *ctx) {
+    return ctx->unconfirmed.heap_size + ctx->unconfirmed.held_count;
 }
 
 static void _log_udp_msg_summary(const char *file,
@@ -396,44 +557,261 @@ static avs_time_monotonic_t get_first_retransmit_time(avs_coap_udp_ctx_t *ctx) {
                                   initial_state.recv_timeout);
 }
 
-static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_unconfirmed_insert_ptr(avs_coap_udp_ctx_t *ctx,
-                            const avs_coap_udp_unconfirmed_msg_t *new_elem) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *list_ptr = (AVS_LIST(
-            avs_coap_udp_unconfirmed_msg_t) *) &ctx->unconfirmed_messages;
+static int compare_u64(uint64_t left, uint64_t right) {
+    if (left < right) {
+        return -1;
+    }
+    return left > right;
+}
+
+static int unconfirmed_by_msg_id_cmp(const void *left_, const void *right_) {
+    const avs_coap_udp_unconfirmed_msg_t *left =
+            (const avs_coap_udp_unconfirmed_msg_t *) left_;
+    const avs_coap_udp_unconfirmed_msg_t *right =
+            (const avs_coap_udp_unconfirmed_msg_t *) right_;
+    if (left->msg_id != right->msg_id) {
+        return left->msg_id < right->msg_id ? -1 : 1;
+    }
+    return compare_u64(left->serial, right->serial);
+}
 
-    AVS_LIST_ITERATE_PTR(list_ptr) {
-        if (!new_elem->hold && (*list_ptr)->hold) {
-            return list_ptr;
-        } else if (new_elem->hold == (*list_ptr)->hold
-                   && avs_time_monotonic_before(new_elem->next_retransmit,
-                                                (*list_ptr)->next_retransmit)) {
-            return list_ptr;
-        }
+static int token_cmp(const avs_coap_token_t *left,
+                     const avs_coap_token_t *right) {
+    if (left->size != right->size) {
+        return left->size < right->size ? -1 : 1;
     }
+    return memcmp(left->bytes, right->bytes, left->size);
+}
 
-    assert(list_ptr);
-    assert(*list_ptr == NULL);
-    return list_ptr;
+static int unconfirmed_by_token_cmp(const void *left_, const void *right_) {
+    const avs_coap_udp_unconfirmed_msg_t *left =
+            *(avs_coap_udp_unconfirmed_msg_t *const *) left_;
+    const avs_coap_udp_unconfirmed_msg_t *right =
+            *(avs_coap_udp_unconfirmed_msg_t *const *) right_;
+    int result = token_cmp(&left->msg.token, &right->msg.token);
+    if (result) {
+        return result;
+    }
+    return compare_u64(left->serial, right->serial);
 }
 
-static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_first_held_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr;
+/**
+ * Returns true if @p left comes before @p right in the logical ordering of
+ * unconfirmed messages, as described in avs_coap_udp_unconfirmed_msg_t docs.
+ */
+static bool unconfirmed_before(const avs_coap_udp_unconfirmed_msg_t *left,
+                               const avs_coap_udp_unconfirmed_msg_t *right) {
+    if (left->hold != right->hold) {
+        return !left->hold;
+    }
+    if (avs_time_monotonic_before(left->next_retransmit,
+                                  right->next_retransmit)) {
+        return true;
+    }
+    if (avs_time_monotonic_before(right->next_retransmit,
+                                  left->next_retransmit)) {
+        return false;
+    }
+    return left->enqueue_seq < right->enqueue_seq;
+}
 
-    AVS_LIST_FOREACH_PTR(unconfirmed_ptr, &ctx->unconfirmed_messages) {
-        if ((*unconfirmed_ptr)->hold) {
-            return unconfirmed_ptr;
+static avs_error_t reserve_unconfirmed_heap(avs_coap_udp_ctx_t *ctx,
+                                            size_t capacity) {
+    if (capacity <= ctx->unconfirmed.heap_capacity) {
+        return AVS_OK;
+    }
+    size_t new_capacity = AVS_MAX(capacity, 2 * ctx->unconfirmed.heap_capacity);
+    avs_coap_udp_unconfirmed_msg_t **new_heap =
+            (avs_coap_udp_unconfirmed_msg_t **) avs_realloc(
+                    ctx->unconfirmed.heap,
+                    new_capacity * sizeof(*ctx->unconfirmed.heap));
+    if (!new_heap) {
+        LOG(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    ctx->unconfirmed.heap = new_heap;
+    ctx->unconfirmed.heap_capacity = new_capacity;
+    return AVS_OK;
+}
+
+static void heap_set(avs_coap_udp_ctx_t *ctx,
+                     size_t index,
+                     avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    ctx->unconfirmed.heap[index] = unconfirmed;
+    unconfirmed->heap_index = index;
+}
+
+static void heap_sift_up(avs_coap_udp_ctx_t *ctx, size_t index) {
+    avs_coap_udp_unconfirmed_msg_t **heap = ctx->unconfirmed.heap;
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed = heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!unconfirmed_before(unconfirmed, heap[parent])) {
+            break;
         }
+        heap_set(ctx, index, heap[parent]);
+        index = parent;
     }
+    heap_set(ctx, index, unconfirmed);
+}
 
-    return NULL;
+static void heap_sift_down(avs_coap_udp_ctx_t *ctx, size_t index) {
+    avs_coap_udp_unconfirmed_msg_t **heap = ctx->unconfirmed.heap;
+    const size_t size = ctx->unconfirmed.heap_size;
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed = heap[index];
+    while (2 * index + 1 < size) {
+        size_t child = 2 * index + 1;
+        if (child + 1 < size
+                && unconfirmed_before(heap[child + 1], heap[child])) {
+            ++child;
+        }
+        if (!unconfirmed_before(heap[child], unconfirmed)) {
+            break;
+        }
+        heap_set(ctx, index, heap[child]);
+        index = child;
+    }
+    heap_set(ctx, index, unconfirmed);
+}
+
+static void heap_push(avs_coap_udp_ctx_t *ctx,
+                      avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    // guaranteed by reserve_unconfirmed_heap() call in create_unconfirmed()
+    assert(ctx->unconfirmed.heap_size < ctx->unconfirmed.heap_capacity);
+    heap_set(ctx, ctx->unconfirmed.heap_size++, unconfirmed);
+    heap_sift_up(ctx, unconfirmed->heap_index);
+}
+
+static void heap_remove(avs_coap_udp_ctx_t *ctx,
+                        avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    const size_t index = unconfirmed->heap_index;
+    assert(index < ctx->unconfirmed.heap_size);
+    assert(ctx->unconfirmed.heap[index] == unconfirmed);
+
+    avs_coap_udp_unconfirmed_msg_t *last =
+            ctx->unconfirmed.heap[--ctx->unconfirmed.heap_size];
+    if (last != unconfirmed) {
+        heap_set(ctx, index, last);
+        heap_sift_up(ctx, index);
+        heap_sift_down(ctx, last->heap_index);
+    }
+}
+
+static void held_append(avs_coap_udp_ctx_t *ctx,
+                        avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    unconfirmed->held_prev = ctx->unconfirmed.held_tail;
+    unconfirmed->held_next = NULL;
+    if (ctx->unconfirmed.held_tail) {
+        ctx->unconfirmed.held_tail->held_next = unconfirmed;
+    } else {
+        ctx->unconfirmed.held_head = unconfirmed;
+    }
+    ctx->unconfirmed.held_tail = unconfirmed;
+    ++ctx->unconfirmed.held_count;
+}
+
+static void held_remove(avs_coap_udp_ctx_t *ctx,
+                        avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    assert(ctx->unconfirmed.held_count > 0);
+    if (unconfirmed->held_prev) {
+        unconfirmed->held_prev->held_next = unconfirmed->held_next;
+    } else {
+        assert(ctx->unconfirmed.held_head == unconfirmed);
+        ctx->unconfirmed.held_head = unconfirmed->held_next;
+    }
+    if (unconfirmed->held_next) {
+        unconfirmed->held_next->held_prev = unconfirmed->held_prev;
+    } else {
+        assert(ctx->unconfirmed.held_tail == unconfirmed);
+        ctx->unconfirmed.held_tail = unconfirmed->held_prev;
+    }
+    unconfirmed->held_prev = NULL;
+    unconfirmed->held_next = NULL;
+    --ctx->unconfirmed.held_count;
+}
+
+/**
+ * Puts @p unconfirmed into the queue appropriate for its hold flag, at the
+ * place determined by its next_retransmit. Does not touch the indexes.
+ */
+static void queue_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                              avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    unconfirmed->enqueue_seq = ++ctx->unconfirmed.last_seq;
+    if (unconfirmed->hold) {
+        held_append(ctx, unconfirmed);
+    } else {
+        heap_push(ctx, unconfirmed);
+    }
+}
+
+/**
+ * Removes @p unconfirmed from its queue. Must be called before modifying hold
+ * or next_retransmit of an enqueued message. Does not touch the indexes.
+ */
+static void unqueue_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                                avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    if (unconfirmed->hold) {
+        held_remove(ctx, unconfirmed);
+    } else {
+        heap_remove(ctx, unconfirmed);
+    }
+}
+
+static void attach_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                               avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    assert(!unconfirmed->enqueued);
+    queue_unconfirmed(ctx, unconfirmed);
+
+    AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t) by_msg_id =
+            AVS_RBTREE_INSERT(ctx->unconfirmed.by_msg_id, unconfirmed);
+    AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t *) by_token =
+            AVS_RBTREE_INSERT(ctx->unconfirmed.by_token,
+                              unconfirmed->token_index_entry);
+    // serial numbers are unique, so there are no duplicate keys
+    assert(by_msg_id == unconfirmed);
+    assert(by_token == unconfirmed->token_index_entry);
+    (void) by_msg_id;
+    (void) by_token;
+
+    unconfirmed->enqueued = true;
+}
+
+static avs_coap_udp_unconfirmed_msg_t *
+detach_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                   avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
+    assert(unconfirmed->enqueued);
+    unqueue_unconfirmed(ctx, unconfirmed);
+    AVS_RBTREE_DETACH(ctx->unconfirmed.by_msg_id, unconfirmed);
+    AVS_RBTREE_DETACH(ctx->unconfirmed.by_token,
+                      unconfirmed->token_index_entry);
+    unconfirmed->enqueued = false;
+    return unconfirmed;
+}
+
+static void delete_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                               avs_coap_udp_unconfirmed_msg_t **unconfirmed) {
+    AVS_ASSERT(!(*unconfirmed)->enqueued, "unconfirmed must be detached");
+    assert(ctx->unconfirmed.num_allocated > 0);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&(*unconfirmed)->token_index_entry);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(unconfirmed);
+    --ctx->unconfirmed.num_allocated;
+}
+
+/**
+ * Returns the message that comes first in the logical ordering, i.e. the one
+ * to be retransmitted first, or the oldest held one if none are started.
+ */
+static avs_coap_udp_unconfirmed_msg_t *
+first_unconfirmed(avs_coap_udp_ctx_t *ctx) {
+    if (ctx->unconfirmed.heap_size) {
+        return ctx->unconfirmed.heap[0];
+    }
+    return ctx->unconfirmed.held_head;
 }
 
 static void reschedule_retransmission_job(avs_coap_udp_ctx_t *ctx) {
-    if (ctx->unconfirmed_messages) {
-        avs_coap_udp_unconfirmed_msg_t *msg =
-                (avs_coap_udp_unconfirmed_msg_t *) ctx->unconfirmed_messages;
+    avs_coap_udp_unconfirmed_msg_t *msg = first_unconfirmed(ctx);
+    if (msg) {
         _avs_coap_reschedule_retry_or_request_expired_job(
                 (avs_coap_ctx_t *) ctx, msg->next_retransmit);
     }
@@ -497,9 +875,8 @@ static inline const char *send_result_string(avs_coap_send_result_t result) {
 }
 
 static void resume_next_unconfirmed(avs_coap_udp_ctx_t *ctx) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr =
-            find_first_held_unconfirmed_ptr(ctx);
-    if (!unconfirmed_ptr) {
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed = ctx->unconfirmed.held_head;
+    if (!unconfirmed) {
         return;
     }
 
@@ -514,29 +891,27 @@ static void resume_next_unconfirmed(avs_coap_udp_ctx_t *ctx) {
         // of them immediately.
         do {
             // Do not use fail_unconfirmed - it indirectly calls this function
-            // again, which may result in
-            // AVS_LIST_SIZE(ctx->unconfirmed_messages) recursive calls .
+            // again, which may result in unconfirmed_count(ctx) recursive
+            // calls.
             //
             // Note: this loop may be infinite in the most degenerate case
             // where get_first_retransmit_time returns an invalid time **just
             // once** (call above) and every response handler calls
             // avs_coap_async_send_request, adding a new held entry to the
             // context.
-            avs_coap_udp_unconfirmed_msg_t *unconfirmed =
-                    AVS_LIST_DETACH(unconfirmed_ptr);
+            detach_unconfirmed(ctx, unconfirmed);
             (void) call_send_result_handler(
                     ctx, unconfirmed, NULL, AVS_COAP_SEND_RESULT_FAIL,
                     _avs_coap_err(AVS_COAP_ERR_TIME_INVALID));
-            AVS_LIST_DELETE(&unconfirmed);
+            delete_unconfirmed(ctx, &unconfirmed);
 
-            unconfirmed_ptr = find_first_held_unconfirmed_ptr(ctx);
-        } while (unconfirmed_ptr);
+            unconfirmed = ctx->unconfirmed.held_head;
+        } while (unconfirmed);
 
         return;
     }
 
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed =
-            AVS_LIST_DETACH(unconfirmed_ptr);
+    unqueue_unconfirmed(ctx, unconfirmed);
     unconfirmed->hold = false;
     unconfirmed->next_retransmit = next_retransmit;
 
@@ -548,19 +923,18 @@ static void resume_next_unconfirmed(avs_coap_udp_ctx_t *ctx) {
                                         unconfirmed->packet_size);
 
     // the msg may need to be retransmitted before other started ones
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    queue_unconfirmed(ctx, unconfirmed);
     reschedule_retransmission_job(ctx);
 
     assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+           == AVS_MIN(unconfirmed_count(ctx), ctx->tx_params.nstart));
 }
 
 static void resume_unconfirmed_messages(avs_coap_udp_ctx_t *ctx) {
     assert(current_nstart(ctx) <= ctx->tx_params.nstart);
 
     const size_t resumed_msgs = current_nstart(ctx);
-    const size_t all_msgs = AVS_LIST_SIZE(ctx->unconfirmed_messages);
+    const size_t all_msgs = unconfirmed_count(ctx);
     const size_t held_msgs = all_msgs - resumed_msgs;
 
     const size_t msgs_to_resume =
@@ -593,8 +967,7 @@ static void finish_unconfirmed(avs_coap_udp_ctx_t *ctx) {
 
     reschedule_retransmission_job(ctx);
     assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+           == AVS_MIN(unconfirmed_count(ctx), ctx->tx_params.nstart));
 }
 
 static void try_cleanup_unconfirmed(avs_coap_udp_ctx_t *ctx,
@@ -604,8 +977,7 @@ static void try_cleanup_unconfirmed(avs_coap_udp_ctx_t *ctx,
                                     avs_error_t fail_err) {
     assert(ctx);
     assert(unconfirmed);
-    AVS_ASSERT(!AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, unconfirmed),
-               "unconfirmed must be detached");
+    AVS_ASSERT(!unconfirmed->enqueued, "unconfirmed must be detached");
     LOG(DEBUG, _("msg ") "%s" _(": ") "%s",
         AVS_COAP_TOKEN_HEX(&unconfirmed->msg.token),
         send_result_string(result));
@@ -616,11 +988,10 @@ static void try_cleanup_unconfirmed(avs_coap_udp_ctx_t *ctx,
 
     if (response && result == AVS_COAP_SEND_RESULT_OK
             && handler_result != AVS_COAP_RESPONSE_ACCEPTED) {
-        AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed),
-                        unconfirmed);
+        attach_unconfirmed(ctx, unconfirmed);
     } else {
         finish_unconfirmed(ctx);
-        AVS_LIST_DELETE(&unconfirmed);
+        delete_unconfirmed(ctx, &unconfirmed);
     }
 }
 
@@ -636,42 +1007,76 @@ static avs_coap_udp_exchange_direction_t direction_from_code(uint8_t code) {
                    : AVS_COAP_UDP_EXCHANGE_SERVER_NOTIFICATION;
 }
 
-static AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_unconfirmed_ptr(avs_coap_udp_ctx_t *ctx,
-                     avs_coap_udp_exchange_direction_t direction,
-                     const avs_coap_token_t *token,
-                     const uint16_t *id) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *list_ptr =
-            &ctx->unconfirmed_messages;
-
-    AVS_LIST_ITERATE_PTR(list_ptr) {
-        const avs_coap_udp_msg_t *msg = &(*list_ptr)->msg;
-        if ((direction == AVS_COAP_UDP_EXCHANGE_ANY
-             || direction == direction_from_code(msg->header.code))
-                && (!token || avs_coap_token_equal(&msg->token, token))
-                && (!id || _avs_coap_udp_header_get_id(&msg->header) == *id)) {
-            return list_ptr;
+static bool
+unconfirmed_matches(const avs_coap_udp_unconfirmed_msg_t *unconfirmed,
+                    avs_coap_udp_exchange_direction_t direction,
+                    const avs_coap_token_t *token,
+                    const uint16_t *id) {
+    const avs_coap_udp_msg_t *msg = &unconfirmed->msg;
+    return (direction == AVS_COAP_UDP_EXCHANGE_ANY
+            || direction == direction_from_code(msg->header.code))
+           && (!token || avs_coap_token_equal(&msg->token, token))
+           && (!id || unconfirmed->msg_id == *id);
+}
+
+/**
+ * Finds an enqueued message matching all given criteria. If there are more
+ * such messages, the one that comes first in the logical ordering is returned.
+ */
+static avs_coap_udp_unconfirmed_msg_t *
+find_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                 avs_coap_udp_exchange_direction_t direction,
+                 const avs_coap_token_t *token,
+                 const uint16_t *id) {
+    assert(token || id);
+
+    // serial numbers start from 1, so a query with serial == 0 lower-bounds
+    // all entries with matching key
+    avs_coap_udp_unconfirmed_msg_t query;
+    memset(&query, 0, sizeof(query));
+
+    avs_coap_udp_unconfirmed_msg_t *result = NULL;
+    if (id) {
+        query.msg_id = *id;
+        AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t) it =
+                AVS_RBTREE_LOWER_BOUND(ctx->unconfirmed.by_msg_id, &query);
+        for (; it && it->msg_id == *id; it = AVS_RBTREE_ELEM_NEXT(it)) {
+            if (unconfirmed_matches(it, direction, token, NULL)
+                    && (!result || unconfirmed_before(it, result))) {
+                result = it;
+            }
+        }
+    } else {
+        query.msg.token = *token;
+        avs_coap_udp_unconfirmed_msg_t *query_ptr = &query;
+        AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t *) it =
+                AVS_RBTREE_LOWER_BOUND(ctx->unconfirmed.by_token, &query_ptr);
+        for (; it && avs_coap_token_equal(&(*it)->msg.token, token);
+             it = AVS_RBTREE_ELEM_NEXT(it)) {
+            if (unconfirmed_matches(*it, direction, NULL, NULL)
+                    && (!result || unconfirmed_before(*it, result))) {
+                result = *it;
+            }
         }
     }
-
-    return NULL;
+    return result;
 }
 
-static inline AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_unconfirmed_ptr_by_token(avs_coap_udp_ctx_t *ctx,
-                              avs_coap_udp_exchange_direction_t direction,
-                              const avs_coap_token_t *token) {
-    return find_unconfirmed_ptr(ctx, direction, token, NULL);
+static inline avs_coap_udp_unconfirmed_msg_t *
+find_unconfirmed_by_token(avs_coap_udp_ctx_t *ctx,
+                          avs_coap_udp_exchange_direction_t direction,
+                          const avs_coap_token_t *token) {
+    return find_unconfirmed(ctx, direction, token, NULL);
 }
 
-static inline AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_unconfirmed_ptr_by_msg_id(avs_coap_udp_ctx_t *ctx, uint16_t msg_id) {
-    return find_unconfirmed_ptr(ctx, AVS_COAP_UDP_EXCHANGE_ANY, NULL, &msg_id);
+static inline avs_coap_udp_unconfirmed_msg_t *
+find_unconfirmed_by_msg_id(avs_coap_udp_ctx_t *ctx, uint16_t msg_id) {
+    return find_unconfirmed(ctx, AVS_COAP_UDP_EXCHANGE_ANY, NULL, &msg_id);
 }
 
-static inline AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *
-find_unconfirmed_ptr_by_response(avs_coap_udp_ctx_t *ctx,
-                                 const avs_coap_udp_msg_t *msg) {
+static inline avs_coap_udp_unconfirmed_msg_t *
+find_unconfirmed_by_response(avs_coap_udp_ctx_t *ctx,
+                             const avs_coap_udp_msg_t *msg) {
     assert(avs_coap_code_is_response(msg->header.code));
 
     uint16_t id = _avs_coap_udp_header_get_id(&msg->header);
@@ -679,11 +1084,11 @@ find_unconfirmed_ptr_by_response(avs_coap_udp_ctx_t *ctx,
     switch (_avs_coap_udp_header_get_type(&msg->header)) {
     case AVS_COAP_UDP_TYPE_CONFIRMABLE:
     case AVS_COAP_UDP_TYPE_NON_CONFIRMABLE:
-        return find_unconfirmed_ptr_by_token(
+        return find_unconfirmed_by_token(
                 ctx, AVS_COAP_UDP_EXCHANGE_CLIENT_REQUEST, &msg->token);
     case AVS_COAP_UDP_TYPE_ACKNOWLEDGEMENT:
-        return find_unconfirmed_ptr(ctx, AVS_COAP_UDP_EXCHANGE_CLIENT_REQUEST,
-                                    &msg->token, &id);
+        return find_unconfirmed(ctx, AVS_COAP_UDP_EXCHANGE_CLIENT_REQUEST,
+                                &msg->token, &id);
     case AVS_COAP_UDP_TYPE_RESET:
         // this should be detected at packet validation
         AVS_UNREACHABLE("According to RFC7252 Reset MUST be empty");
@@ -696,43 +1101,36 @@ static avs_coap_udp_unconfirmed_msg_t *
 detach_unconfirmed_by_token(avs_coap_udp_ctx_t *ctx,
                             avs_coap_udp_exchange_direction_t direction,
                             const avs_coap_token_t *token) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *msg_ptr =
-            find_unconfirmed_ptr_by_token(ctx, direction, token);
+    avs_coap_udp_unconfirmed_msg_t *msg =
+            find_unconfirmed_by_token(ctx, direction, token);
 
-    if (msg_ptr) {
-        return AVS_LIST_DETACH(msg_ptr);
+    if (msg) {
+        return detach_unconfirmed(ctx, msg);
     }
     return NULL;
 }
 
-static void
-confirm_unconfirmed(avs_coap_udp_ctx_t *ctx,
-                    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *msg_ptr,
-                    const avs_coap_udp_msg_t *response) {
+static void confirm_unconfirmed(avs_coap_udp_ctx_t *ctx,
+                                avs_coap_udp_unconfirmed_msg_t *msg,
+                                const avs_coap_udp_msg_t *response) {
     assert(ctx);
-    assert(msg_ptr);
-    assert(*msg_ptr);
-    AVS_ASSERT(AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, *msg_ptr),
-               "unconfirmed_msg must be enqueued");
+    assert(msg);
+    AVS_ASSERT(msg->enqueued, "unconfirmed_msg must be enqueued");
 
-    avs_coap_udp_unconfirmed_msg_t *msg = AVS_LIST_DETACH(msg_ptr);
-    try_cleanup_unconfirmed(ctx, msg, response, AVS_COAP_SEND_RESULT_OK,
-                            AVS_OK);
+    try_cleanup_unconfirmed(ctx, detach_unconfirmed(ctx, msg), response,
+                            AVS_COAP_SEND_RESULT_OK, AVS_OK);
 }
 
 static void fail_unconfirmed(avs_coap_udp_ctx_t *ctx,
-                             AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *msg_ptr,
+                             avs_coap_udp_unconfirmed_msg_t *msg,
                              const avs_coap_udp_msg_t *truncated_msg,
                              avs_error_t err) {
     assert(ctx);
-    assert(msg_ptr);
-    assert(*msg_ptr);
-    AVS_ASSERT(AVS_LIST_FIND_PTR(&ctx->unconfirmed_messages, *msg_ptr),
-               "unconfirmed_msg must be enqueued");
+    assert(msg);
+    AVS_ASSERT(msg->enqueued, "unconfirmed_msg must be enqueued");
 
-    avs_coap_udp_unconfirmed_msg_t *msg = AVS_LIST_DETACH(msg_ptr);
-    try_cleanup_unconfirmed(ctx, msg, truncated_msg, AVS_COAP_SEND_RESULT_FAIL,
-                            err);
+    try_cleanup_unconfirmed(ctx, detach_unconfirmed(ctx, msg), truncated_msg,
+                            AVS_COAP_SEND_RESULT_FAIL, err);
 }
 
 static avs_coap_udp_exchange_direction_t
@@ -753,7 +1151,7 @@ static void coap_udp_abort_delivery(avs_coap_ctx_t *ctx_,
                                     avs_coap_send_result_t result,
                                     avs_error_t fail_err) {
     avs_coap_udp_ctx_t *ctx = (avs_coap_udp_ctx_t *) ctx_;
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) msg =
+    avs_coap_udp_unconfirmed_msg_t *msg =
             detach_unconfirmed_by_token(ctx, udp_direction(direction), token);
     if (!msg) {
         return;
@@ -771,7 +1169,7 @@ static void coap_udp_ignore_current_request(avs_coap_ctx_t *ctx,
 
 static void
 retransmit_next_message_without_reschedule(avs_coap_udp_ctx_t *ctx) {
-    avs_coap_udp_unconfirmed_msg_t *unconfirmed = ctx->unconfirmed_messages;
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed = first_unconfirmed(ctx);
     if (!unconfirmed
             || avs_time_monotonic_before(avs_time_monotonic_now(),
                                          unconfirmed->next_retransmit)) {
@@ -786,13 +1184,13 @@ retransmit_next_message_without_reschedule(avs_coap_udp_ctx_t *ctx) {
             AVS_COAP_TOKEN_HEX(&unconfirmed->msg.token));
 
         // retransmission_job is rescheduled by fail_unconfirmed()
-        fail_unconfirmed(ctx, &ctx->unconfirmed_messages, NULL,
+        fail_unconfirmed(ctx, unconfirmed, NULL,
                          _avs_coap_err(AVS_COAP_ERR_TIMEOUT));
         return;
     }
 
     if (_avs_coap_udp_update_retry_state(&unconfirmed->retry_state)) {
-        fail_unconfirmed(ctx, &ctx->unconfirmed_messages, NULL,
+        fail_unconfirmed(ctx, unconfirmed, NULL,
                          _avs_coap_err(AVS_COAP_ERR_TIME_INVALID));
         return;
     }
@@ -815,31 +1213,29 @@ retransmit_next_message_without_reschedule(avs_coap_udp_ctx_t *ctx) {
             _("unable to schedule message retransmission: next_retransmit time "
               "invalid; either the monotonic clock malfunctioned or UDP tx "
               "params are too large to handle"));
-        fail_unconfirmed(ctx, &ctx->unconfirmed_messages, NULL,
+        fail_unconfirmed(ctx, unconfirmed, NULL,
                          _avs_coap_err(AVS_COAP_ERR_TIME_INVALID));
         return;
     }
 
+    unqueue_unconfirmed(ctx, unconfirmed);
     unconfirmed->next_retransmit = next_retransmit;
-    unconfirmed = AVS_LIST_DETACH(&ctx->unconfirmed_messages);
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    queue_unconfirmed(ctx, unconfirmed);
 
     assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+           == AVS_MIN(unconfirmed_count(ctx), ctx->tx_params.nstart));
 }
 
 static avs_time_monotonic_t coap_udp_on_timeout(avs_coap_ctx_t *ctx_) {
     avs_coap_udp_ctx_t *ctx = (avs_coap_udp_ctx_t *) ctx_;
     retransmit_next_message_without_reschedule(ctx);
 
-    if (ctx->unconfirmed_messages) {
-        avs_coap_udp_unconfirmed_msg_t *unconfirmed = ctx->unconfirmed_messages;
-
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed = first_unconfirmed(ctx);
+    if (unconfirmed) {
         LOG(DEBUG, _("next UDP retransmission: ") "%" PRIi64 ".%09" PRId32,
             unconfirmed->next_retransmit.since_monotonic_epoch.seconds,
             unconfirmed->next_retransmit.since_monotonic_epoch.nanoseconds);
-        return ctx->unconfirmed_messages->next_retransmit;
+        return unconfirmed->next_retransmit;
     } else {
         return AVS_TIME_MONOTONIC_INVALID;
     }
@@ -847,16 +1243,14 @@ static avs_time_monotonic_t coap_udp_on_timeout(avs_coap_ctx_t *ctx_) {
 
 static avs_error_t
 enqueue_unconfirmed(avs_coap_udp_ctx_t *ctx,
-                    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed) {
+                    avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
     LOG(TRACE, _("msg ") "%s" _(": enqueue"),
         AVS_COAP_TOKEN_HEX(&unconfirmed->msg.token));
 
     // do not send the message unless there is no other one waiting to be sent
     // that is held for longer than this one
     assert(ctx->tx_params.nstart > 0);
-    unconfirmed->hold =
-            (AVS_LIST_NTH(ctx->unconfirmed_messages, ctx->tx_params.nstart - 1)
-             != NULL);
+    unconfirmed->hold = (unconfirmed_count(ctx) >= ctx->tx_params.nstart);
 
     // use current time for all held jobs to not cause accidental reordering
     // due to ACK_RANDOM_FACTOR
@@ -888,7 +1282,7 @@ enqueue_unconfirmed(avs_coap_udp_ctx_t *ctx,
         }
     }
 
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    attach_unconfirmed(ctx, unconfirmed);
     reschedule_retransmission_job(ctx);
     return AVS_OK;
 }
@@ -896,30 +1290,52 @@ enqueue_unconfirmed(avs_coap_udp_ctx_t *ctx,
 static avs_error_t create_unconfirmed(
         avs_coap_udp_ctx_t *ctx,
         const avs_coap_udp_msg_t *msg,
-        AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *out_unconfirmed_msg,
+        avs_coap_udp_unconfirmed_msg_t **out_unconfirmed_msg,
         avs_coap_send_result_handler_t *send_result_handler,
         void *send_result_handler_arg) {
     const size_t msg_size = _avs_coap_udp_msg_size(msg);
 
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed_msg =
-            (AVS_LIST(avs_coap_udp_unconfirmed_msg_t)) AVS_LIST_NEW_BUFFER(
-                    sizeof(avs_coap_udp_unconfirmed_msg_t) + msg_size);
-    if (!unconfirmed_msg) {
+    // make sure that the retransmission heap can hold every existing message,
+    // so that no allocation is necessary when moving messages between queues
+    avs_error_t err =
+            reserve_unconfirmed_heap(ctx, ctx->unconfirmed.num_allocated + 1);
+    if (avs_is_err(err)) {
+        return err;
+    }
+
+    AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t) unconfirmed_msg =
+            (AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t))
+                    AVS_RBTREE_ELEM_NEW_BUFFER(
+                            sizeof(avs_coap_udp_unconfirmed_msg_t) + msg_size);
+    AVS_RBTREE_ELEM(avs_coap_udp_unconfirmed_msg_t *) token_index_entry =
+            AVS_RBTREE_ELEM_NEW(avs_coap_udp_unconfirmed_msg_t *);
+    if (!unconfirmed_msg || !token_index_entry) {
+        if (unconfirmed_msg) {
+            AVS_RBTREE_ELEM_DELETE_DETACHED(&unconfirmed_msg);
+        }
+        if (token_index_entry) {
+            AVS_RBTREE_ELEM_DELETE_DETACHED(&token_index_entry);
+        }
         return avs_errno(AVS_ENOMEM);
     }
+    ++ctx->unconfirmed.num_allocated;
 
     *unconfirmed_msg = (avs_coap_udp_unconfirmed_msg_t) {
         .send_result_handler = send_result_handler,
         .send_result_handler_arg = send_result_handler_arg,
         .retry_state = _avs_coap_udp_initial_retry_state(&ctx->tx_params,
                                                          &ctx->base.rand_seed),
+        .serial = ++ctx->unconfirmed.last_seq,
+        .msg_id = _avs_coap_udp_header_get_id(&msg->header),
+        .token_index_entry = token_index_entry,
         .packet_size = msg_size
     };
+    *token_index_entry = unconfirmed_msg;
 
     if (avs_is_err(_avs_coap_udp_msg_copy(msg, &unconfirmed_msg->msg,
                                           unconfirmed_msg->packet, msg_size))) {
         AVS_UNREACHABLE("library created a malformed avs_coap_udp_msg_t");
-        AVS_LIST_CLEAR(&unconfirmed_msg);
+        delete_unconfirmed(ctx, &unconfirmed_msg);
         return _avs_coap_err(AVS_COAP_ERR_ASSERT_FAILED);
     }
 
@@ -1035,7 +1451,7 @@ coap_udp_send_message(avs_coap_ctx_t *ctx_,
     if (type == AVS_COAP_UDP_TYPE_CONFIRMABLE) {
         // The user actually cares about message delivery.
         // We need to store the packet for possible retransmissions.
-        AVS_LIST(avs_coap_udp_unconfirmed_msg_t) unconfirmed = NULL;
+        avs_coap_udp_unconfirmed_msg_t *unconfirmed = NULL;
         err = create_unconfirmed(ctx, &shared_buffer_msg, &unconfirmed,
                                  send_result_handler, send_result_handler_arg);
         if (avs_is_err(err)) {
@@ -1046,7 +1462,7 @@ coap_udp_send_message(avs_coap_ctx_t *ctx_,
         if (avs_is_err(err)) {
             // don't call try_cleanup_unconfirmed to avoid calling user-defined
             // handler
-            AVS_LIST_DELETE(&unconfirmed);
+            delete_unconfirmed(ctx, &unconfirmed);
         }
     } else {
         assert(type != AVS_COAP_UDP_TYPE_CONFIRMABLE);
@@ -1176,9 +1592,9 @@ static avs_error_t send_reset(avs_coap_udp_ctx_t *ctx, uint16_t msg_id) {
 
 static avs_error_t handle_response(avs_coap_udp_ctx_t *ctx,
                                    const avs_coap_udp_msg_t *msg) {
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr =
-            find_unconfirmed_ptr_by_response(ctx, msg);
-    if (!unconfirmed_ptr) {
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed =
+            find_unconfirmed_by_response(ctx, msg);
+    if (!unconfirmed) {
         bool is_confirmable = (_avs_coap_udp_header_get_type(&msg->header)
                                == AVS_COAP_UDP_TYPE_CONFIRMABLE);
         LOG(DEBUG,
@@ -1217,51 +1633,47 @@ static avs_error_t handle_response(avs_coap_udp_ctx_t *ctx,
         return _avs_coap_err(AVS_COAP_ERR_ASSERT_FAILED);
     }
 
-    confirm_unconfirmed(ctx, unconfirmed_ptr, msg);
+    confirm_unconfirmed(ctx, unconfirmed, msg);
     return AVS_OK;
 }
 
-static void
-ack_request(avs_coap_udp_ctx_t *ctx,
-            AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr) {
+static void ack_request(avs_coap_udp_ctx_t *ctx,
+                        avs_coap_udp_unconfirmed_msg_t *unconfirmed) {
     assert(ctx);
-    assert(unconfirmed_ptr);
-    assert(*unconfirmed_ptr);
+    assert(unconfirmed);
 
     // Wait EXCHANGE_LIFETIME for the actual response
     avs_time_monotonic_t next_retransmit = avs_time_monotonic_add(
             avs_time_monotonic_now(),
             avs_coap_udp_exchange_lifetime(&ctx->tx_params));
 
-    if (!avs_time_monotonic_valid((*unconfirmed_ptr)->next_retransmit)) {
+    if (!avs_time_monotonic_valid(unconfirmed->next_retransmit)) {
         LOG(ERROR,
             _("unable to schedule msg retransmission: next_retransmit time "
               "invalid; either the monotonic clock malfunctioned or UDP tx "
               "params are too large to handle"));
-        fail_unconfirmed(ctx, unconfirmed_ptr, NULL,
+        fail_unconfirmed(ctx, unconfirmed, NULL,
                          _avs_coap_err(AVS_COAP_ERR_TIME_INVALID));
         return;
     }
 
-    avs_coap_udp_unconfirmed_msg_t *unconfirmed =
-            AVS_LIST_DETACH(unconfirmed_ptr);
+    unqueue_unconfirmed(ctx, unconfirmed);
     // disable further retransmissions
     unconfirmed->retry_state.retry_count = ctx->tx_params.max_retransmit;
     unconfirmed->next_retransmit = next_retransmit;
 
-    AVS_LIST_INSERT(find_unconfirmed_insert_ptr(ctx, unconfirmed), unconfirmed);
+    queue_unconfirmed(ctx, unconfirmed);
     reschedule_retransmission_job(ctx);
 
     assert(current_nstart(ctx)
-           == AVS_MIN(AVS_LIST_SIZE(ctx->unconfirmed_messages),
-                      ctx->tx_params.nstart));
+           == AVS_MIN(unconfirmed_count(ctx), ctx->tx_params.nstart));
 }
 
 static avs_error_t handle_empty(avs_coap_udp_ctx_t *ctx,
                                 const avs_coap_udp_msg_t *msg) {
     uint16_t msg_id = _avs_coap_udp_header_get_id(&msg->header);
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr =
-            find_unconfirmed_ptr_by_msg_id(ctx, msg_id);
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed =
+            find_unconfirmed_by_msg_id(ctx, msg_id);
 
     switch (_avs_coap_udp_header_get_type(&msg->header)) {
     case AVS_COAP_UDP_TYPE_CONFIRMABLE:
@@ -1272,13 +1684,13 @@ static avs_error_t handle_empty(avs_coap_udp_ctx_t *ctx,
 
     case AVS_COAP_UDP_TYPE_ACKNOWLEDGEMENT:
         // Separate ACK
-        if (unconfirmed_ptr) {
-            if (avs_coap_code_is_request((*unconfirmed_ptr)->msg.header.code)) {
+        if (unconfirmed) {
+            if (avs_coap_code_is_request(unconfirmed->msg.header.code)) {
                 // we still need to wait for a response
-                ack_request(ctx, unconfirmed_ptr);
+                ack_request(ctx, unconfirmed);
             } else {
                 // Separate ACK to Separate Response sent by us
-                confirm_unconfirmed(ctx, unconfirmed_ptr, NULL);
+                confirm_unconfirmed(ctx, unconfirmed, NULL);
             }
             return AVS_OK;
         } else {
@@ -1290,9 +1702,9 @@ static avs_error_t handle_empty(avs_coap_udp_ctx_t *ctx,
         }
 
     case AVS_COAP_UDP_TYPE_RESET: {
-        if (unconfirmed_ptr) {
+        if (unconfirmed) {
             // Reset response to our CON request
-            fail_unconfirmed(ctx, unconfirmed_ptr, NULL,
+            fail_unconfirmed(ctx, unconfirmed, NULL,
                              _avs_coap_err(AVS_COAP_ERR_UDP_RESET_RECEIVED));
         }
 
@@ -1377,10 +1789,10 @@ static void handle_truncated_response(avs_coap_udp_ctx_t *ctx,
     assert(avs_coap_code_is_response(truncated_msg->header.code));
     // Truncated response: notify the owner about failure. The handler will
     // be able to detect that truncation happened by inspecting socket errno
-    AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr =
-            find_unconfirmed_ptr_by_response(ctx, truncated_msg);
-    if (unconfirmed_ptr) {
-        fail_unconfirmed(ctx, unconfirmed_ptr, truncated_msg,
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed =
+            find_unconfirmed_by_response(ctx, truncated_msg);
+    if (unconfirmed) {
+        fail_unconfirmed(ctx, unconfirmed, truncated_msg,
                          _avs_coap_err(
                                  AVS_COAP_ERR_TRUNCATED_MESSAGE_RECEIVED));
     }
@@ -1451,10 +1863,10 @@ coap_udp_receive_message(avs_coap_ctx_t *ctx_,
             } else if (avs_coap_code_is_response(msg.header.code)) {
                 // At this point token and ID are available in the msg
                 // struct.
-                AVS_LIST(avs_coap_udp_unconfirmed_msg_t) *unconfirmed_ptr =
-                        find_unconfirmed_ptr_by_response(ctx, &msg);
-                if (unconfirmed_ptr) {
-                    fail_unconfirmed(ctx, unconfirmed_ptr, NULL, err);
+                avs_coap_udp_unconfirmed_msg_t *unconfirmed =
+                        find_unconfirmed_by_response(ctx, &msg);
+                if (unconfirmed) {
+                    fail_unconfirmed(ctx, unconfirmed, NULL, err);
                 }
                 const avs_coap_udp_type_t type =
                         _avs_coap_udp_header_get_type(&msg.header);
@@ -1502,12 +1914,18 @@ static avs_error_t coap_udp_accept_observation(avs_coap_ctx_t *ctx_,
 static void coap_udp_cleanup(avs_coap_ctx_t *ctx_) {
     avs_coap_udp_ctx_t *ctx = (avs_coap_udp_ctx_t *) ctx_;
 
-    while (ctx->unconfirmed_messages) {
-        avs_coap_udp_unconfirmed_msg_t *unconfirmed =
-                AVS_LIST_DETACH(&ctx->unconfirmed_messages);
-        try_cleanup_unconfirmed(ctx, unconfirmed, NULL,
+    avs_coap_udp_unconfirmed_msg_t *unconfirmed;
+    while ((unconfirmed = first_unconfirmed(ctx))) {
+        try_cleanup_unconfirmed(ctx, detach_unconfirmed(ctx, unconfirmed), NULL,
                                 AVS_COAP_SEND_RESULT_CANCEL, AVS_OK);
     }
+    assert(!ctx->unconfirmed.num_allocated);
+    AVS_RBTREE_DELETE(&ctx->unconfirmed.by_msg_id);
+    AVS_RBTREE_DELETE(&ctx->unconfirmed.by_token);
+    avs_free(ctx->unconfirmed.heap);
+#ifdef WITH_AVS_COAP_OBSERVE
+    coap_udp_notify_cache_cleanup(&ctx->notify_cache);
+#endif // WITH_AVS_COAP_OBSERVE
     avs_free(ctx);
 }
 
@@ -1551,7 +1969,8 @@ avs_coap_udp_ctx_create(avs_sched_t *sched,
                         const avs_coap_udp_tx_params_t *udp_tx_params,
                         avs_shared_buffer_t *in_buffer,
                         avs_shared_buffer_t *out_buffer,
-                        avs_coap_udp_response_cache_t *cache) {
+                        avs_coap_udp_response_cache_t *cache,
+                        size_t notify_cache_size) {
     assert(in_buffer);
     assert(out_buffer);
 
@@ -1571,8 +1990,33 @@ avs_coap_udp_ctx_create(avs_sched_t *sched,
         return NULL;
     }
 
-    _avs_coap_base_init(&ctx->base, (avs_coap_ctx_t *) ctx, in_buffer,
-                        out_buffer, sched);
+    if (avs_is_err(_avs_coap_base_init(&ctx->base, (avs_coap_ctx_t *) ctx,
+                                       in_buffer, out_buffer, sched))) {
+        avs_free(ctx);
+        return NULL;
+    }
+
+    if (!(ctx->unconfirmed.by_msg_id =
+                  AVS_RBTREE_NEW(avs_coap_udp_unconfirmed_msg_t,
+                                 unconfirmed_by_msg_id_cmp))) {
+        goto oom;
+    }
+    if (!(ctx->unconfirmed.by_token =
+                  AVS_RBTREE_NEW(avs_coap_udp_unconfirmed_msg_t *,
+                                 unconfirmed_by_token_cmp))) {
+        AVS_RBTREE_DELETE(&ctx->unconfirmed.by_msg_id);
+        goto oom;
+    }
+#ifdef WITH_AVS_COAP_OBSERVE
+    if (avs_is_err(coap_udp_notify_cache_init(&ctx->notify_cache,
+                                              notify_cache_size))) {
+        AVS_RBTREE_DELETE(&ctx->unconfirmed.by_msg_id);
+        AVS_RBTREE_DELETE(&ctx->unconfirmed.by_token);
+        goto oom;
+    }
+#else  // WITH_AVS_COAP_OBSERVE
+    (void) notify_cache_size;
+#endif // WITH_AVS_COAP_OBSERVE
 
     ctx->vtable = &COAP_UDP_VTABLE;
     ctx->last_mtu = SIZE_MAX;
@@ -1582,4 +2026,10 @@ avs_coap_udp_ctx_create(avs_sched_t *sched,
     ctx->response_cache = cache;
 
     return (avs_coap_ctx_t *) ctx;
+
+oom:
+    LOG(ERROR, _("out of memory"));
+    _avs_coap_base_cleanup(&ctx->base);
+    avs_free(ctx);
+    return NULL;
 }
@@ -42,11 +42,36 @@ typedef struct endpoint {
     char port[sizeof("65535")];
 } endpoint_t;
 
+/**
+ * Slot of the open-addressing hash table that indexes cache entries by remote
+ * endpoint and message ID.
+ *
+ * Entries are referenced by their logical position in the stream of all bytes
+ * ever appended to the buffer, rather than by pointer, because avs_buffer_t may
+ * move its contents around when defragmenting. Only the lower 32 bits of that
+ * position are stored, which is enough as long as the buffer is smaller than
+ * 4 GB. The endpoint is not stored in the slot - it is read from the entry.
+ */
+typedef struct {
+    uint32_t pos;
+    uint16_t msg_id;
+    bool used;
+} index_slot_t;
+
 struct avs_coap_udp_response_cache {
     AVS_LIST(endpoint_t) endpoints; // sorted by id
 
     // priority queue of cache_entry_t, sorted by expiration_time
     avs_buffer_t *buffer;
+
+    // total number of bytes ever consumed from the front of buffer; logical
+    // position of the first entry in the buffer
+    size_t consumed_bytes;
+
+    // hash table with linear probing, large enough to always have at least
+    // half of the slots empty
+    index_slot_t *index;
+    size_t index_size;
 };
 
 typedef struct cache_entry {
@@ -57,9 +82,21 @@ typedef struct cache_entry {
             data[1]; // actually a FAM: serialized avs_coap_udp_msg_t + padding
 } cache_entry_t;
 
+static size_t index_size_for_capacity(size_t capacity) {
+    // every entry contains at least the header and the CoAP message header,
+    // rounded up to the entry alignment
+    const size_t alignment = AVS_ALIGNOF(cache_entry_t);
+    const size_t min_entry_size =
+            (offsetof(cache_entry_t, data) + sizeof(avs_coap_udp_header_t)
+             + alignment - 1)
+            / alignment * alignment;
+    const size_t max_entries = capacity / min_entry_size + 1;
+    return 2 * max_entries;
+}
+
 avs_coap_udp_response_cache_t *
 avs_coap_udp_response_cache_create(size_t capacity) {
-    if (capacity == 0) {
+    if (capacity == 0 || capacity > UINT32_MAX) {
         return NULL;
     }
 
@@ -70,7 +107,16 @@ avs_coap_udp_response_cache_create(size_t capacity) {
         return NULL;
     }
 
+    const size_t index_size = index_size_for_capacity(capacity);
+    if (!(cache->index = (index_slot_t *) avs_calloc(index_size,
+                                                     sizeof(index_slot_t)))) {
+        avs_free(cache);
+        return NULL;
+    }
+    cache->index_size = index_size;
+
     if (avs_buffer_create(&cache->buffer, capacity)) {
+        avs_free(cache->index);
         avs_free(cache);
         return NULL;
     }
@@ -85,26 +131,38 @@ void avs_coap_udp_response_cache_release(
         avs_coap_udp_response_cache_t **cache_ptr) {
     if (cache_ptr && *cache_ptr) {
         avs_buffer_free(&(*cache_ptr)->buffer);
+        avs_free((*cache_ptr)->index);
         AVS_LIST_CLEAR(&(*cache_ptr)->endpoints);
         avs_free(*cache_ptr);
         *cache_ptr = NULL;
     }
 }
 
-static endpoint_t *cache_endpoint_add_ref(avs_coap_udp_response_cache_t *cache,
-                                          const char *remote_addr,
-                                          const char *remote_port) {
+static endpoint_t *
+cache_endpoint_find(const avs_coap_udp_response_cache_t *cache,
+                    const char *remote_addr,
+                    const char *remote_port) {
     assert(remote_addr);
     assert(remote_port);
 
-    AVS_LIST(endpoint_t) *ep_ptr;
-    AVS_LIST_FOREACH_PTR(ep_ptr, &cache->endpoints) {
-        if (!strcmp(remote_addr, (*ep_ptr)->addr)
-                && !strcmp(remote_port, (*ep_ptr)->port)) {
-            ++(*ep_ptr)->refcount;
-            return *ep_ptr;
+    AVS_LIST(endpoint_t) ep;
+    AVS_LIST_FOREACH(ep, cache->endpoints) {
+        if (!strcmp(remote_addr, ep->addr) && !strcmp(remote_port, ep->port)) {
+            return ep;
         }
     }
+    return NULL;
+}
+
+static endpoint_t *cache_endpoint_add_ref(avs_coap_udp_response_cache_t *cache,
+                                          const char *remote_addr,
+                                          const char *remote_port) {
+    endpoint_t *existing_ep =
+            cache_endpoint_find(cache, remote_addr, remote_port);
+    if (existing_ep) {
+        ++existing_ep->refcount;
+        return existing_ep;
+    }
 
     AVS_LIST(endpoint_t) new_ep = AVS_LIST_NEW_ELEMENT(endpoint_t);
     if (!new_ep) {
@@ -145,6 +203,90 @@ static void cache_endpoint_del_ref(avs_coap_udp_response_cache_t *cache,
     }
 }
 
+static size_t index_hash(const endpoint_t *endpoint, uint16_t msg_id) {
+    // endpoints are heap-allocated, so the lowest bits carry no information
+    uint32_t hash = (uint32_t) ((uintptr_t) endpoint >> 4);
+    hash ^= msg_id;
+    hash *= UINT32_C(2654435761);
+    return (size_t) (hash ^ (hash >> 16));
+}
+
+static size_t index_next(const avs_coap_udp_response_cache_t *cache,
+                         size_t i) {
+    return i + 1 < cache->index_size ? i + 1 : 0;
+}
+
+static const cache_entry_t *
+index_entry(const avs_coap_udp_response_cache_t *cache,
+            const index_slot_t *slot) {
+    assert(slot->used);
+    const size_t offset =
+            (size_t) (uint32_t) (slot->pos - (uint32_t) cache->consumed_bytes);
+    return (const cache_entry_t *) (avs_buffer_data(cache->buffer) + offset);
+}
+
+static size_t index_home(const avs_coap_udp_response_cache_t *cache,
+                         const index_slot_t *slot) {
+    return index_hash(index_entry(cache, slot)->endpoint, slot->msg_id)
+           % cache->index_size;
+}
+
+static index_slot_t *index_find(const avs_coap_udp_response_cache_t *cache,
+                                const endpoint_t *endpoint,
+                                uint16_t msg_id) {
+    for (size_t i = index_hash(endpoint, msg_id) % cache->index_size;;
+         i = index_next(cache, i)) {
+        index_slot_t *slot = &cache->index[i];
+        if (!slot->used) {
+            return NULL;
+        }
+        if (slot->msg_id == msg_id
+                && index_entry(cache, slot)->endpoint == endpoint) {
+            return slot;
+        }
+    }
+}
+
+static void index_insert(avs_coap_udp_response_cache_t *cache,
+                         const endpoint_t *endpoint,
+                         uint16_t msg_id,
+                         size_t pos) {
+    assert(!index_find(cache, endpoint, msg_id));
+    size_t i = index_hash(endpoint, msg_id) % cache->index_size;
+    while (cache->index[i].used) {
+        i = index_next(cache, i);
+    }
+    cache->index[i].pos = (uint32_t) pos;
+    cache->index[i].msg_id = msg_id;
+    cache->index[i].used = true;
+}
+
+static size_t index_distance(const avs_coap_udp_response_cache_t *cache,
+                             size_t from,
+                             size_t to) {
+    return to >= from ? to - from : to + cache->index_size - from;
+}
+
+static void index_remove(avs_coap_udp_response_cache_t *cache,
+                         const endpoint_t *endpoint,
+                         uint16_t msg_id) {
+    index_slot_t *slot = index_find(cache, endpoint, msg_id);
+    assert(slot);
+    size_t hole = (size_t) (slot - cache->index);
+    // backward shift deletion: move subsequent entries of the probe sequence
+    // into the hole, so that no tombstones are necessary
+    for (size_t i = index_next(cache, hole); cache->index[i].used;
+         i = index_next(cache, i)) {
+        size_t home = index_home(cache, &cache->index[i]);
+        // move the entry only if its home slot is not within (hole, i]
+        if (index_distance(cache, home, i) >= index_distance(cache, hole, i)) {
+            cache->index[hole] = cache->index[i];
+            hole = i;
+        }
+    }
+    cache->index[hole].used = false;
+}
+
 static size_t padding_bytes_after_msg(size_t msg_size) {
     static const size_t entry_alignment = AVS_ALIGNOF(cache_entry_t);
     const size_t entry_length = offsetof(cache_entry_t, data) + msg_size;
@@ -172,6 +314,8 @@ static void cache_put_entry(avs_coap_udp_response_cache_t *cache,
 
     assert(avs_buffer_data_size(cache->buffer) % AVS_ALIGNOF(cache_entry_t)
            == 0);
+    index_insert(cache, endpoint, _avs_coap_udp_header_get_id(&msg->header),
+                 cache->consumed_bytes + avs_buffer_data_size(cache->buffer));
     int res;
     res = avs_buffer_append_bytes(cache->buffer, &entry,
                                   offsetof(cache_entry_t, data));
@@ -242,6 +386,15 @@ static const cache_entry_t *entry_next(const cache_entry_t *entry) {
     return result;
 }
 
+static void cache_consume_entries_until(avs_coap_udp_response_cache_t *cache,
+                                        const cache_entry_t *entry) {
+    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
+    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
+    assert(!res);
+    (void) res;
+    cache->consumed_bytes += expired_bytes;
+}
+
 static void cache_free_bytes(avs_coap_udp_response_cache_t *cache,
                              size_t bytes_required) {
     assert(bytes_required <= avs_buffer_capacity(cache->buffer));
@@ -257,14 +410,12 @@ static void cache_free_bytes(avs_coap_udp_response_cache_t *cache,
             _("msg_cache: dropping msg (id = ") "%u" _(
                     ") to make room for a new one (size = ") "%lu" _(")"),
             entry_id(entry), (unsigned long) bytes_required);
+        index_remove(cache, entry->endpoint, entry_id(entry));
         cache_endpoint_del_ref(cache, entry->endpoint);
         bytes_free += entry_size(entry);
     }
 
-    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
-    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
-    assert(!res);
-    (void) res;
+    cache_consume_entries_until(cache, entry);
 }
 
 static void cache_drop_expired(avs_coap_udp_response_cache_t *cache,
@@ -275,16 +426,14 @@ static void cache_drop_expired(avs_coap_udp_response_cache_t *cache,
         if (entry_expired(entry, now)) {
             LOG(TRACE, _("msg_cache: dropping expired msg (id = ") "%u" _(")"),
                 entry_id(entry));
+            index_remove(cache, entry->endpoint, entry_id(entry));
             cache_endpoint_del_ref(cache, entry->endpoint);
         } else {
             break;
         }
     }
 
-    size_t expired_bytes = (uintptr_t) entry - (uintptr_t) entry_first(cache);
-    int res = avs_buffer_consume_bytes(cache->buffer, expired_bytes);
-    assert(!res);
-    (void) res;
+    cache_consume_entries_until(cache, entry);
 }
 
 static const cache_entry_t *
@@ -292,17 +441,20 @@ find_entry(const avs_coap_udp_response_cache_t *cache,
            const char *remote_addr,
            const char *remote_port,
            uint16_t msg_id) {
-    for (const cache_entry_t *entry = entry_first(cache);
-         entry_valid(cache, entry);
-         entry = entry_next(entry)) {
-        if (entry_id(entry) == msg_id
-                && !strcmp(entry->endpoint->addr, remote_addr)
-                && !strcmp(entry->endpoint->port, remote_port)) {
-            return entry;
-        }
+    const endpoint_t *endpoint =
+            cache_endpoint_find(cache, remote_addr, remote_port);
+    if (!endpoint) {
+        return NULL;
     }
-
-    return NULL;
+    const index_slot_t *slot = index_find(cache, endpoint, msg_id);
+    if (!slot) {
+        return NULL;
+    }
+    const cache_entry_t *entry = index_entry(cache, slot);
+    assert(entry_valid(cache, entry));
+    assert(entry->endpoint == endpoint);
+    assert(entry_id(entry) == msg_id);
+    return entry;
 }
 
 int _avs_coap_udp_response_cache_add(
@@ -461,7 +461,7 @@ int main() {
             || !(out_buffer = avs_shared_buffer_new(out_buf_size))
             || !(cache = avs_coap_udp_response_cache_create(cache_size))
             || !(ctx = avs_coap_udp_ctx_create(g_sched, &tx_params, in_buffer,
-                                               out_buffer, cache))
+                                               out_buffer, cache, 0))
             || avs_is_err(avs_coap_ctx_set_socket(ctx, g_mocksock))) {
         goto exit;
     }
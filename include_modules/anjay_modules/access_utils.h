@@ -53,6 +53,17 @@ int _anjay_acl_ref_validate_inst_ref(anjay_t *anjay,
                                      anjay_oid_t target_oid,
                                      anjay_iid_t target_iid);
 
+/**
+ * Drops the cached index of the Access Control Object contents, so that it will
+ * be rebuilt on the next access check.
+ *
+ * This is called automatically whenever a change to the Access Control Object
+ * is notified, so it only needs to be called explicitly when its contents are
+ * replaced without performing any notifications (e.g. when restoring it from
+ * persistence).
+ */
+void _anjay_access_control_index_invalidate(anjay_t *anjay);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_INCLUDE_ANJAY_MODULES_ACCESS_UTILS_H */
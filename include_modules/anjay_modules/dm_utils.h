@@ -452,6 +452,16 @@ int _anjay_dm_call_list_instances(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_dm_list_ctx_t *ctx,
                                   const anjay_dm_module_t *current_module);
+int _anjay_dm_call_instance_present(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t iid,
+        const anjay_dm_module_t *current_module);
+int _anjay_dm_call_instance_select_free_iid(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t *out_iid,
+        const anjay_dm_module_t *current_module);
 int _anjay_dm_call_instance_reset(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_iid_t iid,
@@ -19,6 +19,8 @@
 
 #include <stdbool.h>
 
+#include <avsystem/commons/rbtree.h>
+
 #include <anjay/core.h>
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -37,7 +39,9 @@ typedef struct {
 typedef struct {
     anjay_oid_t oid;
     anjay_notify_queue_instance_entry_t instance_set_changes;
-    AVS_LIST(anjay_notify_queue_resource_entry_t) resources_changed;
+    // Set of changed Resources, ordered lexicographically over (IID, RID)
+    // pairs. Always non-NULL, but may be empty.
+    AVS_RBTREE(anjay_notify_queue_resource_entry_t) resources_changed;
 } anjay_notify_queue_object_entry_t;
 
 typedef AVS_LIST(anjay_notify_queue_object_entry_t) anjay_notify_queue_t;
@@ -91,6 +95,13 @@ int _anjay_notify_instance_created(anjay_t *anjay,
                                    anjay_oid_t oid,
                                    anjay_iid_t iid);
 
+/**
+ * Informs the library that attributes of arbitrary data model entities might
+ * have changed in a way that is not reflected in any notification queue, e.g.
+ * when the attribute storage is restored from persistence data.
+ */
+void _anjay_notify_attributes_changed(anjay_t *anjay);
+
 typedef int
 anjay_notify_callback_t(anjay_t *anjay, anjay_notify_queue_t queue, void *data);
 
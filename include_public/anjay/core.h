@@ -74,6 +74,29 @@ typedef struct anjay_struct anjay_t;
     }
 // clang-format on
 
+/**
+ * Policy of sending multiple notifications stored for a single observation,
+ * e.g. when the connection becomes available again after being offline.
+ */
+typedef enum {
+    /**
+     * Each stored notification is sent as a separate message, in order.
+     */
+    ANJAY_STORED_NOTIFICATIONS_SEND_ALL = 0,
+    /**
+     * Only the most recent stored value is sent; older ones are discarded.
+     */
+    ANJAY_STORED_NOTIFICATIONS_SEND_LATEST,
+    /**
+     * All stored values are sent in a single notification, each record with
+     * its own timestamp. This is only possible if the observation uses a
+     * SenML-like Content-Format (LwM2M JSON or SenML CBOR); otherwise, the
+     * values are sent separately as with
+     * @ref ANJAY_STORED_NOTIFICATIONS_SEND_ALL .
+     */
+    ANJAY_STORED_NOTIFICATIONS_SEND_BATCHED
+} anjay_stored_notifications_mode_t;
+
 typedef struct anjay_configuration {
     /**
      * Endpoint name as presented to the LwM2M server. Must be non-NULL, or
@@ -118,6 +141,9 @@ typedef struct anjay_configuration {
      *
      * NOTE: while a single cache is used for all LwM2M servers, cached
      * responses are tied to a particular server and not reused for other ones.
+     *
+     * NOTE: in addition to this many bytes, the cache allocates an index of
+     * message IDs. The index takes at most 60% of this value plus 16 bytes.
      */
     size_t msg_cache_size;
 
@@ -214,6 +240,8 @@ typedef struct anjay_configuration {
      * If set to a positive value, that much *most recent* notifications are
      * stored. Attempting to add a notification to the queue while it is
      * already full drops the oldest one to make room for new one.
+     * Notifications that are currently being sent are never dropped; if all
+     * queued notifications are being sent, the new one is dropped instead.
      */
     size_t stored_notification_limit;
 
@@ -246,6 +274,72 @@ typedef struct anjay_configuration {
      */
     avs_net_socket_tls_ciphersuites_t default_tls_ciphersuites;
 
+    /**
+     * Number of recently sent notifications remembered for each CoAP/UDP
+     * connection, so that a Reset response to any of them is recognized as
+     * cancellation of the observation. If notifications are sent at a high
+     * rate, this should be large enough to cover all notifications sent
+     * during the time a Reset response may arrive.
+     *
+     * If set to 0, a compile-time default is used.
+     */
+    size_t udp_notify_cache_size;
+
+    /**
+     * Maximum number of notifications that may be awaiting delivery
+     * confirmation at the same time on a single connection. Notifications for
+     * the same observation are always delivered one at a time and in order;
+     * higher values only allow notifications for different observations to be
+     * sent without waiting for the previous ones to be acknowledged.
+     *
+     * For CoAP/UDP, Confirmable notifications exceeding NSTART are additionally
+     * held back by the CoAP layer until earlier exchanges finish.
+     *
+     * If set to 0 or 1 (default), notifications are sent one at a time.
+     */
+    size_t max_notifications_in_flight;
+
+    /**
+     * Granularity of observation timers (pmin, pmax and the like). Timers due
+     * within the same period of this length are handled together in a single
+     * scheduler job, which reduces the number of wakeups if there are many
+     * observations. Notifications are never sent early because of this, but
+     * may be delayed by up to this amount of time.
+     *
+     * If not set or shorter than 1 ms, 1 ms is used, which effectively makes
+     * notifications fire at their exact times.
+     */
+    avs_time_duration_t notification_timer_granularity;
+
+    /**
+     * Controls how multiple stored notifications for the same observation are
+     * sent once it is possible to send them. See
+     * @ref anjay_stored_notifications_mode_t for details.
+     */
+    anjay_stored_notifications_mode_t stored_notifications_mode;
+
+    /**
+     * Maximum size of payload buffered for a single incoming request, and
+     * separately for its response.
+     *
+     * Requests larger than that, e.g. firmware images written to /5/0/0, are
+     * passed to the data model handlers as their chunks arrive, in which case
+     * @ref anjay_serve blocks until the whole request is handled. Responses
+     * larger than that are replaced with 5.00 Internal Server Error.
+     *
+     * If set to 0, a compile-time default of the CoAP library is used.
+     */
+    size_t coap_max_buffered_payload_size;
+
+    /**
+     * Maximum number of incoming requests handled at the same time on a single
+     * connection, including ones waiting for further block-wise transfer
+     * chunks. Any more requests are rejected with 5.03 Service Unavailable.
+     *
+     * If set to 0, a compile-time default of the CoAP library is used.
+     */
+    size_t coap_max_pending_requests;
+
 } anjay_configuration_t;
 
 /**
@@ -663,6 +757,55 @@ int anjay_exit_offline(anjay_t *anjay);
  */
 bool anjay_all_connections_failed(anjay_t *anjay);
 
+/**
+ * Dumps the state of observations established by all registered LwM2M
+ * Servers, along with their registration information, into @p out_stream.
+ *
+ * The stored state includes, for each observation, the token and options of
+ * the original Observe request, the observed paths, the last value sent to the
+ * server and any notifications that were queued for sending, but not delivered
+ * yet. It may be used with @ref anjay_observe_restore after the device is
+ * restarted, so that the client may resume its registration with an Update
+ * message and continue sending notifications without requiring the server to
+ * re-establish the observations.
+ *
+ * Only servers with a valid registration are taken into account. Notifications
+ * that are being delivered at the time of calling this function are stored
+ * as unsent.
+ *
+ * NOTE: This function is only supported if Anjay is compiled with Observe and
+ * persistence support, and avs_coap with observation persistence support
+ * enabled. Otherwise, it returns <c>avs_errno(AVS_ENOTSUP)</c>.
+ *
+ * @param anjay      Anjay object to operate on.
+ * @param out_stream Stream to write to.
+ *
+ * @returns AVS_OK in case of success, or an error code in case of failure.
+ */
+avs_error_t anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream);
+
+/**
+ * Reads the observation state previously stored using
+ * @ref anjay_observe_persist from @p in_stream .
+ *
+ * The data is not applied immediately. Observations are restored for each
+ * connection when it is first brought online, and registration information is
+ * used to send a Registration Update instead of a Register message, as long as
+ * the registration lifetime has not passed in the meantime. Information
+ * related to servers that are not configured in the data model is ignored.
+ *
+ * This function MUST be called before the first call to
+ * @ref anjay_sched_run , after the Security and Server objects are populated.
+ * Calling it after any connection has been established is an error.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param in_stream Stream to read the persisted state from.
+ *
+ * @returns AVS_OK in case of success, or an error code in case of failure.
+ *          In case of failure, no state is restored.
+ */
+avs_error_t anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream);
+
 typedef struct {
     /**
      * DTLS keys or certificates.
@@ -152,6 +152,68 @@ int anjay_dm_list_instances_SINGLE(anjay_t *anjay,
                                    const anjay_dm_object_def_t *const *obj_ptr,
                                    anjay_dm_list_ctx_t *ctx);
 
+/**
+ * An optional handler that checks whether an Object Instance with a given
+ * Instance ID exists.
+ *
+ * If this handler is not implemented, the library determines presence of an
+ * Object Instance by calling @ref anjay_dm_list_instances_t and looking for
+ * the Instance ID in the result. Implementing it is only worthwhile for Objects
+ * with large numbers of Instances, that are able to perform the lookup faster
+ * than by enumerating them.
+ *
+ * The result MUST be consistent with what @ref anjay_dm_list_instances_t would
+ * return at the same time.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param obj_ptr Object definition pointer, as passed to
+ *                @ref anjay_register_object .
+ * @param iid     Instance ID to check.
+ *
+ * @returns This handler should return:
+ * - 1 if the Object Instance exists,
+ * - 0 if it does not,
+ * - a negative value in case of error. If it returns one of ANJAY_ERR_
+ *   constants, the response message will have an appropriate CoAP response
+ *   code. Otherwise, the device will respond with an unspecified (but valid)
+ *   error code.
+ */
+typedef int
+anjay_dm_instance_present_t(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid);
+
+/**
+ * An optional handler that selects an Instance ID for a new Object Instance,
+ * used when the server performs a Create operation without specifying one.
+ *
+ * If this handler is not implemented, the library calls
+ * @ref anjay_dm_list_instances_t and picks the lowest Instance ID that is not
+ * in use. Implementing it is only worthwhile for Objects with large numbers of
+ * Instances, that are able to find a free Instance ID faster than by
+ * enumerating them.
+ *
+ * It is recommended, but not required, that the lowest free Instance ID is
+ * returned, for consistency with the default behaviour.
+ *
+ * @param      anjay   Anjay object to operate on.
+ * @param      obj_ptr Object definition pointer, as passed to
+ *                     @ref anjay_register_object .
+ * @param[out] out_iid Instance ID that is not currently in use. It MUST NOT be
+ *                     <c>ANJAY_ID_INVALID</c>.
+ *
+ * @returns This handler should return:
+ * - 0 on success,
+ * - a negative value in case of error, including the case when no free
+ *   Instance ID is available. If it returns one of ANJAY_ERR_ constants, the
+ *   response message will have an appropriate CoAP response code. Otherwise,
+ *   the device will respond with an unspecified (but valid) error code.
+ */
+typedef int
+anjay_dm_instance_select_free_iid_t(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    anjay_iid_t *out_iid);
+
 /**
  * A handler that shall reset Object Instance to its default (after creational)
  * state.
@@ -719,8 +781,31 @@ typedef struct {
      */
     anjay_dm_transaction_rollback_t *transaction_rollback;
 
+    /**
+     * Check whether an Object Instance exists (optional),
+     * @ref anjay_dm_instance_present_t
+     */
+    anjay_dm_instance_present_t *instance_present;
+    /**
+     * Select an Instance ID for a new Object Instance (optional),
+     * @ref anjay_dm_instance_select_free_iid_t
+     */
+    anjay_dm_instance_select_free_iid_t *instance_select_free_iid;
 } anjay_dm_handlers_t;
 
+/**
+ * An entry of a static Resource table, see
+ * @ref anjay_dm_object_def_struct::resources .
+ */
+typedef struct {
+    /** Resource ID; MUST NOT be <c>ANJAY_ID_INVALID</c> (65535) */
+    anjay_rid_t rid;
+    /** Kind of the Resource */
+    anjay_dm_resource_kind_t kind;
+    /** Presence of the Resource in all Instances of the Object */
+    anjay_dm_resource_presence_t presence;
+} anjay_dm_resource_def_t;
+
 /** A struct defining an LwM2M Object. */
 struct anjay_dm_object_def_struct {
     /** Object ID; MUST not be <c>ANJAY_ID_INVALID</c> (65535) */
@@ -736,6 +821,22 @@ struct anjay_dm_object_def_struct {
 
     /** Handler callbacks for this object. */
     anjay_dm_handlers_t handlers;
+
+    /**
+     * Static table of Resources supported by this object (optional). If set,
+     * the library uses it instead of calling
+     * @ref anjay_dm_handlers_t::list_resources, which may then be left NULL.
+     * This is only suitable for Objects in which the set of Resources, their
+     * kinds and presence are the same for all Instances and never change.
+     *
+     * The table MUST be sorted by Resource ID in strictly ascending order, and
+     * needs to have static lifetime. It is validated in
+     * @ref anjay_register_object .
+     */
+    const anjay_dm_resource_def_t *resources;
+
+    /** Number of entries in @ref anjay_dm_object_def_struct::resources . */
+    size_t resources_count;
 };
 
 /**
@@ -761,6 +862,35 @@ int anjay_notify_changed(anjay_t *anjay,
                          anjay_iid_t iid,
                          anjay_rid_t rid);
 
+/**
+ * Identifies a single Resource, as passed to @ref anjay_notify_changed_many.
+ */
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    anjay_rid_t rid;
+} anjay_notify_resource_t;
+
+/**
+ * Notifies the library that the values of multiple Resources changed. This is
+ * equivalent to calling @ref anjay_notify_changed for each of them, but is
+ * cheaper when many changes are reported at once, e.g. after polling a batch of
+ * sensor readings.
+ *
+ * Duplicate entries are allowed and reported only once. Entries are processed
+ * in order; an entry containing @ref ANJAY_ID_INVALID is treated as an error.
+ *
+ * @param anjay          Anjay object to operate on.
+ * @param resources      Array of changed Resources.
+ * @param resource_count Number of elements in the @p resources array.
+ *
+ * @returns 0 on success, a negative value in case of error. In case of error,
+ *          changes preceding the failed entry are still reported.
+ */
+int anjay_notify_changed_many(anjay_t *anjay,
+                              const anjay_notify_resource_t *resources,
+                              size_t resource_count);
+
 /**
  * Notifies the library that the set of Instances existing in a given Object
  * changed. It may trigger an LwM2M Notify message, update server connections
@@ -127,6 +127,26 @@ typedef void anjay_download_finished_handler_t(anjay_t *anjay,
                                                anjay_download_status_t status,
                                                void *user_data);
 
+/**
+ * Download progress, as written to
+ * @ref anjay_download_config_t#checkpoint_stream and read back using
+ * @ref anjay_download_checkpoint_read .
+ */
+typedef struct anjay_download_checkpoint {
+    /** URL of the downloaded resource. */
+    char *url;
+
+    /**
+     * Number of bytes of the resource that have been successfully passed to
+     * @ref anjay_download_config_t#on_next_block , including
+     * @ref anjay_download_config_t#start_offset .
+     */
+    size_t offset;
+
+    /** ETag of the resource, or NULL if the server did not send any. */
+    anjay_etag_t *etag;
+} anjay_download_checkpoint_t;
+
 typedef struct anjay_download_config {
     /** Required. coap://, coaps://, http:// or https:// URL */
     const char *url;
@@ -168,6 +188,82 @@ typedef struct anjay_download_config {
      * inherit parameters from Anjay.
      */
     avs_coap_udp_tx_params_t *coap_tx_params;
+
+    /**
+     * Maximum number of BLOCK2 requests kept in flight at the same time for
+     * coap:// and coaps:// downloads. If greater than 1, consecutive blocks
+     * are requested concurrently (over the same socket and DTLS session) and
+     * reassembled in order before being passed to @ref on_next_block, which
+     * may significantly speed up downloads over links with high latency.
+     *
+     * NSTART transmission parameter is raised to this value for the download
+     * if necessary. The downloader keeps a buffer of the negotiated block
+     * size for each block in the window.
+     *
+     * 0 or 1 means a regular, sequential block-wise transfer. Ignored for
+     * HTTP downloads.
+     */
+    size_t coap_block_window_size;
+
+    /**
+     * Stream to which the download progress is checkpointed, or NULL if
+     * checkpoints shall not be written.
+     *
+     * A checkpoint is written whenever at least @ref checkpoint_interval bytes
+     * have been passed to @ref on_next_block since the previous one, and once
+     * more when the download fails or is aborted - including when Anjay is
+     * being destroyed. If the download finishes successfully, or the resource
+     * changes on the server, the checkpoint is invalidated instead.
+     *
+     * Each checkpoint replaces the previous one: the stream is reset using
+     * <c>avs_stream_reset()</c>, then the checkpoint is written, and
+     * <c>avs_stream_finish_message()</c> is called, so that the stream may
+     * commit it to non-volatile storage.
+     *
+     * If the transfer fails due to a network error, it is automatically
+     * resumed from the checkpointed offset, see @ref max_resume_attempts .
+     * After a reboot, the download may be restarted from the checkpoint by
+     * setting @ref resume_from_checkpoint , or by reading it manually using
+     * @ref anjay_download_checkpoint_read . In both cases, data passed to
+     * @ref on_next_block past the checkpointed offset might need to be
+     * discarded by the application.
+     *
+     * The stream MUST remain valid until
+     * @ref anjay_download_config_t#on_download_finished is called. Requires
+     * Anjay to be compiled with persistence support.
+     */
+    avs_stream_t *checkpoint_stream;
+
+    /**
+     * Minimum number of bytes between consecutive checkpoints written to
+     * @ref checkpoint_stream . If 0, a checkpoint is written after every call
+     * to @ref on_next_block .
+     */
+    size_t checkpoint_interval;
+
+    /**
+     * If set to true, and @ref checkpoint_stream contains a valid checkpoint
+     * for the same @ref url , the download starts from the checkpointed offset
+     * and ETag, and @ref start_offset and @ref etag are ignored. Otherwise, the
+     * download is started as if this flag was not set.
+     *
+     * Note that unless @ref checkpoint_interval is 0, the application might
+     * have already stored data past the checkpointed offset.
+     */
+    bool resume_from_checkpoint;
+
+    /**
+     * Maximum number of consecutive attempts to automatically resume
+     * a transfer that failed due to a network error, without making any
+     * progress in between. Attempts are delayed exponentially, starting from
+     * 1 second, up to 64 seconds.
+     *
+     * If 0, the transfer is not resumed automatically and
+     * @ref on_download_finished is called immediately with
+     * @ref ANJAY_DOWNLOAD_ERR_FAILED . Only applicable if
+     * @ref checkpoint_stream is not NULL.
+     */
+    size_t max_resume_attempts;
 } anjay_download_config_t;
 
 typedef void *anjay_download_handle_t;
@@ -210,6 +306,38 @@ avs_error_t anjay_download(anjay_t *anjay,
  */
 void anjay_download_abort(anjay_t *anjay, anjay_download_handle_t dl_handle);
 
+/**
+ * Reads a checkpoint written by the downloader to
+ * @ref anjay_download_config_t#checkpoint_stream .
+ *
+ * To resume the download, @ref anjay_download_checkpoint_t#url ,
+ * @ref anjay_download_checkpoint_t#offset and
+ * @ref anjay_download_checkpoint_t#etag shall be passed to
+ * @ref anjay_download as @ref anjay_download_config_t#url ,
+ * @ref anjay_download_config_t#start_offset and
+ * @ref anjay_download_config_t#etag , respectively.
+ *
+ * @param in_stream      Stream to read the checkpoint from.
+ * @param out_checkpoint Structure to fill with the checkpoint data. Its
+ *                       contents MUST be freed using
+ *                       @ref anjay_download_checkpoint_cleanup if this
+ *                       function succeeds.
+ *
+ * @returns <c>AVS_OK</c> on success, or an error value if there is no valid
+ *          checkpoint in @p in_stream , or checkpoints are not supported by
+ *          this build of Anjay. <c>*out_checkpoint</c> is not modified in
+ *          the latter cases.
+ */
+avs_error_t
+anjay_download_checkpoint_read(avs_stream_t *in_stream,
+                               anjay_download_checkpoint_t *out_checkpoint);
+
+/**
+ * Frees all data owned by @p checkpoint , previously filled by
+ * @ref anjay_download_checkpoint_read .
+ */
+void anjay_download_checkpoint_cleanup(anjay_download_checkpoint_t *checkpoint);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -195,6 +195,8 @@ avs_error_t anjay_access_control_restore(anjay_t *anjay, avs_stream_t *in) {
         return avs_errno(AVS_EBADMSG);
     }
     if (avs_is_ok((err = restore(anjay, ac, in)))) {
+        // the state has been replaced without performing any notifications
+        _anjay_access_control_index_invalidate(anjay);
         _anjay_access_control_clear_modified(ac);
         ac_log(INFO, _("Access Control state restored"));
     }
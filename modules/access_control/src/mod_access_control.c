@@ -262,6 +262,12 @@ static int set_acl(anjay_t *anjay,
     if (!ac_instance_needs_inserting) {
         if (!result) {
             _anjay_access_control_mark_modified(ac);
+            if (anjay_notify_changed(anjay, ANJAY_DM_OID_ACCESS_CONTROL,
+                                     ac_instance->iid,
+                                     ANJAY_DM_RID_ACCESS_CONTROL_ACL)) {
+                ac_log(WARNING,
+                       _("error while calling anjay_notify_changed()"));
+            }
         }
         return result;
     }
@@ -279,7 +285,7 @@ static int set_acl(anjay_t *anjay,
         assert(AVS_LIST_SIZE(dm_changes) == 1);
         assert(AVS_LIST_SIZE(dm_changes->instance_set_changes.known_added_iids)
                == 1);
-        assert(!dm_changes->resources_changed);
+        assert(!AVS_RBTREE_FIRST(dm_changes->resources_changed));
         _anjay_access_control_mark_modified(ac);
         _anjay_notify_instance_created(
                 anjay, dm_changes->oid,
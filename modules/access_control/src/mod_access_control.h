@@ -23,6 +23,7 @@
 
 #include <anjay/access_control.h>
 
+#include <anjay_modules/access_utils.h>
 #include <anjay_modules/dm_utils.h>
 #include <anjay_modules/notify.h>
 #include <anjay_modules/utils_core.h>
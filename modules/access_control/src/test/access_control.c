@@ -148,3 +148,63 @@ AVS_UNIT_TEST(access_control, set_acl) {
 
     DM_TEST_FINISH;
 }
+
+static bool read_allowed(anjay_t *anjay, anjay_iid_t iid, anjay_ssid_t ssid) {
+    return _anjay_instance_action_allowed(
+            anjay, &(const anjay_action_info_t) {
+                       .oid = TEST_OID,
+                       .iid = iid,
+                       .ssid = ssid,
+                       .action = ANJAY_ACTION_READ
+                   });
+}
+
+AVS_UNIT_TEST(access_control, acl_index_invalidation) {
+    const anjay_dm_object_def_t *const *obj_defs[] = { &FAKE_SECURITY,
+                                                       &FAKE_SERVER, &TEST };
+    anjay_ssid_t ssids[] = { 1, 2 };
+    DM_TEST_INIT_GENERIC(obj_defs, ssids, DM_TEST_CONFIGURATION());
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_install(anjay));
+
+    // prevent sending Update, as that will fail in the test environment
+    AVS_LIST(anjay_server_info_t) server;
+    AVS_LIST_FOREACH(server, anjay->servers->servers) {
+        avs_sched_del(&server->next_action_handle);
+    }
+
+    anjay_sched_run(anjay);
+
+    access_control_t *ac = _anjay_access_control_get(anjay);
+    AVS_LIST(access_control_instance_t) inst =
+            _anjay_access_control_create_missing_ac_instance(
+                    1, &(const acl_target_t) { TEST_OID, 1 });
+    AVS_UNIT_ASSERT_NOT_NULL(inst);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_access_control_add_instance(ac, inst, NULL));
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+
+    AVS_UNIT_ASSERT_TRUE(read_allowed(anjay, 1, 1));
+    AVS_UNIT_ASSERT_FALSE(read_allowed(anjay, 1, 2));
+    AVS_UNIT_ASSERT_FALSE(read_allowed(anjay, 2, 1));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->access_control_index);
+
+    // modification without notification is not visible...
+    ac->current.instances->acl->mask = ANJAY_ACCESS_MASK_NONE;
+    AVS_UNIT_ASSERT_TRUE(read_allowed(anjay, 1, 1));
+
+    // ...until a notification drops the index
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(
+            anjay, ANJAY_DM_OID_ACCESS_CONTROL, ac->current.instances->iid,
+            ANJAY_DM_RID_ACCESS_CONTROL_ACL));
+    AVS_UNIT_ASSERT_NULL(anjay->access_control_index);
+    AVS_UNIT_ASSERT_FALSE(read_allowed(anjay, 1, 1));
+
+    // changes made through the module API are picked up as well
+    AVS_UNIT_ASSERT_SUCCESS(anjay_access_control_set_acl(
+            anjay, TEST_OID, 1, ANJAY_SSID_ANY, ANJAY_ACCESS_MASK_READ));
+    AVS_UNIT_ASSERT_FALSE(read_allowed(anjay, 1, 1));
+    AVS_UNIT_ASSERT_TRUE(read_allowed(anjay, 1, 2));
+
+    DM_TEST_FINISH;
+}
@@ -23,6 +23,7 @@
 
 #include <anjay_modules/dm_utils.h>
 #include <anjay_modules/io_utils.h>
+#include <anjay_modules/notify.h>
 #include <anjay_modules/raw_buffer.h>
 
 #include "mod_attr_storage.h"
@@ -400,6 +401,7 @@ _anjay_attr_storage_persist_inner(anjay_attr_storage_t *attr_storage,
 avs_error_t _anjay_attr_storage_restore_inner(
         anjay_t *anjay, anjay_attr_storage_t *attr_storage, avs_stream_t *in) {
     _anjay_attr_storage_clear(attr_storage);
+    _anjay_notify_attributes_changed(anjay);
 
     if (avs_is_eof(avs_stream_peek(in, 0, &(char) { 0 }))) {
         // empty stream, treat as success
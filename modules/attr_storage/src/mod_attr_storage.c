@@ -24,6 +24,7 @@
 #include <avsystem/commons/stream/stream_membuf.h>
 
 #include <anjay_modules/dm_utils.h>
+#include <anjay_modules/notify.h>
 #include <anjay_modules/raw_buffer.h>
 
 #include "mod_attr_storage.h"
@@ -113,6 +114,7 @@ void anjay_attr_storage_purge(anjay_t *anjay) {
     }
     _anjay_attr_storage_clear(as);
     _anjay_attr_storage_mark_modified(as);
+    _anjay_notify_attributes_changed(anjay);
 }
 
 //// HELPERS ///////////////////////////////////////////////////////////////////
@@ -685,8 +687,10 @@ as_notify_callback(anjay_t *anjay, anjay_notify_queue_t queue, void *data) {
             const anjay_dm_object_def_t *const *obj_ptr =
                     _anjay_dm_find_object_by_oid(anjay, object_entry->oid);
             anjay_iid_t last_iid = ANJAY_ID_INVALID;
-            AVS_LIST(anjay_notify_queue_resource_entry_t) resource_entry;
-            AVS_LIST_FOREACH(resource_entry, object_entry->resources_changed) {
+            AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t)
+                    resource_entry;
+            AVS_RBTREE_FOREACH(resource_entry,
+                               object_entry->resources_changed) {
                 if (resource_entry->iid != last_iid) {
                     // note that remove_absent_resources() does NOT call
                     // remove_object_if_empty().
@@ -77,6 +77,9 @@ static int add_instance(sec_repr_t *repr,
     } else if (find_instance(repr, *inout_iid)) {
         return -1;
     }
+    if (_anjay_sec_transaction_save_instance(repr, *inout_iid)) {
+        return -1;
+    }
     AVS_LIST(sec_instance_t) new_instance =
             AVS_LIST_NEW_ELEMENT(sec_instance_t);
     if (!new_instance) {
@@ -186,6 +189,10 @@ static int del_instance(sec_repr_t *repr, anjay_iid_t iid) {
     AVS_LIST(sec_instance_t) *it;
     AVS_LIST_FOREACH_PTR(it, &repr->instances) {
         if ((*it)->iid == iid) {
+            int result = _anjay_sec_transaction_save_instance(repr, iid);
+            if (result) {
+                return result;
+            }
             AVS_LIST(sec_instance_t) element = AVS_LIST_DETACH(it);
             _anjay_sec_destroy_instances(&element);
             _anjay_sec_mark_modified(repr);
@@ -303,9 +310,12 @@ static int sec_write(anjay_t *anjay,
     assert(riid == ANJAY_ID_INVALID);
     sec_repr_t *repr = _anjay_sec_get(obj_ptr);
     sec_instance_t *inst = find_instance(repr, iid);
-    int retval;
     assert(inst);
 
+    int retval = _anjay_sec_transaction_save_instance(repr, iid);
+    if (retval) {
+        return retval;
+    }
     _anjay_sec_mark_modified(repr);
 
     switch ((security_resource_t) rid) {
@@ -381,6 +391,10 @@ static int sec_instance_create(anjay_t *anjay,
     sec_repr_t *repr = _anjay_sec_get(obj_ptr);
     assert(iid != ANJAY_ID_INVALID);
 
+    int result = _anjay_sec_transaction_save_instance(repr, iid);
+    if (result) {
+        return result;
+    }
     AVS_LIST(sec_instance_t) created = AVS_LIST_NEW_ELEMENT(sec_instance_t);
     if (!created) {
         return ANJAY_ERR_INTERNAL;
@@ -438,9 +452,14 @@ static int sec_instance_reset(anjay_t *anjay,
                               const anjay_dm_object_def_t *const *obj_ptr,
                               anjay_iid_t iid) {
     (void) anjay;
-    sec_instance_t *inst = find_instance(_anjay_sec_get(obj_ptr), iid);
+    sec_repr_t *repr = _anjay_sec_get(obj_ptr);
+    sec_instance_t *inst = find_instance(repr, iid);
     assert(inst);
 
+    int result = _anjay_sec_transaction_save_instance(repr, iid);
+    if (result) {
+        return result;
+    }
     _anjay_sec_destroy_instance_fields(inst);
     memset(inst, 0, sizeof(sec_instance_t));
     inst->iid = iid;
@@ -508,7 +527,7 @@ static void security_purge(sec_repr_t *repr) {
         _anjay_sec_mark_modified(repr);
     }
     _anjay_sec_destroy_instances(&repr->instances);
-    _anjay_sec_destroy_instances(&repr->saved_instances);
+    _anjay_sec_transaction_cleanup(repr);
 }
 
 static void security_delete(void *repr) {
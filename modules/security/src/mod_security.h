@@ -72,10 +72,22 @@ typedef struct {
 
 } sec_instance_t;
 
+/**
+ * State of a single instance from before the current transaction. It is saved
+ * the first time the instance is modified, created or removed within the
+ * transaction, so that instances not touched by it are never copied.
+ */
+typedef struct {
+    anjay_iid_t iid;
+    // NULL if the instance did not exist when the transaction began
+    AVS_LIST(sec_instance_t) instance;
+} sec_saved_instance_t;
+
 typedef struct {
     const anjay_dm_object_def_t *def;
     AVS_LIST(sec_instance_t) instances;
-    AVS_LIST(sec_instance_t) saved_instances;
+    AVS_LIST(sec_saved_instance_t) saved_instances;
+    bool in_transaction;
     bool modified_since_persist;
     bool saved_modified_since_persist;
 } sec_repr_t;
@@ -192,18 +192,56 @@ finish:
     return result;
 }
 
-int _anjay_sec_transaction_begin_impl(sec_repr_t *repr) {
-    assert(!repr->saved_instances);
-    repr->saved_instances = _anjay_sec_clone_instances(repr);
-    if (!repr->saved_instances && repr->instances) {
+static void
+destroy_saved_instances(AVS_LIST(sec_saved_instance_t) *saved_ptr) {
+    AVS_LIST_CLEAR(saved_ptr) {
+        _anjay_sec_destroy_instances(&(*saved_ptr)->instance);
+    }
+}
+
+int _anjay_sec_transaction_save_instance(sec_repr_t *repr, anjay_iid_t iid) {
+    if (!repr->in_transaction) {
+        return 0;
+    }
+    AVS_LIST(sec_saved_instance_t) *saved_ptr;
+    AVS_LIST_FOREACH_PTR(saved_ptr, &repr->saved_instances) {
+        if ((*saved_ptr)->iid == iid) {
+            // already saved earlier in this transaction
+            return 0;
+        }
+    }
+    AVS_LIST(sec_saved_instance_t) saved =
+            AVS_LIST_NEW_ELEMENT(sec_saved_instance_t);
+    if (!saved) {
+        security_log(ERROR, _("out of memory"));
         return ANJAY_ERR_INTERNAL;
     }
+    saved->iid = iid;
+    AVS_LIST(sec_instance_t) it;
+    AVS_LIST_FOREACH(it, repr->instances) {
+        if (it->iid == iid) {
+            if (!(saved->instance = _anjay_sec_clone_instance(it))) {
+                AVS_LIST_DELETE(&saved);
+                return ANJAY_ERR_INTERNAL;
+            }
+            break;
+        }
+    }
+    AVS_LIST_INSERT(saved_ptr, saved);
+    return 0;
+}
+
+int _anjay_sec_transaction_begin_impl(sec_repr_t *repr) {
+    assert(!repr->in_transaction);
+    assert(!repr->saved_instances);
+    repr->in_transaction = true;
     repr->saved_modified_since_persist = repr->modified_since_persist;
     return 0;
 }
 
 int _anjay_sec_transaction_commit_impl(sec_repr_t *repr) {
-    _anjay_sec_destroy_instances(&repr->saved_instances);
+    destroy_saved_instances(&repr->saved_instances);
+    repr->in_transaction = false;
     return 0;
 }
 
@@ -212,9 +250,28 @@ int _anjay_sec_transaction_validate_impl(anjay_t *anjay, sec_repr_t *repr) {
 }
 
 int _anjay_sec_transaction_rollback_impl(sec_repr_t *repr) {
-    _anjay_sec_destroy_instances(&repr->instances);
-    repr->instances = repr->saved_instances;
-    repr->saved_instances = NULL;
+    AVS_LIST_CLEAR(&repr->saved_instances) {
+        sec_saved_instance_t *saved = repr->saved_instances;
+        AVS_LIST(sec_instance_t) *it;
+        AVS_LIST_FOREACH_PTR(it, &repr->instances) {
+            if ((*it)->iid >= saved->iid) {
+                break;
+            }
+        }
+        if (*it && (*it)->iid == saved->iid) {
+            AVS_LIST(sec_instance_t) modified = AVS_LIST_DETACH(it);
+            _anjay_sec_destroy_instances(&modified);
+        }
+        if (saved->instance) {
+            AVS_LIST_INSERT(it, saved->instance);
+            saved->instance = NULL;
+        }
+    }
+    repr->in_transaction = false;
     repr->modified_since_persist = repr->saved_modified_since_persist;
     return 0;
 }
+
+void _anjay_sec_transaction_cleanup(sec_repr_t *repr) {
+    destroy_saved_instances(&repr->saved_instances);
+}
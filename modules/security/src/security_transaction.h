@@ -29,6 +29,20 @@ int _anjay_sec_transaction_commit_impl(sec_repr_t *repr);
 int _anjay_sec_transaction_validate_impl(anjay_t *anjay, sec_repr_t *repr);
 int _anjay_sec_transaction_rollback_impl(sec_repr_t *repr);
 
+/**
+ * Saves the current state of instance @p iid (or the fact that it does not
+ * exist), so that it can be restored on rollback. MUST be called before the
+ * instance is modified, created or removed. Does nothing if no transaction is
+ * in progress, or if the instance has already been saved within the current
+ * one.
+ */
+int _anjay_sec_transaction_save_instance(sec_repr_t *repr, anjay_iid_t iid);
+
+/**
+ * Frees all instance states saved within the current transaction.
+ */
+void _anjay_sec_transaction_cleanup(sec_repr_t *repr);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* SECURITY_TRANSACTION_H */
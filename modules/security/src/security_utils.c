@@ -115,9 +115,18 @@ void _anjay_sec_destroy_instances(AVS_LIST(sec_instance_t) *instances_ptr) {
     }
 }
 
-static int _anjay_sec_clone_instance(sec_instance_t *dest,
-                                     const sec_instance_t *src) {
+static int clone_instance_fields(sec_instance_t *dest,
+                                 const sec_instance_t *src) {
     *dest = *src;
+    // reset all owned fields first, so that dest may be safely destroyed if
+    // cloning any of them fails
+    dest->server_uri = NULL;
+    dest->public_cert_or_psk_identity = ANJAY_RAW_BUFFER_EMPTY;
+    dest->private_cert_or_psk_key = ANJAY_RAW_BUFFER_EMPTY;
+    dest->server_public_key = ANJAY_RAW_BUFFER_EMPTY;
+    dest->sms_key_params = ANJAY_RAW_BUFFER_EMPTY;
+    dest->sms_secret_key = ANJAY_RAW_BUFFER_EMPTY;
+    dest->sms_number = NULL;
 
     dest->server_uri = avs_strdup(src->server_uri);
     if (!dest->server_uri) {
@@ -125,42 +134,36 @@ static int _anjay_sec_clone_instance(sec_instance_t *dest,
         return -1;
     }
 
-    dest->public_cert_or_psk_identity = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->public_cert_or_psk_identity,
                                 &src->public_cert_or_psk_identity)) {
         security_log(ERROR, _("Cannot clone Pk Or Identity resource"));
         return -1;
     }
 
-    dest->private_cert_or_psk_key = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->private_cert_or_psk_key,
                                 &src->private_cert_or_psk_key)) {
         security_log(ERROR, _("Cannot clone Secret Key resource"));
         return -1;
     }
 
-    dest->server_public_key = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->server_public_key,
                                 &src->server_public_key)) {
         security_log(ERROR, _("Cannot clone Server Public Key resource"));
         return -1;
     }
 
-    dest->sms_key_params = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->sms_key_params, &src->sms_key_params)) {
         security_log(ERROR,
                      _("Cannot clone SMS Binding Key Parameters resource"));
         return -1;
     }
 
-    dest->sms_secret_key = ANJAY_RAW_BUFFER_EMPTY;
     if (_anjay_raw_buffer_clone(&dest->sms_secret_key, &src->sms_secret_key)) {
         security_log(ERROR,
                      _("Cannot clone SMS Binding Secret Key(s) resource"));
         return -1;
     }
 
-    dest->sms_number = NULL;
     if (src->sms_number) {
         dest->sms_number = avs_strdup(src->sms_number);
         if (!dest->sms_number) {
@@ -172,6 +175,19 @@ static int _anjay_sec_clone_instance(sec_instance_t *dest,
     return 0;
 }
 
+AVS_LIST(sec_instance_t)
+_anjay_sec_clone_instance(const sec_instance_t *instance) {
+    AVS_LIST(sec_instance_t) clone = AVS_LIST_NEW_ELEMENT(sec_instance_t);
+    if (!clone) {
+        security_log(ERROR, _("out of memory"));
+        return NULL;
+    }
+    if (clone_instance_fields(clone, instance)) {
+        _anjay_sec_destroy_instances(&clone);
+    }
+    return clone;
+}
+
 AVS_LIST(sec_instance_t) _anjay_sec_clone_instances(const sec_repr_t *repr) {
     AVS_LIST(sec_instance_t) retval = NULL;
     AVS_LIST(sec_instance_t) current;
@@ -180,7 +196,7 @@ AVS_LIST(sec_instance_t) _anjay_sec_clone_instances(const sec_repr_t *repr) {
 
     AVS_LIST_FOREACH(current, repr->instances) {
         if (AVS_LIST_INSERT_NEW(sec_instance_t, last)) {
-            if (_anjay_sec_clone_instance(*last, current)) {
+            if (clone_instance_fields(*last, current)) {
                 security_log(ERROR,
                              _("Cannot clone Security Object Instances"));
                 _anjay_sec_destroy_instances(&retval);
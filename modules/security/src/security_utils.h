@@ -65,6 +65,13 @@ void _anjay_sec_destroy_instance_fields(sec_instance_t *instance);
  */
 void _anjay_sec_destroy_instances(AVS_LIST(sec_instance_t) *instances_ptr);
 
+/**
+ * Clones a single Security Object @p instance into a newly allocated list
+ * element. Returns NULL in case of an error.
+ */
+AVS_LIST(sec_instance_t)
+_anjay_sec_clone_instance(const sec_instance_t *instance);
+
 /**
  * Clones all instances of the given Security Object @p repr . Return NULL
  * if either there was nothing to clone or an error has occurred.
@@ -90,6 +90,9 @@ static int add_instance(server_repr_t *repr,
     } else if (find_instance(repr, *inout_iid)) {
         return -1;
     }
+    if (_anjay_serv_transaction_save_instance(repr, *inout_iid)) {
+        return -1;
+    }
     AVS_LIST(server_instance_t) new_instance =
             AVS_LIST_NEW_ELEMENT(server_instance_t);
     if (!new_instance) {
@@ -126,6 +129,10 @@ static int del_instance(server_repr_t *repr, anjay_iid_t iid) {
     AVS_LIST(server_instance_t) *it;
     AVS_LIST_FOREACH_PTR(it, &repr->instances) {
         if ((*it)->iid == iid) {
+            int result = _anjay_serv_transaction_save_instance(repr, iid);
+            if (result) {
+                return result;
+            }
             AVS_LIST_DELETE(it);
             _anjay_serv_mark_modified(repr);
             return 0;
@@ -168,6 +175,10 @@ static int serv_instance_create(anjay_t *anjay,
     (void) anjay;
     server_repr_t *repr = _anjay_serv_get(obj_ptr);
     assert(iid != ANJAY_ID_INVALID);
+    int result = _anjay_serv_transaction_save_instance(repr, iid);
+    if (result) {
+        return result;
+    }
     AVS_LIST(server_instance_t) created =
             AVS_LIST_NEW_ELEMENT(server_instance_t);
     if (!created) {
@@ -194,9 +205,14 @@ static int serv_instance_reset(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj_ptr,
                                anjay_iid_t iid) {
     (void) anjay;
-    server_instance_t *inst = find_instance(_anjay_serv_get(obj_ptr), iid);
+    server_repr_t *repr = _anjay_serv_get(obj_ptr);
+    server_instance_t *inst = find_instance(repr, iid);
     assert(inst);
 
+    int result = _anjay_serv_transaction_save_instance(repr, iid);
+    if (result) {
+        return result;
+    }
     bool has_ssid = inst->has_ssid;
     anjay_ssid_t ssid = inst->data.ssid;
     reset_instance_resources(inst);
@@ -291,7 +307,10 @@ static int serv_write(anjay_t *anjay,
     server_repr_t *repr = _anjay_serv_get(obj_ptr);
     server_instance_t *inst = find_instance(repr, iid);
     assert(inst);
-    int retval;
+    int retval = _anjay_serv_transaction_save_instance(repr, iid);
+    if (retval) {
+        return retval;
+    }
 
     _anjay_serv_mark_modified(repr);
 
@@ -448,7 +467,7 @@ static void server_purge(server_repr_t *repr) {
         _anjay_serv_mark_modified(repr);
     }
     _anjay_serv_destroy_instances(&repr->instances);
-    _anjay_serv_destroy_instances(&repr->saved_instances);
+    _anjay_serv_transaction_cleanup(repr);
 }
 
 static void server_delete(void *repr) {
@@ -47,10 +47,22 @@ typedef struct {
     bool has_notification_storing;
 } server_instance_t;
 
+/**
+ * State of a single instance from before the current transaction. It is saved
+ * the first time the instance is modified, created or removed within the
+ * transaction.
+ */
+typedef struct {
+    anjay_iid_t iid;
+    // NULL if the instance did not exist when the transaction began
+    AVS_LIST(server_instance_t) instance;
+} server_saved_instance_t;
+
 typedef struct {
     const anjay_dm_object_def_t *def;
     AVS_LIST(server_instance_t) instances;
-    AVS_LIST(server_instance_t) saved_instances;
+    AVS_LIST(server_saved_instance_t) saved_instances;
+    bool in_transaction;
     bool modified_since_persist;
     bool saved_modified_since_persist;
 } server_repr_t;
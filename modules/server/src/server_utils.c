@@ -51,15 +51,16 @@ int _anjay_serv_fetch_binding(anjay_input_ctx_t *ctx,
 }
 
 AVS_LIST(server_instance_t)
-_anjay_serv_clone_instances(const server_repr_t *repr) {
-    AVS_LIST(server_instance_t) clone = AVS_LIST_SIMPLE_CLONE(repr->instances);
-    if (clone) {
-        AVS_LIST(server_instance_t) it;
-        AVS_LIST_FOREACH(it, clone) {
-            if (it->data.binding) {
-                it->data.binding = it->binding_buf;
-            }
-        }
+_anjay_serv_clone_instance(const server_instance_t *instance) {
+    AVS_LIST(server_instance_t) clone =
+            AVS_LIST_NEW_ELEMENT(server_instance_t);
+    if (!clone) {
+        server_log(ERROR, _("out of memory"));
+        return NULL;
+    }
+    *clone = *instance;
+    if (clone->data.binding) {
+        clone->data.binding = clone->binding_buf;
     }
     return clone;
 }
@@ -128,6 +128,11 @@ static int read_mask(anjay_t *anjay,
     return result;
 }
 
+typedef struct {
+    anjay_ssid_t ssid;
+    anjay_access_mask_t mask;
+} acl_entry_t;
+
 typedef struct {
     bool acl_empty;
     anjay_ssid_t ssid_lookup;
@@ -265,15 +270,49 @@ static int get_mask(anjay_t *anjay,
     return 0;
 }
 
-static anjay_access_mask_t access_control_mask(anjay_t *anjay,
-                                               anjay_oid_t oid,
-                                               anjay_iid_t iid,
-                                               anjay_ssid_t ssid) {
-    const anjay_dm_object_def_t *const *ac_obj =
-            _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
+static int read_acl_clb(anjay_t *anjay,
+                        const anjay_dm_object_def_t *const *obj,
+                        anjay_iid_t iid,
+                        anjay_rid_t rid,
+                        anjay_riid_t riid,
+                        void *endptr_ptr_) {
+    AVS_LIST(acl_entry_t) **endptr_ptr = (AVS_LIST(acl_entry_t) **) endptr_ptr_;
+    assert(!**endptr_ptr);
+    if (!(**endptr_ptr = AVS_LIST_NEW_ELEMENT(acl_entry_t))) {
+        return -1;
+    }
+    (**endptr_ptr)->ssid = riid;
+    int result = read_mask(anjay, obj, iid, rid, riid, &(**endptr_ptr)->mask);
+    if (result) {
+        AVS_LIST_DELETE(*endptr_ptr);
+    } else {
+        AVS_LIST_ADVANCE_PTR(endptr_ptr);
+    }
+    return result;
+}
+
+static int read_acl(anjay_t *anjay,
+                    const anjay_dm_object_def_t *const *ac_obj,
+                    anjay_iid_t ac_iid,
+                    AVS_LIST(acl_entry_t) *out_acl) {
+    assert(out_acl);
+    assert(!*out_acl);
+    AVS_LIST(acl_entry_t) *endptr = out_acl;
+    int result = foreach_acl(anjay, ac_obj, ac_iid, read_acl_clb, &endptr);
+    if (result) {
+        AVS_LIST_CLEAR(out_acl);
+    }
+    return result;
+}
+
+static anjay_access_mask_t
+access_control_mask_uncached(anjay_t *anjay,
+                             const anjay_dm_object_def_t *const *ac_obj,
+                             anjay_oid_t oid,
+                             anjay_iid_t iid,
+                             anjay_ssid_t ssid) {
     anjay_iid_t ac_iid;
-    if (!ac_obj
-            || find_ac_instance_by_target(anjay, ac_obj, &ac_iid, oid, iid)) {
+    if (find_ac_instance_by_target(anjay, ac_obj, &ac_iid, oid, iid)) {
         return ANJAY_ACCESS_MASK_NONE;
     }
 
@@ -301,6 +340,157 @@ static anjay_access_mask_t access_control_mask(anjay_t *anjay,
     return ANJAY_ACCESS_MASK_NONE;
 }
 
+/**
+ * Entry of the ACL index, i.e. contents of a single Access Control Object
+ * Instance, keyed by its target (Object ID, Object Instance ID) pair.
+ */
+struct anjay_acl_index_entry_struct {
+    anjay_oid_t target_oid;
+    anjay_iid_t target_iid;
+    // false if the Owner Resource could not be read
+    bool owner_valid;
+    anjay_ssid_t owner;
+    // false if the ACL Resource could not be read
+    bool acl_valid;
+    AVS_LIST(acl_entry_t) acl;
+};
+
+static int acl_index_entry_cmp(const void *left_, const void *right_) {
+    const anjay_acl_index_entry_t *left =
+            (const anjay_acl_index_entry_t *) left_;
+    const anjay_acl_index_entry_t *right =
+            (const anjay_acl_index_entry_t *) right_;
+    if (left->target_oid != right->target_oid) {
+        return left->target_oid < right->target_oid ? -1 : 1;
+    }
+    if (left->target_iid != right->target_iid) {
+        return left->target_iid < right->target_iid ? -1 : 1;
+    }
+    return 0;
+}
+
+static int build_acl_index_clb(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *ac_obj,
+                               anjay_iid_t ac_iid,
+                               void *index_) {
+    AVS_RBTREE(anjay_acl_index_entry_t) index =
+            (AVS_RBTREE(anjay_acl_index_entry_t)) index_;
+    AVS_RBTREE_ELEM(anjay_acl_index_entry_t) entry =
+            AVS_RBTREE_ELEM_NEW(anjay_acl_index_entry_t);
+    if (!entry) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    int result = read_ids_from_ac_instance(anjay, ac_iid, &entry->target_oid,
+                                           &entry->target_iid, NULL);
+    if (result) {
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+        return result;
+    }
+    if (AVS_RBTREE_INSERT(index, entry) != entry) {
+        // Multiple Access Control Instances refer to the same target; the one
+        // with the lowest IID takes precedence, compare with
+        // find_ac_instance_by_target()
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&entry);
+        return 0;
+    }
+    entry->owner_valid = !read_ids_from_ac_instance(anjay, ac_iid, NULL, NULL,
+                                                    &entry->owner);
+    entry->acl_valid = !read_acl(anjay, ac_obj, ac_iid, &entry->acl);
+    return 0;
+}
+
+static void delete_acl_index(AVS_RBTREE(anjay_acl_index_entry_t) *index_ptr) {
+    AVS_RBTREE_DELETE(index_ptr) {
+        AVS_LIST_CLEAR(&(**index_ptr)->acl);
+    }
+}
+
+/**
+ * Returns the ACL index for the current contents of the Access Control Object,
+ * building it if necessary. The index is dropped whenever a notification about
+ * a change in the Access Control Object is processed, see
+ * _anjay_access_control_index_invalidate().
+ *
+ * NULL is returned if the index cannot be used at this time, in which case the
+ * Access Control Object needs to be queried directly.
+ */
+static AVS_RBTREE(anjay_acl_index_entry_t)
+get_acl_index(anjay_t *anjay, const anjay_dm_object_def_t *const *ac_obj) {
+    if (AVS_LIST_FIND_BY_VALUE_PTR(&anjay->transaction_state.objs_in_transaction,
+                                   &ac_obj, memcmp)) {
+        // Access Control Object is being modified right now; the changes might
+        // still be rolled back, so neither use nor build the index
+        return NULL;
+    }
+    if (!anjay->access_control_index) {
+        AVS_RBTREE(anjay_acl_index_entry_t) index =
+                AVS_RBTREE_NEW(anjay_acl_index_entry_t, acl_index_entry_cmp);
+        if (!index) {
+            anjay_log(ERROR, _("out of memory"));
+            return NULL;
+        }
+        if (_anjay_dm_foreach_instance(anjay, ac_obj, build_acl_index_clb,
+                                       index)) {
+            anjay_log(WARNING, _("could not build ACL index"));
+            delete_acl_index(&index);
+            return NULL;
+        }
+        anjay->access_control_index = index;
+    }
+    return anjay->access_control_index;
+}
+
+static anjay_access_mask_t access_control_mask(anjay_t *anjay,
+                                               anjay_oid_t oid,
+                                               anjay_iid_t iid,
+                                               anjay_ssid_t ssid) {
+    const anjay_dm_object_def_t *const *ac_obj =
+            _anjay_dm_find_object_by_oid(anjay, ANJAY_DM_OID_ACCESS_CONTROL);
+    if (!ac_obj) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+
+    AVS_RBTREE(anjay_acl_index_entry_t) index = get_acl_index(anjay, ac_obj);
+    if (!index) {
+        return access_control_mask_uncached(anjay, ac_obj, oid, iid, ssid);
+    }
+
+    const anjay_acl_index_entry_t query = {
+        .target_oid = oid,
+        .target_iid = iid
+    };
+    AVS_RBTREE_ELEM(anjay_acl_index_entry_t) entry =
+            AVS_RBTREE_FIND(index, &query);
+    if (!entry) {
+        return ANJAY_ACCESS_MASK_NONE;
+    }
+    if (!entry->acl_valid || (!entry->acl && !entry->owner_valid)) {
+        // some data could not be read while building the index; retry the
+        // query directly to handle it exactly like the non-indexed case
+        return access_control_mask_uncached(anjay, ac_obj, oid, iid, ssid);
+    }
+
+    if (!entry->acl) {
+        // Empty ACL - only the owner of the instance has access
+        return entry->owner == ssid
+                       ? (ANJAY_ACCESS_MASK_FULL & ~ANJAY_ACCESS_MASK_CREATE)
+                       : ANJAY_ACCESS_MASK_NONE;
+    }
+    anjay_access_mask_t default_mask = ANJAY_ACCESS_MASK_NONE;
+    AVS_LIST(acl_entry_t) acl_entry;
+    AVS_LIST_FOREACH(acl_entry, entry->acl) {
+        if (acl_entry->ssid == ssid) {
+            // Found the ACL
+            return acl_entry->mask;
+        } else if (acl_entry->ssid == ANJAY_SSID_ANY) {
+            default_mask = acl_entry->mask;
+        }
+    }
+    // Default ACL, if present
+    return default_mask;
+}
+
 static bool can_instantiate(anjay_t *anjay, const anjay_action_info_t *info) {
     return access_control_mask(anjay, info->oid, ANJAY_ID_INVALID, info->ssid)
            & ANJAY_ACCESS_MASK_CREATE;
@@ -393,6 +583,16 @@ bool _anjay_instance_action_allowed(anjay_t *anjay,
 #endif // WITH_ACCESS_CONTROL
 }
 
+void _anjay_access_control_index_invalidate(anjay_t *anjay) {
+#ifdef WITH_ACCESS_CONTROL
+    if (anjay->access_control_index) {
+        delete_acl_index(&anjay->access_control_index);
+    }
+#else  // WITH_ACCESS_CONTROL
+    (void) anjay;
+#endif // WITH_ACCESS_CONTROL
+}
+
 #ifdef WITH_ACCESS_CONTROL
 
 static void what_changed(anjay_ssid_t origin_ssid,
@@ -464,46 +664,6 @@ enumerate_valid_ssids_clb(anjay_t *anjay,
     return 0;
 }
 
-typedef struct {
-    anjay_ssid_t ssid;
-    anjay_access_mask_t mask;
-} acl_entry_t;
-
-static int read_acl_clb(anjay_t *anjay,
-                        const anjay_dm_object_def_t *const *obj,
-                        anjay_iid_t iid,
-                        anjay_rid_t rid,
-                        anjay_riid_t riid,
-                        void *endptr_ptr_) {
-    AVS_LIST(acl_entry_t) **endptr_ptr = (AVS_LIST(acl_entry_t) **) endptr_ptr_;
-    assert(!**endptr_ptr);
-    if (!(**endptr_ptr = AVS_LIST_NEW_ELEMENT(acl_entry_t))) {
-        return -1;
-    }
-    (**endptr_ptr)->ssid = riid;
-    int result = read_mask(anjay, obj, iid, rid, riid, &(**endptr_ptr)->mask);
-    if (result) {
-        AVS_LIST_DELETE(*endptr_ptr);
-    } else {
-        AVS_LIST_ADVANCE_PTR(endptr_ptr);
-    }
-    return result;
-}
-
-static int read_acl(anjay_t *anjay,
-                    const anjay_dm_object_def_t *const *ac_obj,
-                    anjay_iid_t ac_iid,
-                    AVS_LIST(acl_entry_t) *out_acl) {
-    assert(out_acl);
-    assert(!*out_acl);
-    AVS_LIST(acl_entry_t) *endptr = out_acl;
-    int result = foreach_acl(anjay, ac_obj, ac_iid, read_acl_clb, &endptr);
-    if (result) {
-        AVS_LIST_CLEAR(out_acl);
-    }
-    return result;
-}
-
 /**
  * Finds the server that will become the new owner of the given ACL.
  * Servers with both Write and Delete rights are ranked with value 2, those with
@@ -1011,10 +1171,10 @@ static int generate_apparent_instance_set_change_notifications(
     }
 
     anjay_iid_t last_iid = ANJAY_ID_INVALID;
-    AVS_LIST(anjay_notify_queue_resource_entry_t) it;
-    AVS_LIST_FOREACH(it, ac_notif->resources_changed) {
+    AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) it;
+    AVS_RBTREE_FOREACH(it, ac_notif->resources_changed) {
         // Resource entries are sorted lexicographically over (IID, RID) pairs,
-        // compare with _anjay_notify_queue_resource_change() in notify.c
+        // compare with compare_resource_entries() in notify.c
         if (it->iid == last_iid) {
             continue;
         }
@@ -34,6 +34,7 @@
 #include <anjay/core.h>
 #include <anjay/stats.h>
 
+#include <anjay_modules/access_utils.h>
 #include <anjay_modules/time_defs.h>
 
 #include <anjay_config_log.h>
@@ -70,6 +71,9 @@ static int init(anjay_t *anjay, const anjay_configuration_t *config) {
     anjay->socket_config = config->socket_config;
     anjay->udp_listen_port = config->udp_listen_port;
     anjay->current_connection.conn_type = ANJAY_CONNECTION_UNSET;
+    anjay->coap_max_buffered_payload_size =
+            config->coap_max_buffered_payload_size;
+    anjay->coap_max_pending_requests = config->coap_max_pending_requests;
 
     const char *error_msg;
 #ifdef WITH_AVS_COAP_UDP
@@ -85,6 +89,7 @@ static int init(anjay_t *anjay, const anjay_configuration_t *config) {
         anjay->udp_tx_params =
                 (avs_coap_udp_tx_params_t) ANJAY_COAP_DEFAULT_UDP_TX_PARAMS;
     }
+    anjay->udp_notify_cache_size = config->udp_notify_cache_size;
     if (config->msg_cache_size) {
         anjay->udp_response_cache =
                 avs_coap_udp_response_cache_create(config->msg_cache_size);
@@ -114,6 +119,10 @@ static int init(anjay_t *anjay, const anjay_configuration_t *config) {
         return -1;
     }
 
+    if (_anjay_dm_init(anjay)) {
+        return -1;
+    }
+
     anjay->servers = _anjay_servers_create();
     if (!anjay->servers) {
         anjay_log(ERROR, _("out of memory"));
@@ -133,7 +142,10 @@ static int init(anjay_t *anjay, const anjay_configuration_t *config) {
 
     _anjay_observe_init(&anjay->observe,
                         config->confirmable_notifications,
-                        config->stored_notification_limit);
+                        config->stored_notification_limit,
+                        config->max_notifications_in_flight,
+                        config->stored_notifications_mode,
+                        config->notification_timer_granularity);
 
 #ifdef WITH_DOWNLOADER
     if (_anjay_downloader_init(&anjay->downloader, anjay)) {
@@ -194,6 +206,7 @@ static void anjay_delete_impl(anjay_t *anjay, bool deregister) {
     // avs_sched_cleanup()
     _anjay_observe_cleanup(&anjay->observe);
 
+    _anjay_access_control_index_invalidate(anjay);
     _anjay_dm_cleanup(anjay);
     _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
 
@@ -826,6 +839,27 @@ void anjay_download_abort(anjay_t *anjay, anjay_download_handle_t handle) {
 #endif // WITH_DOWNLOADER
 }
 
+avs_error_t
+anjay_download_checkpoint_read(avs_stream_t *in_stream,
+                               anjay_download_checkpoint_t *out_checkpoint) {
+#ifdef WITH_DOWNLOADER
+    return _anjay_downloader_checkpoint_read(in_stream, out_checkpoint);
+#else  // WITH_DOWNLOADER
+    (void) in_stream;
+    (void) out_checkpoint;
+    anjay_log(ERROR, _("CoAP download support disabled"));
+    return avs_errno(AVS_ENOTSUP);
+#endif // WITH_DOWNLOADER
+}
+
+void anjay_download_checkpoint_cleanup(
+        anjay_download_checkpoint_t *checkpoint) {
+    avs_free(checkpoint->url);
+    checkpoint->url = NULL;
+    avs_free(checkpoint->etag);
+    checkpoint->etag = NULL;
+}
+
 #ifdef ANJAY_TEST
 #    include "test/anjay.c"
 #endif // ANJAY_TEST
@@ -19,6 +19,7 @@
 
 #include <avsystem/commons/list.h>
 #include <avsystem/commons/net.h>
+#include <avsystem/commons/rbtree.h>
 #include <avsystem/commons/shared_buffer.h>
 #include <avsystem/commons/stream.h>
 
@@ -40,6 +41,10 @@ typedef struct {
     avs_sched_handle_t handle;
 } anjay_scheduled_notify_t;
 
+#ifdef WITH_ACCESS_CONTROL
+typedef struct anjay_acl_index_entry_struct anjay_acl_index_entry_t;
+#endif // WITH_ACCESS_CONTROL
+
 typedef struct {
     unsigned depth;
     AVS_LIST(const anjay_dm_object_def_t *const *) objs_in_transaction;
@@ -65,7 +70,10 @@ struct anjay_struct {
 #ifdef WITH_AVS_COAP_UDP
     avs_coap_udp_response_cache_t *udp_response_cache;
     avs_coap_udp_tx_params_t udp_tx_params;
+    size_t udp_notify_cache_size;
 #endif
+    size_t coap_max_buffered_payload_size;
+    size_t coap_max_pending_requests;
     avs_net_dtls_handshake_timeouts_t udp_dtls_hs_tx_params;
     avs_net_socket_tls_ciphersuites_t default_tls_ciphersuites;
 
@@ -83,6 +91,8 @@ struct anjay_struct {
 #endif // WITH_DOWNLOADER
 #ifdef WITH_ACCESS_CONTROL
     bool access_control_sync_in_progress;
+    // Index of the Access Control Object contents, see access_utils.c
+    AVS_RBTREE(anjay_acl_index_entry_t) access_control_index;
 #endif // WITH_ACCESS_CONTROL
     bool prefer_hierarchical_formats;
 #ifdef WITH_NET_STATS
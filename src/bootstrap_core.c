@@ -129,14 +129,17 @@ static void bootstrap_remove_notify_changed(anjay_bootstrap_t *bootstrap,
     if (!*obj_it) {
         return;
     }
-    AVS_LIST(anjay_notify_queue_resource_entry_t) *res_it;
-    AVS_LIST_FOREACH_PTR(res_it, &(*obj_it)->resources_changed) {
-        if ((*res_it)->iid >= iid) {
-            break;
-        }
-    }
-    while (*res_it && (*res_it)->iid == iid) {
-        AVS_LIST_DELETE(res_it);
+    const anjay_notify_queue_resource_entry_t query = {
+        .iid = iid,
+        .rid = 0
+    };
+    AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) res_it =
+            AVS_RBTREE_LOWER_BOUND((*obj_it)->resources_changed, &query);
+    while (res_it && res_it->iid == iid) {
+        AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) next =
+                AVS_RBTREE_ELEM_NEXT(res_it);
+        AVS_RBTREE_DELETE_ELEM((*obj_it)->resources_changed, &res_it);
+        res_it = next;
     }
 }
 
@@ -358,7 +358,8 @@ coap_msg__(aligned_buffer_t *buf,
  * @p Code    - suffix of one of AVS_COAP_CODE_* constants, e.g. GET
  *              or BAD_REQUEST.
  * @p Id      - message identity specified with the ID() macro.
- * @p Payload - one of NO_PAYLOAD, PAYLOAD(), BLOCK2().
+ * @p Payload - one of NO_PAYLOAD, PAYLOAD(), BLOCK1(), BLOCK1_RES(),
+ *              BLOCK2().
  * @p Opts... - additional options, e.g. ETAG(), PATH(), QUERY().
  *
  * Example usage:
@@ -482,6 +483,47 @@ coap_msg__(aligned_buffer_t *buf,
                                : (sizeof("" __VA_ARGS__) - 1               \
                                   - (Seq) * (Size)))
 
+/**
+ * Used in COAP_MSG to define BLOCK1 option and block payload of a request.
+ * @p Seq     - the block sequence number.
+ * @p Size    - block size.
+ * @p Payload - FULL PAYLOAD OF WHOLE BLOCK-WISE TRANSFER (!), given as a string
+ *              literal. The macro will extract the portion of it based on Seq
+ *              and Size. Terminating nullbyte is not considered part of the
+ *              payload.
+ */
+#define BLOCK1(Seq, Size, Payload)                                       \
+    .block1 = {                                                          \
+        .type = AVS_COAP_BLOCK1,                                         \
+        .seq_num = (assert((Seq) < (1 << 23)), (uint32_t) (Seq)),        \
+        .size = (assert((Size) < (1 << 15)), (uint16_t) (Size)),         \
+        .has_more = ((Seq + 1) * (Size) + 1 < sizeof(Payload))           \
+    },                                                                   \
+    .has_block1 = true,                                                  \
+    .block2 = { 0 },                                                     \
+    .payload = ((const uint8_t *) (Payload)) + (Seq) * (Size),           \
+    .payload_size = ((((Seq) + 1) * (Size) + 1 < sizeof(Payload))        \
+                             ? (Size)                                    \
+                             : (sizeof(Payload) - 1 - (Seq) * (Size)))
+
+/**
+ * Used in COAP_MSG to define BLOCK1 option in a response to a BLOCK1 request.
+ * @p Seq     - the block sequence number.
+ * @p Size    - block size.
+ * @p HasMore - value of the "more" flag of the request being responded to.
+ */
+#define BLOCK1_RES(Seq, Size, HasMore)                            \
+    .block1 = {                                                   \
+        .type = AVS_COAP_BLOCK1,                                  \
+        .seq_num = (assert((Seq) < (1 << 23)), (uint32_t) (Seq)), \
+        .size = (assert((Size) < (1 << 15)), (uint16_t) (Size)),  \
+        .has_more = (HasMore)                                     \
+    },                                                            \
+    .has_block1 = true,                                           \
+    .block2 = { 0 },                                              \
+    .payload = NULL,                                              \
+    .payload_size = 0
+
 static inline void expect_timeout(avs_net_socket_t *mocksock) {
     avs_unit_mocksock_input_fail(mocksock, avs_errno(AVS_ETIMEDOUT));
 }
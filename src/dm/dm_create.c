@@ -25,6 +25,7 @@
 #include "../io/vtable.h"
 
 #include <inttypes.h>
+#include <stddef.h>
 
 VISIBILITY_SOURCE_BEGIN
 
@@ -81,6 +82,22 @@ static int dm_create_select_iid_clb(anjay_t *anjay,
 int _anjay_dm_select_free_iid(anjay_t *anjay,
                               const anjay_dm_object_def_t *const *obj,
                               anjay_iid_t *new_iid_ptr) {
+    if (_anjay_dm_handler_implemented(anjay, obj, NULL,
+                                      offsetof(anjay_dm_handlers_t,
+                                               instance_select_free_iid))) {
+        *new_iid_ptr = ANJAY_ID_INVALID;
+        int result = _anjay_dm_call_instance_select_free_iid(anjay, obj,
+                                                             new_iid_ptr, NULL);
+        if (!result && *new_iid_ptr == ANJAY_ID_INVALID) {
+            dm_log(ERROR,
+                   _("instance_select_free_iid handler for ") "/%" PRIu16 _(
+                           " returned an invalid Instance ID"),
+                   (*obj)->oid);
+            return ANJAY_ERR_INTERNAL;
+        }
+        return result;
+    }
+    // fall back to enumerating all instances
     *new_iid_ptr = 0;
     int result =
             _anjay_dm_foreach_instance(anjay, obj, dm_create_select_iid_clb,
@@ -149,6 +149,40 @@ int _anjay_dm_call_list_instances(anjay_t *anjay,
                               anjay, obj_ptr, ctx);
 }
 
+int _anjay_dm_call_instance_present(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t iid,
+        const anjay_dm_module_t *current_module) {
+    dm_log(TRACE, _("instance_present ") "/%u/%u", (*obj_ptr)->oid, iid);
+    // not using CHECKED_TAIL_CALL_HANDLER, as positive values mean success
+    const anjay_dm_handlers_t *handler =
+            get_handler(anjay, obj_ptr, current_module,
+                        offsetof(anjay_dm_handlers_t, instance_present));
+    if (!handler) {
+        dm_log(DEBUG, _("instance_present handler not set for object ") "/%u",
+               (*obj_ptr)->oid);
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    int result = handler->instance_present(anjay, obj_ptr, iid);
+    if (result < 0) {
+        dm_log(DEBUG, _("instance_present failed with code") "%d (%s)", result,
+               AVS_COAP_CODE_STRING(_anjay_make_error_response_code(result)));
+    }
+    return result;
+}
+
+int _anjay_dm_call_instance_select_free_iid(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t *out_iid,
+        const anjay_dm_module_t *current_module) {
+    dm_log(TRACE, _("instance_select_free_iid ") "/%u", (*obj_ptr)->oid);
+    CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
+                              instance_select_free_iid, anjay, obj_ptr,
+                              out_iid);
+}
+
 int _anjay_dm_call_instance_reset(anjay_t *anjay,
                                   const anjay_dm_object_def_t *const *obj_ptr,
                                   anjay_iid_t iid,
@@ -224,6 +224,8 @@ int _anjay_dm_write_attributes(anjay_t *anjay,
         result = dm_write_object_attrs(anjay, obj, &request->attributes);
     }
 #ifdef WITH_OBSERVE
+    // attributes might have been partially written even in case of failure
+    _anjay_observe_invalidate_attrs_cache(&anjay->observe);
     if (!result) {
         // verify that new attributes are "seen" by the observe code
         result = _anjay_observe_notify(anjay, &request->uri,
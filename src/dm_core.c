@@ -19,6 +19,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <math.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -71,6 +72,32 @@ static int validate_version(const anjay_dm_object_def_t *obj_def) {
     return 0;
 }
 
+static bool presence_valid(anjay_dm_resource_presence_t presence) {
+    return presence == ANJAY_DM_RES_ABSENT || presence == ANJAY_DM_RES_PRESENT;
+}
+
+static int validate_resources(const anjay_dm_object_def_t *obj_def) {
+    if (!obj_def->resources) {
+        return 0;
+    }
+    int32_t last_rid = -1;
+    for (size_t i = 0; i < obj_def->resources_count; ++i) {
+        const anjay_dm_resource_def_t *res = &obj_def->resources[i];
+        if (res->rid == ANJAY_ID_INVALID || res->rid <= last_rid
+                || !_anjay_dm_res_kind_valid(res->kind)
+                || !presence_valid(res->presence)) {
+            dm_log(ERROR,
+                   _("invalid Resource table entry for ") "/%u/*/%u" _(
+                           "; entries need to have valid kinds and presence, "
+                           "and be sorted by Resource ID"),
+                   (unsigned) obj_def->oid, (unsigned) res->rid);
+            return -1;
+        }
+        last_rid = res->rid;
+    }
+    return 0;
+}
+
 int anjay_register_object(anjay_t *anjay,
                           const anjay_dm_object_def_t *const *def_ptr) {
     if (!def_ptr || !*def_ptr) {
@@ -86,40 +113,31 @@ int anjay_register_object(anjay_t *anjay,
         return -1;
     }
 
-    if (validate_version(*def_ptr)) {
+    if (validate_version(*def_ptr) || validate_resources(*def_ptr)) {
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
-
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter && **obj_iter);
-
-        if ((***obj_iter)->oid >= (*def_ptr)->oid) {
-            break;
-        }
+    AVS_RBTREE_ELEM(anjay_dm_installed_object_t) new_elem =
+            AVS_RBTREE_ELEM_NEW(anjay_dm_installed_object_t);
+    if (!new_elem) {
+        dm_log(ERROR, _("out of memory"));
+        return -1;
     }
 
-    if (*obj_iter && (***obj_iter)->oid == (*def_ptr)->oid) {
+    new_elem->oid = (*def_ptr)->oid;
+    new_elem->def_ptr = def_ptr;
+    if (AVS_RBTREE_INSERT(anjay->dm.objects, new_elem) != new_elem) {
         dm_log(ERROR, _("data model object ") "/%u" _(" already registered"),
                (*def_ptr)->oid);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&new_elem);
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) new_elem =
-            AVS_LIST_NEW_ELEMENT(const anjay_dm_object_def_t *const *);
-    if (!new_elem) {
-        dm_log(ERROR, _("out of memory"));
-        return -1;
-    }
-
-    *new_elem = def_ptr;
-    AVS_LIST_INSERT(obj_iter, new_elem);
-
-    dm_log(INFO, _("successfully registered object ") "/%u", (**new_elem)->oid);
-    if (anjay_notify_instances_changed(anjay, (**new_elem)->oid)) {
+    dm_log(INFO, _("successfully registered object ") "/%u", new_elem->oid);
+    _anjay_servers_invalidate_registration_payload(anjay);
+    if (anjay_notify_instances_changed(anjay, new_elem->oid)) {
         dm_log(WARNING, _("anjay_notify_instances_changed() failed on ") "/%u",
-               (**new_elem)->oid);
+               new_elem->oid);
     }
     if (anjay_schedule_registration_update(anjay, ANJAY_SSID_ANY)) {
         dm_log(WARNING, _("anjay_schedule_registration_update() failed"));
@@ -150,20 +168,17 @@ int anjay_unregister_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
-    AVS_LIST_FOREACH_PTR(obj_iter, &anjay->dm.objects) {
-        assert(*obj_iter && **obj_iter);
-        if ((***obj_iter)->oid >= (*def_ptr)->oid) {
-            break;
-        }
-    }
-
-    if (!*obj_iter || (***obj_iter)->oid != (*def_ptr)->oid) {
+    AVS_RBTREE_ELEM(anjay_dm_installed_object_t) detached =
+            AVS_RBTREE_FIND(anjay->dm.objects,
+                            &(const anjay_dm_installed_object_t) {
+                                .oid = (*def_ptr)->oid
+                            });
+    if (!detached) {
         dm_log(ERROR, _("object ") "%" PRIu16 _(" is not currently registered"),
                (*def_ptr)->oid);
         return -1;
     }
-    if (**obj_iter != def_ptr) {
+    if (detached->def_ptr != def_ptr) {
         dm_log(ERROR,
                _("object ") "%" PRIu16 _(" that is registered is not the same "
                                          "as the object passed for unregister"),
@@ -171,9 +186,10 @@ int anjay_unregister_object(anjay_t *anjay,
         return -1;
     }
 
-    AVS_LIST(const anjay_dm_object_def_t *const *) detached =
-            AVS_LIST_DETACH(obj_iter);
+    AVS_RBTREE_DETACH(anjay->dm.objects, detached);
+    _anjay_servers_invalidate_registration_payload(anjay);
 
+    AVS_LIST(const anjay_dm_object_def_t *const *) *obj_iter;
     AVS_LIST_FOREACH_PTR(obj_iter,
                          &anjay->transaction_state.objs_in_transaction) {
         if (**obj_iter >= def_ptr) {
@@ -208,13 +224,28 @@ int anjay_unregister_object(anjay_t *anjay,
                                  (*def_ptr)->oid);
 #endif // WITH_BOOTSTRAP
     dm_log(INFO, _("successfully unregistered object ") "/%u", (*def_ptr)->oid);
-    AVS_LIST_DELETE(&detached);
+    AVS_RBTREE_ELEM_DELETE_DETACHED(&detached);
     if (anjay_schedule_registration_update(anjay, ANJAY_SSID_ANY)) {
         dm_log(WARNING, _("anjay_schedule_registration_update() failed"));
     }
     return 0;
 }
 
+static int installed_object_cmp(const void *left, const void *right) {
+    return (int) ((const anjay_dm_installed_object_t *) left)->oid
+           - (int) ((const anjay_dm_installed_object_t *) right)->oid;
+}
+
+int _anjay_dm_init(anjay_t *anjay) {
+    assert(!anjay->dm.objects);
+    if (!(anjay->dm.objects = AVS_RBTREE_NEW(anjay_dm_installed_object_t,
+                                             installed_object_cmp))) {
+        dm_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    return 0;
+}
+
 void _anjay_dm_cleanup(anjay_t *anjay) {
     AVS_LIST_CLEAR(&anjay->dm.modules) {
         if (anjay->dm.modules->def->deleter) {
@@ -222,20 +253,23 @@ void _anjay_dm_cleanup(anjay_t *anjay) {
         }
     }
 
-    AVS_LIST_CLEAR(&anjay->dm.objects);
+    if (anjay->dm.objects) {
+        AVS_RBTREE_DELETE(&anjay->dm.objects);
+    }
 }
 
 const anjay_dm_object_def_t *const *
 _anjay_dm_find_object_by_oid(anjay_t *anjay, anjay_oid_t oid) {
-    AVS_LIST(const anjay_dm_object_def_t *const *) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        assert(*obj && **obj);
-        if ((**obj)->oid == oid) {
-            return *obj;
-        }
+    AVS_RBTREE_ELEM(anjay_dm_installed_object_t) obj =
+            AVS_RBTREE_FIND(anjay->dm.objects,
+                            &(const anjay_dm_installed_object_t) {
+                                .oid = oid
+                            });
+    if (!obj) {
+        return NULL;
     }
-
-    return NULL;
+    assert(obj->def_ptr && *obj->def_ptr);
+    return obj->def_ptr;
 }
 
 uint8_t _anjay_dm_make_success_response_code(anjay_request_action_t action) {
@@ -591,19 +625,19 @@ int _anjay_dm_perform_action(anjay_t *anjay, const anjay_request_t *request) {
 int _anjay_dm_foreach_object(anjay_t *anjay,
                              anjay_dm_foreach_object_handler_t *handler,
                              void *data) {
-    AVS_LIST(const anjay_dm_object_def_t *const *) obj;
-    AVS_LIST_FOREACH(obj, anjay->dm.objects) {
-        assert(*obj && **obj);
+    AVS_RBTREE_ELEM(anjay_dm_installed_object_t) obj;
+    AVS_RBTREE_FOREACH(obj, anjay->dm.objects) {
+        assert(obj->def_ptr && *obj->def_ptr);
 
-        int result = handler(anjay, *obj, data);
+        int result = handler(anjay, obj->def_ptr, data);
         if (result == ANJAY_FOREACH_BREAK) {
-            dm_log(TRACE, _("foreach_object: break on ") "/%u", (**obj)->oid);
+            dm_log(TRACE, _("foreach_object: break on ") "/%u", obj->oid);
             return 0;
         } else if (result) {
             dm_log(DEBUG,
                    _("foreach_object_handler failed for ") "/%u" _(" (") "%d" _(
                            ")"),
-                   (**obj)->oid, result);
+                   obj->oid, result);
             return result;
         }
     }
@@ -744,6 +778,19 @@ static int instance_present_clb(anjay_t *anjay,
 int _anjay_dm_instance_present(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj_ptr,
                                anjay_iid_t iid) {
+    if (_anjay_dm_handler_implemented(anjay, obj_ptr, NULL,
+                                      offsetof(anjay_dm_handlers_t,
+                                               instance_present))) {
+        if (iid == ANJAY_ID_INVALID) {
+            return 0;
+        }
+        int retval = _anjay_dm_call_instance_present(anjay, obj_ptr, iid, NULL);
+        if (retval < 0) {
+            return retval;
+        }
+        return retval ? 1 : 0;
+    }
+    // fall back to enumerating all instances
     instance_present_args_t args = {
         .iid_to_find = iid,
         .found = false
@@ -766,8 +813,22 @@ struct anjay_dm_resource_list_ctx_struct {
     int result;
 };
 
-static bool presence_valid(anjay_dm_resource_presence_t presence) {
-    return presence == ANJAY_DM_RES_ABSENT || presence == ANJAY_DM_RES_PRESENT;
+static void
+call_foreach_resource_handler(anjay_dm_resource_list_ctx_t *ctx,
+                              anjay_rid_t rid,
+                              anjay_dm_resource_kind_t kind,
+                              anjay_dm_resource_presence_t presence) {
+    ctx->result = ctx->handler(ctx->anjay, ctx->obj, ctx->iid, rid, kind,
+                               presence, ctx->handler_data);
+    if (ctx->result == ANJAY_FOREACH_BREAK) {
+        dm_log(TRACE, _("foreach_resource: break on ") "/%u/%u/%u",
+               (*ctx->obj)->oid, ctx->iid, rid);
+    } else if (ctx->result) {
+        dm_log(DEBUG,
+               _("foreach_resource_handler failed for ") "/%u/%u/%u" _(
+                       " (") "%d" _(")"),
+               (*ctx->obj)->oid, ctx->iid, rid, ctx->result);
+    }
 }
 
 void anjay_dm_emit_res(anjay_dm_resource_list_ctx_t *ctx,
@@ -802,17 +863,7 @@ void anjay_dm_emit_res(anjay_dm_resource_list_ctx_t *ctx,
             ctx->result = ANJAY_ERR_INTERNAL;
             return;
         }
-        ctx->result = ctx->handler(ctx->anjay, ctx->obj, ctx->iid, rid, kind,
-                                   presence, ctx->handler_data);
-        if (ctx->result == ANJAY_FOREACH_BREAK) {
-            dm_log(TRACE, _("foreach_resource: break on ") "/%u/%u/%u",
-                   (*ctx->obj)->oid, ctx->iid, rid);
-        } else if (ctx->result) {
-            dm_log(DEBUG,
-                   _("foreach_resource_handler failed for ") "/%u/%u/%u" _(
-                           " (") "%d" _(")"),
-                   (*ctx->obj)->oid, ctx->iid, rid, ctx->result);
-        }
+        call_foreach_resource_handler(ctx, rid, kind, presence);
     }
 }
 
@@ -835,6 +886,15 @@ int _anjay_dm_foreach_resource(anjay_t *anjay,
         .handler_data = data,
         .result = 0
     };
+    if ((*obj)->resources) {
+        // static table, already validated in anjay_register_object()
+        for (size_t i = 0; i < (*obj)->resources_count && !ctx.result; ++i) {
+            const anjay_dm_resource_def_t *res = &(*obj)->resources[i];
+            call_foreach_resource_handler(&ctx, res->rid, res->kind,
+                                          res->presence);
+        }
+        return ctx.result == ANJAY_FOREACH_BREAK ? 0 : ctx.result;
+    }
     int result = _anjay_dm_call_list_resources(anjay, obj, iid, &ctx, NULL);
     if (result < 0) {
         dm_log(ERROR,
@@ -873,6 +933,24 @@ static int kind_and_presence_clb(anjay_t *anjay,
     return ANJAY_FOREACH_CONTINUE;
 }
 
+static const anjay_dm_resource_def_t *
+find_static_resource(const anjay_dm_object_def_t *obj_def, anjay_rid_t rid) {
+    size_t lo = 0;
+    size_t hi = obj_def->resources_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const anjay_dm_resource_def_t *res = &obj_def->resources[mid];
+        if (res->rid == rid) {
+            return res;
+        } else if (res->rid < rid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
 int _anjay_dm_resource_kind_and_presence(
         anjay_t *anjay,
         const anjay_dm_object_def_t *const *obj_ptr,
@@ -880,6 +958,20 @@ int _anjay_dm_resource_kind_and_presence(
         anjay_rid_t rid,
         anjay_dm_resource_kind_t *out_kind,
         anjay_dm_resource_presence_t *out_presence) {
+    if (obj_ptr && (*obj_ptr)->resources) {
+        const anjay_dm_resource_def_t *res =
+                find_static_resource(*obj_ptr, rid);
+        if (!res) {
+            return ANJAY_ERR_NOT_FOUND;
+        }
+        if (out_kind) {
+            *out_kind = res->kind;
+        }
+        if (out_presence) {
+            *out_presence = res->presence;
+        }
+        return 0;
+    }
     resource_present_args_t args = {
         .rid_to_find = rid,
         .kind = (anjay_dm_resource_kind_t) -1,
@@ -20,6 +20,7 @@
 #include <limits.h>
 
 #include <avsystem/commons/list.h>
+#include <avsystem/commons/rbtree.h>
 #include <avsystem/commons/stream.h>
 
 #include <anjay_modules/dm_utils.h>
@@ -36,11 +37,20 @@ typedef struct {
     void *arg;
 } anjay_dm_installed_module_t;
 
+typedef struct {
+    // copy of (*def_ptr)->oid, so that lookups do not need to dereference it
+    anjay_oid_t oid;
+    const anjay_dm_object_def_t *const *def_ptr;
+} anjay_dm_installed_object_t;
+
 struct anjay_dm {
-    AVS_LIST(const anjay_dm_object_def_t *const *) objects;
+    // Registered Objects, ordered by Object ID
+    AVS_RBTREE(anjay_dm_installed_object_t) objects;
     AVS_LIST(anjay_dm_installed_module_t) modules;
 };
 
+int _anjay_dm_init(anjay_t *anjay);
+
 void _anjay_dm_cleanup(anjay_t *anjay);
 
 typedef struct {
@@ -95,6 +95,13 @@ void _anjay_downloader_abort(anjay_downloader_t *dl,
 
 int _anjay_downloader_sched_reconnect_all(anjay_downloader_t *dl);
 
+/**
+ * Implementation of @ref anjay_download_checkpoint_read .
+ */
+avs_error_t
+_anjay_downloader_checkpoint_read(avs_stream_t *in_stream,
+                                  anjay_download_checkpoint_t *out_checkpoint);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_DOWNLOADER_H */
@@ -38,6 +38,20 @@ AVS_STATIC_ASSERT(offsetof(anjay_etag_t, value)
 AVS_STATIC_ASSERT(AVS_ALIGNOF(anjay_etag_t) == AVS_ALIGNOF(avs_coap_etag_t),
                   coap_etag_alignment_compatible);
 
+typedef struct {
+    avs_coap_exchange_id_t exchange_id;
+    // byte offset of the first byte of the requested block
+    size_t offset;
+    bool received;
+    // the fields below are only valid if received is true
+    bool last;
+    // response code, if other than 2.05 Content
+    uint8_t error_code;
+    size_t payload_size;
+    size_t payload_capacity;
+    uint8_t payload[];
+} anjay_coap_download_block_t;
+
 typedef struct {
     anjay_download_ctx_common_t common;
 
@@ -59,6 +73,20 @@ typedef struct {
 #endif // WITH_AVS_COAP_UDP
     avs_coap_ctx_t *coap;
 
+    // The fields below are only used if window_size > 1, in which case
+    // exchange_id is not used, and each block is requested separately.
+    size_t window_size;
+    size_t block_size;
+    // false until the first response is received; only a single request is
+    // sent before that, to learn the block size and ETag used by the server
+    bool window_open;
+    size_t next_request_offset;
+    // no blocks starting at or after this offset will be requested; SIZE_MAX
+    // until the size of the resource is known
+    size_t end_offset;
+    // requested blocks, ordered by offset
+    AVS_LIST(anjay_coap_download_block_t) window;
+
     avs_sched_handle_t job_start;
 } anjay_coap_download_ctx_t;
 
@@ -78,9 +106,20 @@ static void cleanup_coap_context(avs_sched_t *sched, const void *args_) {
 #endif // ANJAY_TEST
 }
 
+static void cancel_window(anjay_coap_download_ctx_t *ctx) {
+    while (ctx->window) {
+        // the response handler ignores cancellation, so this is safe
+        avs_coap_exchange_cancel(ctx->coap, ctx->window->exchange_id);
+        AVS_LIST_DELETE(&ctx->window);
+    }
+}
+
 static void cleanup_coap_transfer(AVS_LIST(anjay_download_ctx_t) *ctx_ptr) {
     anjay_coap_download_ctx_t *ctx = (anjay_coap_download_ctx_t *) *ctx_ptr;
     avs_sched_del(&ctx->job_start);
+    // Exchanges are not cancelled here - they will be when the CoAP context
+    // is cleaned up, and handle_window_response() ignores that.
+    AVS_LIST_CLEAR(&ctx->window);
     _anjay_url_cleanup(&ctx->uri);
 
     anjay_t *anjay = _anjay_downloader_get_anjay(ctx->dl);
@@ -127,6 +166,9 @@ static inline bool etag_matches(const avs_coap_etag_t *a,
 static void abort_download_transfer(anjay_coap_download_ctx_t *dl_ctx,
                                     anjay_download_status_t status) {
     avs_coap_exchange_cancel(dl_ctx->coap, dl_ctx->exchange_id);
+    // the transfer might be resumed later, see reconnect_coap_transfer()
+    dl_ctx->exchange_id = AVS_COAP_EXCHANGE_ID_INVALID;
+    cancel_window(dl_ctx);
 
     AVS_LIST(anjay_download_ctx_t) *dl_ctx_ptr =
             _anjay_downloader_find_ctx_ptr_by_id(dl_ctx->dl, dl_ctx->common.id);
@@ -135,6 +177,45 @@ static void abort_download_transfer(anjay_coap_download_ctx_t *dl_ctx,
     }
 }
 
+/**
+ * Validates the ETag of a 2.05 Content response against the one used for the
+ * download so far. Aborts the transfer and returns -1 on failure.
+ */
+static int handle_response_etag(anjay_coap_download_ctx_t *dl_ctx,
+                                const avs_coap_response_header_t *hdr,
+                                avs_coap_etag_t *out_etag) {
+    if (read_etag(hdr, out_etag)) {
+        dl_log(DEBUG, _("could not parse CoAP response"));
+        abort_download_transfer(
+                dl_ctx, _anjay_download_status_failed(avs_errno(AVS_EPROTO)));
+        return -1;
+    }
+    // NOTE: avs_coap normally performs ETag validation for blockwise
+    // transfers. However, if we resumed the download from persistence
+    // information, avs_coap wouldn't know about the ETag used before, and
+    // would blindly accept any ETag. Blocks requested in separate exchanges
+    // in windowed mode are not validated by avs_coap either.
+    if (dl_ctx->etag.size == 0) {
+        dl_ctx->etag = *out_etag;
+    } else if (!etag_matches(&dl_ctx->etag, out_etag)) {
+        dl_log(DEBUG, _("remote resource expired, aborting download"));
+        abort_download_transfer(dl_ctx, _anjay_download_status_expired());
+        return -1;
+    }
+    return 0;
+}
+
+static void handle_failed_request(anjay_coap_download_ctx_t *dl_ctx,
+                                  avs_error_t err) {
+    dl_log(DEBUG, _("download failed: ") "%s", AVS_COAP_STRERROR(err));
+    if (err.category == AVS_COAP_ERR_CATEGORY
+            && err.code == AVS_COAP_ERR_ETAG_MISMATCH) {
+        abort_download_transfer(dl_ctx, _anjay_download_status_expired());
+    } else {
+        abort_download_transfer(dl_ctx, _anjay_download_status_failed(err));
+    }
+}
+
 static void
 handle_coap_response(avs_coap_ctx_t *ctx,
                      avs_coap_exchange_id_t id,
@@ -167,22 +248,7 @@ handle_coap_response(avs_coap_ctx_t *ctx,
             return;
         }
         avs_coap_etag_t etag;
-        if (read_etag(&response->header, &etag)) {
-            dl_log(DEBUG, _("could not parse CoAP response"));
-            abort_download_transfer(dl_ctx,
-                                    _anjay_download_status_failed(
-                                            avs_errno(AVS_EPROTO)));
-            return;
-        }
-        // NOTE: avs_coap normally performs ETag validation for blockwise
-        // transfers. However, if we resumed the download from persistence
-        // information, avs_coap wouldn't know about the ETag used before, and
-        // would blindly accept any ETag.
-        if (dl_ctx->etag.size == 0) {
-            dl_ctx->etag = etag;
-        } else if (!etag_matches(&dl_ctx->etag, &etag)) {
-            dl_log(DEBUG, _("remote resource expired, aborting download"));
-            abort_download_transfer(dl_ctx, _anjay_download_status_expired());
+        if (handle_response_etag(dl_ctx, &response->header, &etag)) {
             return;
         }
         const void *payload = response->payload;
@@ -194,11 +260,10 @@ handle_coap_response(avs_coap_ctx_t *ctx,
             payload_size -= offset;
         }
 
-        if (avs_is_err((err = dl_ctx->common.on_next_block(
-                                _anjay_downloader_get_anjay(dl_ctx->dl),
+        if (avs_is_err((err = _anjay_downloader_next_block(
+                                dl_ctx->dl, &dl_ctx->common,
                                 (const uint8_t *) payload, payload_size,
-                                (const anjay_etag_t *) &etag,
-                                dl_ctx->common.user_data)))) {
+                                (const anjay_etag_t *) &etag)))) {
             abort_download_transfer(dl_ctx, _anjay_download_status_failed(err));
             return;
         }
@@ -215,16 +280,9 @@ handle_coap_response(avs_coap_ctx_t *ctx,
         }
         break;
     }
-    case AVS_COAP_CLIENT_REQUEST_FAIL: {
-        dl_log(DEBUG, _("download failed: ") "%s", AVS_COAP_STRERROR(err));
-        if (err.category == AVS_COAP_ERR_CATEGORY
-                && err.code == AVS_COAP_ERR_ETAG_MISMATCH) {
-            abort_download_transfer(dl_ctx, _anjay_download_status_expired());
-        } else {
-            abort_download_transfer(dl_ctx, _anjay_download_status_failed(err));
-        }
+    case AVS_COAP_CLIENT_REQUEST_FAIL:
+        handle_failed_request(dl_ctx, err);
         break;
-    }
     case AVS_COAP_CLIENT_REQUEST_CANCEL:
         AVS_UNREACHABLE("This case shall already be handler above.");
         break;
@@ -290,6 +348,313 @@ static inline size_t initial_block2_option_size(anjay_coap_download_ctx_t *ctx,
     return block_size;
 }
 
+static avs_error_t add_uri_options(anjay_coap_download_ctx_t *ctx,
+                                   avs_coap_options_t *options) {
+    avs_error_t err = AVS_OK;
+    AVS_LIST(const anjay_string_t) elem;
+    AVS_LIST_FOREACH(elem, ctx->uri.uri_path) {
+        if (avs_is_err((err = avs_coap_options_add_string(
+                                options, AVS_COAP_OPTION_URI_PATH,
+                                elem->c_str)))) {
+            return err;
+        }
+    }
+    AVS_LIST_FOREACH(elem, ctx->uri.uri_query) {
+        if (avs_is_err((err = avs_coap_options_add_string(
+                                options, AVS_COAP_OPTION_URI_QUERY,
+                                elem->c_str)))) {
+            return err;
+        }
+    }
+    return AVS_OK;
+}
+
+static void
+handle_window_response(avs_coap_ctx_t *ctx,
+                       avs_coap_exchange_id_t id,
+                       avs_coap_client_request_state_t result,
+                       const avs_coap_client_async_response_t *response,
+                       avs_error_t err,
+                       void *arg);
+
+static avs_error_t request_block(anjay_coap_download_ctx_t *ctx) {
+    AVS_LIST(anjay_coap_download_block_t) block =
+            (AVS_LIST(anjay_coap_download_block_t)) AVS_LIST_NEW_BUFFER(
+                    sizeof(anjay_coap_download_block_t) + ctx->block_size);
+    if (!block) {
+        dl_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    block->offset = ctx->next_request_offset;
+    block->payload_capacity = ctx->block_size;
+
+    avs_coap_options_t options;
+    avs_error_t err;
+    if (avs_is_err((err = avs_coap_options_dynamic_init(&options)))) {
+        AVS_LIST_DELETE(&block);
+        return err;
+    }
+    // the block is put in the window first, as the response handler might
+    // be called before avs_coap_client_send_async_request() returns
+    AVS_LIST_APPEND(&ctx->window, block);
+    if (avs_is_ok((err = add_uri_options(ctx, &options)))
+            && avs_is_ok((err = avs_coap_options_add_block(
+                                  &options,
+                                  &(avs_coap_option_block_t) {
+                                      .type = AVS_COAP_BLOCK2,
+                                      .seq_num = (uint32_t) (block->offset
+                                                             / ctx->block_size),
+                                      .size = (uint16_t) ctx->block_size
+                                  })))) {
+        err = avs_coap_client_send_async_request(
+                ctx->coap, &block->exchange_id,
+                &(avs_coap_request_header_t) {
+                    .code = AVS_COAP_CODE_GET,
+                    .options = options
+                },
+                NULL, NULL, handle_window_response, (void *) ctx);
+    }
+    avs_coap_options_cleanup(&options);
+
+    if (avs_is_err(err)) {
+        AVS_LIST(anjay_coap_download_block_t) *block_ptr =
+                AVS_LIST_FIND_PTR(&ctx->window, block);
+        if (block_ptr) {
+            AVS_LIST_DELETE(block_ptr);
+        }
+    } else {
+        ctx->next_request_offset += ctx->block_size;
+    }
+    return err;
+}
+
+static avs_error_t fill_window(anjay_coap_download_ctx_t *ctx) {
+    const size_t max_blocks_in_flight = ctx->window_open ? ctx->window_size : 1;
+    avs_error_t err = AVS_OK;
+    while (avs_is_ok(err) && ctx->next_request_offset < ctx->end_offset
+           && AVS_LIST_SIZE(ctx->window) < max_blocks_in_flight) {
+        err = request_block(ctx);
+    }
+    return err;
+}
+
+static avs_error_t deliver_payload(anjay_coap_download_ctx_t *dl_ctx,
+                                   size_t payload_offset,
+                                   const uint8_t *payload,
+                                   size_t payload_size) {
+    if (payload_offset > dl_ctx->bytes_downloaded) {
+        dl_log(DEBUG, _("missing data at offset ") "%lu",
+               (unsigned long) dl_ctx->bytes_downloaded);
+        return avs_errno(AVS_EPROTO);
+    }
+    // Resumption from a non-multiple block-size, or after block size
+    // renegotiation
+    size_t skip = AVS_MIN(dl_ctx->bytes_downloaded - payload_offset,
+                          payload_size);
+    if (skip == payload_size) {
+        return AVS_OK;
+    }
+    avs_error_t err = _anjay_downloader_next_block(
+            dl_ctx->dl, &dl_ctx->common, payload + skip, payload_size - skip,
+            (const anjay_etag_t *) &dl_ctx->etag);
+    if (avs_is_ok(err)) {
+        dl_ctx->bytes_downloaded += payload_size - skip;
+    }
+    return err;
+}
+
+/**
+ * Passes all blocks at the beginning of the window that have already been
+ * received to the user. Returns true if the transfer has been aborted, either
+ * because it finished, or due to an error.
+ */
+static bool drain_window(anjay_coap_download_ctx_t *dl_ctx) {
+    while (dl_ctx->window && dl_ctx->window->received) {
+        AVS_LIST(anjay_coap_download_block_t) block =
+                AVS_LIST_DETACH(&dl_ctx->window);
+        avs_error_t err = AVS_OK;
+        anjay_download_status_t status = _anjay_download_status_success();
+        if (block->error_code) {
+            status = _anjay_download_status_invalid_response(
+                    block->error_code);
+        } else if (avs_is_err((err = deliver_payload(dl_ctx, block->offset,
+                                                     block->payload,
+                                                     block->payload_size)))) {
+            status = _anjay_download_status_failed(err);
+        }
+        const bool finished = (block->error_code || avs_is_err(err)
+                               || block->last);
+        AVS_LIST_DELETE(&block);
+        if (finished) {
+            if (status.result == ANJAY_DOWNLOAD_FINISHED) {
+                dl_log(INFO, _("transfer id = ") "%" PRIuPTR _(" finished"),
+                       dl_ctx->common.id);
+            }
+            abort_download_transfer(dl_ctx, status);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void set_end_offset(anjay_coap_download_ctx_t *dl_ctx,
+                           size_t end_offset) {
+    dl_ctx->end_offset = AVS_MIN(dl_ctx->end_offset, end_offset);
+    AVS_LIST(anjay_coap_download_block_t) *block_ptr;
+    AVS_LIST(anjay_coap_download_block_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(block_ptr, helper, &dl_ctx->window) {
+        if ((*block_ptr)->offset >= dl_ctx->end_offset) {
+            avs_coap_exchange_cancel(dl_ctx->coap, (*block_ptr)->exchange_id);
+            AVS_LIST_DELETE(block_ptr);
+        }
+    }
+}
+
+static void
+handle_window_response(avs_coap_ctx_t *ctx,
+                       avs_coap_exchange_id_t id,
+                       avs_coap_client_request_state_t result,
+                       const avs_coap_client_async_response_t *response,
+                       avs_error_t err,
+                       void *arg) {
+    if (result == AVS_COAP_CLIENT_REQUEST_CANCEL) {
+        return;
+    }
+
+    anjay_coap_download_ctx_t *dl_ctx = (anjay_coap_download_ctx_t *) arg;
+    AVS_LIST(anjay_coap_download_block_t) *block_ptr;
+    AVS_LIST_FOREACH_PTR(block_ptr, &dl_ctx->window) {
+        if (avs_coap_exchange_id_equal((*block_ptr)->exchange_id, id)) {
+            break;
+        }
+    }
+    if (!block_ptr || !*block_ptr) {
+        AVS_UNREACHABLE("response to a request not in the window");
+        return;
+    }
+    anjay_coap_download_block_t *block = *block_ptr;
+
+    if (result == AVS_COAP_CLIENT_REQUEST_FAIL) {
+        handle_failed_request(dl_ctx, err);
+        return;
+    }
+
+    assert(result == AVS_COAP_CLIENT_REQUEST_OK
+           || result == AVS_COAP_CLIENT_REQUEST_PARTIAL_CONTENT);
+    block->exchange_id = AVS_COAP_EXCHANGE_ID_INVALID;
+    if (result == AVS_COAP_CLIENT_REQUEST_PARTIAL_CONTENT) {
+        // Each exchange is only supposed to retrieve a single block - do not
+        // let avs_coap request the following one on its own.
+        avs_coap_exchange_cancel(ctx, id);
+    }
+    block->received = true;
+
+    const uint8_t code = response->header.code;
+    if (code != AVS_COAP_CODE_CONTENT) {
+        dl_log(DEBUG,
+               _("server responded with ") "%s" _(" (expected ") "%s" _(
+                       ") for block at offset ") "%lu",
+               AVS_COAP_CODE_STRING(code),
+               AVS_COAP_CODE_STRING(AVS_COAP_CODE_CONTENT),
+               (unsigned long) block->offset);
+        // This might be a request past the end of the resource, sent before
+        // its size was known. Whether it is an actual error will be decided
+        // once all preceding blocks are received.
+        block->error_code = code;
+        set_end_offset(dl_ctx, block->offset + 1);
+        (void) drain_window(dl_ctx);
+        return;
+    }
+
+    avs_coap_etag_t etag;
+    if (handle_response_etag(dl_ctx, &response->header, &etag)) {
+        return;
+    }
+    avs_coap_option_block_t block2;
+    switch (avs_coap_options_get_block(&response->header.options,
+                                       AVS_COAP_BLOCK2, &block2)) {
+    case 0:
+        break;
+    case AVS_COAP_OPTION_MISSING:
+        // the whole resource has been sent in a single response
+        block2.size = 0;
+        break;
+    default:
+        abort_download_transfer(
+                dl_ctx, _anjay_download_status_failed(avs_errno(AVS_EPROTO)));
+        return;
+    }
+
+    block->last = (result == AVS_COAP_CLIENT_REQUEST_OK);
+    if (block->last) {
+        // the current block itself must not be dropped, even if empty
+        set_end_offset(dl_ctx,
+                       AVS_MAX(response->payload_offset
+                                       + response->payload_size,
+                               block->offset + 1));
+    }
+    if (block_ptr == &dl_ctx->window) {
+        // This is the next block to pass to the user, so there is no need to
+        // copy it. This is always the case for the first response, which may
+        // not have the BLOCK2 option, and so might be larger than the buffer.
+        if (avs_is_err((err = deliver_payload(
+                                dl_ctx, response->payload_offset,
+                                (const uint8_t *) response->payload,
+                                response->payload_size)))) {
+            abort_download_transfer(dl_ctx, _anjay_download_status_failed(err));
+            return;
+        }
+        block->payload_size = 0;
+    } else if (response->payload_offset != block->offset
+               || response->payload_size > block->payload_capacity) {
+        dl_log(DEBUG, _("unexpected block at offset ") "%lu",
+               (unsigned long) response->payload_offset);
+        abort_download_transfer(
+                dl_ctx, _anjay_download_status_failed(avs_errno(AVS_EPROTO)));
+        return;
+    } else {
+        memcpy(block->payload, response->payload, response->payload_size);
+        block->payload_size = response->payload_size;
+    }
+
+    if (drain_window(dl_ctx)) {
+        return;
+    }
+    dl_log(TRACE,
+           _("transfer id = ") "%" PRIuPTR _(": ") "%lu" _(" B downloaded"),
+           dl_ctx->common.id, (unsigned long) dl_ctx->bytes_downloaded);
+
+    if (block2.size && block2.size < dl_ctx->block_size) {
+        // The server renegotiated a smaller block size. Blocks requested
+        // before that would come in the new size, leaving gaps, so request
+        // everything not yet passed to the user again.
+        dl_log(DEBUG, _("block size renegotiated: ") "%lu" _(" -> ") "%u",
+               (unsigned long) dl_ctx->block_size, (unsigned) block2.size);
+        cancel_window(dl_ctx);
+        dl_ctx->block_size = block2.size;
+        dl_ctx->next_request_offset = dl_ctx->bytes_downloaded
+                                      / dl_ctx->block_size
+                                      * dl_ctx->block_size;
+    }
+    dl_ctx->window_open = true;
+    if (avs_is_err((err = fill_window(dl_ctx)))) {
+        abort_download_transfer(dl_ctx, _anjay_download_status_failed(err));
+    }
+}
+
+static avs_error_t start_windowed_download(anjay_coap_download_ctx_t *ctx,
+                                           size_t block_size) {
+    // This is also called after reconnecting, in which case all exchanges are
+    // already gone, together with the old CoAP context.
+    cancel_window(ctx);
+    ctx->block_size = block_size;
+    ctx->window_open = false;
+    ctx->next_request_offset =
+            ctx->bytes_downloaded / ctx->block_size * ctx->block_size;
+    ctx->end_offset = SIZE_MAX;
+    return fill_window(ctx);
+}
+
 static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
     anjay_t *anjay = _anjay_get_from_sched(sched);
     uintptr_t id = *(const uintptr_t *) id_ptr;
@@ -305,6 +670,13 @@ static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
     avs_coap_options_t options;
     const uint8_t code = AVS_COAP_CODE_GET;
     const size_t block_size = initial_block2_option_size(ctx, code);
+    if (ctx->window_size > 1) {
+        if (avs_is_err((err = start_windowed_download(ctx, block_size)))) {
+            _anjay_downloader_abort_transfer(
+                    ctx->dl, dl_ctx_ptr, _anjay_download_status_failed(err));
+        }
+        return;
+    }
     if (avs_is_err((err = avs_coap_options_dynamic_init(&options)))) {
         dl_log(ERROR,
                _("download id = ") "%" PRIuPTR _("cannot start: out of memory"),
@@ -312,20 +684,8 @@ static void start_download_job(avs_sched_t *sched, const void *id_ptr) {
         goto end;
     }
 
-    AVS_LIST(const anjay_string_t) elem;
-    AVS_LIST_FOREACH(elem, ctx->uri.uri_path) {
-        if (avs_is_err((err = avs_coap_options_add_string(
-                                &options, AVS_COAP_OPTION_URI_PATH,
-                                elem->c_str)))) {
-            goto end;
-        }
-    }
-    AVS_LIST_FOREACH(elem, ctx->uri.uri_query) {
-        if (avs_is_err((err = avs_coap_options_add_string(
-                                &options, AVS_COAP_OPTION_URI_QUERY,
-                                elem->c_str)))) {
-            goto end;
-        }
+    if (avs_is_err((err = add_uri_options(ctx, &options)))) {
+        goto end;
     }
 
     // When we start the download, there is no need to ask for a blockwise
@@ -372,10 +732,11 @@ static avs_error_t reset_coap_ctx(anjay_coap_download_ctx_t *ctx) {
         // NOTE: we set udp_response_cache to NULL, because it should never be
         // necessary. It's used to cache responses generated by us whenever we
         // handle an incoming request, and contexts used for downloads don't
-        // expect receiving any requests that would need handling.
+        // expect receiving any requests that would need handling. For the
+        // same reason, the default (minimal) notify cache size is used.
         ctx->coap = avs_coap_udp_ctx_create(anjay->sched, &ctx->tx_params,
                                             anjay->in_shared_buffer,
-                                            anjay->out_shared_buffer, NULL);
+                                            anjay->out_shared_buffer, NULL, 0);
         break;
 #endif // WITH_AVS_COAP_UDP
 
@@ -431,21 +792,26 @@ reconnect_coap_transfer(anjay_downloader_t *dl,
     } else {
         // A new DTLS session requires resetting the CoAP context.
         // If we manage to resume the session, we can simply continue sending
-        // retransmissions as if nothing happened.
+        // retransmissions as if nothing happened - unless there is nothing to
+        // retransmit, because the transfer failed and is being resumed from
+        // the last received block.
         if (!_anjay_was_session_resumed(ctx->socket)) {
             if (avs_is_err((err = reset_coap_ctx(ctx)))) {
                 return err;
             }
+        } else if (avs_coap_exchange_id_valid(ctx->exchange_id)
+                   || ctx->window) {
+            return AVS_OK;
+        }
 
-            anjay_t *anjay = _anjay_downloader_get_anjay(dl);
-            if (AVS_SCHED_NOW(anjay->sched, &ctx->job_start, start_download_job,
-                              &ctx->common.id, sizeof(ctx->common.id))) {
-                dl_log(WARNING,
-                       _("could not schedule resumption for download id "
-                         "= ") "%" PRIuPTR,
-                       ctx->common.id);
-                return avs_errno(AVS_ENOMEM);
-            }
+        anjay_t *anjay = _anjay_downloader_get_anjay(dl);
+        if (AVS_SCHED_NOW(anjay->sched, &ctx->job_start, start_download_job,
+                          &ctx->common.id, sizeof(ctx->common.id))) {
+            dl_log(WARNING,
+                   _("could not schedule resumption for download id "
+                     "= ") "%" PRIuPTR,
+                   ctx->common.id);
+            return avs_errno(AVS_ENOMEM);
         }
     }
     return AVS_OK;
@@ -577,6 +943,15 @@ _anjay_downloader_coap_ctx_new(anjay_downloader_t *dl,
     }
 #endif // WITH_AVS_COAP_UDP
 
+    ctx->window_size = cfg->coap_block_window_size;
+#ifdef WITH_AVS_COAP_UDP
+    if (ctx->tx_params.nstart < ctx->window_size) {
+        // Otherwise, avs_coap would hold back requests in excess of NSTART,
+        // defeating the purpose of the window.
+        ctx->tx_params.nstart = ctx->window_size;
+    }
+#endif // WITH_AVS_COAP_UDP
+
     if (avs_is_err((err = reset_coap_ctx(ctx)))) {
         goto error;
     }
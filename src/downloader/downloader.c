@@ -17,6 +17,7 @@
 #include <anjay_config.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <avsystem/commons/errno.h>
 #include <avsystem/commons/memory.h>
@@ -37,6 +38,199 @@ struct anjay_download_ctx {
     anjay_download_ctx_common_t common;
 };
 
+#ifdef WITH_AVS_PERSISTENCE
+static const char *CHECKPOINT_MAGIC = "DLC";
+
+typedef enum {
+    CHECKPOINT_VERSION_0 = 0,
+    CHECKPOINT_VERSION_CURRENT = CHECKPOINT_VERSION_0
+} checkpoint_version_t;
+
+static const uint8_t SUPPORTED_CHECKPOINT_VERSIONS[] = {
+    CHECKPOINT_VERSION_0
+};
+
+static anjay_etag_t *etag_copy(const anjay_etag_t *etag) {
+    if (!etag || !etag->size) {
+        return NULL;
+    }
+    const size_t struct_size = offsetof(anjay_etag_t, value) + etag->size;
+    anjay_etag_t *result = (anjay_etag_t *) avs_malloc(struct_size);
+    if (result) {
+        memcpy(result, etag, struct_size);
+    }
+    return result;
+}
+
+static bool etag_equal(const anjay_etag_t *a, const anjay_etag_t *b) {
+    const uint8_t a_size = a ? a->size : 0;
+    const uint8_t b_size = b ? b->size : 0;
+    return a_size == b_size
+           && (!a_size || memcmp(a->value, b->value, a_size) == 0);
+}
+
+static avs_error_t etag_persistence(avs_persistence_context_t *ctx,
+                                    anjay_etag_t **etag) {
+    uint8_t size = *etag ? (*etag)->size : 0;
+    avs_error_t err = avs_persistence_u8(ctx, &size);
+    if (avs_is_err(err) || !size) {
+        return err;
+    }
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        assert(!*etag);
+        if (!(*etag = (anjay_etag_t *) avs_malloc(
+                      offsetof(anjay_etag_t, value) + size))) {
+            dl_log(ERROR, _("out of memory"));
+            return avs_errno(AVS_ENOMEM);
+        }
+        (*etag)->size = size;
+    }
+    return avs_persistence_bytes(ctx, (*etag)->value, size);
+}
+
+static avs_error_t
+checkpoint_persistence(avs_persistence_context_t *ctx,
+                       anjay_download_checkpoint_t *checkpoint) {
+    uint8_t version = CHECKPOINT_VERSION_CURRENT;
+    uint64_t offset = checkpoint->offset;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_magic_string(ctx,
+                                                           CHECKPOINT_MAGIC)))
+            || avs_is_err((err = avs_persistence_version(
+                                   ctx, &version, SUPPORTED_CHECKPOINT_VERSIONS,
+                                   sizeof(SUPPORTED_CHECKPOINT_VERSIONS))))
+            || avs_is_err((err = avs_persistence_string(ctx, &checkpoint->url)))
+            || avs_is_err((err = avs_persistence_u64(ctx, &offset)))
+            || avs_is_err((err = etag_persistence(ctx, &checkpoint->etag))));
+    if (avs_is_ok(err)
+            && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        if (!checkpoint->url || offset > SIZE_MAX) {
+            err = avs_errno(AVS_EBADMSG);
+        } else {
+            checkpoint->offset = (size_t) offset;
+        }
+    }
+    return err;
+}
+
+static void write_checkpoint(anjay_download_ctx_common_t *common) {
+    avs_persistence_context_t ctx =
+            avs_persistence_store_context_create(common->checkpoint_stream);
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_stream_reset(common->checkpoint_stream)))
+            || avs_is_err((err = checkpoint_persistence(&ctx,
+                                                        &common->checkpoint)))
+            || avs_is_err((err = avs_stream_finish_message(
+                                   common->checkpoint_stream))));
+    if (avs_is_err(err)) {
+        dl_log(WARNING,
+               _("could not write checkpoint for download id = ") "%" PRIuPTR,
+               common->id);
+    } else {
+        common->checkpoint_persisted_offset = common->checkpoint.offset;
+    }
+}
+
+static void invalidate_checkpoint(anjay_download_ctx_common_t *common) {
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_stream_reset(common->checkpoint_stream)))
+            || avs_is_err((err = avs_stream_finish_message(
+                                   common->checkpoint_stream))));
+    if (avs_is_err(err)) {
+        dl_log(WARNING,
+               _("could not invalidate checkpoint for download id = ") "%"
+                       PRIuPTR,
+               common->id);
+    }
+}
+
+static void update_checkpoint(anjay_download_ctx_common_t *common,
+                              size_t data_size,
+                              const anjay_etag_t *etag) {
+    common->checkpoint.offset += data_size;
+    if (!etag_equal(common->checkpoint.etag, etag)) {
+        anjay_etag_t *copy = etag_copy(etag);
+        if (!copy && etag && etag->size) {
+            // do not checkpoint the new data with an outdated ETag
+            dl_log(ERROR, _("out of memory"));
+            common->checkpoint.offset -= data_size;
+            return;
+        }
+        avs_free(common->checkpoint.etag);
+        common->checkpoint.etag = copy;
+    }
+    if (common->checkpoint.offset - common->checkpoint_persisted_offset
+            >= AVS_MAX(common->checkpoint_interval, 1)) {
+        write_checkpoint(common);
+    }
+}
+
+static avs_error_t checkpoint_init(anjay_download_ctx_common_t *common,
+                                   const anjay_download_config_t *config) {
+    common->checkpoint_stream = config->checkpoint_stream;
+    common->checkpoint_interval = config->checkpoint_interval;
+    common->max_resume_attempts = config->max_resume_attempts;
+    common->resume_offset = config->start_offset;
+    common->checkpoint_persisted_offset = config->start_offset;
+    common->checkpoint.offset = config->start_offset;
+    if (!(common->checkpoint.url = avs_strdup(config->url))
+            || (config->etag && config->etag->size
+                && !(common->checkpoint.etag = etag_copy(config->etag)))) {
+        dl_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    return AVS_OK;
+}
+
+avs_error_t
+_anjay_downloader_checkpoint_read(avs_stream_t *in_stream,
+                                  anjay_download_checkpoint_t *out_checkpoint) {
+    avs_persistence_context_t ctx =
+            avs_persistence_restore_context_create(in_stream);
+    anjay_download_checkpoint_t checkpoint = {
+        .url = NULL
+    };
+    avs_error_t err = checkpoint_persistence(&ctx, &checkpoint);
+    if (avs_is_err(err)) {
+        dl_log(DEBUG, _("no valid download checkpoint"));
+        anjay_download_checkpoint_cleanup(&checkpoint);
+        return err;
+    }
+    *out_checkpoint = checkpoint;
+    return AVS_OK;
+}
+#else  // WITH_AVS_PERSISTENCE
+avs_error_t
+_anjay_downloader_checkpoint_read(avs_stream_t *in_stream,
+                                  anjay_download_checkpoint_t *out_checkpoint) {
+    (void) in_stream;
+    (void) out_checkpoint;
+    dl_log(ERROR, _("download checkpoints require persistence support"));
+    return avs_errno(AVS_ENOTSUP);
+}
+#endif // WITH_AVS_PERSISTENCE
+
+avs_error_t _anjay_downloader_next_block(anjay_downloader_t *dl,
+                                         anjay_download_ctx_common_t *common,
+                                         const uint8_t *data,
+                                         size_t data_size,
+                                         const anjay_etag_t *etag) {
+    avs_error_t err =
+            common->on_next_block(_anjay_downloader_get_anjay(dl), data,
+                                  data_size, etag, common->user_data);
+    if (avs_is_err(err)) {
+        // failures reported by the user are not worth retrying
+        common->on_next_block_failed = true;
+        return err;
+    }
+#ifdef WITH_AVS_PERSISTENCE
+    if (common->checkpoint_stream) {
+        update_checkpoint(common, data_size, etag);
+    }
+#endif // WITH_AVS_PERSISTENCE
+    return AVS_OK;
+}
+
 int _anjay_downloader_init(anjay_downloader_t *dl, anjay_t *anjay) {
     assert(anjay);
     assert(_anjay_downloader_get_anjay(dl) == anjay);
@@ -59,9 +253,77 @@ static void cleanup_transfer(AVS_LIST(anjay_download_ctx_t) *ctx) {
     assert(*ctx);
     assert((*ctx)->common.vtable);
 
+    avs_sched_del(&(*ctx)->common.resume_job);
+    anjay_download_checkpoint_cleanup(&(*ctx)->common.checkpoint);
     (*ctx)->common.vtable->cleanup(ctx);
 }
 
+static void reconnect_transfer(anjay_downloader_t *dl,
+                               AVS_LIST(anjay_download_ctx_t) *ctx) {
+    assert(ctx);
+    assert(*ctx);
+    assert((*ctx)->common.vtable);
+
+    avs_sched_del(&(*ctx)->common.resume_job);
+    avs_error_t err = (*ctx)->common.vtable->reconnect(dl, ctx);
+    if (avs_is_err(err)) {
+        _anjay_downloader_abort_transfer(dl, ctx,
+                                         _anjay_download_status_failed(err));
+    }
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+static void resume_job(avs_sched_t *sched, const void *id_ptr) {
+    anjay_t *anjay = _anjay_get_from_sched(sched);
+    uintptr_t id = *(const uintptr_t *) id_ptr;
+    AVS_LIST(anjay_download_ctx_t) *ctx =
+            _anjay_downloader_find_ctx_ptr_by_id(&anjay->downloader, id);
+    if (!ctx) {
+        dl_log(DEBUG, _("download id = ") "%" PRIuPTR _(" expired"), id);
+        return;
+    }
+    reconnect_transfer(&anjay->downloader, ctx);
+}
+
+/**
+ * Schedules resumption of a failed transfer from the last checkpointed offset,
+ * using the backend reconnect routine. Returns 0 if the transfer shall be kept
+ * alive, or -1 if it shall be aborted.
+ */
+static int schedule_resume(anjay_downloader_t *dl,
+                           anjay_download_ctx_common_t *common) {
+    if (common->on_next_block_failed) {
+        return -1;
+    }
+    if (common->checkpoint.offset != common->resume_offset) {
+        // some progress has been made since the previous attempt
+        common->resume_offset = common->checkpoint.offset;
+        common->resume_attempts = 0;
+    }
+    if (common->resume_attempts >= common->max_resume_attempts) {
+        return -1;
+    }
+    const avs_time_duration_t delay = avs_time_duration_from_scalar(
+            1 << AVS_MIN(common->resume_attempts, 6), AVS_TIME_S);
+    if (AVS_SCHED_DELAYED(_anjay_downloader_get_anjay(dl)->sched,
+                          &common->resume_job, delay, resume_job, &common->id,
+                          sizeof(common->id))) {
+        dl_log(WARNING,
+               _("could not schedule resumption for download id = ") "%"
+                       PRIuPTR,
+               common->id);
+        return -1;
+    }
+    ++common->resume_attempts;
+    dl_log(INFO,
+           _("download id = ") "%" PRIuPTR _(" failed, resuming from offset ")
+                   "%lu" _(" (attempt ") "%lu" _(")"),
+           common->id, (unsigned long) common->checkpoint.offset,
+           (unsigned long) common->resume_attempts);
+    return 0;
+}
+#endif // WITH_AVS_PERSISTENCE
+
 void _anjay_downloader_abort_transfer(anjay_downloader_t *dl,
                                       AVS_LIST(anjay_download_ctx_t) *ctx,
                                       anjay_download_status_t status) {
@@ -97,25 +359,28 @@ void _anjay_downloader_abort_transfer(anjay_downloader_t *dl,
         break;
     }
 
+#ifdef WITH_AVS_PERSISTENCE
+    if ((*ctx)->common.checkpoint_stream) {
+        if (status.result == ANJAY_DOWNLOAD_FINISHED
+                || status.result == ANJAY_DOWNLOAD_ERR_EXPIRED) {
+            invalidate_checkpoint(&(*ctx)->common);
+        } else {
+            // persist the progress made since the last periodic checkpoint
+            write_checkpoint(&(*ctx)->common);
+            if (status.result == ANJAY_DOWNLOAD_ERR_FAILED
+                    && !schedule_resume(dl, &(*ctx)->common)) {
+                return;
+            }
+        }
+    }
+#endif // WITH_AVS_PERSISTENCE
+
     (*ctx)->common.on_download_finished(_anjay_downloader_get_anjay(dl), status,
                                         (*ctx)->common.user_data);
 
     cleanup_transfer(ctx);
 }
 
-static void reconnect_transfer(anjay_downloader_t *dl,
-                               AVS_LIST(anjay_download_ctx_t) *ctx) {
-    assert(ctx);
-    assert(*ctx);
-    assert((*ctx)->common.vtable);
-
-    avs_error_t err = (*ctx)->common.vtable->reconnect(dl, ctx);
-    if (avs_is_err(err)) {
-        _anjay_downloader_abort_transfer(dl, ctx,
-                                         _anjay_download_status_failed(err));
-    }
-}
-
 void _anjay_downloader_cleanup(anjay_downloader_t *dl) {
     assert(dl);
     avs_sched_del(&dl->reconnect_job_handle);
@@ -132,6 +397,10 @@ static int get_ctx_socket(anjay_downloader_t *dl,
     assert(dl);
     assert(ctx);
     assert(ctx->common.vtable);
+    if (ctx->common.resume_job) {
+        // the connection is broken until the transfer is resumed
+        return -1;
+    }
     int result =
             ctx->common.vtable->get_socket(dl, ctx, out_socket, out_transport);
     if (!result) {
@@ -245,6 +514,32 @@ avs_error_t _anjay_downloader_download(anjay_downloader_t *dl,
 
     AVS_LIST(anjay_download_ctx_t) dl_ctx = NULL;
     avs_error_t err = avs_errno(AVS_EPROTONOSUPPORT);
+#ifdef WITH_AVS_PERSISTENCE
+    anjay_download_config_t resumed_config;
+    anjay_download_checkpoint_t checkpoint = {
+        .url = NULL
+    };
+    if (config->checkpoint_stream && config->resume_from_checkpoint
+            && avs_is_ok(_anjay_downloader_checkpoint_read(
+                       config->checkpoint_stream, &checkpoint))) {
+        if (strcmp(checkpoint.url, config->url) == 0) {
+            dl_log(INFO,
+                   _("resuming download from checkpoint at offset ") "%lu",
+                   (unsigned long) checkpoint.offset);
+            resumed_config = *config;
+            resumed_config.start_offset = checkpoint.offset;
+            resumed_config.etag = checkpoint.etag;
+            config = &resumed_config;
+        } else {
+            dl_log(DEBUG, _("checkpoint is for a different URL, ignoring"));
+        }
+    }
+#else  // WITH_AVS_PERSISTENCE
+    if (config->checkpoint_stream) {
+        dl_log(ERROR, _("download checkpoints require persistence support"));
+        return avs_errno(AVS_ENOTSUP);
+    }
+#endif // WITH_AVS_PERSISTENCE
 #ifdef WITH_COAP_DOWNLOAD
     if (_anjay_transport_info_by_uri_scheme(config->url) != NULL) {
         err = _anjay_downloader_coap_ctx_new(dl, &dl_ctx, config,
@@ -261,6 +556,15 @@ avs_error_t _anjay_downloader_download(anjay_downloader_t *dl,
         dl_log(WARNING, _("unrecognized protocol in URL: ") "%s", config->url);
     }
 
+#ifdef WITH_AVS_PERSISTENCE
+    if (dl_ctx && config->checkpoint_stream
+            && avs_is_err((err = checkpoint_init(&dl_ctx->common, config)))) {
+        cleanup_transfer(&dl_ctx);
+    }
+    // config->etag may point into the checkpoint, so it is freed only now
+    anjay_download_checkpoint_cleanup(&checkpoint);
+#endif // WITH_AVS_PERSISTENCE
+
     if (dl_ctx) {
         AVS_LIST_APPEND(&dl->downloads, dl_ctx);
 
@@ -28,6 +28,10 @@
 
 #include "private.h"
 
+#ifdef ANJAY_TEST
+#    include "test/http_mock.h"
+#endif // ANJAY_TEST
+
 VISIBILITY_SOURCE_BEGIN
 
 typedef struct {
@@ -118,11 +122,10 @@ static void handle_http_packet(anjay_downloader_t *dl,
                 size_t bytes_to_write =
                         ctx->bytes_downloaded + bytes_read - ctx->bytes_written;
                 assert(bytes_read >= bytes_to_write);
-                if (avs_is_err((err = ctx->common.on_next_block(
-                                        anjay,
+                if (avs_is_err((err = _anjay_downloader_next_block(
+                                        dl, &ctx->common,
                                         &buffer[bytes_read - bytes_to_write],
-                                        bytes_to_write, ctx->etag,
-                                        ctx->common.user_data)))) {
+                                        bytes_to_write, ctx->etag)))) {
                     _anjay_downloader_abort_transfer(
                             dl, ctx_ptr, _anjay_download_status_failed(err));
                     break;
@@ -224,6 +227,9 @@ static void send_request(avs_sched_t *sched, const void *id_ptr) {
         return;
     }
 
+    // unless Content-Range says otherwise, the whole resource is being sent;
+    // this matters if the server ignored Range after resuming the transfer
+    ctx->bytes_downloaded = 0;
     AVS_LIST(const avs_http_header_t) it;
     AVS_LIST_FOREACH(it, received_headers) {
         if (avs_strcasecmp(it->key, "Content-Range") == 0) {
@@ -392,3 +398,7 @@ error:
     assert(avs_is_err(err));
     return err;
 }
+
+#ifdef ANJAY_TEST
+#    include "test/http.c"
+#endif // ANJAY_TEST
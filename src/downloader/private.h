@@ -48,6 +48,24 @@ typedef struct {
     anjay_download_next_block_handler_t *on_next_block;
     anjay_download_finished_handler_t *on_download_finished;
     void *user_data;
+
+    // Fields below are managed by downloader.c; checkpoint_stream is NULL if
+    // checkpoints are disabled. checkpoint.offset is the offset of the next
+    // byte to be passed to on_next_block.
+    avs_stream_t *checkpoint_stream;
+    size_t checkpoint_interval;
+    size_t checkpoint_persisted_offset;
+    anjay_download_checkpoint_t checkpoint;
+
+    // Automatic resumption of failed transfers; resume_attempts counts the
+    // consecutive attempts made since checkpoint.offset was resume_offset.
+    // While resume_job is scheduled, the backend socket is not reported to
+    // the user.
+    size_t max_resume_attempts;
+    size_t resume_attempts;
+    size_t resume_offset;
+    bool on_next_block_failed;
+    avs_sched_handle_t resume_job;
 } anjay_download_ctx_common_t;
 
 static inline anjay_t *_anjay_downloader_get_anjay(anjay_downloader_t *dl) {
@@ -61,6 +79,18 @@ void _anjay_downloader_abort_transfer(anjay_downloader_t *dl,
                                       AVS_LIST(anjay_download_ctx_t) *ctx,
                                       anjay_download_status_t status);
 
+/**
+ * Passes a chunk of downloaded data to the user-defined on_next_block handler,
+ * and writes a checkpoint if enabled and due.
+ *
+ * Backends MUST use this function instead of calling on_next_block directly.
+ */
+avs_error_t _anjay_downloader_next_block(anjay_downloader_t *dl,
+                                         anjay_download_ctx_common_t *common,
+                                         const uint8_t *data,
+                                         size_t data_size,
+                                         const anjay_etag_t *etag);
+
 static inline anjay_download_status_t _anjay_download_status_success(void) {
     return (anjay_download_status_t) {
         .result = ANJAY_DOWNLOAD_FINISHED
@@ -18,6 +18,7 @@
 #include <anjay_test/mock_clock.h>
 #include <anjay_test/utils.h>
 #include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream/stream_membuf.h>
 #include <avsystem/commons/unit/mock_helpers.h>
 #include <avsystem/commons/unit/mocksock.h>
 #include <avsystem/commons/unit/test.h>
@@ -1031,3 +1032,174 @@ AVS_UNIT_TEST(downloader, resumption_at_some_offset) {
         teardown_simple();
     }
 }
+
+AVS_UNIT_TEST(downloader, coap_download_windowed) {
+    enum { BLOCK_SIZE = 32 };
+
+    setup_simple("coap://127.0.0.1:5683");
+    SIMPLE_ENV.cfg.coap_block_window_size = 2;
+
+    // limit the initial block size to 32 bytes
+    size_t new_capacity = 64;
+    memcpy((void *) (intptr_t) &SIMPLE_ENV.base->anjay.in_shared_buffer
+                   ->capacity,
+           &new_capacity, sizeof(new_capacity));
+
+    avs_unit_mocksock_expect_connect(SIMPLE_ENV.mocksock, "127.0.0.1", "5683");
+
+    const coap_test_msg_t *req[5];
+    const coap_test_msg_t *res[5];
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(req); ++i) {
+        req[i] = COAP_MSG(CON, GET, ID_TOKEN_RAW(i, nth_token(i)),
+                          BLOCK2(i, BLOCK_SIZE, ""));
+        res[i] = i * BLOCK_SIZE < sizeof(DESPAIR) - 1
+                         ? COAP_MSG(ACK, CONTENT,
+                                    ID_TOKEN_RAW(i, nth_token(i)),
+                                    BLOCK2(i, BLOCK_SIZE, DESPAIR))
+                         : COAP_MSG(ACK, BAD_OPTION,
+                                    ID_TOKEN_RAW(i, nth_token(i)),
+                                    NO_PAYLOAD);
+    }
+
+    // only the first block is requested until the block size is known
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req[0]->content,
+                                    req[0]->length);
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res[0]->content,
+                            res[0]->length);
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req[1]->content,
+                                    req[1]->length);
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req[2]->content,
+                                    req[2]->length);
+    // responses arriving out of order are reassembled
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res[2]->content,
+                            res[2]->length);
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res[1]->content,
+                            res[1]->length);
+    // the size of the resource is not known yet, so block 4 is requested
+    // past its end, and the error response to it is ignored
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req[3]->content,
+                                    req[3]->length);
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req[4]->content,
+                                    req[4]->length);
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res[4]->content,
+                            res[4]->length);
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res[3]->content,
+                            res[3]->length);
+    expect_timeout(SIMPLE_ENV.mocksock);
+
+    for (size_t offset = 0; offset < sizeof(DESPAIR) - 1;
+         offset += BLOCK_SIZE) {
+        on_next_block_args_t args = {
+            .data_size = AVS_MIN(BLOCK_SIZE, sizeof(DESPAIR) - 1 - offset),
+            .result = AVS_OK
+        };
+        memcpy(args.data, &DESPAIR[offset], args.data_size);
+        expect_next_block(&SIMPLE_ENV.data, args);
+    }
+    expect_download_finished(&SIMPLE_ENV.data,
+                             _anjay_download_status_success());
+
+    perform_simple_download();
+
+    teardown_simple();
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+AVS_UNIT_TEST(downloader, coap_download_checkpoint) {
+    enum { BLOCK_SIZE = 16 };
+
+    setup_simple("coap://127.0.0.1:5683");
+    avs_stream_t *checkpoint_stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(checkpoint_stream);
+    SIMPLE_ENV.cfg.checkpoint_stream = checkpoint_stream;
+    SIMPLE_ENV.cfg.checkpoint_interval = 2 * BLOCK_SIZE;
+
+    avs_unit_mocksock_expect_connect(SIMPLE_ENV.mocksock, "127.0.0.1", "5683");
+
+    static const avs_coap_etag_t etag = {
+        .size = 3,
+        .bytes = "tag"
+    };
+    for (size_t i = 0; i < 4; ++i) {
+        const coap_test_msg_t *req =
+                i == 0 ? COAP_MSG(CON, GET, ID_TOKEN_RAW(i, nth_token(i)),
+                                  NO_PAYLOAD)
+                       : COAP_MSG(CON, GET, ID_TOKEN_RAW(i, nth_token(i)),
+                                  BLOCK2(i, BLOCK_SIZE, ""));
+        const coap_test_msg_t *res =
+                COAP_MSG(ACK, CONTENT, ID_TOKEN_RAW(i, nth_token(i)),
+                         ETAG("tag"), BLOCK2(i, BLOCK_SIZE, DESPAIR));
+        avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req->content,
+                                        req->length);
+        avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res->content,
+                                res->length);
+
+        on_next_block_args_t args = {
+            .data_size = BLOCK_SIZE,
+            .etag = (const anjay_etag_t *) &etag,
+            // fail after the periodic checkpoint written at 32 bytes
+            .result = i == 3 ? avs_errno(AVS_EIO) : AVS_OK
+        };
+        memcpy(args.data, &DESPAIR[i * BLOCK_SIZE], BLOCK_SIZE);
+        expect_next_block(&SIMPLE_ENV.data, args);
+    }
+    expect_timeout(SIMPLE_ENV.mocksock);
+    expect_download_finished(&SIMPLE_ENV.data,
+                             _anjay_download_status_failed(
+                                     avs_errno(AVS_EIO)));
+
+    perform_simple_download();
+
+    // the checkpoint written on failure includes the third block
+    anjay_download_checkpoint_t checkpoint;
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_download_checkpoint_read(checkpoint_stream, &checkpoint));
+    AVS_UNIT_ASSERT_EQUAL_STRING(checkpoint.url, "coap://127.0.0.1:5683");
+    AVS_UNIT_ASSERT_EQUAL(checkpoint.offset, 3 * BLOCK_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(checkpoint.etag);
+    AVS_UNIT_ASSERT_EQUAL(checkpoint.etag->size, etag.size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(checkpoint.etag->value, etag.bytes,
+                                      etag.size);
+    anjay_download_checkpoint_cleanup(&checkpoint);
+
+    avs_stream_cleanup(&checkpoint_stream);
+    teardown_simple();
+}
+
+AVS_UNIT_TEST(downloader, coap_download_checkpoint_invalidated_on_success) {
+    setup_simple("coap://127.0.0.1:5683");
+    avs_stream_t *checkpoint_stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(checkpoint_stream);
+    SIMPLE_ENV.cfg.checkpoint_stream = checkpoint_stream;
+
+    const coap_test_msg_t *req =
+            COAP_MSG(CON, GET, ID_TOKEN_RAW(0, nth_token(0)), NO_PAYLOAD);
+    const coap_test_msg_t *res =
+            COAP_MSG(ACK, CONTENT, ID_TOKEN_RAW(0, nth_token(0)),
+                     BLOCK2(0, 128, DESPAIR));
+
+    avs_unit_mocksock_expect_connect(SIMPLE_ENV.mocksock, "127.0.0.1", "5683");
+    avs_unit_mocksock_expect_output(SIMPLE_ENV.mocksock, &req->content,
+                                    req->length);
+    avs_unit_mocksock_input(SIMPLE_ENV.mocksock, &res->content, res->length);
+    expect_timeout(SIMPLE_ENV.mocksock);
+
+    expect_next_block(&SIMPLE_ENV.data,
+                      (on_next_block_args_t) {
+                          .data = DESPAIR,
+                          .data_size = sizeof(DESPAIR) - 1,
+                          .result = AVS_OK
+                      });
+    expect_download_finished(&SIMPLE_ENV.data,
+                             _anjay_download_status_success());
+
+    perform_simple_download();
+
+    anjay_download_checkpoint_t checkpoint;
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_download_checkpoint_read(checkpoint_stream, &checkpoint));
+
+    avs_stream_cleanup(&checkpoint_stream);
+    teardown_simple();
+}
+#endif // WITH_AVS_PERSISTENCE
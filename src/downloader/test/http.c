@@ -0,0 +1,370 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_test/mock_clock.h>
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/unit/mock_helpers.h>
+#include <avsystem/commons/unit/test.h>
+
+#define TEST_URL "http://127.0.0.1/file"
+
+typedef struct {
+    const char *data;
+    bool message_finished;
+    avs_error_t err;
+} http_read_t;
+
+typedef struct {
+    anjay_t anjay;
+    avs_stream_t *checkpoint_stream;
+    anjay_download_config_t cfg;
+
+    // response to the next request
+    const char *content_range;
+    const char *etag;
+    const http_read_t *reads;
+    size_t num_reads;
+    size_t next_read;
+
+    // headers of the last request
+    char if_match[258];
+    char range[64];
+    size_t num_requests;
+    AVS_LIST(const avs_http_header_t) *header_storage;
+
+    size_t num_next_block_calls;
+    const char *expected_data;
+    bool finished;
+    anjay_download_status_t status;
+} http_test_env_t;
+
+static http_test_env_t HTTP_ENV;
+
+// used as a placeholder, only the address matters
+static char HTTP_SOCKET;
+
+static avs_error_t mock_open_stream(avs_stream_t **out,
+                                    avs_http_t *client,
+                                    avs_http_method_t method,
+                                    avs_http_content_encoding_t encoding,
+                                    const avs_url_t *url,
+                                    const char *auth_username,
+                                    const char *auth_password) {
+    (void) client;
+    (void) encoding;
+    (void) url;
+    (void) auth_username;
+    (void) auth_password;
+    AVS_UNIT_ASSERT_EQUAL(method, AVS_HTTP_GET);
+    // a membuf is as good a stream as any, as long as no calls reach it
+    AVS_UNIT_ASSERT_NOT_NULL((*out = avs_stream_membuf_create()));
+    HTTP_ENV.if_match[0] = '\0';
+    HTTP_ENV.range[0] = '\0';
+    HTTP_ENV.next_read = 0;
+    ++HTTP_ENV.num_requests;
+    return AVS_OK;
+}
+
+static void
+mock_set_header_storage(avs_stream_t *stream,
+                        AVS_LIST(const avs_http_header_t) *header_storage) {
+    (void) stream;
+    if (HTTP_ENV.header_storage) {
+        AVS_LIST_CLEAR(HTTP_ENV.header_storage);
+    }
+    HTTP_ENV.header_storage = header_storage;
+}
+
+static int mock_add_header(avs_stream_t *stream,
+                           const char *key,
+                           const char *value) {
+    (void) stream;
+    if (!strcmp(key, "If-Match")) {
+        avs_simple_snprintf(HTTP_ENV.if_match, sizeof(HTTP_ENV.if_match), "%s",
+                            value);
+    } else if (!strcmp(key, "Range")) {
+        avs_simple_snprintf(HTTP_ENV.range, sizeof(HTTP_ENV.range), "%s",
+                            value);
+    }
+    return 0;
+}
+
+static void add_response_header(const char *key, const char *value) {
+    AVS_LIST(avs_http_header_t) header =
+            AVS_LIST_NEW_ELEMENT(avs_http_header_t);
+    AVS_UNIT_ASSERT_NOT_NULL(header);
+    header->key = key;
+    header->value = value;
+    AVS_LIST_APPEND((AVS_LIST(avs_http_header_t) *) HTTP_ENV.header_storage,
+                    header);
+}
+
+static avs_error_t mock_finish_message(avs_stream_t *stream) {
+    (void) stream;
+    AVS_UNIT_ASSERT_NOT_NULL(HTTP_ENV.header_storage);
+    if (HTTP_ENV.content_range) {
+        add_response_header("Content-Range", HTTP_ENV.content_range);
+    }
+    if (HTTP_ENV.etag) {
+        add_response_header("ETag", HTTP_ENV.etag);
+    }
+    return AVS_OK;
+}
+
+static avs_error_t mock_read(avs_stream_t *stream,
+                             size_t *out_bytes_read,
+                             bool *out_message_finished,
+                             void *buffer,
+                             size_t buffer_length) {
+    (void) stream;
+    AVS_UNIT_ASSERT_TRUE(HTTP_ENV.next_read < HTTP_ENV.num_reads);
+    const http_read_t *read = &HTTP_ENV.reads[HTTP_ENV.next_read++];
+    *out_bytes_read = 0;
+    *out_message_finished = false;
+    if (avs_is_err(read->err)) {
+        return read->err;
+    }
+    *out_bytes_read = strlen(read->data);
+    AVS_UNIT_ASSERT_TRUE(*out_bytes_read <= buffer_length);
+    memcpy(buffer, read->data, *out_bytes_read);
+    *out_message_finished = read->message_finished;
+    return AVS_OK;
+}
+
+static bool mock_nonblock_read_ready(avs_stream_t *stream) {
+    (void) stream;
+    return HTTP_ENV.next_read < HTTP_ENV.num_reads;
+}
+
+static avs_net_socket_t *mock_getsock(avs_stream_t *stream) {
+    return stream ? (avs_net_socket_t *) &HTTP_SOCKET : NULL;
+}
+
+static avs_error_t http_on_next_block(anjay_t *anjay,
+                                      const uint8_t *data,
+                                      size_t data_size,
+                                      const anjay_etag_t *etag,
+                                      void *user_data) {
+    (void) anjay;
+    (void) user_data;
+    AVS_UNIT_ASSERT_NOT_NULL(HTTP_ENV.expected_data);
+    AVS_UNIT_ASSERT_EQUAL(data_size, strlen(HTTP_ENV.expected_data));
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(data, HTTP_ENV.expected_data,
+                                      data_size);
+    AVS_UNIT_ASSERT_NOT_NULL(etag);
+    AVS_UNIT_ASSERT_EQUAL(etag->size, 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(etag->value, "tag", 3);
+    HTTP_ENV.expected_data = NULL;
+    ++HTTP_ENV.num_next_block_calls;
+    return AVS_OK;
+}
+
+static void http_on_download_finished(anjay_t *anjay,
+                                      anjay_download_status_t status,
+                                      void *user_data) {
+    (void) anjay;
+    (void) user_data;
+    AVS_UNIT_ASSERT_FALSE(HTTP_ENV.finished);
+    HTTP_ENV.finished = true;
+    HTTP_ENV.status = status;
+}
+
+static void http_setup(void) {
+    memset(&HTTP_ENV, 0, sizeof(HTTP_ENV));
+
+    AVS_UNIT_MOCK(avs_http_open_stream) = mock_open_stream;
+    AVS_UNIT_MOCK(avs_http_set_header_storage) = mock_set_header_storage;
+    AVS_UNIT_MOCK(avs_http_add_header) = mock_add_header;
+    AVS_UNIT_MOCK(avs_stream_finish_message) = mock_finish_message;
+    AVS_UNIT_MOCK(avs_stream_read) = mock_read;
+    AVS_UNIT_MOCK(avs_stream_nonblock_read_ready) = mock_nonblock_read_ready;
+    AVS_UNIT_MOCK(avs_stream_net_getsock) = mock_getsock;
+
+    HTTP_ENV.anjay = (anjay_t) {
+        .sched = avs_sched_new("Anjay-test", &HTTP_ENV.anjay)
+    };
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_downloader_init(&HTTP_ENV.anjay.downloader,
+                                                   &HTTP_ENV.anjay));
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S));
+
+    enum { ARBITRARY_SIZE = 4096 };
+    HTTP_ENV.anjay.in_shared_buffer = avs_shared_buffer_new(ARBITRARY_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(HTTP_ENV.anjay.in_shared_buffer);
+
+    AVS_UNIT_ASSERT_NOT_NULL(
+            (HTTP_ENV.checkpoint_stream = avs_stream_membuf_create()));
+    HTTP_ENV.cfg = (anjay_download_config_t) {
+        .url = TEST_URL,
+        .on_next_block = http_on_next_block,
+        .on_download_finished = http_on_download_finished,
+        .checkpoint_stream = HTTP_ENV.checkpoint_stream
+    };
+}
+
+static void http_teardown(void) {
+    _anjay_downloader_cleanup(&HTTP_ENV.anjay.downloader);
+    avs_sched_cleanup(&HTTP_ENV.anjay.sched);
+    avs_free(HTTP_ENV.anjay.in_shared_buffer);
+    avs_stream_cleanup(&HTTP_ENV.checkpoint_stream);
+    _anjay_mock_clock_finish();
+    memset(&HTTP_ENV, 0, sizeof(HTTP_ENV));
+}
+
+static void expect_response(const char *content_range,
+                            const http_read_t *reads,
+                            size_t num_reads) {
+    HTTP_ENV.content_range = content_range;
+    HTTP_ENV.etag = "\"tag\"";
+    HTTP_ENV.reads = reads;
+    HTTP_ENV.num_reads = num_reads;
+}
+
+static size_t num_download_sockets(void) {
+    AVS_LIST(anjay_socket_entry_t) sockets = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_downloader_get_sockets(&HTTP_ENV.anjay.downloader,
+                                          &sockets));
+    size_t result = AVS_LIST_SIZE(sockets);
+    AVS_LIST_CLEAR(&sockets);
+    return result;
+}
+
+static void assert_checkpoint(size_t expected_offset) {
+    anjay_download_checkpoint_t checkpoint;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_download_checkpoint_read(
+            HTTP_ENV.checkpoint_stream, &checkpoint));
+    AVS_UNIT_ASSERT_EQUAL_STRING(checkpoint.url, TEST_URL);
+    AVS_UNIT_ASSERT_EQUAL(checkpoint.offset, expected_offset);
+    AVS_UNIT_ASSERT_NOT_NULL(checkpoint.etag);
+    AVS_UNIT_ASSERT_EQUAL(checkpoint.etag->size, 3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(checkpoint.etag->value, "tag", 3);
+    anjay_download_checkpoint_cleanup(&checkpoint);
+}
+
+static const http_read_t FIRST_HALF_THEN_RESET[] = {
+    { .data = "0123456789" },
+    { .err = { AVS_ERRNO_CATEGORY, AVS_ECONNRESET } }
+};
+
+static const http_read_t SECOND_HALF[] = {
+    { .data = "abcdefghij", .message_finished = true }
+};
+
+AVS_UNIT_TEST(downloader_http, resume_after_network_failure) {
+    http_setup();
+    HTTP_ENV.cfg.max_resume_attempts = 3;
+
+    anjay_download_handle_t handle = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_downloader_download(
+            &HTTP_ENV.anjay.downloader, &handle, &HTTP_ENV.cfg));
+    AVS_UNIT_ASSERT_NOT_NULL(handle);
+
+    expect_response(NULL, FIRST_HALF_THEN_RESET,
+                    AVS_ARRAY_SIZE(FIRST_HALF_THEN_RESET));
+    HTTP_ENV.expected_data = "0123456789";
+    avs_sched_run(HTTP_ENV.anjay.sched);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.num_requests, 1);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.num_next_block_calls, 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(HTTP_ENV.range, "");
+
+    // the transfer is waiting to be resumed, with the broken stream hidden
+    AVS_UNIT_ASSERT_FALSE(HTTP_ENV.finished);
+    AVS_UNIT_ASSERT_EQUAL(num_download_sockets(), 0);
+    assert_checkpoint(10);
+
+    expect_response("bytes 10-19/20", SECOND_HALF,
+                    AVS_ARRAY_SIZE(SECOND_HALF));
+    HTTP_ENV.expected_data = "abcdefghij";
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    avs_sched_run(HTTP_ENV.anjay.sched);
+    avs_sched_run(HTTP_ENV.anjay.sched);
+
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.num_requests, 2);
+    AVS_UNIT_ASSERT_EQUAL_STRING(HTTP_ENV.range, "bytes=10-");
+    AVS_UNIT_ASSERT_EQUAL_STRING(HTTP_ENV.if_match, "\"tag\"");
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.num_next_block_calls, 2);
+    AVS_UNIT_ASSERT_TRUE(HTTP_ENV.finished);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.status.result, ANJAY_DOWNLOAD_FINISHED);
+
+    anjay_download_checkpoint_t checkpoint;
+    AVS_UNIT_ASSERT_FAILED(anjay_download_checkpoint_read(
+            HTTP_ENV.checkpoint_stream, &checkpoint));
+
+    http_teardown();
+}
+
+AVS_UNIT_TEST(downloader_http, resume_attempts_exhausted) {
+    static const http_read_t RESET[] = {
+        { .err = { AVS_ERRNO_CATEGORY, AVS_ECONNRESET } }
+    };
+
+    http_setup();
+    HTTP_ENV.cfg.max_resume_attempts = 1;
+
+    anjay_download_handle_t handle = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_downloader_download(
+            &HTTP_ENV.anjay.downloader, &handle, &HTTP_ENV.cfg));
+
+    expect_response(NULL, RESET, AVS_ARRAY_SIZE(RESET));
+    avs_sched_run(HTTP_ENV.anjay.sched);
+    AVS_UNIT_ASSERT_FALSE(HTTP_ENV.finished);
+
+    expect_response(NULL, RESET, AVS_ARRAY_SIZE(RESET));
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    avs_sched_run(HTTP_ENV.anjay.sched);
+    avs_sched_run(HTTP_ENV.anjay.sched);
+
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.num_requests, 2);
+    AVS_UNIT_ASSERT_TRUE(HTTP_ENV.finished);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.status.result, ANJAY_DOWNLOAD_ERR_FAILED);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.status.details.error.code, AVS_ECONNRESET);
+
+    http_teardown();
+}
+
+AVS_UNIT_TEST(downloader_http, resume_from_checkpoint_on_start) {
+    http_setup();
+
+    // no automatic resumption - the first download fails
+    anjay_download_handle_t handle = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_downloader_download(
+            &HTTP_ENV.anjay.downloader, &handle, &HTTP_ENV.cfg));
+    expect_response(NULL, FIRST_HALF_THEN_RESET,
+                    AVS_ARRAY_SIZE(FIRST_HALF_THEN_RESET));
+    HTTP_ENV.expected_data = "0123456789";
+    avs_sched_run(HTTP_ENV.anjay.sched);
+    AVS_UNIT_ASSERT_TRUE(HTTP_ENV.finished);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.status.result, ANJAY_DOWNLOAD_ERR_FAILED);
+
+    // e.g. after a reboot
+    HTTP_ENV.finished = false;
+    HTTP_ENV.cfg.resume_from_checkpoint = true;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_downloader_download(
+            &HTTP_ENV.anjay.downloader, &handle, &HTTP_ENV.cfg));
+    expect_response("bytes 10-19/20", SECOND_HALF,
+                    AVS_ARRAY_SIZE(SECOND_HALF));
+    HTTP_ENV.expected_data = "abcdefghij";
+    avs_sched_run(HTTP_ENV.anjay.sched);
+
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.num_requests, 2);
+    AVS_UNIT_ASSERT_EQUAL_STRING(HTTP_ENV.range, "bytes=10-");
+    AVS_UNIT_ASSERT_EQUAL_STRING(HTTP_ENV.if_match, "\"tag\"");
+    AVS_UNIT_ASSERT_TRUE(HTTP_ENV.finished);
+    AVS_UNIT_ASSERT_EQUAL(HTTP_ENV.status.result, ANJAY_DOWNLOAD_FINISHED);
+
+    http_teardown();
+}
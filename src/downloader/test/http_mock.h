@@ -0,0 +1,49 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_TEST_DOWNLOADER_HTTP_MOCK_H
+#define ANJAY_TEST_DOWNLOADER_HTTP_MOCK_H
+
+#include <avsystem/commons/unit/mock_helpers.h>
+
+AVS_UNIT_MOCK_CREATE(avs_http_open_stream)
+#define avs_http_open_stream(...) \
+    AVS_UNIT_MOCK_WRAPPER(avs_http_open_stream)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(avs_http_set_header_storage)
+#define avs_http_set_header_storage(...) \
+    AVS_UNIT_MOCK_WRAPPER(avs_http_set_header_storage)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(avs_http_add_header)
+#define avs_http_add_header(...) \
+    AVS_UNIT_MOCK_WRAPPER(avs_http_add_header)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(avs_stream_finish_message)
+#define avs_stream_finish_message(...) \
+    AVS_UNIT_MOCK_WRAPPER(avs_stream_finish_message)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(avs_stream_read)
+#define avs_stream_read(...) AVS_UNIT_MOCK_WRAPPER(avs_stream_read)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(avs_stream_nonblock_read_ready)
+#define avs_stream_nonblock_read_ready(...) \
+    AVS_UNIT_MOCK_WRAPPER(avs_stream_nonblock_read_ready)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(avs_stream_net_getsock)
+#define avs_stream_net_getsock(...) \
+    AVS_UNIT_MOCK_WRAPPER(avs_stream_net_getsock)(__VA_ARGS__)
+
+#endif /* ANJAY_TEST_DOWNLOADER_HTTP_MOCK_H */
@@ -21,7 +21,7 @@
 #include "batch_builder.h"
 #include "vtable.h"
 
-#include <avsystem/commons/list.h>
+#include <avsystem/commons/memory.h>
 #include <avsystem/commons/utils.h>
 
 #include <anjay_modules/dm_utils.h>
@@ -45,11 +45,15 @@ typedef enum {
 typedef struct {
     anjay_batch_data_type_t type;
     union {
+        /**
+         * Used for ANJAY_BATCH_DATA_BYTES and ANJAY_BATCH_DATA_STRING. Refers
+         * to a region of the blob that follows all entries; for strings,
+         * length includes the terminating nullbyte.
+         */
         struct {
-            const void *data;
+            size_t offset;
             size_t length;
-        } bytes;
-        const char *string;
+        } blob;
         int64_t int_value;
         double double_value;
         bool bool_value;
@@ -66,10 +70,18 @@ typedef struct {
     avs_time_real_t timestamp;
 } anjay_batch_entry_t;
 
+/**
+ * Compiled batch is allocated as a single contiguous memory block: the header,
+ * followed by an array of entry_count entries, followed by blob_size bytes of
+ * string and bytes payloads referenced by the entries.
+ */
 struct anjay_batch_struct {
-    AVS_LIST(anjay_batch_entry_t) list;
     size_t ref_count;
     avs_time_real_t compilation_time;
+    size_t entry_count;
+    size_t blob_size;
+    const char *blob;
+    anjay_batch_entry_t entries[];
 };
 
 struct anjay_batch_data_output_state_struct {
@@ -78,7 +90,8 @@ struct anjay_batch_data_output_state_struct {
 
 typedef struct {
     const anjay_ret_bytes_ctx_vtable_t *vtable;
-    void *data;
+    anjay_batch_builder_t *builder;
+    size_t offset;
     size_t remaining_bytes;
 } builder_bytes_t;
 
@@ -91,36 +104,74 @@ typedef struct builder_out_struct {
     anjay_uri_path_t path;
 } builder_out_ctx_t;
 
+/**
+ * Batch builder collects entries into a growable array, and string and bytes
+ * payloads into a single growable blob, so that the number of allocations does
+ * not depend on the number of entries.
+ */
 struct anjay_batch_builder_struct {
-    AVS_LIST(anjay_batch_entry_t) list;
-    AVS_LIST(anjay_batch_entry_t) *last_element;
+    anjay_batch_entry_t *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    char *blob;
+    size_t blob_size;
+    size_t blob_capacity;
 };
 
+#define BATCH_BUILDER_INITIAL_ENTRY_CAPACITY 8
+#define BATCH_BUILDER_INITIAL_BLOB_CAPACITY 64
+
 anjay_batch_builder_t *_anjay_batch_builder_new(void) {
-    anjay_batch_builder_t *builder =
-            (anjay_batch_builder_t *) avs_calloc(1,
-                                                 sizeof(anjay_batch_builder_t));
-    if (!builder) {
-        return NULL;
+    return (anjay_batch_builder_t *) avs_calloc(1,
+                                                sizeof(anjay_batch_builder_t));
+}
+
+static int ensure_capacity(void **buffer_ptr,
+                           size_t *capacity_ptr,
+                           size_t required_capacity,
+                           size_t initial_capacity,
+                           size_t element_size) {
+    if (required_capacity <= *capacity_ptr) {
+        return 0;
+    }
+    size_t new_capacity = *capacity_ptr ? *capacity_ptr : initial_capacity;
+    while (new_capacity < required_capacity) {
+        if (new_capacity > SIZE_MAX / 2) {
+            new_capacity = required_capacity;
+            break;
+        }
+        new_capacity *= 2;
+    }
+    if (new_capacity > SIZE_MAX / element_size) {
+        return -1;
+    }
+    void *new_buffer = avs_realloc(*buffer_ptr, new_capacity * element_size);
+    if (!new_buffer) {
+        return -1;
     }
-    builder->last_element = &builder->list;
-    return builder;
+    *buffer_ptr = new_buffer;
+    *capacity_ptr = new_capacity;
+    return 0;
 }
 
-static int make_data_with_duplicated_string(anjay_batch_data_t *batch_data,
-                                            const char *str) {
-    assert(batch_data);
-    assert(str);
-    char *new_str = avs_strdup(str);
-    if (!new_str) {
+/**
+ * Reserves @p size bytes at the end of the builder's blob and sets
+ * @p out_offset to the offset of the reserved region.
+ */
+static int
+blob_alloc(anjay_batch_builder_t *builder, size_t size, size_t *out_offset) {
+    if (size > SIZE_MAX - builder->blob_size) {
         return -1;
     }
-    *batch_data = (anjay_batch_data_t) {
-        .type = ANJAY_BATCH_DATA_STRING,
-        .value = {
-            .string = new_str
-        }
-    };
+    void *blob = builder->blob;
+    if (ensure_capacity(&blob, &builder->blob_capacity,
+                        builder->blob_size + size,
+                        BATCH_BUILDER_INITIAL_BLOB_CAPACITY, 1)) {
+        return -1;
+    }
+    builder->blob = (char *) blob;
+    *out_offset = builder->blob_size;
+    builder->blob_size += size;
     return 0;
 }
 
@@ -133,16 +184,44 @@ static int batch_data_add(anjay_batch_builder_t *builder,
             && !_anjay_uri_path_has(uri, ANJAY_ID_RID)) {
         return -1;
     }
-    *builder->last_element = AVS_LIST_NEW_ELEMENT(anjay_batch_entry_t);
-    if (!*builder->last_element) {
+    void *entries = builder->entries;
+    if (ensure_capacity(&entries, &builder->entry_capacity,
+                        builder->entry_count + 1,
+                        BATCH_BUILDER_INITIAL_ENTRY_CAPACITY,
+                        sizeof(anjay_batch_entry_t))) {
         return -1;
     }
-    **builder->last_element = (anjay_batch_entry_t) {
+    builder->entries = (anjay_batch_entry_t *) entries;
+    builder->entries[builder->entry_count++] = (anjay_batch_entry_t) {
         .path = *uri,
         .timestamp = timestamp,
         .data = data
     };
-    AVS_LIST_ADVANCE_PTR(&builder->last_element);
+    return 0;
+}
+
+/**
+ * Adds an entry referring to a newly reserved blob region of @p length bytes.
+ * On failure, the builder is left unchanged.
+ */
+static int batch_blob_data_add(anjay_batch_builder_t *builder,
+                               const anjay_uri_path_t *uri,
+                               avs_time_real_t timestamp,
+                               anjay_batch_data_type_t type,
+                               size_t length,
+                               size_t *out_offset) {
+    anjay_batch_data_t data = {
+        .type = type
+    };
+    if (blob_alloc(builder, length, &data.value.blob.offset)) {
+        return -1;
+    }
+    data.value.blob.length = length;
+    if (batch_data_add(builder, uri, timestamp, data)) {
+        builder->blob_size -= length;
+        return -1;
+    }
+    *out_offset = data.value.blob.offset;
     return 0;
 }
 
@@ -189,11 +268,15 @@ int _anjay_batch_add_string(anjay_batch_builder_t *builder,
                             const anjay_uri_path_t *uri,
                             avs_time_real_t timestamp,
                             const char *str) {
-    anjay_batch_data_t str_data;
-    if (make_data_with_duplicated_string(&str_data, str)) {
+    assert(str);
+    const size_t length = strlen(str) + 1;
+    size_t offset;
+    if (batch_blob_data_add(builder, uri, timestamp, ANJAY_BATCH_DATA_STRING,
+                            length, &offset)) {
         return -1;
     }
-    return batch_data_add(builder, uri, timestamp, str_data);
+    memcpy(&builder->blob[offset], str, length);
+    return 0;
 }
 
 int _anjay_batch_add_objlnk(anjay_batch_builder_t *builder,
@@ -213,24 +296,10 @@ int _anjay_batch_add_objlnk(anjay_batch_builder_t *builder,
     return batch_data_add(builder, uri, timestamp, data);
 }
 
-static void batch_entry_cleanup(void *entry_) {
-    anjay_batch_entry_t *entry = (anjay_batch_entry_t *) entry_;
-    if (entry->data.type == ANJAY_BATCH_DATA_STRING) {
-        avs_free((void *) (intptr_t) entry->data.value.string);
-    } else if (entry->data.type == ANJAY_BATCH_DATA_BYTES) {
-        avs_free((void *) (intptr_t) entry->data.value.bytes.data);
-    }
-}
-
-static void list_cleanup(AVS_LIST(anjay_batch_entry_t) list) {
-    AVS_LIST_CLEAR(&list) {
-        batch_entry_cleanup(list);
-    }
-}
-
 void _anjay_batch_builder_cleanup(anjay_batch_builder_t **builder) {
     if (builder && *builder) {
-        list_cleanup((*builder)->list);
+        avs_free((*builder)->entries);
+        avs_free((*builder)->blob);
         avs_free(*builder);
         *builder = NULL;
     }
@@ -238,16 +307,26 @@ void _anjay_batch_builder_cleanup(anjay_batch_builder_t **builder) {
 
 anjay_batch_t *_anjay_batch_builder_compile(anjay_batch_builder_t **builder) {
     assert(builder && *builder);
-    anjay_batch_t *batch =
-            (anjay_batch_t *) avs_calloc(1, sizeof(anjay_batch_t));
+    const size_t entries_size =
+            (*builder)->entry_count * sizeof(anjay_batch_entry_t);
+    anjay_batch_t *batch = (anjay_batch_t *) avs_malloc(
+            sizeof(anjay_batch_t) + entries_size + (*builder)->blob_size);
     if (!batch) {
         return NULL;
     }
-    batch->list = (*builder)->list;
     batch->ref_count = 1;
     batch->compilation_time = avs_time_real_now();
-    avs_free(*builder);
-    *builder = NULL;
+    batch->entry_count = (*builder)->entry_count;
+    batch->blob_size = (*builder)->blob_size;
+    char *blob = (char *) &batch->entries[batch->entry_count];
+    if (entries_size) {
+        memcpy(batch->entries, (*builder)->entries, entries_size);
+    }
+    if (batch->blob_size) {
+        memcpy(blob, (*builder)->blob, batch->blob_size);
+    }
+    batch->blob = blob;
+    _anjay_batch_builder_cleanup(builder);
     return batch;
 }
 
@@ -263,7 +342,6 @@ void _anjay_batch_release(anjay_batch_t **batch) {
     assert((*batch)->ref_count);
 
     if (--((*batch)->ref_count) == 0) {
-        list_cleanup((*batch)->list);
         avs_free(*batch);
     }
     *batch = NULL;
@@ -283,9 +361,14 @@ bytes_append(anjay_ret_bytes_ctx_t *ctx, const void *data, size_t length) {
                   (unsigned) bytes->remaining_bytes, (unsigned) length);
         return -1;
     }
+    if (!length) {
+        return 0;
+    }
 
-    memcpy(bytes->data, data, length);
-    bytes->data = ((uint8_t *) bytes->data) + length;
+    // The blob might have been reallocated since bytes_begin(), so the
+    // position is tracked as an offset rather than a pointer
+    memcpy(&bytes->builder->blob[bytes->offset], data, length);
+    bytes->offset += length;
     bytes->remaining_bytes -= length;
     return 0;
 }
@@ -307,31 +390,16 @@ static int bytes_begin(anjay_output_ctx_t *ctx_,
         return -1;
     }
 
-    void *buf = NULL;
-    if (length) {
-        buf = avs_malloc(length);
-        if (!buf) {
-            return -1;
-        }
-    }
-
-    anjay_batch_data_t data = {
-        .type = ANJAY_BATCH_DATA_BYTES,
-        .value.bytes = {
-            .data = buf,
-            .length = length
-        }
-    };
-
-    if (batch_data_add(ctx->builder, &ctx->path, avs_time_real_now(), data)) {
-        avs_free(buf);
+    size_t offset;
+    if (batch_blob_data_add(ctx->builder, &ctx->path, avs_time_real_now(),
+                            ANJAY_BATCH_DATA_BYTES, length, &offset)) {
         return -1;
     }
 
     value_returned(ctx);
 
-    // Doesn't change owner of buf
-    ctx->bytes.data = buf;
+    ctx->bytes.builder = ctx->builder;
+    ctx->bytes.offset = offset;
     ctx->bytes.remaining_bytes = length;
     *out_bytes_ctx = (anjay_ret_bytes_ctx_t *) &ctx->bytes;
     return 0;
@@ -496,6 +564,108 @@ int _anjay_dm_read_into_batch(anjay_batch_builder_t *builder,
     return close_retval ? close_retval : retval;
 }
 
+typedef struct {
+    anjay_output_ctx_t base;
+    anjay_uri_path_t path;
+    bool value_returned;
+    anjay_batch_numeric_value_t *out_value;
+} numeric_out_ctx_t;
+
+static int numeric_set_path(anjay_output_ctx_t *ctx_,
+                            const anjay_uri_path_t *path) {
+    numeric_out_ctx_t *ctx = (numeric_out_ctx_t *) ctx_;
+    if (ctx->value_returned || _anjay_uri_path_length(&ctx->path) > 0) {
+        // more than one value - not a single numeric Resource
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+    ctx->path = *path;
+    return 0;
+}
+
+static int numeric_ret(numeric_out_ctx_t *ctx) {
+    if (ctx->value_returned || !_anjay_uri_path_has(&ctx->path, ANJAY_ID_RID)) {
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+    ctx->out_value->path = ctx->path;
+    ctx->out_value->timestamp = avs_time_real_now();
+    ctx->value_returned = true;
+    return 0;
+}
+
+static int numeric_ret_integer(anjay_output_ctx_t *ctx_, int64_t value) {
+    numeric_out_ctx_t *ctx = (numeric_out_ctx_t *) ctx_;
+    int result = numeric_ret(ctx);
+    if (!result) {
+        ctx->out_value->is_int = true;
+        ctx->out_value->value.int_value = value;
+    }
+    return result;
+}
+
+static int numeric_ret_double(anjay_output_ctx_t *ctx_, double value) {
+    numeric_out_ctx_t *ctx = (numeric_out_ctx_t *) ctx_;
+    int result = numeric_ret(ctx);
+    if (!result) {
+        ctx->out_value->is_int = false;
+        ctx->out_value->value.double_value = value;
+    }
+    return result;
+}
+
+static const anjay_output_ctx_vtable_t NUMERIC_OUT_VTABLE = {
+    .integer = numeric_ret_integer,
+    .floating = numeric_ret_double,
+    .set_path = numeric_set_path
+};
+
+int _anjay_dm_read_numeric(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj,
+                           const anjay_dm_path_info_t *path_info,
+                           anjay_ssid_t requesting_ssid,
+                           anjay_batch_numeric_value_t *out_value) {
+    assert(anjay);
+    assert(out_value);
+    if (!_anjay_uri_path_has(&path_info->uri, ANJAY_ID_RID)) {
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+    numeric_out_ctx_t ctx = {
+        .base = {
+            .vtable = &NUMERIC_OUT_VTABLE
+        },
+        .path = MAKE_ROOT_PATH(),
+        .out_value = out_value
+    };
+    int result = _anjay_dm_read(anjay, obj, path_info, requesting_ssid,
+                                (anjay_output_ctx_t *) &ctx);
+    // the handler might have ignored the error returned by anjay_ret_*()
+    if (ctx.base.error == ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED) {
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+    if (!result && !ctx.value_returned) {
+        return ANJAY_OUTCTXERR_ANJAY_RET_NOT_CALLED;
+    }
+    return result;
+}
+
+anjay_batch_t *
+_anjay_batch_from_numeric_value(const anjay_batch_numeric_value_t *value) {
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    if (!builder) {
+        return NULL;
+    }
+    anjay_batch_t *result = NULL;
+    if (!(value->is_int ? _anjay_batch_add_int(builder, &value->path,
+                                               value->timestamp,
+                                               value->value.int_value)
+                        : _anjay_batch_add_double(builder, &value->path,
+                                                  value->timestamp,
+                                                  value->value.double_value))) {
+        result = _anjay_batch_builder_compile(&builder);
+    }
+    _anjay_batch_builder_cleanup(&builder);
+    return result;
+}
+
 static bool is_timestamp_absolute(avs_time_real_t timestamp) {
     /**
      * timestamp.since_real_epoch contatins time measured since reboot if no
@@ -532,7 +702,8 @@ static double convert_to_senml_time(avs_time_real_t timestamp,
     }
 }
 
-static int serialize_batch_entry(const anjay_batch_entry_t *entry,
+static int serialize_batch_entry(const anjay_batch_t *batch,
+                                 const anjay_batch_entry_t *entry,
                                  avs_time_real_t serialization_time,
                                  anjay_output_ctx_t *output) {
     int result = _anjay_output_set_path(output, &entry->path);
@@ -549,10 +720,11 @@ static int serialize_batch_entry(const anjay_batch_entry_t *entry,
     switch (entry->data.type) {
     case ANJAY_BATCH_DATA_BYTES:
         return anjay_ret_bytes(output,
-                               entry->data.value.bytes.data,
-                               entry->data.value.bytes.length);
+                               &batch->blob[entry->data.value.blob.offset],
+                               entry->data.value.blob.length);
     case ANJAY_BATCH_DATA_STRING:
-        return anjay_ret_string(output, entry->data.value.string);
+        return anjay_ret_string(output,
+                                &batch->blob[entry->data.value.blob.offset]);
     case ANJAY_BATCH_DATA_INT:
         return anjay_ret_i64(output, entry->data.value.int_value);
     case ANJAY_BATCH_DATA_DOUBLE:
@@ -606,28 +778,36 @@ int _anjay_batch_data_output_entry(
         const anjay_batch_data_output_state_t **state,
         anjay_output_ctx_t *out_ctx) {
     assert(state);
-    const AVS_LIST(anjay_batch_entry_t) it;
+    const anjay_batch_entry_t *const end =
+            &batch->entries[batch->entry_count];
+    const anjay_batch_entry_t *it;
     if (!*state) {
-        it = batch->list;
+        it = batch->entries;
     } else {
         it = &(*state)->entry;
-        assert(AVS_LIST_FIND_PTR(&batch->list, it) != NULL);
+        assert(it >= batch->entries && it < end);
     }
-    while (it
+    while (it < end
            && !is_server_allowed_to_read(anjay, it->path.ids[ANJAY_ID_OID],
                                          it->path.ids[ANJAY_ID_IID],
                                          target_ssid)) {
-        AVS_LIST_ADVANCE(&it);
+        ++it;
     }
     int result = 0;
-    if (it) {
-        result = serialize_batch_entry(it, serialization_time, out_ctx);
-        AVS_LIST_ADVANCE(&it);
+    if (it < end) {
+        result = serialize_batch_entry(batch, it, serialization_time, out_ctx);
+        ++it;
     }
-    *state = AVS_CONTAINER_OF(it, anjay_batch_data_output_state_t, entry);
+    *state = it < end ? AVS_CONTAINER_OF(it, anjay_batch_data_output_state_t,
+                                         entry)
+                      : NULL;
     return result;
 }
 
+/**
+ * Compares entry data, assuming that the blobs of both batches are already
+ * known to be equal - so it is enough to compare the blob references.
+ */
 static bool batch_data_equal(const anjay_batch_data_t *a,
                              const anjay_batch_data_t *b) {
     if (a->type != b->type) {
@@ -635,12 +815,9 @@ static bool batch_data_equal(const anjay_batch_data_t *a,
     }
     switch (a->type) {
     case ANJAY_BATCH_DATA_BYTES:
-        return a->value.bytes.length == b->value.bytes.length
-               && !memcmp(a->value.bytes.data,
-                          b->value.bytes.data,
-                          a->value.bytes.length);
     case ANJAY_BATCH_DATA_STRING:
-        return !strcmp(a->value.string, b->value.string);
+        return a->value.blob.offset == b->value.blob.offset
+               && a->value.blob.length == b->value.blob.length;
     case ANJAY_BATCH_DATA_INT:
         return a->value.int_value == b->value.int_value;
     case ANJAY_BATCH_DATA_DOUBLE:
@@ -659,26 +836,32 @@ bool _anjay_batch_values_equal(const anjay_batch_t *a, const anjay_batch_t *b) {
     if (!a || !b) {
         return !a && !b;
     }
-    AVS_LIST(anjay_batch_entry_t) ait = a->list;
-    AVS_LIST(anjay_batch_entry_t) bit = b->list;
-    while (ait && bit) {
-        if (!_anjay_uri_path_equal(&ait->path, &bit->path)
-                || !batch_data_equal(&ait->data, &bit->data)) {
+    if (a == b) {
+        return true;
+    }
+    // Blobs are filled in entry order, so batches with equal entries always
+    // have byte-for-byte equal blobs, and equal offsets within them.
+    if (a->entry_count != b->entry_count || a->blob_size != b->blob_size
+            || (a->blob_size && memcmp(a->blob, b->blob, a->blob_size))) {
+        return false;
+    }
+    for (size_t i = 0; i < a->entry_count; ++i) {
+        if (!_anjay_uri_path_equal(&a->entries[i].path, &b->entries[i].path)
+                || !batch_data_equal(&a->entries[i].data,
+                                     &b->entries[i].data)) {
             return false;
         }
-        AVS_LIST_ADVANCE(&ait);
-        AVS_LIST_ADVANCE(&bit);
     }
-    return !ait && !bit;
+    return true;
 }
 
 bool _anjay_batch_data_requires_hierarchical_format(
         const anjay_batch_t *batch) {
-    if (!batch || !batch->list || AVS_LIST_NEXT(batch->list)) {
-        // entry list is not exactly 1 element long
+    if (!batch || batch->entry_count != 1) {
+        // batch is not exactly 1 entry long
         return true;
     }
-    const anjay_batch_entry_t *const entry = batch->list;
+    const anjay_batch_entry_t *const entry = &batch->entries[0];
     if (entry->data.type == ANJAY_BATCH_DATA_START_AGGREGATE) {
         // batch consists of an empty aggregate, so isn't a single simple value
         return true;
@@ -692,7 +875,7 @@ double _anjay_batch_data_numeric_value(const anjay_batch_t *batch) {
         // not a simple value
         return NAN;
     }
-    const anjay_batch_entry_t *const entry = batch->list;
+    const anjay_batch_entry_t *const entry = &batch->entries[0];
     switch (entry->data.type) {
     case ANJAY_BATCH_DATA_INT:
         return (double) entry->data.value.int_value;
@@ -707,6 +890,154 @@ avs_time_real_t _anjay_batch_get_compilation_time(const anjay_batch_t *batch) {
     return batch->compilation_time;
 }
 
+#ifdef WITH_AVS_PERSISTENCE
+avs_error_t _anjay_persistence_uri_path(avs_persistence_context_t *ctx,
+                                        anjay_uri_path_t *path) {
+    avs_error_t err = AVS_OK;
+    for (size_t i = 0; avs_is_ok(err) && i < AVS_ARRAY_SIZE(path->ids); ++i) {
+        err = avs_persistence_u16(ctx, &path->ids[i]);
+    }
+    return err;
+}
+
+static avs_error_t persistence_entry(avs_persistence_context_t *ctx,
+                                     anjay_batch_entry_t *entry) {
+    uint8_t type = (uint8_t) entry->data.type;
+    avs_error_t err;
+    if (avs_is_err((err = _anjay_persistence_uri_path(ctx, &entry->path)))
+            || avs_is_err((err = _anjay_persistence_time_real(
+                                   ctx, &entry->timestamp)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &type)))) {
+        return err;
+    }
+    entry->data.type = (anjay_batch_data_type_t) type;
+    switch (entry->data.type) {
+    case ANJAY_BATCH_DATA_BYTES:
+    case ANJAY_BATCH_DATA_STRING: {
+        uint32_t offset = (uint32_t) entry->data.value.blob.offset;
+        uint32_t length = (uint32_t) entry->data.value.blob.length;
+        if (offset != entry->data.value.blob.offset
+                || length != entry->data.value.blob.length) {
+            return avs_errno(AVS_E2BIG);
+        }
+        (void) (avs_is_err((err = avs_persistence_u32(ctx, &offset)))
+                || avs_is_err((err = avs_persistence_u32(ctx, &length))));
+        entry->data.value.blob.offset = offset;
+        entry->data.value.blob.length = length;
+        return err;
+    }
+    case ANJAY_BATCH_DATA_INT:
+        return avs_persistence_i64(ctx, &entry->data.value.int_value);
+    case ANJAY_BATCH_DATA_DOUBLE:
+        return avs_persistence_double(ctx, &entry->data.value.double_value);
+    case ANJAY_BATCH_DATA_BOOL:
+        return avs_persistence_bool(ctx, &entry->data.value.bool_value);
+    case ANJAY_BATCH_DATA_OBJLNK:
+        (void) (avs_is_err((err = avs_persistence_u16(
+                                    ctx, &entry->data.value.objlnk.oid)))
+                || avs_is_err((err = avs_persistence_u16(
+                                       ctx, &entry->data.value.objlnk.iid))));
+        return err;
+    case ANJAY_BATCH_DATA_START_AGGREGATE:
+        return AVS_OK;
+    }
+    return avs_errno(AVS_EBADMSG);
+}
+
+static bool is_entry_valid(const anjay_batch_t *batch,
+                           const anjay_batch_entry_t *entry) {
+    switch (entry->data.type) {
+    case ANJAY_BATCH_DATA_BYTES:
+    case ANJAY_BATCH_DATA_STRING:
+        if (entry->data.value.blob.offset > batch->blob_size
+                || entry->data.value.blob.length
+                               > batch->blob_size
+                                         - entry->data.value.blob.offset) {
+            return false;
+        }
+        return entry->data.type != ANJAY_BATCH_DATA_STRING
+               || (entry->data.value.blob.length > 0
+                   && batch->blob[entry->data.value.blob.offset
+                                  + entry->data.value.blob.length - 1]
+                              == '\0');
+    case ANJAY_BATCH_DATA_START_AGGREGATE:
+        return true;
+    default:
+        return _anjay_uri_path_has(&entry->path, ANJAY_ID_RID);
+    }
+}
+
+avs_error_t _anjay_batch_persist(avs_persistence_context_t *ctx,
+                                 const anjay_batch_t *batch) {
+    uint32_t entry_count = (uint32_t) batch->entry_count;
+    uint32_t blob_size = (uint32_t) batch->blob_size;
+    if (entry_count != batch->entry_count || blob_size != batch->blob_size) {
+        return avs_errno(AVS_E2BIG);
+    }
+    avs_time_real_t compilation_time = batch->compilation_time;
+    avs_error_t err;
+    if (avs_is_err((err = avs_persistence_u32(ctx, &entry_count)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &blob_size)))
+            || avs_is_err((err = _anjay_persistence_time_real(
+                                   ctx, &compilation_time)))
+            || avs_is_err((err = avs_persistence_bytes(
+                                   ctx, (void *) (intptr_t) batch->blob,
+                                   blob_size)))) {
+        return err;
+    }
+    for (size_t i = 0; avs_is_ok(err) && i < batch->entry_count; ++i) {
+        anjay_batch_entry_t entry = batch->entries[i];
+        err = persistence_entry(ctx, &entry);
+    }
+    return err;
+}
+
+avs_error_t _anjay_batch_restore(avs_persistence_context_t *ctx,
+                                 anjay_batch_t **out_batch) {
+    assert(out_batch && !*out_batch);
+    uint32_t entry_count;
+    uint32_t blob_size;
+    avs_error_t err;
+    if (avs_is_err((err = avs_persistence_u32(ctx, &entry_count)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &blob_size)))) {
+        return err;
+    }
+    if (entry_count > (SIZE_MAX - sizeof(anjay_batch_t) - blob_size)
+                              / sizeof(anjay_batch_entry_t)) {
+        return avs_errno(AVS_EBADMSG);
+    }
+    anjay_batch_t *batch = (anjay_batch_t *) avs_malloc(
+            sizeof(anjay_batch_t) + entry_count * sizeof(anjay_batch_entry_t)
+            + blob_size);
+    if (!batch) {
+        batch_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    batch->ref_count = 1;
+    batch->entry_count = entry_count;
+    batch->blob_size = blob_size;
+    char *blob = (char *) &batch->entries[entry_count];
+    batch->blob = blob;
+    if (avs_is_ok((err = _anjay_persistence_time_real(
+                           ctx, &batch->compilation_time)))) {
+        err = avs_persistence_bytes(ctx, blob, blob_size);
+    }
+    for (size_t i = 0; avs_is_ok(err) && i < entry_count; ++i) {
+        memset(&batch->entries[i], 0, sizeof(batch->entries[i]));
+        if (avs_is_ok((err = persistence_entry(ctx, &batch->entries[i])))
+                && !is_entry_valid(batch, &batch->entries[i])) {
+            err = avs_errno(AVS_EBADMSG);
+        }
+    }
+    if (avs_is_err(err)) {
+        avs_free(batch);
+        return err;
+    }
+    *out_batch = batch;
+    return AVS_OK;
+}
+#endif // WITH_AVS_PERSISTENCE
+
 #ifdef ANJAY_TEST
 #    include "test/batch_builder.c"
 #endif
@@ -19,6 +19,10 @@
 
 #include <anjay/anjay.h>
 
+#ifdef WITH_AVS_PERSISTENCE
+#    include <avsystem/commons/persistence.h>
+#endif // WITH_AVS_PERSISTENCE
+
 #include "../dm_core.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -123,6 +127,50 @@ int _anjay_dm_read_into_batch(anjay_batch_builder_t *builder,
                               const anjay_dm_path_info_t *path_info,
                               anjay_ssid_t requesting_ssid);
 
+/**
+ * Single numeric value read from the data model, see
+ * @ref _anjay_dm_read_numeric .
+ */
+typedef struct {
+    bool is_int;
+    union {
+        int64_t int_value;
+        double double_value;
+    } value;
+    anjay_uri_path_t path;
+    avs_time_real_t timestamp;
+} anjay_batch_numeric_value_t;
+
+/**
+ * Reads a single Resource or Resource Instance, that is expected to hold a
+ * numeric value, without building a batch.
+ *
+ * @returns 0 for success, @ref ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED if the
+ *          path does not refer to a single numeric value (the caller may then
+ *          fall back to @ref _anjay_dm_read_into_batch ), or another negative
+ *          value in case of error.
+ */
+int _anjay_dm_read_numeric(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj,
+                           const anjay_dm_path_info_t *path_info,
+                           anjay_ssid_t requesting_ssid,
+                           anjay_batch_numeric_value_t *out_value);
+
+static inline double
+_anjay_batch_numeric_value_as_double(const anjay_batch_numeric_value_t *value) {
+    return value->is_int ? (double) value->value.int_value
+                         : value->value.double_value;
+}
+
+/**
+ * Creates a single-entry batch holding @p value . The result is the same as if
+ * the value was read using @ref _anjay_dm_read_into_batch .
+ *
+ * @returns Compiled batch with refcount of 1, or NULL if out of memory.
+ */
+anjay_batch_t *
+_anjay_batch_from_numeric_value(const anjay_batch_numeric_value_t *value);
+
 /**
  * Filters content of the batch for server with specified @p target_ssid
  * according to Access Control permissions of this server. Then outputs the data
@@ -240,6 +288,29 @@ double _anjay_batch_data_numeric_value(const anjay_batch_t *batch);
  */
 avs_time_real_t _anjay_batch_get_compilation_time(const anjay_batch_t *batch);
 
+#ifdef WITH_AVS_PERSISTENCE
+/**
+ * Stores or restores (depending on the direction of @p ctx) a data model path.
+ */
+avs_error_t _anjay_persistence_uri_path(avs_persistence_context_t *ctx,
+                                        anjay_uri_path_t *path);
+
+/**
+ * Stores the contents of a compiled batch, including its compilation time and
+ * entry timestamps, using a persistence context in the STORE direction.
+ */
+avs_error_t _anjay_batch_persist(avs_persistence_context_t *ctx,
+                                 const anjay_batch_t *batch);
+
+/**
+ * Restores a batch stored with @ref _anjay_batch_persist using a persistence
+ * context in the RESTORE direction. On success, <c>*out_batch</c> is set to a
+ * new batch with refcount of 1.
+ */
+avs_error_t _anjay_batch_restore(avs_persistence_context_t *ctx,
+                                 anjay_batch_t **out_batch);
+#endif // WITH_AVS_PERSISTENCE
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_BATCH_BUILDER_H
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../io_core.h"
+#include "senml_like_encoder_vtable.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define cbor_log(level, ...) _anjay_log(cbor, level, __VA_ARGS__)
+
+/* CBOR major types, see RFC 7049 section 2.1 */
+#define CBOR_MAJOR_TYPE_UINT 0
+#define CBOR_MAJOR_TYPE_NEGATIVE_INT 1
+#define CBOR_MAJOR_TYPE_BYTE_STRING 2
+#define CBOR_MAJOR_TYPE_TEXT_STRING 3
+#define CBOR_MAJOR_TYPE_ARRAY 4
+#define CBOR_MAJOR_TYPE_MAP 5
+#define CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE 7
+
+#define CBOR_EXT_LENGTH_1BYTE 24
+#define CBOR_EXT_LENGTH_2BYTE 25
+#define CBOR_EXT_LENGTH_4BYTE 26
+#define CBOR_EXT_LENGTH_8BYTE 27
+#define CBOR_EXT_LENGTH_INDEFINITE 31
+
+#define CBOR_VALUE_FALSE 0xF4
+#define CBOR_VALUE_TRUE 0xF5
+#define CBOR_VALUE_FLOAT_32 0xFA
+#define CBOR_VALUE_FLOAT_64 0xFB
+#define CBOR_BREAK 0xFF
+
+/* SenML labels, see RFC 8428 section 6 */
+#define SENML_LABEL_BASE_NAME (-2)
+#define SENML_LABEL_NAME 0
+#define SENML_LABEL_VALUE 2
+#define SENML_LABEL_STRING_VALUE 3
+#define SENML_LABEL_BOOL_VALUE 4
+#define SENML_LABEL_TIME 6
+#define SENML_LABEL_DATA_VALUE 8
+/* Object Link value, see LwM2M TS 1.1 Core, section 7.4.5 */
+#define SENML_EXT_OBJLNK_VALUE_LABEL "vlo"
+
+typedef struct {
+    const anjay_senml_like_encoder_vtable_t *vtable;
+    avs_stream_t *stream;
+    bool element_started;
+    bool bytes_started;
+    size_t bytes_remaining;
+} senml_cbor_encoder_t;
+
+static int
+write_header(avs_stream_t *stream, uint8_t major_type, uint64_t value) {
+    uint8_t buf[9];
+    size_t size;
+    if (value < CBOR_EXT_LENGTH_1BYTE) {
+        buf[0] = (uint8_t) value;
+        size = 1;
+    } else if (value <= UINT8_MAX) {
+        buf[0] = CBOR_EXT_LENGTH_1BYTE;
+        buf[1] = (uint8_t) value;
+        size = 2;
+    } else if (value <= UINT16_MAX) {
+        const uint16_t portable = avs_convert_be16((uint16_t) value);
+        buf[0] = CBOR_EXT_LENGTH_2BYTE;
+        memcpy(&buf[1], &portable, sizeof(portable));
+        size = 1 + sizeof(portable);
+    } else if (value <= UINT32_MAX) {
+        const uint32_t portable = avs_convert_be32((uint32_t) value);
+        buf[0] = CBOR_EXT_LENGTH_4BYTE;
+        memcpy(&buf[1], &portable, sizeof(portable));
+        size = 1 + sizeof(portable);
+    } else {
+        const uint64_t portable = avs_convert_be64(value);
+        buf[0] = CBOR_EXT_LENGTH_8BYTE;
+        memcpy(&buf[1], &portable, sizeof(portable));
+        size = 1 + sizeof(portable);
+    }
+    buf[0] |= (uint8_t) (major_type << 5);
+    return avs_is_ok(avs_stream_write(stream, buf, size)) ? 0 : -1;
+}
+
+static int write_byte(avs_stream_t *stream, uint8_t value) {
+    return avs_is_ok(avs_stream_write(stream, &value, 1)) ? 0 : -1;
+}
+
+static int write_int(avs_stream_t *stream, int64_t value) {
+    if (value >= 0) {
+        return write_header(stream, CBOR_MAJOR_TYPE_UINT, (uint64_t) value);
+    }
+    // -1 - value, computed in a way that does not overflow for INT64_MIN
+    return write_header(stream, CBOR_MAJOR_TYPE_NEGATIVE_INT,
+                        (uint64_t) (-(value + 1)));
+}
+
+static int write_text(avs_stream_t *stream, const char *value) {
+    const size_t length = strlen(value);
+    if (write_header(stream, CBOR_MAJOR_TYPE_TEXT_STRING, length)
+            || avs_is_err(avs_stream_write(stream, value, length))) {
+        return -1;
+    }
+    return 0;
+}
+
+static bool double_fits_in_float(double value) {
+    // converting out-of-range values to float is undefined behavior
+    return isfinite(value) && fabs(value) <= FLT_MAX
+           && (double) (float) value == value;
+}
+
+static int write_double(avs_stream_t *stream, double value) {
+    if (double_fits_in_float(value)) {
+        const uint32_t portable = avs_htonf((float) value);
+        if (write_byte(stream, CBOR_VALUE_FLOAT_32)
+                || avs_is_err(avs_stream_write(stream, &portable,
+                                               sizeof(portable)))) {
+            return -1;
+        }
+    } else {
+        const uint64_t portable = avs_htond(value);
+        if (write_byte(stream, CBOR_VALUE_FLOAT_64)
+                || avs_is_err(avs_stream_write(stream, &portable,
+                                               sizeof(portable)))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int begin_value(senml_cbor_encoder_t *ctx, int label) {
+    if (!ctx->element_started || ctx->bytes_started) {
+        cbor_log(DEBUG, _("value encoded outside of an element"));
+        return -1;
+    }
+    return write_int(ctx->stream, label);
+}
+
+static int encode_uint(anjay_senml_like_encoder_t *ctx_, uint64_t value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE)
+            || write_header(ctx->stream, CBOR_MAJOR_TYPE_UINT, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_int(anjay_senml_like_encoder_t *ctx_, int64_t value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE) || write_int(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_double(anjay_senml_like_encoder_t *ctx_, double value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_VALUE)
+            || write_double(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_bool(anjay_senml_like_encoder_t *ctx_, bool value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_BOOL_VALUE)
+            || write_byte(ctx->stream,
+                          value ? CBOR_VALUE_TRUE : CBOR_VALUE_FALSE)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_string(anjay_senml_like_encoder_t *ctx_, const char *value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_STRING_VALUE)
+            || write_text(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int encode_objlnk(anjay_senml_like_encoder_t *ctx_, const char *value) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (!ctx->element_started || ctx->bytes_started
+            || write_text(ctx->stream, SENML_EXT_OBJLNK_VALUE_LABEL)
+            || write_text(ctx->stream, value)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int element_begin(anjay_senml_like_encoder_t *ctx_,
+                         const char *basename,
+                         const char *name,
+                         double time_s) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (ctx->element_started) {
+        cbor_log(DEBUG, _("previous element not finished"));
+        return -1;
+    }
+    // Each element contains exactly one value, so its size is known upfront
+    const uint64_t map_size =
+            1 + !!basename + !!name + (isnan(time_s) ? 0 : 1);
+    if (write_header(ctx->stream, CBOR_MAJOR_TYPE_MAP, map_size)
+            || (basename
+                && (write_int(ctx->stream, SENML_LABEL_BASE_NAME)
+                    || write_text(ctx->stream, basename)))
+            || (name
+                && (write_int(ctx->stream, SENML_LABEL_NAME)
+                    || write_text(ctx->stream, name)))
+            || (!isnan(time_s)
+                && (write_int(ctx->stream, SENML_LABEL_TIME)
+                    || write_double(ctx->stream, time_s)))) {
+        return -1;
+    }
+    ctx->element_started = true;
+    return 0;
+}
+
+static int element_end(anjay_senml_like_encoder_t *ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (!ctx->element_started || ctx->bytes_started) {
+        return -1;
+    }
+    ctx->element_started = false;
+    return 0;
+}
+
+static int bytes_begin(anjay_senml_like_encoder_t *ctx_, size_t size) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (begin_value(ctx, SENML_LABEL_DATA_VALUE)
+            || write_header(ctx->stream, CBOR_MAJOR_TYPE_BYTE_STRING, size)) {
+        return -1;
+    }
+    ctx->bytes_started = true;
+    ctx->bytes_remaining = size;
+    return 0;
+}
+
+static int bytes_append(anjay_senml_like_encoder_t *ctx_,
+                        const void *data,
+                        size_t size) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (!ctx->bytes_started) {
+        return -1;
+    }
+    if (size > ctx->bytes_remaining) {
+        cbor_log(DEBUG, _("tried to write too many bytes, expected ") "%lu" _(
+                                 ", got ") "%lu",
+                 (unsigned long) ctx->bytes_remaining, (unsigned long) size);
+        return -1;
+    }
+    if (avs_is_err(avs_stream_write(ctx->stream, data, size))) {
+        return -1;
+    }
+    ctx->bytes_remaining -= size;
+    return 0;
+}
+
+static int bytes_end(anjay_senml_like_encoder_t *ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) ctx_;
+    if (!ctx->bytes_started) {
+        return -1;
+    }
+    ctx->bytes_started = false;
+    if (ctx->bytes_remaining) {
+        cbor_log(DEBUG, _("not all declared bytes were written, ") "%lu" _(
+                                 " remaining"),
+                 (unsigned long) ctx->bytes_remaining);
+        return -1;
+    }
+    return 0;
+}
+
+static int encoder_cleanup(anjay_senml_like_encoder_t **ctx_) {
+    senml_cbor_encoder_t *ctx = (senml_cbor_encoder_t *) *ctx_;
+    int retval = -1;
+
+    if (!ctx->element_started && !write_byte(ctx->stream, CBOR_BREAK)) {
+        retval = 0;
+    }
+
+    avs_free(*ctx_);
+    *ctx_ = NULL;
+    return retval;
+}
+
+static const anjay_senml_like_encoder_vtable_t SENML_CBOR_ENCODER_VTABLE = {
+    .senml_like_encode_uint = encode_uint,
+    .senml_like_encode_int = encode_int,
+    .senml_like_encode_double = encode_double,
+    .senml_like_encode_bool = encode_bool,
+    .senml_like_encode_string = encode_string,
+    .senml_like_encode_objlnk = encode_objlnk,
+    .senml_like_element_begin = element_begin,
+    .senml_like_element_end = element_end,
+    .senml_like_bytes_begin = bytes_begin,
+    .senml_like_bytes_append = bytes_append,
+    .senml_like_bytes_end = bytes_end,
+    .senml_like_encoder_cleanup = encoder_cleanup
+};
+
+anjay_senml_like_encoder_t *
+_anjay_senml_cbor_encoder_new(avs_stream_t *stream) {
+    if (!stream) {
+        cbor_log(DEBUG, _("no stream provided"));
+        return NULL;
+    }
+
+    senml_cbor_encoder_t *ctx =
+            (senml_cbor_encoder_t *) avs_calloc(1,
+                                                sizeof(senml_cbor_encoder_t));
+    if (!ctx) {
+        cbor_log(DEBUG, _("failed to allocate encoder context"));
+        return NULL;
+    }
+    ctx->vtable = &SENML_CBOR_ENCODER_VTABLE;
+    ctx->stream = stream;
+
+    // The number of records is not known in advance, so an indefinite-length
+    // array is used; it is terminated in encoder_cleanup()
+    if (write_byte(ctx->stream, (uint8_t) ((CBOR_MAJOR_TYPE_ARRAY << 5)
+                                           | CBOR_EXT_LENGTH_INDEFINITE))) {
+        avs_free(ctx);
+        return NULL;
+    }
+    return (anjay_senml_like_encoder_t *) ctx;
+}
+
+#ifdef ANJAY_TEST
+#    include "test/cbor_encoder.c"
+#endif
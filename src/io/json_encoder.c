@@ -63,50 +63,79 @@ struct json_encoder_struct {
 
 static int begin_pair(json_encoder_t *ctx, senml_like_data_type_t type);
 
+/**
+ * RFC 4627 section 2.5 Strings:
+ *
+ * "(...)
+ *  All Unicode characters may be placed within the
+ *  quotation marks except for the characters that must be escaped:
+ *  quotation mark, reverse solidus, and the control characters (U+0000
+ *  through U+001F).
+ * "
+ *
+ * For each ASCII character, this table contains 0 if it may be written as-is,
+ * 'u' if it shall be escaped as "\u00XX", or the character to put after the
+ * backslash otherwise. Bytes outside the ASCII range are always escaped as
+ * "\u00XX".
+ */
+static const char JSON_ESCAPE_TABLE[0x80] = {
+    // clang-format off
+    ['\0'] = 'u', [0x01] = 'u', [0x02] = 'u', [0x03] = 'u',
+    [0x04] = 'u', [0x05] = 'u', [0x06] = 'u', [0x07] = 'u',
+    ['\b'] = 'b', ['\t'] = 't', ['\n'] = 'n', [0x0B] = 'u',
+    ['\f'] = 'f', ['\r'] = 'r', [0x0E] = 'u', [0x0F] = 'u',
+    [0x10] = 'u', [0x11] = 'u', [0x12] = 'u', [0x13] = 'u',
+    [0x14] = 'u', [0x15] = 'u', [0x16] = 'u', [0x17] = 'u',
+    [0x18] = 'u', [0x19] = 'u', [0x1A] = 'u', [0x1B] = 'u',
+    [0x1C] = 'u', [0x1D] = 'u', [0x1E] = 'u', [0x1F] = 'u',
+    ['"'] = '"', ['\\'] = '\\', [0x7F] = 'u'
+    // clang-format on
+};
+
+static inline char json_escape_char(uint8_t value) {
+    return value < sizeof(JSON_ESCAPE_TABLE) ? JSON_ESCAPE_TABLE[value] : 'u';
+}
+
+static avs_error_t write_escaped_char(avs_stream_t *stream, uint8_t value) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    const char escape = json_escape_char(value);
+    assert(escape);
+    if (escape == 'u') {
+        const char buf[] = { '\\', 'u', '0', '0', HEX_DIGITS[value >> 4],
+                             HEX_DIGITS[value & 0xF] };
+        return avs_stream_write(stream, buf, sizeof(buf));
+    } else {
+        const char buf[] = { '\\', escape };
+        return avs_stream_write(stream, buf, sizeof(buf));
+    }
+}
+
 static int write_quoted_string(avs_stream_t *stream, const char *value) {
     if (avs_is_err(avs_stream_write(stream, "\"", 1))) {
         return -1;
     }
-    for (size_t i = 0; i < strlen(value); ++i) {
-        /**
-         * RFC 4627 section 2.5 Strings:
-         *
-         * "(...)
-         *  All Unicode characters may be placed within the
-         *  quotation marks except for the characters that must be escaped:
-         *  quotation mark, reverse solidus, and the control characters (U+0000
-         *  through U+001F).
-         * "
-         */
-        if ((value[i] == '\\' || value[i] == '"')
-                && avs_is_err(avs_stream_write(stream, "\\", 1))) {
-            return -1;
+    const char *run_start = value;
+    const char *ptr = value;
+    while (*ptr) {
+        if (!json_escape_char((uint8_t) *ptr)) {
+            ++ptr;
+            continue;
         }
-
-        avs_error_t err;
-        if ((uint8_t) value[i] >= 0x20 && (uint8_t) value[i] < 127) {
-            err = avs_stream_write(stream, &value[i], 1);
-        } else if (value[i] == '\b') {
-            err = avs_stream_write(stream, "\\b", 2);
-        } else if (value[i] == '\f') {
-            err = avs_stream_write(stream, "\\f", 2);
-        } else if (value[i] == '\n') {
-            err = avs_stream_write(stream, "\\n", 2);
-        } else if (value[i] == '\r') {
-            err = avs_stream_write(stream, "\\r", 2);
-        } else if (value[i] == '\t') {
-            err = avs_stream_write(stream, "\\t", 2);
-        } else {
-            const int nibble0 = ((uint8_t) value[i] >> 4) & 0xF;
-            const int nibble1 = ((uint8_t) value[i]) & 0xF;
-            err = avs_stream_write_f(stream, "\\u00%x%x", nibble0, nibble1);
-        }
-
-        if (avs_is_err(err)) {
+        if ((ptr > run_start
+             && avs_is_err(avs_stream_write(stream, run_start,
+                                            (size_t) (ptr - run_start))))
+                || avs_is_err(write_escaped_char(stream, (uint8_t) *ptr))) {
             return -1;
         }
+        run_start = ++ptr;
     }
-    return avs_is_ok(avs_stream_write(stream, "\"", 1)) ? 0 : -1;
+    if ((ptr > run_start
+         && avs_is_err(avs_stream_write(stream, run_start,
+                                        (size_t) (ptr - run_start))))
+            || avs_is_err(avs_stream_write(stream, "\"", 1))) {
+        return -1;
+    }
+    return 0;
 }
 
 static inline void nested_context_push(json_encoder_t *ctx, uint8_t level) {
@@ -401,3 +430,7 @@ _anjay_lwm2m_json_encoder_new(avs_stream_t *stream, const char *basename) {
     return (anjay_senml_like_encoder_t *) ctx;
 }
 #endif // WITH_LWM2M_JSON
+
+#ifdef ANJAY_TEST
+#    include "test/json_encoder.c"
+#endif
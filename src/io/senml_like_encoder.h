@@ -114,6 +114,18 @@ int _anjay_senml_like_encoder_cleanup(anjay_senml_like_encoder_t **ctx);
 anjay_senml_like_encoder_t *_anjay_lwm2m_json_encoder_new(avs_stream_t *stream,
                                                           const char *basename);
 
+/**
+ * Creates SenML CBOR encoder (content format 112). Writes the beginning of an
+ * indefinite-length array to stream; basename, if any, is encoded as part of
+ * the first element.
+ *
+ * @param stream Stream to encode data to. Encoder doesn't take ownership of
+ *               stream.
+ * @returns Pointer to encoder in case of success, NULL otherwise.
+ */
+anjay_senml_like_encoder_t *
+_anjay_senml_cbor_encoder_new(avs_stream_t *stream);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_IO_SENML_LIKE_ENCODER_H
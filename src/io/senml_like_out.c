@@ -299,6 +299,11 @@ anjay_output_ctx_t *_anjay_output_senml_like_create(avs_stream_t *stream,
         break;
     }
 #endif // WITH_LWM2M_JSON
+#ifdef WITH_CBOR
+    case AVS_COAP_FORMAT_SENML_CBOR:
+        ctx->encoder = _anjay_senml_cbor_encoder_new(stream);
+        break;
+#endif // WITH_CBOR
     default:
         senml_log(WARNING, _("unsupported content format"));
         goto error;
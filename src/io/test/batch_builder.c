@@ -59,7 +59,7 @@ AVS_UNIT_TEST(batch_builder, single_int_entry) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, 0));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 1);
 
     builder_teardown(builder);
 }
@@ -73,7 +73,7 @@ AVS_UNIT_TEST(batch_builder, two_entries) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, 0));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 2);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 2);
 
     builder_teardown(builder);
 }
@@ -90,13 +90,15 @@ AVS_UNIT_TEST(batch_builder, string_copy) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, str));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 1);
 
     // Passed string shouldn't be required anymore.
     avs_free(str);
 
-    AVS_LIST(anjay_batch_entry_t) entry = AVS_LIST_TAIL(builder->list);
-    AVS_UNIT_ASSERT_EQUAL_STRING(entry->data.value.string, test_string.data);
+    const anjay_batch_entry_t *entry =
+            &builder->entries[builder->entry_count - 1];
+    AVS_UNIT_ASSERT_EQUAL_STRING(&builder->blob[entry->data.value.blob.offset],
+                                 test_string.data);
 
     builder_teardown(builder);
 }
@@ -107,14 +109,197 @@ AVS_UNIT_TEST(batch_builder, compile) {
     AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
             builder, &MAKE_RESOURCE_INSTANCE_PATH(0, 0, 0, 0),
             AVS_TIME_REAL_INVALID, 0));
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(builder->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 1);
 
     anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
     AVS_UNIT_ASSERT_NULL(builder);
 
-    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(batch->list), 1);
+    AVS_UNIT_ASSERT_EQUAL(batch->entry_count, 1);
     AVS_UNIT_ASSERT_EQUAL(batch->ref_count, 1);
 
     _anjay_batch_release(&batch);
     AVS_UNIT_ASSERT_NULL(batch);
 }
+
+static anjay_batch_t *compile_strings(const char *first, const char *second) {
+    anjay_batch_builder_t *builder = builder_setup();
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 0),
+                                    AVS_TIME_REAL_INVALID, first));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 1),
+                                    AVS_TIME_REAL_INVALID, second));
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    return batch;
+}
+
+AVS_UNIT_TEST(batch_builder, values_equal_strings) {
+    anjay_batch_t *reference = compile_strings("raz", "dwa");
+    anjay_batch_t *same = compile_strings("raz", "dwa");
+    anjay_batch_t *same_length = compile_strings("raz", "dwo");
+    anjay_batch_t *moved_boundary = compile_strings("razd", "wa");
+
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(reference, same));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(reference, same_length));
+    AVS_UNIT_ASSERT_FALSE(
+            _anjay_batch_values_equal(reference, moved_boundary));
+
+    _anjay_batch_release(&reference);
+    _anjay_batch_release(&same);
+    _anjay_batch_release(&same_length);
+    _anjay_batch_release(&moved_boundary);
+}
+
+AVS_UNIT_TEST(batch_builder, values_equal_paths_and_counts) {
+    anjay_batch_t *reference = compile_strings("raz", "dwa");
+
+    // Same blob contents, but the second string is under a different Resource
+    anjay_batch_builder_t *builder = builder_setup();
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 0),
+                                    AVS_TIME_REAL_INVALID, "raz"));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 2),
+                                    AVS_TIME_REAL_INVALID, "dwa"));
+    anjay_batch_t *other_path = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(other_path);
+
+    // Same blob contents, plus an entry that does not use the blob
+    builder = builder_setup();
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 0),
+                                    AVS_TIME_REAL_INVALID, "raz"));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 1),
+                                    AVS_TIME_REAL_INVALID, "dwa"));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_int(builder, &MAKE_RESOURCE_PATH(0, 0, 2),
+                                 AVS_TIME_REAL_INVALID, 3));
+    anjay_batch_t *extra_entry = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(extra_entry);
+
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(reference, other_path));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(reference, extra_entry));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(extra_entry, reference));
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(reference, reference));
+    AVS_UNIT_ASSERT_FALSE(_anjay_batch_values_equal(reference, NULL));
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(NULL, NULL));
+
+    _anjay_batch_release(&reference);
+    _anjay_batch_release(&other_path);
+    _anjay_batch_release(&extra_entry);
+}
+
+#define GROWTH_STRINGS 40
+
+AVS_UNIT_TEST(batch_builder, strings_survive_blob_growth) {
+    anjay_batch_builder_t *builder = builder_setup();
+
+    // String i consists of i + 1 copies of a letter, so the blob is
+    // reallocated several times and earlier strings have to be moved with it
+    char values[GROWTH_STRINGS][GROWTH_STRINGS + 1];
+    for (size_t i = 0; i < GROWTH_STRINGS; ++i) {
+        memset(values[i], 'a' + (char) (i % 26), i + 1);
+        values[i][i + 1] = '\0';
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_string(
+                builder, &MAKE_RESOURCE_PATH(0, 0, (anjay_rid_t) i),
+                AVS_TIME_REAL_INVALID, values[i]));
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
+                builder, &MAKE_RESOURCE_PATH(1, 0, (anjay_rid_t) i),
+                AVS_TIME_REAL_INVALID, (int64_t) i));
+    }
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 2 * GROWTH_STRINGS);
+
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NULL(builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+
+    // Strings are laid out back to back in the order they were added
+    size_t expected_offset = 0;
+    for (size_t i = 0; i < GROWTH_STRINGS; ++i) {
+        const anjay_batch_entry_t *str_entry = &batch->entries[2 * i];
+        const anjay_batch_entry_t *int_entry = &batch->entries[2 * i + 1];
+        AVS_UNIT_ASSERT_EQUAL(str_entry->data.type, ANJAY_BATCH_DATA_STRING);
+        AVS_UNIT_ASSERT_EQUAL(str_entry->data.value.blob.offset,
+                              expected_offset);
+        AVS_UNIT_ASSERT_EQUAL(str_entry->data.value.blob.length, i + 2);
+        AVS_UNIT_ASSERT_EQUAL_STRING(
+                &batch->blob[str_entry->data.value.blob.offset], values[i]);
+        AVS_UNIT_ASSERT_EQUAL(int_entry->data.type, ANJAY_BATCH_DATA_INT);
+        AVS_UNIT_ASSERT_EQUAL(int_entry->data.value.int_value, (int64_t) i);
+        expected_offset += i + 2;
+    }
+    AVS_UNIT_ASSERT_EQUAL(batch->blob_size, expected_offset);
+
+    _anjay_batch_release(&batch);
+}
+
+AVS_UNIT_TEST(batch_builder, failed_string_does_not_use_blob) {
+    anjay_batch_builder_t *builder = builder_setup();
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 0),
+                                    AVS_TIME_REAL_INVALID, "raz"));
+    // Values may only be stored under Resource or Resource Instance paths
+    AVS_UNIT_ASSERT_FAILED(
+            _anjay_batch_add_string(builder, &MAKE_INSTANCE_PATH(0, 0),
+                                    AVS_TIME_REAL_INVALID, "dwa"));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(0, 0, 1),
+                                    AVS_TIME_REAL_INVALID, "trzy"));
+
+    AVS_UNIT_ASSERT_EQUAL(builder->entry_count, 2);
+    AVS_UNIT_ASSERT_EQUAL(builder->blob_size, sizeof("raz") + sizeof("trzy"));
+    AVS_UNIT_ASSERT_EQUAL(builder->entries[1].data.value.blob.offset,
+                          sizeof("raz"));
+    AVS_UNIT_ASSERT_EQUAL_STRING(
+            &builder->blob[builder->entries[1].data.value.blob.offset],
+            "trzy");
+
+    builder_teardown(builder);
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+#    include <avsystem/commons/stream/stream_membuf.h>
+
+AVS_UNIT_TEST(batch_builder, persistence_roundtrip) {
+    anjay_batch_builder_t *builder = builder_setup();
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_string(builder, &MAKE_RESOURCE_PATH(1, 2, 3),
+                                    AVS_TIME_REAL_INVALID, "raz dwa trzy"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
+            builder, &MAKE_RESOURCE_INSTANCE_PATH(1, 2, 4, 5),
+            avs_time_real_from_scalar(1234, AVS_TIME_S), -42));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_batch_add_double(builder, &MAKE_RESOURCE_PATH(1, 2, 6),
+                                    AVS_TIME_REAL_INVALID, 3.5));
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+
+    avs_stream_t *membuf = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(membuf);
+    avs_persistence_context_t store_ctx =
+            avs_persistence_store_context_create(membuf);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_persist(&store_ctx, batch));
+
+    anjay_batch_t *restored = NULL;
+    avs_persistence_context_t restore_ctx =
+            avs_persistence_restore_context_create(membuf);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_restore(&restore_ctx, &restored));
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+    AVS_UNIT_ASSERT_EQUAL(restored->ref_count, 1);
+    AVS_UNIT_ASSERT_EQUAL(restored->entry_count, batch->entry_count);
+    AVS_UNIT_ASSERT_TRUE(_anjay_batch_values_equal(batch, restored));
+    AVS_UNIT_ASSERT_TRUE(avs_time_real_equal(
+            _anjay_batch_get_compilation_time(batch),
+            _anjay_batch_get_compilation_time(restored)));
+    AVS_UNIT_ASSERT_TRUE(
+            avs_time_real_equal(restored->entries[1].timestamp,
+                                avs_time_real_from_scalar(1234, AVS_TIME_S)));
+
+    _anjay_batch_release(&restored);
+    _anjay_batch_release(&batch);
+    avs_stream_cleanup(&membuf);
+}
+#endif // WITH_AVS_PERSISTENCE
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/stream/stream_outbuf.h>
+
+#define AVS_UNIT_ENABLE_SHORT_ASSERTS
+#include <avsystem/commons/unit/test.h>
+
+#include <avsystem/coap/option.h>
+
+#define TEST_ENV(Size, Uri)                                                   \
+    char buf[Size];                                                           \
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;        \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf));                  \
+    anjay_output_ctx_t *out = NULL;                                           \
+    ASSERT_OK(_anjay_output_dynamic_construct(&out, (avs_stream_t *) &outbuf, \
+                                              (Uri),                          \
+                                              AVS_COAP_FORMAT_SENML_CBOR,     \
+                                              ANJAY_ACTION_READ))
+
+#define VERIFY_BYTES(Data)                                              \
+    do {                                                                \
+        ASSERT_EQ(avs_stream_outbuf_offset(&outbuf), sizeof(Data) - 1); \
+        ASSERT_EQ_BYTES(buf, Data);                                     \
+    } while (0)
+
+AVS_UNIT_TEST(senml_cbor_out, instance) {
+    TEST_ENV(256, &MAKE_INSTANCE_PATH(3, 0));
+
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 0)));
+    ASSERT_OK(anjay_ret_string(out, "Acme"));
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(3, 0, 1)));
+    ASSERT_OK(anjay_ret_i64(out, 42));
+    ASSERT_OK(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 // {bn: "/3/0", n: "/0", vs: "Acme"}
+                 "\xA3\x21\x64/3/0\x00\x62/0\x03\x64"
+                 "Acme"
+                 // {n: "/1", v: 42}
+                 "\xA2\x00\x62/1\x02\x18\x2A"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, value_types) {
+    TEST_ENV(256, &MAKE_INSTANCE_PATH(1, 2));
+
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 0)));
+    ASSERT_OK(anjay_ret_i64(out, -500));
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 1)));
+    ASSERT_OK(anjay_ret_double(out, 1.5));
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 2)));
+    ASSERT_OK(anjay_ret_double(out, 0.1));
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 3)));
+    ASSERT_OK(anjay_ret_bool(out, true));
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 4)));
+    ASSERT_OK(anjay_ret_bytes(out, "\x01\x02\x03", 3));
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 5)));
+    ASSERT_OK(anjay_ret_objlnk(out, 3, 0));
+    ASSERT_OK(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x64/1/2\x00\x62/0\x02\x39\x01\xF3"
+                 "\xA2\x00\x62/1\x02\xFA\x3F\xC0\x00\x00"
+                 "\xA2\x00\x62/2\x02\xFB\x3F\xB9\x99\x99\x99\x99\x99\x9A"
+                 "\xA2\x00\x62/3\x04\xF5"
+                 "\xA2\x00\x62/4\x08\x43\x01\x02\x03"
+                 "\xA2\x00\x62/5\x63vlo\x63"
+                 "3:0"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, resource_with_timestamp) {
+    TEST_ENV(256, &MAKE_RESOURCE_PATH(1, 2, 3));
+
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 3)));
+    ASSERT_OK(_anjay_output_set_time(out, 2.0));
+    ASSERT_OK(anjay_ret_bool(out, false));
+    ASSERT_OK(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 // {bn: "/1/2/3", t: 2.0, vb: false}
+                 "\xA3\x21\x66/1/2/3\x06\xFA\x40\x00\x00\x00\x04\xF4"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, double_out_of_float_range) {
+    TEST_ENV(256, &MAKE_RESOURCE_PATH(1, 2, 3));
+
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 3)));
+    ASSERT_OK(anjay_ret_double(out, 1e300));
+    ASSERT_OK(_anjay_output_ctx_destroy(&out));
+
+    VERIFY_BYTES("\x9F"
+                 // {bn: "/1/2/3", v: 1e300}
+                 "\xA2\x21\x66/1/2/3\x02\xFB\x7E\x37\xE4\x3C\x88\x00\x75\x9C"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, bytes_too_short) {
+    TEST_ENV(256, &MAKE_RESOURCE_PATH(1, 2, 3));
+
+    ASSERT_OK(_anjay_output_set_path(out, &MAKE_RESOURCE_PATH(1, 2, 3)));
+    anjay_ret_bytes_ctx_t *bytes = anjay_ret_bytes_begin(out, 4);
+    ASSERT_NOT_NULL(bytes);
+    ASSERT_OK(anjay_ret_bytes_append(bytes, "\x01\x02", 2));
+    ASSERT_FAIL(_anjay_output_ctx_destroy(&out));
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
+#include <avsystem/commons/unit/test.h>
+
+#define TEST_ENV(Size)                                                 \
+    char *buf = (char *) avs_malloc(Size);                             \
+    AVS_UNIT_ASSERT_NOT_NULL(buf);                                     \
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER; \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, (Size))
+
+#define TEST_TEARDOWN avs_free(buf)
+
+/**
+ * Straightforward, character-by-character implementation of string escaping,
+ * used as a reference for the table-driven one.
+ */
+static size_t reference_escape(char *out, const char *value) {
+    size_t out_size = 0;
+    out[out_size++] = '"';
+    for (const char *ptr = value; *ptr; ++ptr) {
+        const uint8_t ch = (uint8_t) *ptr;
+        if (ch == '"' || ch == '\\') {
+            out[out_size++] = '\\';
+            out[out_size++] = (char) ch;
+        } else if (ch >= 0x20 && ch < 0x7F) {
+            out[out_size++] = (char) ch;
+        } else if (ch == '\b') {
+            out_size += (size_t) sprintf(&out[out_size], "\\b");
+        } else if (ch == '\f') {
+            out_size += (size_t) sprintf(&out[out_size], "\\f");
+        } else if (ch == '\n') {
+            out_size += (size_t) sprintf(&out[out_size], "\\n");
+        } else if (ch == '\r') {
+            out_size += (size_t) sprintf(&out[out_size], "\\r");
+        } else if (ch == '\t') {
+            out_size += (size_t) sprintf(&out[out_size], "\\t");
+        } else {
+            out_size += (size_t) sprintf(&out[out_size], "\\u00%02x", ch);
+        }
+    }
+    out[out_size++] = '"';
+    return out_size;
+}
+
+#define VERIFY_QUOTED(Value, Expected)                                   \
+    do {                                                                 \
+        TEST_ENV(256);                                                   \
+        AVS_UNIT_ASSERT_SUCCESS(                                         \
+                write_quoted_string((avs_stream_t *) &outbuf, (Value))); \
+        AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf),         \
+                              sizeof(Expected) - 1);                     \
+        AVS_UNIT_ASSERT_EQUAL_BYTES(buf, Expected);                      \
+        TEST_TEARDOWN;                                                   \
+    } while (0)
+
+AVS_UNIT_TEST(json_encoder, quoted_string) {
+    VERIFY_QUOTED("", "\"\"");
+    VERIFY_QUOTED("plain text", "\"plain text\"");
+    VERIFY_QUOTED("\"quoted\"", "\"\\\"quoted\\\"\"");
+    VERIFY_QUOTED("C:\\path", "\"C:\\\\path\"");
+    VERIFY_QUOTED("\b\f\n\r\t", "\"\\b\\f\\n\\r\\t\"");
+    VERIFY_QUOTED("\x01\x1f\x7f", "\"\\u0001\\u001f\\u007f\"");
+    VERIFY_QUOTED("za\xc5\xbc\xc3\xb3\xc5\x82\xc4\x87",
+                  "\"za\\u00c5\\u00bc\\u00c3\\u00b3\\u00c5\\u0082\\u00c4"
+                  "\\u0087\"");
+}
+
+AVS_UNIT_TEST(json_encoder, quoted_string_stream_error) {
+    TEST_ENV(8);
+    AVS_UNIT_ASSERT_FAILED(
+            write_quoted_string((avs_stream_t *) &outbuf, "\"too long\""));
+    TEST_TEARDOWN;
+}
+
+static void verify_against_reference(const char *value) {
+    const size_t buf_size = 6 * strlen(value) + 2;
+    char *expected = (char *) avs_malloc(buf_size);
+    AVS_UNIT_ASSERT_NOT_NULL(expected);
+    const size_t expected_size = reference_escape(expected, value);
+
+    TEST_ENV(buf_size);
+    AVS_UNIT_ASSERT_SUCCESS(
+            write_quoted_string((avs_stream_t *) &outbuf, value));
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), expected_size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, expected, expected_size);
+    TEST_TEARDOWN;
+    avs_free(expected);
+}
+
+AVS_UNIT_TEST(json_encoder, quoted_string_every_byte) {
+    // every entry of the lookup table, both alone and between plain runs
+    char value[sizeof("ab") + 1];
+    for (int ch = 1; ch <= UINT8_MAX; ++ch) {
+        value[0] = (char) ch;
+        value[1] = '\0';
+        verify_against_reference(value);
+
+        value[0] = 'a';
+        value[1] = (char) ch;
+        value[2] = 'b';
+        value[3] = '\0';
+        verify_against_reference(value);
+    }
+}
+
+AVS_UNIT_TEST(json_encoder, quoted_string_run_boundaries) {
+    // escapes at both ends of the string, next to each other, and on both
+    // sides of a long plain run
+    char long_run[1024];
+    memset(long_run, 'x', sizeof(long_run) - 1);
+    long_run[0] = '\n';
+    long_run[sizeof(long_run) / 2] = '"';
+    long_run[sizeof(long_run) - 2] = '\\';
+    long_run[sizeof(long_run) - 1] = '\0';
+
+    verify_against_reference("\"abc");
+    verify_against_reference("abc\"");
+    verify_against_reference("a\"\\\nb");
+    verify_against_reference("\x01\x02\x7f\xff");
+    verify_against_reference(long_run);
+}
@@ -16,6 +16,7 @@
 
 #include <anjay_config.h>
 
+#include <anjay_modules/access_utils.h>
 #include <anjay_modules/dm_utils.h>
 #include <anjay_modules/notify.h>
 
@@ -39,8 +40,8 @@ static int observe_notify(anjay_t *anjay, anjay_notify_queue_t queue) {
                     _anjay_observe_notify(anjay, &MAKE_OBJECT_PATH(it->oid),
                                           _anjay_dm_current_ssid(anjay), true));
         } else {
-            AVS_LIST(anjay_notify_queue_resource_entry_t) it2;
-            AVS_LIST_FOREACH(it2, it->resources_changed) {
+            AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) it2;
+            AVS_RBTREE_FOREACH(it2, it->resources_changed) {
                 _anjay_update_ret(&ret,
                                   _anjay_observe_notify(
                                           anjay,
@@ -64,8 +65,8 @@ security_modified_notify(anjay_t *anjay,
     }
     int ret = 0;
     int32_t last_iid = -1;
-    AVS_LIST(anjay_notify_queue_resource_entry_t) it;
-    AVS_LIST_FOREACH(it, security->resources_changed) {
+    AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) it;
+    AVS_RBTREE_FOREACH(it, security->resources_changed) {
         if (it->iid != last_iid) {
             _anjay_update_ret(&ret,
                               _anjay_schedule_socket_update(anjay, it->iid));
@@ -81,8 +82,8 @@ security_modified_notify(anjay_t *anjay,
 static int server_modified_notify(anjay_t *anjay,
                                   anjay_notify_queue_object_entry_t *server) {
     int ret = 0;
-    AVS_LIST(anjay_notify_queue_resource_entry_t) it;
-    AVS_LIST_FOREACH(it, server->resources_changed) {
+    AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) it;
+    AVS_RBTREE_FOREACH(it, server->resources_changed) {
         if (it->rid != ANJAY_DM_RID_SERVER_BINDING
                 && it->rid != ANJAY_DM_RID_SERVER_LIFETIME) {
             continue;
@@ -103,12 +104,49 @@ static int server_modified_notify(anjay_t *anjay,
     return ret;
 }
 
+static void invalidate_caches(anjay_t *anjay,
+                              anjay_oid_t oid,
+                              bool instance_set_changed) {
+    if (oid == ANJAY_DM_OID_ACCESS_CONTROL) {
+        _anjay_access_control_index_invalidate(anjay);
+    }
+    if (instance_set_changed && oid != ANJAY_DM_OID_SECURITY) {
+        // Security Object is not a part of the Register payload
+        _anjay_servers_invalidate_registration_payload(anjay);
+    }
+    if (instance_set_changed || oid == ANJAY_DM_OID_SERVER) {
+        // Effective attributes depend on the default periods stored in the
+        // Server object, and on which level they are inherited from
+        _anjay_observe_invalidate_attrs_cache(&anjay->observe);
+    }
+}
+
+void _anjay_notify_attributes_changed(anjay_t *anjay) {
+#ifdef WITH_OBSERVE
+    _anjay_observe_invalidate_attrs_cache(&anjay->observe);
+#else  // WITH_OBSERVE
+    (void) anjay;
+#endif // WITH_OBSERVE
+}
+
+static void invalidate_caches_for_queue(anjay_t *anjay,
+                                        anjay_notify_queue_t queue) {
+    AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        invalidate_caches(anjay, it->oid,
+                          it->instance_set_changes.instance_set_changed);
+    }
+}
+
 static int anjay_notify_perform_impl(anjay_t *anjay,
                                      anjay_notify_queue_t queue,
                                      bool server_notify) {
     if (!queue) {
         return 0;
     }
+    // caches need to be dropped before anything else, as sending
+    // notifications involves e.g. access control checks
+    invalidate_caches_for_queue(anjay, queue);
     int ret = 0;
     AVS_LIST(anjay_notify_queue_object_entry_t) it;
     AVS_LIST_FOREACH(it, queue) {
@@ -148,6 +186,18 @@ int _anjay_notify_flush(anjay_t *anjay, anjay_notify_queue_t *queue_ptr) {
     return result;
 }
 
+static int compare_resource_entries(const void *left_, const void *right_) {
+    const anjay_notify_queue_resource_entry_t *left =
+            (const anjay_notify_queue_resource_entry_t *) left_;
+    const anjay_notify_queue_resource_entry_t *right =
+            (const anjay_notify_queue_resource_entry_t *) right_;
+    int result = left->iid - right->iid;
+    if (!result) {
+        result = left->rid - right->rid;
+    }
+    return result;
+}
+
 static AVS_LIST(anjay_notify_queue_object_entry_t) *
 find_or_create_object_entry(anjay_notify_queue_t *out_queue, anjay_oid_t oid) {
     AVS_LIST(anjay_notify_queue_object_entry_t) *it;
@@ -158,12 +208,18 @@ find_or_create_object_entry(anjay_notify_queue_t *out_queue, anjay_oid_t oid) {
             break;
         }
     }
-    if (AVS_LIST_INSERT_NEW(anjay_notify_queue_object_entry_t, it)) {
-        (*it)->oid = oid;
-        return it;
-    } else {
+    AVS_LIST(anjay_notify_queue_object_entry_t) entry =
+            AVS_LIST_NEW_ELEMENT(anjay_notify_queue_object_entry_t);
+    if (!entry
+            || !(entry->resources_changed =
+                         AVS_RBTREE_NEW(anjay_notify_queue_resource_entry_t,
+                                        compare_resource_entries))) {
+        AVS_LIST_CLEAR(&entry);
         return NULL;
     }
+    entry->oid = oid;
+    AVS_LIST_INSERT(it, entry);
+    return it;
 }
 
 static int add_entry_to_iid_set(AVS_LIST(anjay_iid_t) *iid_set_ptr,
@@ -201,11 +257,12 @@ static void delete_notify_queue_object_entry_if_empty(
         return;
     }
     if ((*entry_ptr)->instance_set_changes.instance_set_changed
-            || (*entry_ptr)->resources_changed) {
+            || AVS_RBTREE_FIRST((*entry_ptr)->resources_changed)) {
         // entry not empty
         return;
     }
     assert(!(*entry_ptr)->instance_set_changes.known_added_iids);
+    AVS_RBTREE_DELETE(&(*entry_ptr)->resources_changed);
     AVS_LIST_DELETE(entry_ptr);
 }
 
@@ -255,14 +312,25 @@ int _anjay_notify_queue_instance_set_unknown_change(
     return 0;
 }
 
-static int
-compare_resource_entries(const anjay_notify_queue_resource_entry_t *left,
-                         const anjay_notify_queue_resource_entry_t *right) {
-    int result = left->iid - right->iid;
-    if (!result) {
-        result = left->rid - right->rid;
+static int add_resource_entry(anjay_notify_queue_object_entry_t *obj_entry,
+                              anjay_iid_t iid,
+                              anjay_rid_t rid) {
+    const anjay_notify_queue_resource_entry_t query = {
+        .iid = iid,
+        .rid = rid
+    };
+    if (AVS_RBTREE_FIND(obj_entry->resources_changed, &query)) {
+        return 0;
     }
-    return result;
+    AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) new_entry =
+            AVS_RBTREE_ELEM_NEW(anjay_notify_queue_resource_entry_t);
+    if (!new_entry) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    *new_entry = query;
+    AVS_RBTREE_INSERT(obj_entry->resources_changed, new_entry);
+    return 0;
 }
 
 int _anjay_notify_queue_resource_change(anjay_notify_queue_t *out_queue,
@@ -275,36 +343,17 @@ int _anjay_notify_queue_resource_change(anjay_notify_queue_t *out_queue,
         anjay_log(ERROR, _("out of memory"));
         return -1;
     }
-    anjay_notify_queue_resource_entry_t new_entry = {
-        .iid = iid,
-        .rid = rid
-    };
-    AVS_LIST(anjay_notify_queue_resource_entry_t) *res_entry_ptr;
-    AVS_LIST_FOREACH_PTR(res_entry_ptr, &(*obj_entry_ptr)->resources_changed) {
-        int compare = compare_resource_entries(*res_entry_ptr, &new_entry);
-        if (compare == 0) {
-            return 0;
-        } else if (compare > 0) {
-            break;
-        }
-    }
-    if (!AVS_LIST_INSERT_NEW(anjay_notify_queue_resource_entry_t,
-                             res_entry_ptr)) {
-        anjay_log(ERROR, _("out of memory"));
-        if (!(*obj_entry_ptr)->instance_set_changes.instance_set_changed
-                && !(*obj_entry_ptr)->resources_changed) {
-            AVS_LIST_DELETE(obj_entry_ptr);
-        }
+    if (add_resource_entry(*obj_entry_ptr, iid, rid)) {
+        delete_notify_queue_object_entry_if_empty(obj_entry_ptr);
         return -1;
     }
-    **res_entry_ptr = new_entry;
     return 0;
 }
 
 void _anjay_notify_clear_queue(anjay_notify_queue_t *out_queue) {
     AVS_LIST_CLEAR(out_queue) {
         AVS_LIST_CLEAR(&(*out_queue)->instance_set_changes.known_added_iids);
-        AVS_LIST_CLEAR(&(*out_queue)->resources_changed);
+        AVS_RBTREE_DELETE(&(*out_queue)->resources_changed);
     }
 }
 
@@ -325,6 +374,7 @@ static int reschedule_notify(anjay_t *anjay) {
 int _anjay_notify_instance_created(anjay_t *anjay,
                                    anjay_oid_t oid,
                                    anjay_iid_t iid) {
+    invalidate_caches(anjay, oid, true);
     int retval;
     (void) ((retval = _anjay_notify_queue_instance_created(
                      &anjay->scheduled_notify.queue, oid, iid))
@@ -336,6 +386,9 @@ int anjay_notify_changed(anjay_t *anjay,
                          anjay_oid_t oid,
                          anjay_iid_t iid,
                          anjay_rid_t rid) {
+    // the change has already happened, so data derived from it is stale even
+    // before the scheduled notification is processed
+    invalidate_caches(anjay, oid, false);
     int retval;
     (void) ((retval = _anjay_notify_queue_resource_change(
                      &anjay->scheduled_notify.queue, oid, iid, rid))
@@ -343,7 +396,47 @@ int anjay_notify_changed(anjay_t *anjay,
     return retval;
 }
 
+int anjay_notify_changed_many(anjay_t *anjay,
+                              const anjay_notify_resource_t *resources,
+                              size_t resource_count) {
+    int result = 0;
+    AVS_LIST(anjay_notify_queue_object_entry_t) *obj_entry_ptr = NULL;
+    for (size_t i = 0; i < resource_count; ++i) {
+        if (resources[i].oid == ANJAY_ID_INVALID
+                || resources[i].iid == ANJAY_ID_INVALID
+                || resources[i].rid == ANJAY_ID_INVALID) {
+            anjay_log(ERROR, _("invalid Resource path at index ") "%u",
+                      (unsigned) i);
+            result = -1;
+            break;
+        }
+        // changes are usually grouped by Object, so the Object entry is only
+        // looked up when the Object ID changes
+        if (!obj_entry_ptr || (*obj_entry_ptr)->oid != resources[i].oid) {
+            invalidate_caches(anjay, resources[i].oid, false);
+            if (!(obj_entry_ptr = find_or_create_object_entry(
+                          &anjay->scheduled_notify.queue, resources[i].oid))) {
+                anjay_log(ERROR, _("out of memory"));
+                result = -1;
+                break;
+            }
+        }
+        if (add_resource_entry(*obj_entry_ptr, resources[i].iid,
+                               resources[i].rid)) {
+            delete_notify_queue_object_entry_if_empty(obj_entry_ptr);
+            result = -1;
+            break;
+        }
+    }
+    if (anjay->scheduled_notify.queue) {
+        // changes queued before a failure shall still be processed
+        _anjay_update_ret(&result, reschedule_notify(anjay));
+    }
+    return result;
+}
+
 int anjay_notify_instances_changed(anjay_t *anjay, anjay_oid_t oid) {
+    invalidate_caches(anjay, oid, true);
     int retval;
     (void) ((retval = _anjay_notify_queue_instance_set_unknown_change(
                      &anjay->scheduled_notify.queue, oid))
@@ -396,3 +489,7 @@ anjay_resource_observation_status_t anjay_resource_observation_status(
     return _anjay_observe_status(anjay, oid, iid, rid);
 }
 #endif // WITH_OBSERVATION_STATUS
+
+#ifdef ANJAY_TEST
+#    include "test/notify.c"
+#endif // ANJAY_TEST
@@ -25,6 +25,7 @@
 
 #include <anjay_modules/time_defs.h>
 
+#include "../access_utils.h"
 #include "../anjay_core.h"
 #include "../coap/content_format.h"
 #include "../dm/dm_read.h"
@@ -73,9 +74,19 @@ int _anjay_observe_path_entry_cmp(const void *left, const void *right) {
 
 void _anjay_observe_init(anjay_observe_state_t *observe,
                          bool confirmable_notifications,
-                         size_t stored_notification_limit) {
+                         size_t stored_notification_limit,
+                         size_t max_notifications_in_flight,
+                         anjay_stored_notifications_mode_t
+                                 stored_notifications_mode,
+                         avs_time_duration_t timer_granularity) {
     assert(!observe->connection_entries);
     observe->confirmable_notifications = confirmable_notifications;
+    observe->max_in_flight = AVS_MAX(max_notifications_in_flight, 1);
+    observe->stored_notifications_mode = stored_notifications_mode;
+    observe->timer_granularity = timer_granularity;
+    observe->unsent_queue.prev = &observe->unsent_queue;
+    observe->unsent_queue.next = &observe->unsent_queue;
+    observe->unsent_count = 0;
 
     if (stored_notification_limit == 0) {
         observe->notify_queue_limit_mode = NOTIFY_QUEUE_UNLIMITED;
@@ -89,6 +100,96 @@ static inline bool is_error_value(const anjay_observation_value_t *value) {
     return _anjay_observe_is_error_details(&value->details);
 }
 
+static inline bool is_value_in_flight(const anjay_observation_value_t *value) {
+    // values being sent, including the ones batched into them, are unlinked
+    // from the global queue of unsent values for the duration
+    return value->ref->in_flight && !value->unsent_link.next;
+}
+
+static void insert_unsent_link(anjay_observation_value_t *value,
+                               anjay_observe_unsent_link_t *next) {
+    value->unsent_link.prev = next->prev;
+    value->unsent_link.next = next;
+    next->prev->next = &value->unsent_link;
+    next->prev = &value->unsent_link;
+}
+
+/**
+ * Inserts the value into the global queue of unsent values, just before
+ * @p next. Inserting it into the connection entry's unsent list is the
+ * responsibility of the caller.
+ */
+static void link_unsent_value(anjay_observe_connection_entry_t *conn_state,
+                              anjay_observation_value_t *value,
+                              anjay_observe_unsent_link_t *next) {
+    value->queued_in = conn_state;
+    insert_unsent_link(value, next);
+    ++conn_state->observe->unsent_count;
+}
+
+static void
+append_unsent_value(anjay_observe_connection_entry_t *conn_state,
+                    AVS_LIST(anjay_observation_value_t) value) {
+    AVS_LIST_APPEND(&conn_state->unsent_last, value);
+    conn_state->unsent_last = value;
+    if (!conn_state->unsent) {
+        conn_state->unsent = value;
+    }
+    link_unsent_value(conn_state, value, &conn_state->observe->unsent_queue);
+}
+
+/**
+ * Removes the value from the global queue of unsent values, but keeps it
+ * counted in anjay_observe_state_t::unsent_count. Used directly for values
+ * that are about to be sent, so that they are never considered for dropping.
+ */
+static void unlink_from_unsent_queue(anjay_observation_value_t *value) {
+    assert(value->queued_in);
+    assert(value->unsent_link.next);
+    value->unsent_link.prev->next = value->unsent_link.next;
+    value->unsent_link.next->prev = value->unsent_link.prev;
+    value->unsent_link.prev = NULL;
+    value->unsent_link.next = NULL;
+}
+
+/**
+ * Puts a value whose delivery failed back into the global queue of unsent
+ * values, at the position matching its age. Values are sent roughly in queue
+ * order, so that position is usually close to the head of the queue.
+ */
+static void relink_into_unsent_queue(anjay_observation_value_t *value) {
+    assert(value->queued_in);
+    assert(!value->unsent_link.next);
+    anjay_observe_unsent_link_t *queue =
+            &value->queued_in->observe->unsent_queue;
+    anjay_observe_unsent_link_t *next = queue->next;
+    while (next != queue
+           && !avs_time_real_before(
+                      value->timestamp,
+                      AVS_CONTAINER_OF(next, anjay_observation_value_t,
+                                       unsent_link)
+                              ->timestamp)) {
+        next = next->next;
+    }
+    insert_unsent_link(value, next);
+}
+
+/**
+ * Removes the value from the global queue of unsent values, if it is linked
+ * there, and stops counting it as queued. Removing it from the connection
+ * entry's unsent list is the responsibility of the caller.
+ */
+static void unlink_unsent_value(anjay_observation_value_t *value) {
+    assert(value->queued_in);
+    anjay_observe_state_t *observe = value->queued_in->observe;
+    assert(observe->unsent_count > 0);
+    if (value->unsent_link.next) {
+        unlink_from_unsent_queue(value);
+    }
+    value->queued_in = NULL;
+    --observe->unsent_count;
+}
+
 static void delete_value(AVS_LIST(anjay_observation_value_t) *value_ptr) {
     if (*value_ptr && !is_error_value(*value_ptr)) {
         for (size_t i = 0; i < (*value_ptr)->ref->paths_count; ++i) {
@@ -100,6 +201,13 @@ static void delete_value(AVS_LIST(anjay_observation_value_t) *value_ptr) {
     AVS_LIST_DELETE(value_ptr);
 }
 
+static void delete_batched_values(anjay_observe_in_flight_t *in_flight) {
+    while (in_flight->batched) {
+        unlink_unsent_value(in_flight->batched);
+        delete_value(&in_flight->batched);
+    }
+}
+
 static inline const anjay_observe_path_entry_t *
 path_entry_query(const anjay_uri_path_t *path) {
     return AVS_CONTAINER_OF(path, anjay_observe_path_entry_t, path);
@@ -197,7 +305,8 @@ remove_from_observed_paths(anjay_observe_connection_entry_t *conn,
 
 static void clear_observation(anjay_observe_connection_entry_t *connection,
                               anjay_observation_t *observation) {
-    avs_sched_del(&observation->notify_task);
+    assert(!observation->in_flight);
+    _anjay_timer_cancel(&connection->notify_timers, &observation->notify_timer);
     while (observation->last_sent) {
         delete_value(&observation->last_sent);
     }
@@ -211,6 +320,7 @@ static void clear_observation(anjay_observe_connection_entry_t *connection,
             if ((*unsent_ptr)->ref != observation) {
                 server_last_unsent = *unsent_ptr;
             } else {
+                unlink_unsent_value(*unsent_ptr);
                 delete_value(unsent_ptr);
             }
         }
@@ -226,13 +336,27 @@ detach_observation(anjay_observe_connection_entry_t *conn,
     remove_from_observed_paths(conn, observation);
 }
 
+static void
+cleanup_serialization_state(anjay_observation_serialization_state_t *state) {
+    _anjay_output_ctx_destroy(&state->out_ctx);
+    avs_stream_cleanup(&state->membuf_stream);
+}
+
 void _anjay_observe_cleanup_connection(anjay_observe_connection_entry_t *conn) {
+    AVS_LIST_CLEAR(&conn->in_flight) {
+        conn->in_flight->value->ref->in_flight = NULL;
+        cleanup_serialization_state(&conn->in_flight->serialization_state);
+        delete_batched_values(conn->in_flight);
+    }
     while (conn->unsent) {
+        unlink_unsent_value(conn->unsent);
         delete_value(&conn->unsent);
     }
+    conn->unsent_last = NULL;
     AVS_RBTREE_DELETE(&conn->observations) {
         remove_from_observed_paths(conn, *conn->observations);
-        avs_sched_del(&(*conn->observations)->notify_task);
+        _anjay_timer_cancel(&conn->notify_timers,
+                            &(*conn->observations)->notify_timer);
         if ((*conn->observations)->last_sent) {
             delete_value(&(*conn->observations)->last_sent);
         }
@@ -242,15 +366,117 @@ void _anjay_observe_cleanup_connection(anjay_observe_connection_entry_t *conn) {
         assert(!AVS_RBTREE_FIRST(conn->observed_paths));
         AVS_RBTREE_DELETE(&conn->observed_paths);
     }
+    _anjay_timer_wheel_cleanup(&conn->notify_timers);
     if (conn->flush_task) {
         avs_sched_del(&conn->flush_task);
     }
 }
 
+static void clear_read_cache(anjay_observe_state_t *observe) {
+    if (observe->read_cache) {
+        AVS_RBTREE_DELETE(&observe->read_cache) {
+            if ((*observe->read_cache)->batch) {
+                _anjay_batch_release(&(*observe->read_cache)->batch);
+            }
+        }
+    }
+}
+
+static int read_cache_entry_cmp(const void *left, const void *right) {
+    return _anjay_uri_path_compare(
+            &((const anjay_observe_read_cache_entry_t *) left)->path,
+            &((const anjay_observe_read_cache_entry_t *) right)->path);
+}
+
+static void read_cache_job(avs_sched_t *sched, const void *observe_ptr) {
+    (void) sched;
+    clear_read_cache(*(anjay_observe_state_t *const *) observe_ptr);
+}
+
+/**
+ * Results of reading Object or root paths depend on which Object Instances the
+ * requesting server has access to, so only paths with an Instance ID, for
+ * which access is all-or-nothing, are shared between servers.
+ */
+static bool is_read_cacheable(const anjay_uri_path_t *path) {
+    return _anjay_uri_path_has(path, ANJAY_ID_IID);
+}
+
+static AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t)
+find_read_cache_entry(anjay_observe_state_t *observe,
+                      const anjay_uri_path_t *path) {
+    if (!observe->read_cache) {
+        return NULL;
+    }
+    return AVS_RBTREE_FIND(observe->read_cache,
+                           AVS_CONTAINER_OF(path,
+                                            anjay_observe_read_cache_entry_t,
+                                            path));
+}
+
+/**
+ * Returns a new, empty cache entry for @p path , or NULL if it could not be
+ * created. The latter is not an error, the value just won't be shared.
+ */
+static AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t)
+create_read_cache_entry(anjay_t *anjay, const anjay_uri_path_t *path) {
+    anjay_observe_state_t *observe = &anjay->observe;
+    assert(is_read_cacheable(path));
+    assert(!find_read_cache_entry(observe, path));
+    // the job will run after all jobs that are due in the current pass
+    if (!observe->read_cache_job
+            && AVS_SCHED_NOW(anjay->sched, &observe->read_cache_job,
+                             read_cache_job, &observe, sizeof(observe))) {
+        return NULL;
+    }
+    if (!observe->read_cache
+            && !(observe->read_cache =
+                         AVS_RBTREE_NEW(anjay_observe_read_cache_entry_t,
+                                        read_cache_entry_cmp))) {
+        return NULL;
+    }
+    AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t) entry =
+            AVS_RBTREE_ELEM_NEW(anjay_observe_read_cache_entry_t);
+    if (entry) {
+        entry->path = *path;
+        AVS_RBTREE_INSERT(observe->read_cache, entry);
+    }
+    return entry;
+}
+
+/**
+ * Performs the access check that _anjay_dm_read() would do, for a value that
+ * has been read on behalf of another server.
+ */
+static int check_cached_read_allowed(anjay_t *anjay,
+                                     const anjay_uri_path_t *path,
+                                     anjay_ssid_t ssid) {
+    const anjay_action_info_t action_info = {
+        .oid = path->ids[ANJAY_ID_OID],
+        .iid = path->ids[ANJAY_ID_IID],
+        .ssid = ssid,
+        .action = ANJAY_ACTION_READ
+    };
+    return _anjay_instance_action_allowed(anjay, &action_info)
+                   ? 0
+                   : ANJAY_ERR_UNAUTHORIZED;
+}
+
+static const anjay_batch_t *
+read_cache_entry_batch(anjay_observe_read_cache_entry_t *entry) {
+    if (!entry->batch) {
+        entry->batch = _anjay_batch_from_numeric_value(&entry->numeric);
+    }
+    return entry->batch;
+}
+
 void _anjay_observe_cleanup(anjay_observe_state_t *observe) {
     AVS_LIST_CLEAR(&observe->connection_entries) {
         _anjay_observe_cleanup_connection(observe->connection_entries);
     }
+    avs_sched_del(&observe->read_cache_job);
+    clear_read_cache(observe);
+    _anjay_observe_restored_cleanup(observe);
 }
 
 static void
@@ -269,12 +495,7 @@ static void delete_connection_if_empty(
     }
 }
 
-typedef struct {
-    anjay_observe_connection_entry_t *conn_state;
-    anjay_observation_t *observation;
-} trigger_observe_args_t;
-
-static void trigger_observe(avs_sched_t *sched, const void *args_);
+static void trigger_observe(anjay_timer_wheel_t *wheel, anjay_timer_t *timer);
 
 static const anjay_observation_value_t *
 newest_value(const anjay_observation_t *observation) {
@@ -306,8 +527,9 @@ static int schedule_trigger(anjay_observe_connection_entry_t *conn_state,
         trigger_instant = monotonic_now;
     }
 
-    if (avs_time_monotonic_before(avs_sched_time(&observation->notify_task),
-                                  trigger_instant)) {
+    if (avs_time_monotonic_before(
+                _anjay_timer_expiry(&observation->notify_timer),
+                trigger_instant)) {
         anjay_log(LAZY_TRACE,
                   _("Notify for token ") "%s" _(" already scheduled earlier "
                                                 "than requested ") "%ld.%09lds",
@@ -323,15 +545,9 @@ static int schedule_trigger(anjay_observe_connection_entry_t *conn_state,
               (long) trigger_instant.since_monotonic_epoch.seconds,
               (long) trigger_instant.since_monotonic_epoch.nanoseconds);
 
-    int retval =
-            AVS_SCHED_AT(_anjay_from_server(conn_state->conn_ref.server)->sched,
-                         &observation->notify_task, trigger_instant,
-                         trigger_observe,
-                         (&(const trigger_observe_args_t) {
-                             .conn_state = conn_state,
-                             .observation = observation
-                         }),
-                         sizeof(trigger_observe_args_t));
+    int retval = _anjay_timer_schedule(&conn_state->notify_timers,
+                                       &observation->notify_timer,
+                                       trigger_instant);
     if (retval) {
         anjay_log(ERROR,
                   _("Could not schedule automatic notification trigger, "
@@ -368,23 +584,12 @@ create_observation_value(const anjay_msg_details_t *details,
     return result;
 }
 
-static size_t count_queued_notifications(const anjay_observe_state_t *observe) {
-    size_t count = 0;
-
-    AVS_LIST(anjay_observe_connection_entry_t) conn;
-    AVS_LIST_FOREACH(conn, observe->connection_entries) {
-        count += AVS_LIST_SIZE(conn->unsent);
-    }
-
-    return count;
-}
-
 static bool is_observe_queue_full(const anjay_observe_state_t *observe) {
     if (observe->notify_queue_limit_mode == NOTIFY_QUEUE_UNLIMITED) {
         return false;
     }
 
-    size_t num_queued = count_queued_notifications(observe);
+    size_t num_queued = observe->unsent_count;
     anjay_log(TRACE, "%u/%u" _(" queued notifications"), (unsigned) num_queued,
               (unsigned) observe->notify_queue_limit);
 
@@ -392,48 +597,94 @@ static bool is_observe_queue_full(const anjay_observe_state_t *observe) {
     return num_queued >= observe->notify_queue_limit;
 }
 
-static AVS_LIST(anjay_observe_connection_entry_t)
+/**
+ * Returns the oldest queued value that is not currently being sent, or NULL if
+ * there is no such value.
+ */
+static anjay_observation_value_t *
 find_oldest_queued_notification(anjay_observe_state_t *observe) {
-    AVS_LIST(anjay_observe_connection_entry_t) oldest = NULL;
-
-    AVS_LIST(anjay_observe_connection_entry_t) conn;
-    AVS_LIST_FOREACH(conn, observe->connection_entries) {
-        if (conn->unsent) {
-            if (!oldest
-                    || avs_time_real_before(conn->unsent->timestamp,
-                                            oldest->unsent->timestamp)) {
-                oldest = conn;
-            }
-        }
+    if (observe->unsent_queue.next == &observe->unsent_queue) {
+        return NULL;
     }
+    return AVS_CONTAINER_OF(observe->unsent_queue.next,
+                            anjay_observation_value_t, unsent_link);
+}
 
-    return oldest;
+static AVS_LIST(anjay_observation_value_t) *
+find_unsent_value_ptr(anjay_observe_connection_entry_t *conn_state,
+                      const anjay_observation_value_t *value,
+                      anjay_observation_value_t **out_prev) {
+    AVS_LIST(anjay_observation_value_t) *value_ptr = &conn_state->unsent;
+    *out_prev = NULL;
+    while (*value_ptr != value) {
+        assert(*value_ptr);
+        *out_prev = *value_ptr;
+        AVS_LIST_ADVANCE_PTR(&value_ptr);
+    }
+    return value_ptr;
 }
 
+/**
+ * Detaches the value pointed to by @p value_ptr from the unsent list of
+ * @p conn_state, leaving it linked in the global queue of unsent values.
+ * @p prev shall be the element preceding it on that list, or NULL if it is
+ * the first one.
+ */
 static anjay_observation_value_t *
-detach_first_unsent_value(anjay_observe_connection_entry_t *conn_state) {
-    assert(conn_state->unsent);
-    anjay_observation_t *observation = conn_state->unsent->ref;
-    if (observation->last_unsent == conn_state->unsent) {
-        observation->last_unsent = NULL;
+detach_from_unsent_list(anjay_observe_connection_entry_t *conn_state,
+                        AVS_LIST(anjay_observation_value_t) *value_ptr,
+                        anjay_observation_value_t *prev) {
+    anjay_observation_value_t *value = *value_ptr;
+    anjay_observation_t *observation = value->ref;
+    assert(!is_value_in_flight(value));
+    if (observation->last_unsent == value) {
+        // the only value of this observation that may precede the detached one
+        // is the one currently being sent, if any
+        observation->last_unsent =
+                observation->in_flight ? observation->in_flight->value : NULL;
     }
-    anjay_observation_value_t *result = AVS_LIST_DETACH(&conn_state->unsent);
-    if (conn_state->unsent_last == result) {
-        assert(!conn_state->unsent);
-        conn_state->unsent_last = NULL;
+    AVS_LIST_DETACH(value_ptr);
+    if (conn_state->unsent_last == value) {
+        assert(!*value_ptr);
+        conn_state->unsent_last = prev;
     }
-    return result;
+    return value;
 }
 
-static void drop_oldest_queued_notification(anjay_observe_state_t *observe) {
-    AVS_LIST(anjay_observe_connection_entry_t) oldest =
-            find_oldest_queued_notification(observe);
+/**
+ * Detaches the value pointed to by @p value_ptr from the unsent list of
+ * @p conn_state and from the global queue of unsent values. @p prev shall be
+ * the element preceding it on that list, or NULL if it is the first one.
+ */
+static anjay_observation_value_t *
+detach_unsent_value(anjay_observe_connection_entry_t *conn_state,
+                    AVS_LIST(anjay_observation_value_t) *value_ptr,
+                    anjay_observation_value_t *prev) {
+    anjay_observation_value_t *value =
+            detach_from_unsent_list(conn_state, value_ptr, prev);
+    unlink_unsent_value(value);
+    return value;
+}
 
-    AVS_ASSERT(oldest, "function is not supposed to be called when there are "
-                       "no queued notifications");
+/**
+ * Drops the oldest queued value that is not currently being sent.
+ *
+ * @returns 0 on success, or -1 if all queued values are being sent.
+ */
+static int drop_oldest_queued_notification(anjay_observe_state_t *observe) {
+    anjay_observation_value_t *oldest =
+            find_oldest_queued_notification(observe);
+    if (!oldest) {
+        return -1;
+    }
 
-    anjay_observation_value_t *entry = detach_first_unsent_value(oldest);
+    anjay_observe_connection_entry_t *conn_state = oldest->queued_in;
+    anjay_observation_value_t *prev;
+    AVS_LIST(anjay_observation_value_t) entry = detach_unsent_value(
+            conn_state, find_unsent_value_ptr(conn_state, oldest, &prev),
+            prev);
     delete_value(&entry);
+    return 0;
 }
 
 static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
@@ -441,8 +692,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
                             avs_coap_notify_reliability_hint_t reliability_hint,
                             const anjay_msg_details_t *details,
                             const anjay_batch_t *const *values) {
-    anjay_observe_state_t *observe =
-            &_anjay_from_server(conn_state->conn_ref.server)->observe;
+    anjay_observe_state_t *observe = conn_state->observe;
     if (is_observe_queue_full(observe)) {
         switch (observe->notify_queue_limit_mode) {
         case NOTIFY_QUEUE_UNLIMITED:
@@ -451,7 +701,13 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
 
         case NOTIFY_QUEUE_DROP_OLDEST:
             assert(observe->notify_queue_limit != 0);
-            drop_oldest_queued_notification(observe);
+            if (drop_oldest_queued_notification(observe)) {
+                // all queued values are being sent right now; the new value
+                // is dropped instead, so that the limit is never exceeded
+                anjay_log(DEBUG, _("notification queue full, dropping new "
+                                   "value"));
+                return 0;
+            }
             break;
         }
     }
@@ -463,11 +719,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
         return -1;
     }
 
-    AVS_LIST_APPEND(&conn_state->unsent_last, res_value);
-    conn_state->unsent_last = res_value;
-    if (!conn_state->unsent) {
-        conn_state->unsent = res_value;
-    }
+    append_unsent_value(conn_state, res_value);
     observation->last_unsent = res_value;
     return 0;
 }
@@ -475,7 +727,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
 static int insert_error(anjay_observe_connection_entry_t *conn_state,
                         anjay_observation_t *observation,
                         int outer_result) {
-    avs_sched_del(&observation->notify_task);
+    _anjay_timer_cancel(&conn_state->notify_timers, &observation->notify_timer);
     const anjay_msg_details_t details = {
         .msg_code = _anjay_make_error_response_code(outer_result),
         .format = AVS_COAP_FORMAT_NONE
@@ -638,9 +890,8 @@ create_detached_observation(const avs_coap_token_t *token,
             AVS_LIST_ADVANCE(&it);
         }
     } else {
-        assert(paths->count == 1);
         memcpy((void *) (intptr_t) (const void *) &new_observation->paths[0],
-               paths->paths, sizeof(*paths->paths));
+               paths->paths, paths->count * sizeof(*paths->paths));
     }
     return new_observation;
 }
@@ -682,6 +933,11 @@ find_or_create_connection_state(anjay_connection_ref_t ref) {
         }
         memcpy((void *) (intptr_t) (const void *) &(*conn_ptr)->conn_ref, &ref,
                sizeof(ref));
+        (*conn_ptr)->observe = &_anjay_from_server(ref.server)->observe;
+        _anjay_timer_wheel_init(&(*conn_ptr)->notify_timers,
+                                _anjay_from_server(ref.server)->sched,
+                                (*conn_ptr)->observe->timer_granularity,
+                                trigger_observe);
     }
     return conn_ptr;
 }
@@ -702,18 +958,16 @@ static void observe_remove_entry(anjay_connection_ref_t connection,
     if (!conn_ptr) {
         return;
     }
-    if (avs_coap_exchange_id_valid((*conn_ptr)->notify_exchange_id)) {
-        avs_coap_exchange_cancel(_anjay_connection_get_coap(
-                                         (*conn_ptr)->conn_ref),
-                                 (*conn_ptr)->notify_exchange_id);
-    }
-    assert(!avs_coap_exchange_id_valid((*conn_ptr)->notify_exchange_id));
-    assert(!(*conn_ptr)->serialization_state.membuf_stream);
-    assert(!(*conn_ptr)->serialization_state.out_ctx);
     AVS_RBTREE_ELEM(anjay_observation_t) observation =
             AVS_RBTREE_FIND((*conn_ptr)->observations,
                             _anjay_observation_query(token));
     if (observation) {
+        if (observation->in_flight) {
+            avs_coap_exchange_cancel(
+                    _anjay_connection_get_coap((*conn_ptr)->conn_ref),
+                    observation->in_flight->exchange_id);
+        }
+        assert(!observation->in_flight);
         delete_observation(conn_ptr, &observation);
     }
 }
@@ -806,53 +1060,132 @@ get_observation_path(const anjay_observation_t *observation) {
                                                      : MAKE_ROOT_PATH());
 }
 
+#ifdef ANJAY_OBSERVE_PERSISTENCE
+anjay_observe_connection_entry_t *
+_anjay_observe_find_or_create_connection(anjay_connection_ref_t ref) {
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            find_or_create_connection_state(ref);
+    return conn_ptr ? *conn_ptr : NULL;
+}
+
+void _anjay_observe_delete_connection_if_empty(anjay_connection_ref_t ref) {
+    AVS_LIST(anjay_observe_connection_entry_t) *conn_ptr =
+            find_connection_state(ref);
+    if (conn_ptr) {
+        delete_connection_if_empty(conn_ptr);
+    }
+}
+
+AVS_RBTREE_ELEM(anjay_observation_t) _anjay_observe_restore_observation(
+        anjay_observe_connection_entry_t *conn_state,
+        const avs_coap_token_t *token,
+        anjay_request_action_t action,
+        const anjay_uri_path_t *paths,
+        size_t paths_count,
+        avs_time_real_t last_confirmable,
+        const anjay_observe_persisted_value_t *last_sent) {
+    const paths_arg_t paths_arg = {
+        .type = PATHS_POINTER_ARRAY,
+        .paths = paths,
+        .count = paths_count
+    };
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            create_detached_observation(token, action, &paths_arg);
+    if (!observation) {
+        return NULL;
+    }
+    if (!(observation->last_sent = create_observation_value(
+                  &last_sent->details, last_sent->reliability_hint, observation,
+                  cast_to_const_batch_array(last_sent->values)))
+            || attach_new_observation(conn_state, observation)) {
+        clear_observation(conn_state, observation);
+        AVS_RBTREE_ELEM_DELETE_DETACHED(&observation);
+        return NULL;
+    }
+    observation->last_sent->timestamp = last_sent->timestamp;
+    observation->last_confirmable = last_confirmable;
+    return observation;
+}
+
+int _anjay_observe_restore_unsent_value(
+        anjay_observe_connection_entry_t *conn_state,
+        anjay_observation_t *observation,
+        const anjay_observe_persisted_value_t *value) {
+    // nothing is being sent before the connection is restored, so the value
+    // is never dropped and becomes the last unsent one
+    assert(!conn_state->in_flight);
+    int result = insert_new_value(conn_state, observation,
+                                  value->reliability_hint, &value->details,
+                                  cast_to_const_batch_array(value->values));
+    if (!result) {
+        observation->last_unsent->timestamp = value->timestamp;
+    }
+    return result;
+}
+#endif // ANJAY_OBSERVE_PERSISTENCE
+
+/**
+ * Returns the value to serialize after @p value in the payload of
+ * @p in_flight, or NULL if @p value is the last one. Batched values, if any,
+ * are serialized first, in order, followed by the main value.
+ */
+static const anjay_observation_value_t *
+next_serialized_value(const anjay_observe_in_flight_t *in_flight,
+                      const anjay_observation_value_t *value) {
+    if (value == in_flight->value) {
+        return NULL;
+    }
+    const anjay_observation_value_t *next = AVS_LIST_NEXT(value);
+    return next ? next : in_flight->value;
+}
+
 static int write_notify_payload(size_t payload_offset,
                                 void *payload_buf,
                                 size_t payload_buf_size,
                                 size_t *out_payload_chunk_size,
-                                void *conn_) {
-    anjay_observe_connection_entry_t *conn =
-            (anjay_observe_connection_entry_t *) conn_;
-    if (payload_offset != conn->serialization_state.expected_offset) {
+                                void *in_flight_) {
+    anjay_observe_in_flight_t *in_flight =
+            (anjay_observe_in_flight_t *) in_flight_;
+    anjay_observation_serialization_state_t *state =
+            &in_flight->serialization_state;
+    if (payload_offset != state->expected_offset) {
         anjay_log(DEBUG,
                   _("Server requested unexpected chunk of payload (expected "
                     "offset ") "%zu" _(", got ") "%zu" _(")"),
-                  conn->serialization_state.expected_offset, payload_offset);
+                  state->expected_offset, payload_offset);
         return -1;
     }
 
-    anjay_t *anjay = _anjay_from_server(conn->conn_ref.server);
-    anjay_observation_value_t *value = conn->unsent;
-    anjay_observation_t *observation = value->ref;
+    anjay_t *anjay = _anjay_from_server(in_flight->conn->conn_ref.server);
+    anjay_observation_t *observation = in_flight->value->ref;
 
     char *write_ptr = (char *) payload_buf;
     const char *end_ptr = write_ptr + payload_buf_size;
     while (true) {
         size_t bytes_read;
-        if (avs_is_err(avs_stream_read(conn->serialization_state.membuf_stream,
-                                       &bytes_read, NULL, write_ptr,
+        if (avs_is_err(avs_stream_read(state->membuf_stream, &bytes_read, NULL,
+                                       write_ptr,
                                        (size_t) (end_ptr - write_ptr)))) {
             return -1;
         }
         write_ptr += bytes_read;
-        if (write_ptr >= end_ptr || !conn->serialization_state.out_ctx) {
+        if (write_ptr >= end_ptr || !state->out_ctx) {
             break;
         }
         // NOTE: Access Control permissions have been checked during the
         // _anjay_dm_read_as_batch() stage, so we're "spoofing"
         // ANJAY_SSID_BOOTSTRAP as the permissions are checked now
         int result = _anjay_batch_data_output_entry(
-                anjay, value->values[conn->serialization_state.curr_value_idx],
-                ANJAY_SSID_BOOTSTRAP,
-                conn->serialization_state.serialization_time,
-                &conn->serialization_state.output_state,
-                conn->serialization_state.out_ctx);
-        if (!result && !conn->serialization_state.output_state) {
-            ++conn->serialization_state.curr_value_idx;
-            if (conn->serialization_state.curr_value_idx
-                    >= observation->paths_count) {
+                anjay, state->curr_value->values[state->curr_value_idx],
+                ANJAY_SSID_BOOTSTRAP, state->serialization_time,
+                &state->output_state, state->out_ctx);
+        if (!result && !state->output_state
+                && ++state->curr_value_idx >= observation->paths_count) {
+            state->curr_value_idx = 0;
+            if (!(state->curr_value = next_serialized_value(
+                          in_flight, state->curr_value))) {
                 result = _anjay_output_ctx_destroy_and_process_result(
-                        &conn->serialization_state.out_ctx, result);
+                        &state->out_ctx, result);
             }
         }
         if (result) {
@@ -860,7 +1193,7 @@ static int write_notify_payload(size_t payload_offset,
         }
     }
     *out_payload_chunk_size = (size_t) (write_ptr - (char *) payload_buf);
-    conn->serialization_state.expected_offset += *out_payload_chunk_size;
+    state->expected_offset += *out_payload_chunk_size;
     return 0;
 }
 
@@ -940,6 +1273,42 @@ static int read_observation_path(anjay_t *anjay,
     return result;
 }
 
+/**
+ * Variant of read_observation_path() used when notifying, that reuses values
+ * already read for other observations in the same scheduler pass.
+ */
+static int read_notification_path(anjay_t *anjay,
+                                  const anjay_uri_path_t *path,
+                                  anjay_request_action_t action,
+                                  anjay_ssid_t connection_ssid,
+                                  anjay_batch_t **out_batch) {
+    if (!is_read_cacheable(path)) {
+        return read_observation_path(anjay, path, action, connection_ssid,
+                                     out_batch);
+    }
+    AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t) entry =
+            find_read_cache_entry(&anjay->observe, path);
+    if (entry) {
+        int result = check_cached_read_allowed(anjay, path, connection_ssid);
+        if (result) {
+            return result;
+        }
+        const anjay_batch_t *batch = read_cache_entry_batch(entry);
+        if (!batch) {
+            anjay_log(ERROR, _("out of memory"));
+            return -1;
+        }
+        *out_batch = _anjay_batch_acquire(batch);
+        return 0;
+    }
+    int result = read_observation_path(anjay, path, action, connection_ssid,
+                                       out_batch);
+    if (!result && (entry = create_read_cache_entry(anjay, path))) {
+        entry->batch = _anjay_batch_acquire(*out_batch);
+    }
+    return result;
+}
+
 static int read_observation_values(anjay_t *anjay,
                                    const paths_arg_t *paths,
                                    anjay_request_action_t action,
@@ -1112,6 +1481,19 @@ process_ltgt(double threshold, double previous_value, double new_value) {
                || (previous_value >= threshold && new_value < threshold));
 }
 
+static bool has_numeric_filters(const anjay_dm_r_attributes_t *attrs) {
+    return !isnan(attrs->greater_than) || !isnan(attrs->less_than)
+           || !isnan(attrs->step);
+}
+
+static bool should_update_numeric(const anjay_dm_r_attributes_t *attrs,
+                                  double previous_numeric,
+                                  double new_numeric) {
+    return process_step(attrs, previous_numeric, new_numeric)
+           || process_ltgt(attrs->less_than, previous_numeric, new_numeric)
+           || process_ltgt(attrs->greater_than, previous_numeric, new_numeric);
+}
+
 static bool should_update(const anjay_uri_path_t *path,
                           const anjay_dm_r_attributes_t *attrs,
                           const anjay_batch_t *previous_value,
@@ -1127,23 +1509,102 @@ static bool should_update(const anjay_uri_path_t *path,
         new_numeric = _anjay_batch_data_numeric_value(new_value);
     }
     if (isnan(new_numeric) || isnan(previous_numeric)
-            || (isnan(attrs->greater_than) && isnan(attrs->less_than)
-                && isnan(attrs->step))) {
+            || !has_numeric_filters(attrs)) {
         // either previous or current value is not numeric, or none of lt/gt/st
         // attributes are set - notifying each value change
         return true;
     }
 
-    return process_step(attrs, previous_numeric, new_numeric)
-           || process_ltgt(attrs->less_than, previous_numeric, new_numeric)
-           || process_ltgt(attrs->greater_than, previous_numeric, new_numeric);
+    return should_update_numeric(attrs, previous_numeric, new_numeric);
+}
+
+/**
+ * Fast path for observations of a single numeric Resource with any of the
+ * lt/gt/st attributes set: the value is read straight into a number, and a
+ * batch is only created if the value passes the filters.
+ *
+ * On success, *out_batch is set to the new value, or left NULL if the value has
+ * been filtered out. Returns ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED if the fast
+ * path is not applicable; read_notification_path() shall be used then.
+ *
+ * Like read_notification_path(), the value is shared through the read cache.
+ */
+static int
+read_numeric_observation_value(anjay_t *anjay,
+                               const anjay_observation_t *observation,
+                               const anjay_dm_r_attributes_t *attrs,
+                               anjay_ssid_t connection_ssid,
+                               anjay_batch_t **out_batch) {
+    assert(out_batch && !*out_batch);
+    const anjay_uri_path_t *path = &observation->paths[0];
+    if (observation->paths_count != 1
+            || !_anjay_uri_path_has(path, ANJAY_ID_RID)
+            || !has_numeric_filters(attrs)) {
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+    double previous_numeric = _anjay_batch_data_numeric_value(
+            newest_value(observation)->values[0]);
+    if (isnan(previous_numeric)) {
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+
+    AVS_RBTREE_ELEM(anjay_observe_read_cache_entry_t) entry =
+            find_read_cache_entry(&anjay->observe, path);
+    anjay_batch_numeric_value_t value;
+    double new_numeric;
+    int result;
+    if (entry) {
+        if ((result = check_cached_read_allowed(anjay, path,
+                                                connection_ssid))) {
+            return result;
+        }
+        new_numeric = entry->batch
+                              ? _anjay_batch_data_numeric_value(entry->batch)
+                              : _anjay_batch_numeric_value_as_double(
+                                        &entry->numeric);
+    } else {
+        const anjay_dm_object_def_t *const *obj =
+                _anjay_dm_find_object_by_oid(anjay, path->ids[ANJAY_ID_OID]);
+        anjay_dm_path_info_t path_info;
+        if ((result = _anjay_dm_path_info(anjay, obj, path, &path_info))
+                || (result = _anjay_dm_read_numeric(anjay, obj, &path_info,
+                                                    connection_ssid, &value))) {
+            return result;
+        }
+        new_numeric = _anjay_batch_numeric_value_as_double(&value);
+        if (!isnan(new_numeric)
+                && (entry = create_read_cache_entry(anjay, path))) {
+            entry->numeric = value;
+        }
+    }
+
+    if (isnan(new_numeric)) {
+        return ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+    }
+    // NOTE: int(42) and double(42.0) are treated as equal here, unlike in
+    // _anjay_batch_values_equal()
+    if (new_numeric == previous_numeric
+            || !should_update_numeric(attrs, previous_numeric, new_numeric)) {
+        return 0;
+    }
+    if (entry) {
+        const anjay_batch_t *batch = read_cache_entry_batch(entry);
+        *out_batch = batch ? _anjay_batch_acquire(batch) : NULL;
+    } else {
+        *out_batch = _anjay_batch_from_numeric_value(&value);
+    }
+    if (!*out_batch) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    return 0;
 }
 
-static bool confirmable_required(const anjay_observe_connection_entry_t *conn) {
+static bool confirmable_required(const anjay_observe_connection_entry_t *conn,
+                                 const anjay_observation_t *observation) {
     anjay_t *anjay = _anjay_from_server(conn->conn_ref.server);
     anjay_socket_transport_t transport =
             _anjay_connection_transport(conn->conn_ref);
-    anjay_observation_t *observation = conn->unsent->ref;
     avs_time_real_t confirmable_necessary_at = avs_time_real_add(
             observation->last_confirmable,
             avs_time_duration_diff(
@@ -1152,8 +1613,11 @@ static bool confirmable_required(const anjay_observe_connection_entry_t *conn) {
     return !avs_time_real_before(avs_time_real_now(), confirmable_necessary_at);
 }
 
-static void value_sent(anjay_observe_connection_entry_t *conn_state) {
-    anjay_observation_value_t *sent = detach_first_unsent_value(conn_state);
+static void value_sent(anjay_observe_connection_entry_t *conn_state,
+                       anjay_observation_value_t *value) {
+    anjay_observation_value_t *prev;
+    anjay_observation_value_t *sent = detach_unsent_value(
+            conn_state, find_unsent_value_ptr(conn_state, value, &prev), prev);
     anjay_observation_t *observation = sent->ref;
     assert(AVS_LIST_SIZE(observation->last_sent) <= 1);
     delete_value(&observation->last_sent);
@@ -1178,17 +1642,25 @@ static bool notification_storing_enabled(anjay_connection_ref_t conn_ref) {
 }
 
 static void remove_all_unsent_values(anjay_observe_connection_entry_t *conn) {
-    while (conn->unsent && !is_error_value(conn->unsent)) {
-        AVS_LIST(anjay_observation_value_t) value =
-                detach_first_unsent_value(conn);
-        delete_value(&value);
+    AVS_LIST(anjay_observation_value_t) *value_ptr = &conn->unsent;
+    anjay_observation_value_t *prev = NULL;
+    while (*value_ptr && !is_error_value(*value_ptr)) {
+        if (is_value_in_flight(*value_ptr)) {
+            // will be handled when the delivery finishes
+            prev = *value_ptr;
+            AVS_LIST_ADVANCE_PTR(&value_ptr);
+        } else {
+            AVS_LIST(anjay_observation_value_t) value =
+                    detach_unsent_value(conn, value_ptr, prev);
+            delete_value(&value);
+        }
     }
 }
 
 static void schedule_all_triggers(anjay_observe_connection_entry_t *conn) {
     AVS_RBTREE_ELEM(anjay_observation_t) observation;
     AVS_RBTREE_FOREACH(observation, conn->observations) {
-        if (!observation->notify_task) {
+        if (!_anjay_timer_scheduled(&observation->notify_timer)) {
             _anjay_observe_schedule_pmax_trigger(conn, observation);
         }
     }
@@ -1201,7 +1673,7 @@ static bool connection_exists(anjay_t *anjay,
     return conn_ptr && *conn_ptr == conn;
 }
 
-static void flush_next_unsent(anjay_observe_connection_entry_t *conn);
+static void flush_unsent(anjay_observe_connection_entry_t *conn);
 
 static void on_network_error(anjay_connection_ref_t conn_ref) {
     anjay_log(WARNING, _("network communication error while sending Notify"));
@@ -1210,22 +1682,24 @@ static void on_network_error(anjay_connection_ref_t conn_ref) {
     }
 }
 
+static bool can_send_more(const anjay_observe_connection_entry_t *conn) {
+    return AVS_LIST_SIZE(conn->in_flight) < conn->observe->max_in_flight;
+}
+
 static void flush_send_queue_job(avs_sched_t *sched, const void *conn_ptr) {
     (void) sched;
     anjay_observe_connection_entry_t *conn =
             *(anjay_observe_connection_entry_t *const *) conn_ptr;
-    if (conn && conn->unsent
-            && !avs_coap_exchange_id_valid(conn->notify_exchange_id)
+    if (conn && conn->unsent && can_send_more(conn)
             && _anjay_connection_ready_for_outgoing_message(conn->conn_ref)
             && _anjay_connection_get_online_socket(conn->conn_ref)) {
-        flush_next_unsent(conn);
+        flush_unsent(conn);
     }
 }
 
 static int
 sched_flush_send_queue(AVS_LIST(anjay_observe_connection_entry_t) conn) {
-    if (conn->flush_task
-            || avs_coap_exchange_id_valid(conn->notify_exchange_id)) {
+    if (conn->flush_task || !can_send_more(conn)) {
         anjay_log(TRACE, _("skipping notification flush scheduling: flush "
                            "already scheduled"));
         return 0;
@@ -1288,19 +1762,15 @@ static void on_entry_flushed(anjay_observe_connection_entry_t *conn,
               AVS_COAP_STRERROR(err));
 }
 
-static void
-cleanup_serialization_state(anjay_observation_serialization_state_t *state) {
-    _anjay_output_ctx_destroy(&state->out_ctx);
-    avs_stream_cleanup(&state->membuf_stream);
-}
-
 static int
-initialize_serialization_state(anjay_observe_connection_entry_t *conn) {
-    assert(!conn->serialization_state.membuf_stream);
-    assert(!conn->serialization_state.out_ctx);
-    memset(&conn->serialization_state, 0, sizeof(conn->serialization_state));
-
-    anjay_observation_value_t *value = conn->unsent;
+initialize_serialization_state(anjay_observe_in_flight_t *in_flight) {
+    anjay_observation_serialization_state_t *state =
+            &in_flight->serialization_state;
+    assert(!state->membuf_stream);
+    assert(!state->out_ctx);
+    memset(state, 0, sizeof(*state));
+
+    anjay_observation_value_t *value = in_flight->value;
     anjay_observation_t *observation = value->ref;
 
     // DO NOT ATTEMPT TO INLINE get_observation_path() HERE.
@@ -1316,47 +1786,167 @@ initialize_serialization_state(anjay_observe_connection_entry_t *conn) {
     // link here. -- marian
     const anjay_uri_path_t root_path = get_observation_path(observation);
 
-    if (!(conn->serialization_state.membuf_stream = avs_stream_membuf_create())
-            || _anjay_output_dynamic_construct(
-                       &conn->serialization_state.out_ctx,
-                       conn->serialization_state.membuf_stream, &root_path,
-                       value->details.format, observation->action)) {
+    if (!(state->membuf_stream = avs_stream_membuf_create())
+            || _anjay_output_dynamic_construct(&state->out_ctx,
+                                               state->membuf_stream, &root_path,
+                                               value->details.format,
+                                               observation->action)) {
         return -1;
     }
-    conn->serialization_state.serialization_time = avs_time_real_now();
+    state->curr_value =
+            in_flight->batched ? in_flight->batched : in_flight->value;
+    state->serialization_time = avs_time_real_now();
     return 0;
 }
 
-static void
-handle_notify_delivery(avs_coap_ctx_t *coap, avs_error_t err, void *conn_) {
+static bool format_supports_timestamps(uint16_t format) {
+    return format == AVS_COAP_FORMAT_OMA_LWM2M_JSON
+           || format == AVS_COAP_FORMAT_SENML_CBOR;
+}
+
+static anjay_observation_value_t *
+next_unsent_value_of_observation(const anjay_observation_value_t *value) {
+    if (value == value->ref->last_unsent) {
+        return NULL;
+    }
+    AVS_LIST(anjay_observation_value_t) next = AVS_LIST_NEXT(value);
+    while (next->ref != value->ref) {
+        next = AVS_LIST_NEXT(next);
+    }
+    return next;
+}
+
+/**
+ * Applies anjay_observe_state_t::stored_notifications_mode to the values queued
+ * for the observation of @p value, which shall be the first of them. Unless
+ * all values are to be sent separately, older values are either deleted or (in
+ * the batched mode) detached onto the @p out_batched list, oldest first.
+ *
+ * @returns The value that shall actually be sent.
+ */
+static anjay_observation_value_t *
+coalesce_stored_values(anjay_observe_connection_entry_t *conn,
+                       anjay_observation_value_t *value,
+                       AVS_LIST(anjay_observation_value_t) *out_batched) {
+    assert(!*out_batched);
+    const anjay_stored_notifications_mode_t mode =
+            conn->observe->stored_notifications_mode;
+    if (mode == ANJAY_STORED_NOTIFICATIONS_SEND_ALL
+            || (mode == ANJAY_STORED_NOTIFICATIONS_SEND_BATCHED
+                && !format_supports_timestamps(value->details.format))) {
+        return value;
+    }
+    anjay_observation_value_t *next;
+    while (!is_error_value(value)
+           && (next = next_unsent_value_of_observation(value))
+           && !is_error_value(next)
+           && next->details.format == value->details.format) {
+        anjay_observation_value_t *prev;
+        AVS_LIST(anjay_observation_value_t) *older_ptr =
+                find_unsent_value_ptr(conn, value, &prev);
+        if (mode == ANJAY_STORED_NOTIFICATIONS_SEND_BATCHED) {
+            // batched values still count against the queue limit, but are
+            // taken out of the global queue along with the value being sent
+            AVS_LIST(anjay_observation_value_t) older =
+                    detach_from_unsent_list(conn, older_ptr, prev);
+            unlink_from_unsent_queue(older);
+            AVS_LIST_INSERT(out_batched, older);
+            AVS_LIST_ADVANCE_PTR(&out_batched);
+        } else {
+            AVS_LIST(anjay_observation_value_t) older =
+                    detach_unsent_value(conn, older_ptr, prev);
+            delete_value(&older);
+        }
+        value = next;
+    }
+    return value;
+}
+
+/**
+ * Puts the values batched into @p in_flight back into the unsent list, just
+ * before the main value, so that they can be sent again later. All of them,
+ * including the main value, are also linked back into the global queue of
+ * unsent values.
+ */
+static void requeue_in_flight_values(anjay_observe_in_flight_t *in_flight) {
+    anjay_observe_connection_entry_t *conn = in_flight->conn;
+    anjay_observation_value_t *prev;
+    AVS_LIST(anjay_observation_value_t) *insert_ptr =
+            find_unsent_value_ptr(conn, in_flight->value, &prev);
+    while (in_flight->batched) {
+        AVS_LIST(anjay_observation_value_t) value =
+                AVS_LIST_DETACH(&in_flight->batched);
+        assert(value->queued_in == conn);
+        relink_into_unsent_queue(value);
+        AVS_LIST_INSERT(insert_ptr, value);
+        AVS_LIST_ADVANCE_PTR(&insert_ptr);
+    }
+    relink_into_unsent_queue(in_flight->value);
+}
+
+/**
+ * Detaches @p in_flight from its connection entry and observation, and frees
+ * it along with any values batched into it. The main value being sent is left
+ * intact.
+ */
+static void delete_in_flight(anjay_observe_in_flight_t *in_flight) {
+    anjay_observe_connection_entry_t *conn = in_flight->conn;
+    assert(in_flight->value->ref->in_flight == in_flight);
+    in_flight->value->ref->in_flight = NULL;
+    cleanup_serialization_state(&in_flight->serialization_state);
+    delete_batched_values(in_flight);
+    AVS_LIST(anjay_observe_in_flight_t) *in_flight_ptr =
+            AVS_LIST_FIND_PTR(&conn->in_flight, in_flight);
+    assert(in_flight_ptr);
+    AVS_LIST_DELETE(in_flight_ptr);
+}
+
+static void handle_notify_delivery(avs_coap_ctx_t *coap,
+                                   avs_error_t err,
+                                   void *in_flight_) {
     (void) coap;
-    anjay_observe_connection_entry_t *conn =
-            (anjay_observe_connection_entry_t *) conn_;
+    anjay_observe_in_flight_t *in_flight =
+            (anjay_observe_in_flight_t *) in_flight_;
+    anjay_observe_connection_entry_t *conn = in_flight->conn;
+    anjay_observation_value_t *value = in_flight->value;
 
-    conn->notify_exchange_id = AVS_COAP_EXCHANGE_ID_INVALID;
-    cleanup_serialization_state(&conn->serialization_state);
+    if (avs_is_err(err)) {
+        requeue_in_flight_values(in_flight);
+    }
+    delete_in_flight(in_flight);
     if (avs_is_ok(err)) {
-        assert(!is_error_value(conn->unsent));
-        if (conn->unsent->reliability_hint
-                == AVS_COAP_NOTIFY_PREFER_CONFIRMABLE) {
-            conn->unsent->ref->last_confirmable = avs_time_real_now();
+        assert(!is_error_value(value));
+        if (value->reliability_hint == AVS_COAP_NOTIFY_PREFER_CONFIRMABLE) {
+            value->ref->last_confirmable = avs_time_real_now();
         }
-        value_sent(conn);
+        value_sent(conn, value);
     }
     on_entry_flushed(conn, err);
 }
 
-static void flush_next_unsent(anjay_observe_connection_entry_t *conn) {
-    assert(conn->unsent);
-    anjay_observation_t *observation = conn->unsent->ref;
-    anjay_msg_details_t details = conn->unsent->details;
+static avs_error_t send_unsent_value(anjay_observe_connection_entry_t *conn,
+                                     anjay_observation_value_t *value) {
+    anjay_observation_t *observation = value->ref;
+    assert(!observation->in_flight);
 
-    if (confirmable_required(conn)) {
-        conn->unsent->reliability_hint = AVS_COAP_NOTIFY_PREFER_CONFIRMABLE;
+    AVS_LIST(anjay_observe_in_flight_t) in_flight =
+            AVS_LIST_NEW_ELEMENT(anjay_observe_in_flight_t);
+    if (!in_flight) {
+        anjay_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
     }
+    in_flight->conn = conn;
+    in_flight->value = value =
+            coalesce_stored_values(conn, value, &in_flight->batched);
+    unlink_from_unsent_queue(value);
+    AVS_LIST_INSERT(&conn->in_flight, in_flight);
+    observation->in_flight = in_flight;
 
-    anjay_connection_ref_t conn_ref = conn->conn_ref;
-    avs_coap_ctx_t *coap = _anjay_connection_get_coap(conn_ref);
+    if (confirmable_required(conn, observation)) {
+        value->reliability_hint = AVS_COAP_NOTIFY_PREFER_CONFIRMABLE;
+    }
+
+    avs_coap_ctx_t *coap = _anjay_connection_get_coap(conn->conn_ref);
     assert(coap);
 
     // Note: if we are dealing with a non-composite Observe, we assert that the
@@ -1368,38 +1958,79 @@ static void flush_next_unsent(anjay_observe_connection_entry_t *conn) {
     // that there is any common root, so we use /.
     assert(observation->action != ANJAY_ACTION_READ
            || observation->paths_count == 1);
-    assert(!avs_coap_exchange_id_valid(conn->notify_exchange_id));
 
     avs_coap_response_header_t response = { 0 };
-    avs_error_t err = _anjay_coap_fill_response_header(&response, &details);
-    if (avs_is_err(err)) {
-        on_entry_flushed(conn, err);
-    } else {
-        avs_coap_payload_writer_t *payload_writer = NULL;
-        if (!is_error_value(conn->unsent)) {
-            payload_writer = write_notify_payload;
-            if (initialize_serialization_state(conn)) {
-                err = avs_errno(AVS_ENOMEM);
-            }
+    avs_error_t err =
+            _anjay_coap_fill_response_header(&response, &value->details);
+    avs_coap_payload_writer_t *payload_writer = NULL;
+    if (avs_is_ok(err) && !is_error_value(value)) {
+        payload_writer = write_notify_payload;
+        if (initialize_serialization_state(in_flight)) {
+            err = avs_errno(AVS_ENOMEM);
         }
-        if (avs_is_err(err)) {
-            on_entry_flushed(conn, err);
-        } else if (avs_is_err(
-                           (err = avs_coap_notify_async(
-                                    coap, &conn->notify_exchange_id,
+    }
+    if (avs_is_ok(err)) {
+        err = avs_coap_notify_async(coap, &in_flight->exchange_id,
                                     (avs_coap_observe_id_t) {
                                         .token = observation->token
                                     },
-                                    &response, conn->unsent->reliability_hint,
-                                    payload_writer, conn,
-                                    handle_notify_delivery, conn)))
-                   && connection_exists(_anjay_from_server(conn_ref.server),
-                                        conn)) {
+                                    &response, value->reliability_hint,
+                                    payload_writer, in_flight,
+                                    handle_notify_delivery, in_flight);
+    }
+    if (avs_is_err(err)
+            && connection_exists(_anjay_from_server(conn->conn_ref.server),
+                                 conn)) {
+        // NOTE: delivery handler is never called if avs_coap_notify_async()
+        // fails, so in_flight is still there
+        requeue_in_flight_values(in_flight);
+        delete_in_flight(in_flight);
+    }
+    avs_coap_options_cleanup(&response.options);
+    return err;
+}
+
+/**
+ * Returns the first queued value that may be sent right now, i.e. the first
+ * one whose observation does not have any other notification in flight.
+ */
+static anjay_observation_value_t *
+next_value_to_send(anjay_observe_connection_entry_t *conn) {
+    AVS_LIST(anjay_observation_value_t) value;
+    AVS_LIST_FOREACH(value, conn->unsent) {
+        if (!value->ref->in_flight) {
+            return value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Sends as many queued notifications as the in-flight window allows. The
+ * notifications are passed to the CoAP layer in queue order, which in case of
+ * CoAP/UDP additionally limits the number of outstanding Confirmable messages
+ * to NSTART.
+ */
+static void flush_unsent(anjay_observe_connection_entry_t *conn) {
+    assert(conn->unsent);
+    anjay_t *anjay = _anjay_from_server(conn->conn_ref.server);
+    anjay_connection_ref_t conn_ref = conn->conn_ref;
+    anjay_observation_value_t *value;
+    while (can_send_more(conn) && (value = next_value_to_send(conn))) {
+        avs_error_t err = send_unsent_value(conn, value);
+        if (!connection_exists(anjay, conn)) {
+            break;
+        }
+        if (avs_is_err(err)) {
             on_entry_flushed(conn, err);
-            cleanup_serialization_state(&conn->serialization_state);
+            break;
+        }
+        if (!_anjay_connection_get_online_socket(conn_ref)) {
+            // the delivery handler might have been called immediately, and
+            // detected a network error
+            break;
         }
     }
-    avs_coap_options_cleanup(&response.options);
     _anjay_connection_schedule_queue_mode_close(conn_ref);
 }
 
@@ -1416,14 +2047,23 @@ void _anjay_observe_interrupt(anjay_connection_ref_t ref) {
                   _anjay_server_ssid(ref.server), ref.conn_type);
         avs_sched_del(&(*conn_ptr)->flush_task);
     }
-    if (avs_coap_exchange_id_valid((*conn_ptr)->notify_exchange_id)) {
+    if ((*conn_ptr)->in_flight) {
         anjay_log(TRACE,
-                  _("Cancelling notification attempt for server SSID ") "%u" _(
+                  _("Cancelling notification attempts for server SSID ") "%u" _(
                           ", connection type ") "%d",
                   _anjay_server_ssid(ref.server), ref.conn_type);
-        avs_coap_exchange_cancel(_anjay_connection_get_coap(ref),
-                                 (*conn_ptr)->notify_exchange_id);
-        assert(!avs_coap_exchange_id_valid((*conn_ptr)->notify_exchange_id));
+        avs_coap_ctx_t *coap = _anjay_connection_get_coap(ref);
+        while ((*conn_ptr)->in_flight) {
+            const avs_coap_exchange_id_t exchange_id =
+                    (*conn_ptr)->in_flight->exchange_id;
+            // handle_notify_delivery() is called from inside, and removes the
+            // element from the in_flight list
+            avs_coap_exchange_cancel(coap, exchange_id);
+            assert(!(*conn_ptr)->in_flight
+                   || !avs_coap_exchange_id_equal(
+                              (*conn_ptr)->in_flight->exchange_id,
+                              exchange_id));
+        }
     }
 }
 
@@ -1472,11 +2112,23 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
             goto finish;
         }
 
+        bool pmax_expired = has_pmax_expired(newest_value(observation),
+                                             &attrs.standard.common);
+        bool filtered_out = false;
         if (has_epmin_expired(newest_value(observation)->values[i],
                               &attrs.standard.common)) {
-            if ((result = read_observation_path(anjay, &observation->paths[i],
+            result = ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED;
+            if (!pmax_expired) {
+                result = read_numeric_observation_value(
+                        anjay, observation, &attrs.standard, ssid, &batches[i]);
+                filtered_out = (!result && !batches[i]);
+            }
+            if (result == ANJAY_OUTCTXERR_METHOD_NOT_IMPLEMENTED) {
+                result = read_notification_path(anjay, &observation->paths[i],
                                                 observation->action, ssid,
-                                                &batches[i]))) {
+                                                &batches[i]);
+            }
+            if (result) {
                 anjay_log(ERROR,
                           _("Could not read path ") "%s" _(" for notifying"),
                           ANJAY_DEBUG_MAKE_PATH(&observation->paths[i]));
@@ -1493,9 +2145,8 @@ update_notification_value(anjay_observe_connection_entry_t *conn_state,
                     _anjay_batch_acquire(newest_value(observation)->values[i]);
         }
 
-        if (!should_update_batch
-                && (has_pmax_expired(newest_value(observation),
-                                     &attrs.standard.common)
+        if (!should_update_batch && !filtered_out
+                && (pmax_expired
                     || should_update(&observation->paths[i], &attrs.standard,
                                      newest_value(observation)->values[i],
                                      batches[i]))) {
@@ -1530,36 +2181,44 @@ finish:
     return result;
 }
 
-static void trigger_observe(avs_sched_t *sched, const void *args_) {
-    (void) sched;
-    const trigger_observe_args_t *args = (const trigger_observe_args_t *) args_;
-    assert(args->conn_state);
-    assert(args->observation);
+static void trigger_observe(anjay_timer_wheel_t *wheel, anjay_timer_t *timer) {
+    anjay_observe_connection_entry_t *conn_state =
+            AVS_CONTAINER_OF(wheel, anjay_observe_connection_entry_t,
+                             notify_timers);
+    anjay_observation_t *observation =
+            AVS_CONTAINER_OF(timer, anjay_observation_t, notify_timer);
     bool ready_for_notifying = _anjay_connection_ready_for_outgoing_message(
-            args->conn_state->conn_ref);
+            conn_state->conn_ref);
     if (ready_for_notifying
-            || notification_storing_enabled(args->conn_state->conn_ref)) {
-        int result =
-                update_notification_value(args->conn_state, args->observation);
+            || notification_storing_enabled(conn_state->conn_ref)) {
+        int result = update_notification_value(conn_state, observation);
         if (result) {
-            insert_error(args->conn_state, args->observation, result);
+            insert_error(conn_state, observation, result);
         }
     }
-    if (ready_for_notifying && args->conn_state->unsent
-            && !avs_coap_exchange_id_valid(
-                       args->conn_state->notify_exchange_id)) {
-        avs_sched_del(&args->conn_state->flush_task);
-        assert(!args->conn_state->flush_task);
-        if (_anjay_connection_get_online_socket(args->conn_state->conn_ref)) {
-            flush_next_unsent(args->conn_state);
-        } else if (_anjay_server_registration_info(
-                           args->conn_state->conn_ref.server)
+    if (ready_for_notifying && conn_state->unsent
+            && can_send_more(conn_state)) {
+        avs_sched_del(&conn_state->flush_task);
+        assert(!conn_state->flush_task);
+        if (_anjay_connection_get_online_socket(conn_state->conn_ref)) {
+            flush_unsent(conn_state);
+        } else if (_anjay_server_registration_info(conn_state->conn_ref.server)
                            ->queue_mode) {
-            _anjay_connection_bring_online(args->conn_state->conn_ref);
+            _anjay_connection_bring_online(conn_state->conn_ref);
             // once the connection is up, _anjay_observe_sched_flush()
             // will be called; we're done here
-        } else if (!notification_storing_enabled(args->conn_state->conn_ref)) {
-            remove_all_unsent_values(args->conn_state);
+        } else if (!notification_storing_enabled(conn_state->conn_ref)) {
+            remove_all_unsent_values(conn_state);
+        }
+    }
+}
+
+void _anjay_observe_invalidate_attrs_cache(anjay_observe_state_t *observe) {
+    AVS_LIST(anjay_observe_connection_entry_t) connection;
+    AVS_LIST_FOREACH(connection, observe->connection_entries) {
+        AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path_entry;
+        AVS_RBTREE_FOREACH(path_entry, connection->observed_paths) {
+            path_entry->attrs_cached = false;
         }
     }
 }
@@ -1567,13 +2226,16 @@ static void trigger_observe(avs_sched_t *sched, const void *args_) {
 static anjay_dm_oi_attributes_t
 get_oi_attributes(anjay_observe_connection_entry_t *connection,
                   anjay_observe_path_entry_t *path_entry) {
-    anjay_dm_internal_r_attrs_t attrs = ANJAY_DM_INTERNAL_R_ATTRS_EMPTY;
-    if (get_effective_attrs(_anjay_from_server(connection->conn_ref.server),
-                            &attrs, &path_entry->path,
-                            _anjay_server_ssid(connection->conn_ref.server))) {
-        return ANJAY_DM_OI_ATTRIBUTES_EMPTY;
+    if (!path_entry->attrs_cached) {
+        if (get_effective_attrs(
+                    _anjay_from_server(connection->conn_ref.server),
+                    &path_entry->attrs, &path_entry->path,
+                    _anjay_server_ssid(connection->conn_ref.server))) {
+            return ANJAY_DM_OI_ATTRIBUTES_EMPTY;
+        }
+        path_entry->attrs_cached = true;
     }
-    return attrs.standard.common;
+    return path_entry->attrs.standard.common;
 }
 
 static int notify_path_changed(anjay_observe_connection_entry_t *connection,
@@ -1729,6 +2391,8 @@ int _anjay_observe_notify(anjay_t *anjay,
                           const anjay_uri_path_t *path,
                           anjay_ssid_t ssid,
                           bool invert_ssid_match) {
+    // values read earlier in this scheduler pass might be outdated now
+    clear_read_cache(&anjay->observe);
     // This extra level of indirection is required to be able to mock
     // notify_path_changed in unit tests.
     // Hopefully compilers will inline it in production builds.
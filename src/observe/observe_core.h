@@ -20,6 +20,8 @@
 #include <avsystem/commons/persistence.h>
 #include <avsystem/commons/rbtree.h>
 
+#include <avsystem/coap/config.h>
+
 #include "../coap/msg_details.h"
 #include "../io/batch_builder.h"
 #include "../servers.h"
@@ -32,21 +34,99 @@ typedef struct anjay_observation_struct anjay_observation_t;
 typedef struct anjay_observe_connection_entry_struct
         anjay_observe_connection_entry_t;
 
+#    if defined(WITH_AVS_PERSISTENCE) \
+            && defined(WITH_AVS_COAP_OBSERVE_PERSISTENCE)
+#        define ANJAY_OBSERVE_PERSISTENCE
+typedef struct anjay_observe_restored_server_struct
+        anjay_observe_restored_server_t;
+#    endif // defined(WITH_AVS_PERSISTENCE) &&
+           // defined(WITH_AVS_COAP_OBSERVE_PERSISTENCE)
+
 typedef enum {
     NOTIFY_QUEUE_UNLIMITED,
     NOTIFY_QUEUE_DROP_OLDEST
 } notify_queue_limit_mode_t;
 
+/**
+ * Links of a circular, doubly linked, intrusive list.
+ */
+typedef struct anjay_observe_unsent_link_struct {
+    struct anjay_observe_unsent_link_struct *prev;
+    struct anjay_observe_unsent_link_struct *next;
+} anjay_observe_unsent_link_t;
+
+/**
+ * Value of a single path read from the data model while notifying. It is
+ * shared by all observations of that path, on all connections, that are
+ * triggered in the same scheduler pass, so that the read handler is called only
+ * once for all of them.
+ */
+typedef struct {
+    anjay_uri_path_t path;
+    // NULL if the value has only been read through the numeric fast path
+    anjay_batch_t *batch;
+    // only meaningful if batch is NULL
+    anjay_batch_numeric_value_t numeric;
+} anjay_observe_read_cache_entry_t;
+
 typedef struct {
     AVS_LIST(anjay_observe_connection_entry_t) connection_entries;
     bool confirmable_notifications;
 
     notify_queue_limit_mode_t notify_queue_limit_mode;
     size_t notify_queue_limit;
+
+    /**
+     * Maximum number of notifications that may be in flight at the same time
+     * for a single connection. Always at least 1.
+     */
+    size_t max_in_flight;
+
+    anjay_stored_notifications_mode_t stored_notifications_mode;
+
+    /** Tick length of the connections' notification timer wheels. */
+    avs_time_duration_t timer_granularity;
+
+    /**
+     * Sentinel of a list that links all values queued in the unsent lists of
+     * all connection entries, in order of insertion, except the ones that are
+     * currently being sent. The element following the sentinel is thus the
+     * oldest notification that may be dropped.
+     */
+    anjay_observe_unsent_link_t unsent_queue;
+    /**
+     * Total number of stored values, i.e. the ones linked in unsent_queue,
+     * plus the ones currently being sent, including values batched into them.
+     */
+    size_t unsent_count;
+
+    /**
+     * Values read for notifications during the current scheduler pass, keyed
+     * by path. NULL while empty. Cleared by read_cache_job, which is scheduled
+     * when the first entry is added, and whenever anything in the data model
+     * is notified as changed.
+     */
+    AVS_RBTREE(anjay_observe_read_cache_entry_t) read_cache;
+    avs_sched_handle_t read_cache_job;
+
+#    ifdef ANJAY_OBSERVE_PERSISTENCE
+    /**
+     * State read by anjay_observe_restore() that has not been applied yet.
+     * Parts of each element are consumed as connections
+     * are brought online and registrations are resumed.
+     */
+    AVS_LIST(anjay_observe_restored_server_t) restored;
+#    endif // ANJAY_OBSERVE_PERSISTENCE
 } anjay_observe_state_t;
 
 typedef struct {
     anjay_observation_t *const ref;
+    // Connection entry in which unsent list the value is queued, and links in
+    // anjay_observe_state_t::unsent_queue. Only meaningful while the value is
+    // queued, i.e. not after it is moved to anjay_observation_t::last_sent.
+    // The links are NULL while the value is being sent.
+    anjay_observe_connection_entry_t *queued_in;
+    anjay_observe_unsent_link_t unsent_link;
     anjay_msg_details_t details;
     avs_coap_notify_reliability_hint_t reliability_hint;
     avs_time_real_t timestamp;
@@ -61,7 +141,11 @@ typedef struct {
 
 void _anjay_observe_init(anjay_observe_state_t *observe,
                          bool confirmable_notifications,
-                         size_t stored_notification_limit);
+                         size_t stored_notification_limit,
+                         size_t max_notifications_in_flight,
+                         anjay_stored_notifications_mode_t
+                                 stored_notifications_mode,
+                         avs_time_duration_t timer_granularity);
 
 void _anjay_observe_cleanup(anjay_observe_state_t *observe);
 
@@ -78,6 +162,34 @@ int _anjay_observe_notify(anjay_t *anjay,
                           anjay_ssid_t ssid,
                           bool invert_ssid_match);
 
+/**
+ * Drops effective attributes cached for all observed paths. Shall be called
+ * whenever the attributes might have changed, e.g. after Write-Attributes or
+ * a change to the Server object, or presence of Object Instances.
+ */
+void _anjay_observe_invalidate_attrs_cache(anjay_observe_state_t *observe);
+
+#    ifdef ANJAY_OBSERVE_PERSISTENCE
+/**
+ * Restores observations persisted for the connection referenced by @p ref ,
+ * if anjay_observe_restore() has been called and not all of the restored
+ * state has been applied yet. Shall be called when the CoAP context of the
+ * connection has just been created, before a socket is assigned to it.
+ */
+void _anjay_observe_restore_connection(anjay_connection_ref_t ref);
+
+/**
+ * Replaces the registration information of @p server with one read by
+ * anjay_observe_restore(), if any, so that an Update is sent instead of
+ * Register. Shall be called when the server's primary connection is brought
+ * up, before its registration is validated.
+ */
+void _anjay_observe_resume_registration(anjay_server_info_t *server);
+#    else // ANJAY_OBSERVE_PERSISTENCE
+#        define _anjay_observe_restore_connection(...) ((void) 0)
+#        define _anjay_observe_resume_registration(...) ((void) 0)
+#    endif // ANJAY_OBSERVE_PERSISTENCE
+
 #    ifdef WITH_OBSERVATION_STATUS
 anjay_resource_observation_status_t _anjay_observe_status(anjay_t *anjay,
                                                           anjay_oid_t oid,
@@ -92,6 +204,9 @@ anjay_resource_observation_status_t _anjay_observe_status(anjay_t *anjay,
 #    define _anjay_observe_gc(...) ((void) 0)
 #    define _anjay_observe_interrupt(...) ((void) 0)
 #    define _anjay_observe_sched_flush(...) 0
+#    define _anjay_observe_invalidate_attrs_cache(...) ((void) 0)
+#    define _anjay_observe_restore_connection(...) ((void) 0)
+#    define _anjay_observe_resume_registration(...) ((void) 0)
 
 #    ifdef WITH_OBSERVATION_STATUS
 #        define _anjay_observe_status(...)         \
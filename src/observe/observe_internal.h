@@ -18,17 +18,23 @@
 #define ANJAY_OBSERVE_INTERNAL_H
 
 #include "observe_core.h"
+#include "timer_wheel.h"
 
 #include <avsystem/coap/code.h>
 
+#include <anjay_modules/dm/attributes.h>
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
+typedef struct anjay_observe_in_flight_struct anjay_observe_in_flight_t;
+
 struct anjay_observation_struct {
     const avs_coap_token_t token;
 
     const anjay_request_action_t action;
 
-    avs_sched_handle_t notify_task;
+    // element of anjay_observe_connection_entry_t::notify_timers
+    anjay_timer_t notify_timer;
     avs_time_real_t last_confirmable;
 
     // last_sent has ALWAYS EXACTLY one element,
@@ -43,6 +49,12 @@ struct anjay_observation_struct {
     // to this resource+format or not)
     AVS_LIST(anjay_observation_value_t) last_unsent;
 
+    // Notification currently being delivered for this observation, if any.
+    // There is at most one per observation, so that notifications are always
+    // delivered in order - the value being sent is thus always the first one
+    // in the unsent list that refers to this observation.
+    anjay_observe_in_flight_t *in_flight;
+
     const size_t paths_count;
     const anjay_uri_path_t paths[];
 };
@@ -53,6 +65,12 @@ typedef struct {
     // List of observations (pointers to elements inside
     // anjay_observe_connection_entry_t::observations) that include "path"
     AVS_LIST(AVS_RBTREE_ELEM(anjay_observation_t)) refs;
+
+    // Effective attributes of "path" for the server this entry belongs to,
+    // valid only if attrs_cached is true. Reset by
+    // _anjay_observe_invalidate_attrs_cache().
+    bool attrs_cached;
+    anjay_dm_internal_r_attrs_t attrs;
 } anjay_observe_path_entry_t;
 
 typedef struct {
@@ -60,18 +78,40 @@ typedef struct {
     anjay_output_ctx_t *out_ctx;
     size_t expected_offset;
     avs_time_real_t serialization_time;
+    // value currently being serialized - either one of the batched values or
+    // the main one, see anjay_observe_in_flight_t
+    const anjay_observation_value_t *curr_value;
     size_t curr_value_idx;
     const anjay_batch_data_output_state_t *output_state;
 } anjay_observation_serialization_state_t;
 
+struct anjay_observe_in_flight_struct {
+    anjay_observe_connection_entry_t *conn;
+    // element of anjay_observe_connection_entry_t::unsent being sent;
+    // it is moved to anjay_observation_t::last_sent after successful delivery
+    anjay_observation_value_t *value;
+    // older values of the same observation, detached from the unsent list and
+    // from anjay_observe_state_t::unsent_queue, but still counted as queued,
+    // that are sent in the same payload before value; only used with
+    // ANJAY_STORED_NOTIFICATIONS_SEND_BATCHED
+    AVS_LIST(anjay_observation_value_t) batched;
+    avs_coap_exchange_id_t exchange_id;
+    anjay_observation_serialization_state_t serialization_state;
+};
+
 struct anjay_observe_connection_entry_struct {
     const anjay_connection_ref_t conn_ref;
+    anjay_observe_state_t *observe;
 
     AVS_RBTREE(anjay_observation_t) observations;
     AVS_RBTREE(anjay_observe_path_entry_t) observed_paths;
+    // notify_timer of all observations, so that all of them that expire at
+    // the same time are triggered in a single scheduler job
+    anjay_timer_wheel_t notify_timers;
     avs_sched_handle_t flush_task;
-    avs_coap_exchange_id_t notify_exchange_id;
-    anjay_observation_serialization_state_t serialization_state;
+    // Notifications passed to CoAP layer whose delivery has not yet been
+    // confirmed; up to anjay_observe_state_t::max_in_flight elements
+    AVS_LIST(anjay_observe_in_flight_t) in_flight;
 
     AVS_LIST(anjay_observation_value_t) unsent;
     // pointer to the last element of unsent
@@ -105,6 +145,54 @@ int _anjay_observe_schedule_pmax_trigger(
 
 void _anjay_observe_cancel_handler(avs_coap_observe_id_t id, void *ref_ptr);
 
+#ifdef ANJAY_OBSERVE_PERSISTENCE
+/**
+ * Contents of an anjay_observation_value_t, as read from persistent storage.
+ */
+typedef struct {
+    anjay_msg_details_t details;
+    avs_coap_notify_reliability_hint_t reliability_hint;
+    avs_time_real_t timestamp;
+    // Array of anjay_observation_t::paths_count elements, or NULL if details
+    // describe an error value
+    anjay_batch_t **values;
+} anjay_observe_persisted_value_t;
+
+anjay_observe_connection_entry_t *
+_anjay_observe_find_or_create_connection(anjay_connection_ref_t ref);
+
+void _anjay_observe_delete_connection_if_empty(anjay_connection_ref_t ref);
+
+/**
+ * Creates a new observation with @p last_sent as its last sent value and
+ * inserts it into @p conn_state . Batches referenced by @p last_sent are
+ * acquired, not moved.
+ *
+ * @returns The newly created observation, or NULL in case of error.
+ */
+AVS_RBTREE_ELEM(anjay_observation_t) _anjay_observe_restore_observation(
+        anjay_observe_connection_entry_t *conn_state,
+        const avs_coap_token_t *token,
+        anjay_request_action_t action,
+        const anjay_uri_path_t *paths,
+        size_t paths_count,
+        avs_time_real_t last_confirmable,
+        const anjay_observe_persisted_value_t *last_sent);
+
+/**
+ * Appends @p value to the unsent values of @p observation , honoring the
+ * limit of stored notifications.
+ */
+int _anjay_observe_restore_unsent_value(
+        anjay_observe_connection_entry_t *conn_state,
+        anjay_observation_t *observation,
+        const anjay_observe_persisted_value_t *value);
+
+void _anjay_observe_restored_cleanup(anjay_observe_state_t *observe);
+#else // ANJAY_OBSERVE_PERSISTENCE
+#    define _anjay_observe_restored_cleanup(...) ((void) 0)
+#endif // ANJAY_OBSERVE_PERSISTENCE
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif /* ANJAY_OBSERVE_INTERNAL_H */
@@ -0,0 +1,678 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <avsystem/commons/errno.h>
+#include <avsystem/commons/memory.h>
+#include <avsystem/commons/stream/stream_inbuf.h>
+#include <avsystem/commons/stream/stream_membuf.h>
+
+#include <avsystem/coap/observe.h>
+
+#include <anjay/core.h>
+
+#include "../anjay_core.h"
+#include "../servers_utils.h"
+
+#define ANJAY_OBSERVE_SOURCE
+
+#include "../servers_inactive.h"
+
+#ifdef WITH_OBSERVE
+#    include "observe_internal.h"
+#endif // WITH_OBSERVE
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef ANJAY_OBSERVE_PERSISTENCE
+
+static const char *MAGIC = "OBS";
+
+typedef enum {
+    OBSERVE_PERSISTENCE_VERSION_0 = 0,
+    OBSERVE_PERSISTENCE_VERSION_CURRENT = OBSERVE_PERSISTENCE_VERSION_0
+} observe_persistence_version_t;
+
+static const uint8_t SUPPORTED_VERSIONS[] = { OBSERVE_PERSISTENCE_VERSION_0 };
+
+/**
+ * Observe state of a single connection, serialized as a self-contained blob.
+ * It is parsed only when the connection is brought online, as avs_coap only
+ * allows restoring observations into a CoAP context without a socket.
+ */
+typedef struct {
+    anjay_connection_type_t conn_type;
+    void *data;
+    size_t size;
+} restored_connection_t;
+
+struct anjay_observe_restored_server_struct {
+    anjay_ssid_t ssid;
+    // false once the registration has been resumed
+    bool registration_pending;
+    anjay_registration_info_t registration_info;
+    AVS_LIST(restored_connection_t) connections;
+};
+
+typedef struct {
+    anjay_observe_persisted_value_t value;
+    size_t values_count;
+} restored_value_t;
+
+static void restored_server_cleanup(anjay_observe_restored_server_t *server) {
+    _anjay_registration_info_cleanup(&server->registration_info);
+    AVS_LIST_CLEAR(&server->connections) {
+        avs_free(server->connections->data);
+    }
+}
+
+static void
+restored_servers_clear(AVS_LIST(anjay_observe_restored_server_t) *servers) {
+    AVS_LIST_CLEAR(servers) {
+        restored_server_cleanup(*servers);
+    }
+}
+
+void _anjay_observe_restored_cleanup(anjay_observe_state_t *observe) {
+    restored_servers_clear(&observe->restored);
+}
+
+static AVS_LIST(anjay_observe_restored_server_t) *
+find_restored_server(anjay_observe_state_t *observe, anjay_ssid_t ssid) {
+    AVS_LIST(anjay_observe_restored_server_t) *server_ptr;
+    AVS_LIST_FOREACH_PTR(server_ptr, &observe->restored) {
+        if ((*server_ptr)->ssid == ssid) {
+            return server_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void delete_restored_server_if_consumed(
+        AVS_LIST(anjay_observe_restored_server_t) *server_ptr) {
+    if (!(*server_ptr)->registration_pending && !(*server_ptr)->connections) {
+        restored_server_cleanup(*server_ptr);
+        AVS_LIST_DELETE(server_ptr);
+    }
+}
+
+//// COMMON PRIMITIVES /////////////////////////////////////////////////////////
+
+static avs_error_t handle_token(avs_persistence_context_t *ctx,
+                                avs_coap_token_t *token) {
+    avs_error_t err = avs_persistence_u8(ctx, &token->size);
+    if (avs_is_ok(err) && token->size > AVS_COAP_MAX_TOKEN_LENGTH) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    if (avs_is_ok(err)) {
+        err = avs_persistence_bytes(ctx, token->bytes, token->size);
+    }
+    return err;
+}
+
+static avs_error_t persist_value(avs_persistence_context_t *ctx,
+                                 const anjay_observation_value_t *value) {
+    uint8_t msg_code = value->details.msg_code;
+    uint16_t format = value->details.format;
+    uint8_t reliability_hint = (uint8_t) value->reliability_hint;
+    avs_time_real_t timestamp = value->timestamp;
+    const bool is_error = _anjay_observe_is_error_details(&value->details);
+    uint32_t values_count = is_error ? 0 : (uint32_t) value->ref->paths_count;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_u8(ctx, &msg_code)))
+            || avs_is_err((err = avs_persistence_u16(ctx, &format)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &reliability_hint)))
+            || avs_is_err((err = _anjay_persistence_time_real(ctx, &timestamp)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &values_count))));
+    for (uint32_t i = 0; avs_is_ok(err) && i < values_count; ++i) {
+        err = _anjay_batch_persist(ctx, value->values[i]);
+    }
+    return err;
+}
+
+static void restored_value_cleanup(restored_value_t *value) {
+    if (value->value.values) {
+        for (size_t i = 0; i < value->values_count; ++i) {
+            if (value->value.values[i]) {
+                _anjay_batch_release(&value->value.values[i]);
+            }
+        }
+        avs_free(value->value.values);
+        value->value.values = NULL;
+    }
+}
+
+static avs_error_t restore_value(avs_persistence_context_t *ctx,
+                                 restored_value_t *out_value) {
+    memset(out_value, 0, sizeof(*out_value));
+    uint8_t reliability_hint;
+    uint32_t values_count;
+    avs_error_t err;
+    if (avs_is_err((err = avs_persistence_u8(
+                            ctx, &out_value->value.details.msg_code)))
+            || avs_is_err((err = avs_persistence_u16(
+                                   ctx, &out_value->value.details.format)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &reliability_hint)))
+            || avs_is_err((err = _anjay_persistence_time_real(
+                                   ctx, &out_value->value.timestamp)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &values_count)))) {
+        return err;
+    }
+    out_value->value.reliability_hint =
+            (avs_coap_notify_reliability_hint_t) reliability_hint;
+    if (_anjay_observe_is_error_details(&out_value->value.details)
+            != !values_count) {
+        return avs_errno(AVS_EBADMSG);
+    }
+    if (!values_count) {
+        return AVS_OK;
+    }
+    if (!(out_value->value.values = (anjay_batch_t **) avs_calloc(
+                  values_count, sizeof(anjay_batch_t *)))) {
+        anjay_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    out_value->values_count = values_count;
+    for (size_t i = 0; avs_is_ok(err) && i < values_count; ++i) {
+        err = _anjay_batch_restore(ctx, &out_value->value.values[i]);
+    }
+    if (avs_is_err(err)) {
+        restored_value_cleanup(out_value);
+    }
+    return err;
+}
+
+static bool value_matches_observation(const restored_value_t *value,
+                                      size_t paths_count) {
+    return !value->values_count || value->values_count == paths_count;
+}
+
+//// PERSIST ///////////////////////////////////////////////////////////////////
+
+static avs_error_t persist_observation(avs_persistence_context_t *ctx,
+                                       avs_coap_ctx_t *coap,
+                                       const anjay_observation_t *observation) {
+    avs_coap_token_t token = observation->token;
+    uint8_t action = (uint8_t) observation->action;
+    uint32_t paths_count = (uint32_t) observation->paths_count;
+    avs_time_real_t last_confirmable = observation->last_confirmable;
+    avs_error_t err;
+    (void) (avs_is_err((err = handle_token(ctx, &token)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &action)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &paths_count))));
+    for (uint32_t i = 0; avs_is_ok(err) && i < paths_count; ++i) {
+        anjay_uri_path_t path = observation->paths[i];
+        err = _anjay_persistence_uri_path(ctx, &path);
+    }
+    (void) (avs_is_err(err)
+            || avs_is_err((err = _anjay_persistence_time_real(
+                                   ctx, &last_confirmable)))
+            || avs_is_err((err = persist_value(ctx, observation->last_sent)))
+            || avs_is_err((err = avs_coap_observe_persist(
+                                   coap,
+                                   (avs_coap_observe_id_t) {
+                                       .token = token
+                                   },
+                                   ctx))));
+    return err;
+}
+
+static avs_error_t
+persist_unsent_value(avs_persistence_context_t *ctx,
+                     const anjay_observation_value_t *value) {
+    avs_coap_token_t token = value->ref->token;
+    avs_error_t err;
+    (void) (avs_is_err((err = handle_token(ctx, &token)))
+            || avs_is_err((err = persist_value(ctx, value))));
+    return err;
+}
+
+static avs_error_t
+persist_connection_data(avs_persistence_context_t *ctx,
+                        const anjay_observe_connection_entry_t *conn) {
+    avs_coap_ctx_t *coap = _anjay_connection_get_coap(conn->conn_ref);
+    uint32_t count = (uint32_t) AVS_RBTREE_SIZE(conn->observations);
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    AVS_RBTREE_ELEM(anjay_observation_t) observation;
+    AVS_RBTREE_FOREACH(observation, conn->observations) {
+        if (avs_is_err(err)) {
+            return err;
+        }
+        err = persist_observation(ctx, coap, observation);
+    }
+
+    // Notifications being delivered are stored as unsent. Values batched into
+    // them are older than anything left in the unsent list, so they go first.
+    count = (uint32_t) AVS_LIST_SIZE(conn->unsent);
+    AVS_LIST(anjay_observe_in_flight_t) in_flight;
+    AVS_LIST_FOREACH(in_flight, conn->in_flight) {
+        count += (uint32_t) AVS_LIST_SIZE(in_flight->batched);
+    }
+    if (avs_is_err(err)
+            || avs_is_err((err = avs_persistence_u32(ctx, &count)))) {
+        return err;
+    }
+    AVS_LIST_FOREACH(in_flight, conn->in_flight) {
+        AVS_LIST(anjay_observation_value_t) value;
+        AVS_LIST_FOREACH(value, in_flight->batched) {
+            if (avs_is_err((err = persist_unsent_value(ctx, value)))) {
+                return err;
+            }
+        }
+    }
+    AVS_LIST(anjay_observation_value_t) value;
+    AVS_LIST_FOREACH(value, conn->unsent) {
+        if (avs_is_err((err = persist_unsent_value(ctx, value)))) {
+            return err;
+        }
+    }
+    return AVS_OK;
+}
+
+static avs_error_t persist_connection(avs_persistence_context_t *ctx,
+                                      const anjay_observe_connection_entry_t
+                                              *conn) {
+    avs_stream_t *membuf = avs_stream_membuf_create();
+    if (!membuf) {
+        anjay_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    avs_persistence_context_t blob_ctx =
+            avs_persistence_store_context_create(membuf);
+    uint8_t conn_type = (uint8_t) conn->conn_ref.conn_type;
+    void *data = NULL;
+    size_t size = 0;
+    avs_error_t err;
+    (void) (avs_is_err((err = persist_connection_data(&blob_ctx, conn)))
+            || avs_is_err((err = avs_stream_membuf_take_ownership(
+                                   membuf, &data, &size)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &conn_type)))
+            || avs_is_err((err = avs_persistence_sized_buffer(ctx, &data,
+                                                              &size))));
+    avs_free(data);
+    avs_stream_cleanup(&membuf);
+    return err;
+}
+
+static bool
+should_persist_connection(const anjay_observe_connection_entry_t *conn,
+                          anjay_server_info_t *server) {
+    // a connection without a CoAP context has no observations at CoAP level
+    return conn->conn_ref.server == server
+           && _anjay_connection_get_coap(conn->conn_ref);
+}
+
+typedef struct {
+    avs_persistence_context_t *ctx;
+    avs_error_t err;
+} persist_servers_args_t;
+
+static int persist_server_clb(anjay_t *anjay,
+                              anjay_server_info_t *server,
+                              void *args_) {
+    persist_servers_args_t *args = (persist_servers_args_t *) args_;
+    anjay_ssid_t ssid = _anjay_server_ssid(server);
+    if (ssid == ANJAY_SSID_BOOTSTRAP
+            || _anjay_server_registration_expired(server)) {
+        return ANJAY_FOREACH_CONTINUE;
+    }
+
+    // shallow copy - the data is not modified in the STORE direction
+    anjay_registration_info_t registration_info =
+            *_anjay_server_registration_info(server);
+    bool more = true;
+    uint32_t conn_count = 0;
+    AVS_LIST(anjay_observe_connection_entry_t) conn;
+    AVS_LIST_FOREACH(conn, anjay->observe.connection_entries) {
+        if (should_persist_connection(conn, server)) {
+            ++conn_count;
+        }
+    }
+    (void) (avs_is_err((args->err = avs_persistence_bool(args->ctx, &more)))
+            || avs_is_err((args->err = avs_persistence_u16(args->ctx, &ssid)))
+            || avs_is_err((args->err = _anjay_registration_info_persistence(
+                                   args->ctx, &registration_info)))
+            || avs_is_err((args->err = avs_persistence_u32(args->ctx,
+                                                           &conn_count))));
+    AVS_LIST_FOREACH(conn, anjay->observe.connection_entries) {
+        if (avs_is_err(args->err)) {
+            break;
+        }
+        if (should_persist_connection(conn, server)) {
+            args->err = persist_connection(args->ctx, conn);
+        }
+    }
+    return avs_is_ok(args->err) ? ANJAY_FOREACH_CONTINUE : -1;
+}
+
+avs_error_t anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream) {
+    avs_persistence_context_t ctx =
+            avs_persistence_store_context_create(out_stream);
+    uint8_t version = OBSERVE_PERSISTENCE_VERSION_CURRENT;
+    persist_servers_args_t args = {
+        .ctx = &ctx,
+        .err = AVS_OK
+    };
+    (void) (avs_is_err((args.err = avs_persistence_magic_string(&ctx, MAGIC)))
+            || avs_is_err((args.err = avs_persistence_version(
+                                   &ctx, &version, SUPPORTED_VERSIONS,
+                                   sizeof(SUPPORTED_VERSIONS)))));
+    if (avs_is_ok(args.err)
+            && _anjay_servers_foreach_active(anjay, persist_server_clb, &args)
+            && avs_is_ok(args.err)) {
+        args.err = avs_errno(AVS_EPROTO);
+    }
+    if (avs_is_ok(args.err)) {
+        bool more = false;
+        args.err = avs_persistence_bool(&ctx, &more);
+    }
+    if (avs_is_err(args.err)) {
+        anjay_log(ERROR, _("Could not persist observe state"));
+    }
+    return args.err;
+}
+
+//// RESTORE ///////////////////////////////////////////////////////////////////
+
+static avs_error_t
+restore_observation(avs_persistence_context_t *ctx,
+                    anjay_observe_connection_entry_t *conn) {
+    avs_coap_token_t token;
+    uint8_t action;
+    uint32_t paths_count;
+    anjay_uri_path_t *paths = NULL;
+    avs_time_real_t last_confirmable;
+    restored_value_t last_sent = { 0 };
+    avs_error_t err;
+    if (avs_is_err((err = handle_token(ctx, &token)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &action)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &paths_count)))) {
+        return err;
+    }
+    if (!paths_count) {
+        return avs_errno(AVS_EBADMSG);
+    }
+    if (!(paths = (anjay_uri_path_t *) avs_calloc(paths_count,
+                                                  sizeof(*paths)))) {
+        anjay_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    for (uint32_t i = 0; avs_is_ok(err) && i < paths_count; ++i) {
+        err = _anjay_persistence_uri_path(ctx, &paths[i]);
+    }
+    (void) (avs_is_err(err)
+            || avs_is_err((err = _anjay_persistence_time_real(
+                                   ctx, &last_confirmable)))
+            || avs_is_err((err = restore_value(ctx, &last_sent))));
+    if (avs_is_ok(err)
+            && !value_matches_observation(&last_sent, paths_count)) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+
+    anjay_connection_ref_t *heap_conn = NULL;
+    if (avs_is_ok(err)
+            && !(heap_conn = (anjay_connection_ref_t *) avs_malloc(
+                         sizeof(anjay_connection_ref_t)))) {
+        anjay_log(ERROR, _("out of memory"));
+        err = avs_errno(AVS_ENOMEM);
+    }
+    if (avs_is_ok(err)) {
+        *heap_conn = conn->conn_ref;
+        if (avs_is_err((err = avs_coap_observe_restore(
+                                _anjay_connection_get_coap(conn->conn_ref),
+                                _anjay_observe_cancel_handler, heap_conn,
+                                ctx)))) {
+            avs_free(heap_conn);
+        } else if (!_anjay_observe_restore_observation(
+                           conn, &token, (anjay_request_action_t) action,
+                           paths, paths_count, last_confirmable,
+                           &last_sent.value)) {
+            // the CoAP-level observation will stay orphaned until the
+            // context is destroyed; there is no way to cancel it silently
+            anjay_log(ERROR,
+                      _("Could not restore observation for token ") "%s",
+                      ANJAY_TOKEN_TO_STRING(token));
+            err = avs_errno(AVS_ENOMEM);
+        }
+    }
+
+    restored_value_cleanup(&last_sent);
+    avs_free(paths);
+    return err;
+}
+
+static avs_error_t
+restore_unsent_value(avs_persistence_context_t *ctx,
+                     anjay_observe_connection_entry_t *conn) {
+    avs_coap_token_t token;
+    restored_value_t value;
+    avs_error_t err;
+    if (avs_is_err((err = handle_token(ctx, &token)))
+            || avs_is_err((err = restore_value(ctx, &value)))) {
+        return err;
+    }
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            AVS_RBTREE_FIND(conn->observations,
+                            _anjay_observation_query(&token));
+    if (!observation) {
+        anjay_log(DEBUG,
+                  _("Dropping stored notification for unknown token ") "%s",
+                  ANJAY_TOKEN_TO_STRING(token));
+    } else if (!value_matches_observation(&value, observation->paths_count)) {
+        err = avs_errno(AVS_EBADMSG);
+    } else if (_anjay_observe_restore_unsent_value(conn, observation,
+                                                   &value.value)) {
+        err = avs_errno(AVS_ENOMEM);
+    }
+    restored_value_cleanup(&value);
+    return err;
+}
+
+static avs_error_t restore_connection_data(avs_persistence_context_t *ctx,
+                                           anjay_connection_ref_t ref) {
+    anjay_observe_connection_entry_t *conn =
+            _anjay_observe_find_or_create_connection(ref);
+    if (!conn) {
+        return avs_errno(AVS_ENOMEM);
+    }
+    uint32_t count;
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    while (avs_is_ok(err) && count--) {
+        err = restore_observation(ctx, conn);
+    }
+    if (avs_is_ok(err)) {
+        err = avs_persistence_u32(ctx, &count);
+    }
+    while (avs_is_ok(err) && count--) {
+        err = restore_unsent_value(ctx, conn);
+    }
+
+    AVS_RBTREE_ELEM(anjay_observation_t) observation;
+    AVS_RBTREE_FOREACH(observation, conn->observations) {
+        _anjay_observe_schedule_pmax_trigger(conn, observation);
+    }
+    _anjay_observe_delete_connection_if_empty(ref);
+    return err;
+}
+
+void _anjay_observe_restore_connection(anjay_connection_ref_t ref) {
+    anjay_observe_state_t *observe = &_anjay_from_server(ref.server)->observe;
+    AVS_LIST(anjay_observe_restored_server_t) *server_ptr =
+            find_restored_server(observe, _anjay_server_ssid(ref.server));
+    if (!server_ptr) {
+        return;
+    }
+    AVS_LIST(restored_connection_t) *conn_ptr;
+    AVS_LIST_FOREACH_PTR(conn_ptr, &(*server_ptr)->connections) {
+        if ((*conn_ptr)->conn_type == ref.conn_type) {
+            break;
+        }
+    }
+    if (!*conn_ptr) {
+        return;
+    }
+
+    avs_stream_inbuf_t in = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+    avs_stream_inbuf_set_buffer(&in, (*conn_ptr)->data, (*conn_ptr)->size);
+    avs_persistence_context_t ctx =
+            avs_persistence_restore_context_create((avs_stream_t *) &in);
+    if (avs_is_err(restore_connection_data(&ctx, ref))) {
+        anjay_log(WARNING,
+                  _("Could not restore all observations for SSID ") "%u",
+                  _anjay_server_ssid(ref.server));
+    }
+
+    // the data is applied only once; if the CoAP context is recreated later,
+    // the observations are gone anyway
+    avs_free((*conn_ptr)->data);
+    AVS_LIST_DELETE(conn_ptr);
+    delete_restored_server_if_consumed(server_ptr);
+}
+
+void _anjay_observe_resume_registration(anjay_server_info_t *server) {
+    anjay_observe_state_t *observe = &_anjay_from_server(server)->observe;
+    AVS_LIST(anjay_observe_restored_server_t) *server_ptr =
+            find_restored_server(observe, _anjay_server_ssid(server));
+    if (!server_ptr || !(*server_ptr)->registration_pending) {
+        return;
+    }
+    if (_anjay_server_registration_expired(server)) {
+        anjay_log(INFO,
+                  _("Resuming restored registration for SSID ") "%u",
+                  _anjay_server_ssid(server));
+        _anjay_server_resume_registration(server,
+                                          &(*server_ptr)->registration_info);
+    }
+    (*server_ptr)->registration_pending = false;
+    delete_restored_server_if_consumed(server_ptr);
+}
+
+static avs_error_t
+restore_connection_blob(avs_persistence_context_t *ctx,
+                        AVS_LIST(restored_connection_t) *out_conn) {
+    uint8_t conn_type;
+    avs_error_t err = avs_persistence_u8(ctx, &conn_type);
+    if (avs_is_ok(err) && conn_type >= ANJAY_CONNECTION_LIMIT_) {
+        err = avs_errno(AVS_EBADMSG);
+    }
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (!(*out_conn = AVS_LIST_NEW_ELEMENT(restored_connection_t))) {
+        anjay_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    (*out_conn)->conn_type = (anjay_connection_type_t) conn_type;
+    return avs_persistence_sized_buffer(ctx, &(*out_conn)->data,
+                                        &(*out_conn)->size);
+}
+
+static avs_error_t
+restore_server(avs_persistence_context_t *ctx,
+               AVS_LIST(anjay_observe_restored_server_t) *out_server) {
+    if (!(*out_server =
+                  AVS_LIST_NEW_ELEMENT(anjay_observe_restored_server_t))) {
+        anjay_log(ERROR, _("out of memory"));
+        return avs_errno(AVS_ENOMEM);
+    }
+    (*out_server)->registration_pending = true;
+    uint32_t conn_count;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_u16(ctx, &(*out_server)->ssid)))
+            || avs_is_err((err = _anjay_registration_info_persistence(
+                                   ctx, &(*out_server)->registration_info)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &conn_count))));
+    AVS_LIST(restored_connection_t) *conn_ptr = &(*out_server)->connections;
+    while (avs_is_ok(err) && conn_count--) {
+        err = restore_connection_blob(ctx, conn_ptr);
+        if (*conn_ptr) {
+            AVS_LIST_ADVANCE_PTR(&conn_ptr);
+        }
+    }
+    return err;
+}
+
+static int check_active_clb(anjay_t *anjay,
+                            anjay_server_info_t *server,
+                            void *out_active_) {
+    (void) anjay;
+    (void) server;
+    *(bool *) out_active_ = true;
+    return ANJAY_FOREACH_BREAK;
+}
+
+avs_error_t anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream) {
+    bool any_active = false;
+    _anjay_servers_foreach_active(anjay, check_active_clb, &any_active);
+    if (any_active || anjay->observe.connection_entries) {
+        anjay_log(ERROR, _("Cannot restore observe state after connections "
+                           "have been established"));
+        return avs_errno(AVS_EINVAL);
+    }
+
+    avs_persistence_context_t ctx =
+            avs_persistence_restore_context_create(in_stream);
+    uint8_t version;
+    AVS_LIST(anjay_observe_restored_server_t) restored = NULL;
+    AVS_LIST(anjay_observe_restored_server_t) *tail = &restored;
+    bool more = false;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_magic_string(&ctx, MAGIC)))
+            || avs_is_err((err = avs_persistence_version(
+                                   &ctx, &version, SUPPORTED_VERSIONS,
+                                   sizeof(SUPPORTED_VERSIONS))))
+            || avs_is_err((err = avs_persistence_bool(&ctx, &more))));
+    while (avs_is_ok(err) && more) {
+        err = restore_server(&ctx, tail);
+        if (*tail) {
+            AVS_LIST_ADVANCE_PTR(&tail);
+        }
+        if (avs_is_ok(err)) {
+            err = avs_persistence_bool(&ctx, &more);
+        }
+    }
+
+    if (avs_is_err(err)) {
+        anjay_log(ERROR, _("Could not restore observe state"));
+        restored_servers_clear(&restored);
+        return err;
+    }
+    restored_servers_clear(&anjay->observe.restored);
+    anjay->observe.restored = restored;
+    return AVS_OK;
+}
+
+#else // ANJAY_OBSERVE_PERSISTENCE
+
+avs_error_t anjay_observe_persist(anjay_t *anjay, avs_stream_t *out_stream) {
+    (void) anjay;
+    (void) out_stream;
+    anjay_log(ERROR, _("Observe persistence not compiled in"));
+    return avs_errno(AVS_ENOTSUP);
+}
+
+avs_error_t anjay_observe_restore(anjay_t *anjay, avs_stream_t *in_stream) {
+    (void) anjay;
+    (void) in_stream;
+    anjay_log(ERROR, _("Observe persistence not compiled in"));
+    return avs_errno(AVS_ENOTSUP);
+}
+
+#endif // ANJAY_OBSERVE_PERSISTENCE
@@ -19,8 +19,11 @@
 #include <math.h>
 #include <stdarg.h>
 
+#include <avsystem/commons/stream/stream_inbuf.h>
 #include <avsystem/commons/unit/test.h>
 
+#include <anjay_modules/notify.h>
+
 #include <anjay_test/dm.h>
 #include <anjay_test/mock_clock.h>
 #include <anjay_test/utils.h>
@@ -35,13 +38,51 @@
 #define MSG_ID_BASE 0x26DB
 
 static void assert_observe_consistency(anjay_t *anjay) {
+    size_t unsent_count = 0;
+    size_t in_flight_count = 0;
     AVS_LIST(anjay_observe_connection_entry_t) conn;
     AVS_LIST_FOREACH(conn, anjay->observe.connection_entries) {
+        AVS_UNIT_ASSERT_TRUE(conn->observe == &anjay->observe);
+        AVS_LIST(anjay_observation_value_t) value;
+        AVS_LIST_FOREACH(value, conn->unsent) {
+            AVS_UNIT_ASSERT_TRUE(value->queued_in == conn);
+            // only values being sent are unlinked from the global queue
+            const bool being_sent = value->ref->in_flight
+                                    && value->ref->in_flight->value == value;
+            AVS_UNIT_ASSERT_TRUE(being_sent == !value->unsent_link.next);
+            ++unsent_count;
+        }
+        AVS_UNIT_ASSERT_TRUE(AVS_LIST_TAIL(conn->unsent) == conn->unsent_last);
+
+        AVS_UNIT_ASSERT_TRUE(AVS_LIST_SIZE(conn->in_flight)
+                             <= anjay->observe.max_in_flight);
+        AVS_LIST(anjay_observe_in_flight_t) in_flight;
+        AVS_LIST_FOREACH(in_flight, conn->in_flight) {
+            AVS_UNIT_ASSERT_TRUE(in_flight->conn == conn);
+            AVS_UNIT_ASSERT_TRUE(in_flight->value->queued_in == conn);
+            AVS_UNIT_ASSERT_TRUE(in_flight->value->ref->in_flight == in_flight);
+            ++in_flight_count;
+            AVS_LIST(anjay_observation_value_t) batched;
+            AVS_LIST_FOREACH(batched, in_flight->batched) {
+                AVS_UNIT_ASSERT_TRUE(batched->queued_in == conn);
+                AVS_UNIT_ASSERT_TRUE(batched->ref == in_flight->value->ref);
+                AVS_UNIT_ASSERT_NULL(batched->unsent_link.next);
+                ++unsent_count;
+                ++in_flight_count;
+            }
+        }
+
         size_t path_refs_in_observations = 0;
+        size_t observations_in_flight = 0;
         AVS_RBTREE_ELEM(anjay_observation_t) observation;
         AVS_RBTREE_FOREACH(observation, conn->observations) {
             path_refs_in_observations += observation->paths_count;
+            if (observation->in_flight) {
+                ++observations_in_flight;
+            }
         }
+        AVS_UNIT_ASSERT_EQUAL(observations_in_flight,
+                              AVS_LIST_SIZE(conn->in_flight));
 
         size_t path_refs = 0;
         AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path_entry;
@@ -66,6 +107,25 @@ static void assert_observe_consistency(anjay_t *anjay) {
         }
         AVS_UNIT_ASSERT_EQUAL(path_refs_in_observations, path_refs);
     }
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, unsent_count);
+
+    // global queue shall contain all stored values that are not being sent,
+    // oldest first
+    size_t queue_length = 0;
+    avs_time_real_t prev_timestamp = AVS_TIME_REAL_INVALID;
+    const anjay_observe_unsent_link_t *link;
+    for (link = anjay->observe.unsent_queue.next;
+         link != &anjay->observe.unsent_queue;
+         link = link->next) {
+        AVS_UNIT_ASSERT_TRUE(link->next->prev == link);
+        const anjay_observation_value_t *value =
+                AVS_CONTAINER_OF(link, anjay_observation_value_t, unsent_link);
+        AVS_UNIT_ASSERT_FALSE(
+                avs_time_real_before(value->timestamp, prev_timestamp));
+        prev_timestamp = value->timestamp;
+        ++queue_length;
+    }
+    AVS_UNIT_ASSERT_EQUAL(queue_length + in_flight_count, unsent_count);
 }
 
 static void assert_observe_size(anjay_t *anjay, size_t sz) {
@@ -759,9 +819,9 @@ static void notify_max_period_test(const char *con_notify_ack,
                    },
                    "Hello", 5);
 
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
     AVS_UNIT_ASSERT_EQUAL(
             AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
                     ->last_sent->timestamp.since_real_epoch.seconds,
@@ -882,7 +942,6 @@ AVS_UNIT_TEST(notify, min_period) {
 
     ////// AFTER PMIN, NO CHANGE //////
     _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -890,9 +949,63 @@ AVS_UNIT_TEST(notify, min_period) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, attrs_cache) {
+    static const anjay_dm_internal_r_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 10,
+                .max_period = 365 * 24 * 60 * 60 /* a year */,
+                .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+                .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_WITH_SSIDS(14);
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "Res4"),
+                    OBSERVE(0), PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT,
+                            ID_TOKEN(0x69ED, "Res4"), CONTENT_FORMAT(PLAINTEXT),
+                            OBSERVE(0), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    AVS_RBTREE_ELEM(anjay_observe_path_entry_t) path_entry =
+            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observed_paths);
+    AVS_UNIT_ASSERT_NOT_NULL(path_entry);
+    AVS_UNIT_ASSERT_FALSE(path_entry->attrs_cached);
+
+    ////// FIRST NOTIFY READS THE ATTRIBUTES //////
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_TRUE(path_entry->attrs_cached);
+
+    ////// SUBSEQUENT ONES USE THE CACHE //////
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+
+    ////// INVALIDATION //////
+    _anjay_notify_attributes_changed(anjay);
+    AVS_UNIT_ASSERT_FALSE(path_entry->attrs_cached);
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_TRUE(path_entry->attrs_cached);
 
     DM_TEST_FINISH;
 }
@@ -994,7 +1107,6 @@ AVS_UNIT_TEST(notify, epmin_less_than_pmax) {
 
     ////// NOTIFY ABOUT RESOURCE CHANGE //////
     _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
 
@@ -1062,6 +1174,248 @@ AVS_UNIT_TEST(notify, confirmable) {
     DM_TEST_FINISH;
 }
 
+#define EXPECT_PIPELINED_NOTIFY(MsgId, Token, Observe, Payload)            \
+    do {                                                                   \
+        const coap_test_msg_t *notify =                                    \
+                COAP_MSG(CON, CONTENT, ID_TOKEN((MsgId), Token),           \
+                         OBSERVE(Observe), CONTENT_FORMAT(PLAINTEXT),      \
+                         PAYLOAD(Payload));                                \
+        avs_unit_mocksock_expect_output(mocksocks[0], notify->content,     \
+                                        notify->length);                   \
+    } while (0)
+
+#define PIPELINED_NOTIFY_ACK(MsgId)                                        \
+    do {                                                                   \
+        const coap_test_msg_t *ack =                                       \
+                COAP_MSG(ACK, EMPTY, ID(MsgId), NO_PAYLOAD);               \
+        avs_unit_mocksock_input(mocksocks[0], ack->content, ack->length);  \
+        anjay_serve(anjay, mocksocks[0]);                                  \
+    } while (0)
+
+AVS_UNIT_TEST(notify, confirmable_pipelined) {
+    ////// INITIALIZATION //////
+    const avs_coap_udp_tx_params_t tx_params = {
+        .ack_timeout = { 2, 0 },
+        .ack_random_factor = 1.0,
+        .max_retransmit = 0,
+        .nstart = 2
+    };
+    const anjay_dm_object_def_t *const *obj_defs[] = {
+        DM_TEST_DEFAULT_OBJECTS
+    };
+    anjay_ssid_t ssids[] = { 14 };
+    DM_TEST_INIT_GENERIC(obj_defs, ssids,
+                         DM_TEST_CONFIGURATION(
+                                 .confirmable_notifications = true,
+                                 .max_notifications_in_flight = 2,
+                                 .udp_tx_params = &tx_params));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "A"), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "0"));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69ED, "A"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("0"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69EE, "B"), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "0"));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69EE, "B"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("0"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69EF, "C"), OBSERVE(0),
+                    PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "0"));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID_TOKEN(0x69EF, "C"),
+                            CONTENT_FORMAT(PLAINTEXT), OBSERVE(0),
+                            PAYLOAD("0"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 3);
+
+    anjay_observe_connection_entry_t *conn =
+            anjay->observe.connection_entries;
+    AVS_UNIT_ASSERT_NOT_NULL(conn);
+
+    ////// FIRST CHANGE //////
+    // value read for A is reused for B and C; two notifications go out
+    // without waiting for an ACK, the third one waits for a free slot
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "1"));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE, "A", 1, "1");
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 1, "B", 1, "1");
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->in_flight), 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 3);
+
+    ////// SECOND CHANGE //////
+    // new values are queued behind the ones in flight
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "2"));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->in_flight), 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 6);
+
+    ////// ACK FREES A SLOT //////
+    // the oldest value whose observation is not in flight goes next, i.e. C1
+    // rather than the newer A2
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE);
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 2, "C", 1, "1");
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->in_flight), 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 5);
+
+    ////// TIMEOUT //////
+    // B1 times out; it stays queued ahead of B2 and is sent again
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    _anjay_mock_clock_advance(
+            avs_time_duration_from_scalar(1500, AVS_TIME_MS));
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->in_flight), 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 5);
+    AVS_UNIT_ASSERT_NULL(conn->unsent->ref->in_flight);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(conn->unsent->ref->token.bytes, "B", 1);
+
+    anjay->current_connection.server = anjay->servers->servers;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_PRIMARY;
+    _anjay_observe_sched_flush(anjay->current_connection);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 3, "B", 2, "1");
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->in_flight), 2);
+
+    ////// DRAINING THE QUEUE //////
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE + 2);
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 4, "A", 2, "2");
+    anjay_sched_run(anjay);
+
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE + 3);
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 5, "B", 3, "2");
+    anjay_sched_run(anjay);
+
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE + 4);
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 6, "C", 2, "2");
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE + 5);
+    anjay_sched_run(anjay);
+    // queue becomes empty, so all observations are rescheduled
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE + 6);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_NULL(conn->in_flight);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, queue_limit_with_value_in_flight) {
+    ////// INITIALIZATION //////
+    const avs_coap_udp_tx_params_t tx_params = {
+        .ack_timeout = { 10, 0 },
+        .ack_random_factor = 1.0,
+        .max_retransmit = 0,
+        .nstart = 1
+    };
+    const anjay_dm_object_def_t *const *obj_defs[] = {
+        DM_TEST_DEFAULT_OBJECTS
+    };
+    anjay_ssid_t ssids[] = { 14 };
+    DM_TEST_INIT_GENERIC(obj_defs, ssids,
+                         DM_TEST_CONFIGURATION(
+                                 .confirmable_notifications = true,
+                                 .stored_notification_limit = 1,
+                                 .udp_tx_params = &tx_params));
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "Res4"),
+                    OBSERVE(0), PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 41));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT,
+                            ID_TOKEN(0x69ED, "Res4"), CONTENT_FORMAT(PLAINTEXT),
+                            OBSERVE(0), PAYLOAD("41"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 1);
+
+    anjay_observe_connection_entry_t *conn =
+            anjay->observe.connection_entries;
+    AVS_UNIT_ASSERT_NOT_NULL(conn);
+
+    ////// NOTIFICATION IN FLIGHT //////
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 42));
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE, "Res4", 1, "42");
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_NOT_NULL(conn->in_flight);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 1);
+
+    ////// CHANGES WHILE THE ONLY STORED VALUE IS BEING SENT //////
+    // the value in flight cannot be dropped, so the new ones are dropped
+    // instead and the limit is never exceeded
+    for (int64_t value = 43; value <= 44; ++value) {
+        AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+        anjay_sched_run(anjay);
+        _anjay_mock_clock_advance(
+                avs_time_duration_from_scalar(1, AVS_TIME_S));
+        DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+        expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, value));
+        anjay_sched_run(anjay);
+        assert_observe_consistency(anjay);
+        AVS_UNIT_ASSERT_NOT_NULL(conn->in_flight);
+        AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 1);
+    }
+
+    ////// DELIVERY //////
+    // queue becomes empty, so the observation is rescheduled
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_NULL(conn->in_flight);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
+
+    ////// NEXT CHANGE //////
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 45));
+    EXPECT_PIPELINED_NOTIFY(MSG_ID_BASE + 1, "Res4", 2, "45");
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 1);
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    PIPELINED_NOTIFY_ACK(MSG_ID_BASE + 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
+
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(notify, extremes) {
     static const anjay_dm_internal_r_attrs_t ATTRS = {
         .standard = {
@@ -1104,12 +1458,11 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// EVEN LESS //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1117,12 +1470,11 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// IN BETWEEN //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1135,12 +1487,11 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// EQUAL - STILL NOT CROSSING //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1148,12 +1499,11 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// GREATER //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1166,12 +1516,11 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// STILL GREATER //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1179,12 +1528,11 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// LESS AGAIN //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1197,9 +1545,63 @@ AVS_UNIT_TEST(notify, extremes) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, extremes_non_numeric_fallback) {
+    static const anjay_dm_internal_r_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 0,
+                .max_period = 365 * 24 * 60 * 60 /* a year */,
+                .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+                .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+            },
+            .greater_than = 777.0,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_WITH_SSIDS(14);
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "Res4"),
+                    OBSERVE(0), PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT,
+                            ID_TOKEN(0x69ED, "Res4"), CONTENT_FORMAT(PLAINTEXT),
+                            OBSERVE(0), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    ////// NUMERIC, FILTERED OUT WITHOUT BATCHING //////
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 600));
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 1);
+
+    ////// NO LONGER NUMERIC - READ AGAIN INTO A BATCH //////
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "N/A"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "N/A"));
+    const coap_test_msg_t *notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "Res4"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("N/A"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 1);
 
     DM_TEST_FINISH;
 }
@@ -1241,12 +1643,11 @@ AVS_UNIT_TEST(notify, greater_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// LESS //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1259,12 +1660,11 @@ AVS_UNIT_TEST(notify, greater_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// GREATER AGAIN //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1277,9 +1677,9 @@ AVS_UNIT_TEST(notify, greater_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     DM_TEST_FINISH;
 }
@@ -1326,12 +1726,11 @@ AVS_UNIT_TEST(notify, less_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// STILL LESS //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1339,12 +1738,11 @@ AVS_UNIT_TEST(notify, less_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// GREATER //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1357,12 +1755,11 @@ AVS_UNIT_TEST(notify, less_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// LESS AGAIN //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1375,9 +1772,9 @@ AVS_UNIT_TEST(notify, less_only) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     DM_TEST_FINISH;
 }
@@ -1418,12 +1815,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// INCREASE BY EXACTLY stp //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1436,12 +1832,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// INCREASE BY OVER stp //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1454,12 +1849,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// NON-NUMERIC VALUE //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1472,12 +1866,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// BACK TO NUMBERS //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1490,12 +1883,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// TOO LITTLE DECREASE //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1503,12 +1895,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// DECREASE BY EXACTLY stp //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1521,12 +1912,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// DECREASE BY MORE THAN stp //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1539,12 +1929,11 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     ////// INCREASE BY EXACTLY stp //////
-    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
@@ -1557,9 +1946,9 @@ AVS_UNIT_TEST(notify, step) {
     anjay_sched_run(anjay);
     assert_observe_consistency(anjay);
     assert_observe_size(anjay, 1);
-    AVS_UNIT_ASSERT_NOT_NULL(
-            AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
-                    ->notify_task);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(
+            &AVS_RBTREE_FIRST(anjay->observe.connection_entries->observations)
+                     ->notify_timer));
 
     DM_TEST_FINISH;
 }
@@ -1622,9 +2011,8 @@ AVS_UNIT_TEST(notify, multiple_formats) {
                      CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Hello"));
     avs_unit_mocksock_expect_output(mocksocks[0], n_notify_response->content,
                                     n_notify_response->length);
-    // plaintext
+    // plaintext - value read for the previous observation is reused
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hello"));
     const coap_test_msg_t *p_notify_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "P"), OBSERVE(1),
                      CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Hello"));
@@ -1632,7 +2020,6 @@ AVS_UNIT_TEST(notify, multiple_formats) {
                                     p_notify_response->length);
     // TLV
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hello"));
     const coap_test_msg_t *t_notify_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 2, "T"), OBSERVE(1),
                      CONTENT_FORMAT(OMA_LWM2M_TLV),
@@ -1655,10 +2042,8 @@ AVS_UNIT_TEST(notify, multiple_formats) {
                      CONTENT_FORMAT(PLAINTEXT), PAYLOAD("EjRWeA=="));
     avs_unit_mocksock_expect_output(mocksocks[0], n_bytes_response->content,
                                     n_bytes_response->length);
-    // plaintext
+    // plaintext - value read for the previous observation is reused
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4,
-                    ANJAY_MOCK_DM_BYTES(0, "\x12\x34\x56\x78"));
     const coap_test_msg_t *p_bytes_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 4, "P"), OBSERVE(2),
                      CONTENT_FORMAT(PLAINTEXT), PAYLOAD("EjRWeA=="));
@@ -1666,8 +2051,6 @@ AVS_UNIT_TEST(notify, multiple_formats) {
                                     p_bytes_response->length);
     // TLV
     expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
-    expect_read_res(anjay, &OBJ, 69, 4,
-                    ANJAY_MOCK_DM_BYTES(0, "\x12\x34\x56\x78"));
     const coap_test_msg_t *t_bytes_response =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 5, "T"), OBSERVE(2),
                      CONTENT_FORMAT(OMA_LWM2M_TLV),
@@ -1723,7 +2106,25 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
     _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, ANJAY_ID_INVALID, 0,
                                         ANJAY_MOCK_DM_STRING(0, "Rin"));
 
+    // value read for server 14 is reused
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    const coap_test_msg_t *notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "SuccsTkn"),
+                     OBSERVE(1), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Rin"));
+    avs_unit_mocksock_expect_output(mocksocks[1], notify_response->content,
+
+                                    notify_response->length);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    anjay_sched_run(anjay);
+
+    // second notification
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     _anjay_mock_dm_expect_list_instances(
             anjay, &OBJ, 0, (const anjay_iid_t[]) { 69, ANJAY_ID_INVALID });
     _anjay_mock_dm_expect_list_resources(
@@ -1738,17 +2139,65 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
                     { 6, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
                     ANJAY_MOCK_DM_RES_END });
     _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, ANJAY_ID_INVALID, 0,
-                                        ANJAY_MOCK_DM_STRING(0, "Len"));
-    const coap_test_msg_t *notify_response =
-            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "SuccsTkn"),
-                     OBSERVE(1), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Len"));
-    avs_unit_mocksock_expect_output(mocksocks[1], notify_response->content,
+                                        ANJAY_MOCK_DM_STRING(0, "Miku"));
 
-                                    notify_response->length);
+    // value read for server 14 is reused
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    const coap_test_msg_t *notify_response2 =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "SuccsTkn"),
+                     OBSERVE(2), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Miku"));
+    avs_unit_mocksock_expect_output(mocksocks[1], notify_response2->content,
+                                    notify_response2->length);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
     anjay_sched_run(anjay);
 
-    // second notification
+    // reactivate the server
+    connection->conn_socket_ = socket14;
+    _anjay_observe_gc(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 2);
+    anjay->current_connection.server = anjay->servers->servers;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_PRIMARY;
+    _anjay_observe_sched_flush(anjay->current_connection);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    const coap_test_msg_t *notify_response3 =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(0x7548, "SuccsTkn"), OBSERVE(1),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Rin"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response3->content,
+                                    notify_response3->length);
+    anjay_sched_run(anjay);
+
+    const coap_test_msg_t *notify_response4 =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(0x7549, "SuccsTkn"), OBSERVE(2),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Miku"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response4->content,
+                                    notify_response4->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    anjay_sched_run(anjay);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, storing_latest_only) {
+    SUCCESS_TEST(14, 34);
+    anjay->observe.stored_notifications_mode =
+            ANJAY_STORED_NOTIFICATIONS_SEND_LATEST;
+    anjay_server_connection_t *connection =
+            _anjay_get_server_connection((const anjay_connection_ref_t) {
+                .server = anjay->servers->servers,
+                .conn_type = ANJAY_CONNECTION_PRIMARY
+            });
+    AVS_UNIT_ASSERT_NOT_NULL(connection);
+
+    // deactivate the first server
+    avs_net_socket_t *socket14 = connection->conn_socket_;
+    connection->conn_socket_ = NULL;
+    _anjay_observe_gc(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 2);
+
+    // first notification
     DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
@@ -1772,9 +2221,26 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
                     { 6, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
                     ANJAY_MOCK_DM_RES_END });
     _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, ANJAY_ID_INVALID, 0,
-                                        ANJAY_MOCK_DM_STRING(0, "Miku"));
+                                        ANJAY_MOCK_DM_STRING(0, "Rin"));
 
+    // value read for server 14 is reused
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    const coap_test_msg_t *notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "SuccsTkn"),
+                     OBSERVE(1), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Rin"));
+    avs_unit_mocksock_expect_output(mocksocks[1], notify_response->content,
+                                    notify_response->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
+    anjay_sched_run(anjay);
+
+    // second notification
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     _anjay_mock_dm_expect_list_instances(
             anjay, &OBJ, 0, (const anjay_iid_t[]) { 69, ANJAY_ID_INVALID });
     _anjay_mock_dm_expect_list_resources(
@@ -1789,10 +2255,13 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
                     { 6, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
                     ANJAY_MOCK_DM_RES_END });
     _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 69, 4, ANJAY_ID_INVALID, 0,
-                                        ANJAY_MOCK_DM_STRING(0, "Luka"));
+                                        ANJAY_MOCK_DM_STRING(0, "Miku"));
+
+    // value read for server 14 is reused
+    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
     const coap_test_msg_t *notify_response2 =
             COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "SuccsTkn"),
-                     OBSERVE(2), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Luka"));
+                     OBSERVE(2), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Miku"));
     avs_unit_mocksock_expect_output(mocksocks[1], notify_response2->content,
                                     notify_response2->length);
     DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
@@ -1808,20 +2277,120 @@ AVS_UNIT_TEST(notify, storing_when_inactive) {
     _anjay_observe_sched_flush(anjay->current_connection);
     memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
 
+    // only the most recent value is sent
     const coap_test_msg_t *notify_response3 =
             COAP_MSG(NON, CONTENT, ID_TOKEN(0x7548, "SuccsTkn"), OBSERVE(1),
-                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Rin"));
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Miku"));
     avs_unit_mocksock_expect_output(mocksocks[0], notify_response3->content,
                                     notify_response3->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
 
-    const coap_test_msg_t *notify_response4 =
-            COAP_MSG(NON, CONTENT, ID_TOKEN(0x7549, "SuccsTkn"), OBSERVE(2),
-                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("Miku"));
-    avs_unit_mocksock_expect_output(mocksocks[0], notify_response4->content,
-                                    notify_response4->length);
+    DM_TEST_FINISH;
+}
+
+// Absolute time, well above SENML_TIME_SECONDS_THRESHOLD, so that JSON
+// timestamps are serialized as whole seconds despite the mock clock advancing
+// by a nanosecond on each read
+#define BATCHED_TEST_TIME_S 1600000000
+
+static void expect_batched_test_notify_read(anjay_t *anjay, int64_t value) {
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
     DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, value));
+}
+
+AVS_UNIT_TEST(notify, storing_batched) {
+    const anjay_dm_object_def_t *const *obj_defs[] = {
+        DM_TEST_DEFAULT_OBJECTS
+    };
+    anjay_ssid_t ssids[] = { 14 };
+    DM_TEST_INIT_GENERIC(
+            obj_defs, ssids,
+            DM_TEST_CONFIGURATION(.confirmable_notifications = true,
+                                  .stored_notifications_mode =
+                                          ANJAY_STORED_NOTIFICATIONS_SEND_BATCHED));
+    _anjay_mock_clock_reset(
+            avs_time_monotonic_from_scalar(BATCHED_TEST_TIME_S, AVS_TIME_S));
+
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0xFA3E, "SuccsTkn"),
+                    OBSERVE(0), ACCEPT(AVS_COAP_FORMAT_OMA_LWM2M_JSON),
+                    PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_RESPONSE(
+            mocksocks[0], ACK, CONTENT, ID_TOKEN(0xFA3E, "SuccsTkn"),
+            OBSERVE(0), CONTENT_FORMAT(OMA_LWM2M_JSON),
+            PAYLOAD("{\"bn\":\"/42/69/4\",\"e\":[{\"t\":1600000000,"
+                    "\"v\":514}]}"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 1);
+
+    anjay_server_connection_t *connection =
+            _anjay_get_server_connection((const anjay_connection_ref_t) {
+                .server = anjay->servers->servers,
+                .conn_type = ANJAY_CONNECTION_PRIMARY
+            });
+    AVS_UNIT_ASSERT_NOT_NULL(connection);
+
+    // deactivate the server
+    avs_net_socket_t *socket14 = connection->conn_socket_;
+    connection->conn_socket_ = NULL;
+    _anjay_observe_gc(anjay);
+    assert_observe_consistency(anjay);
+
+    // two values are stored, one second apart
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    _anjay_mock_clock_reset(avs_time_monotonic_from_scalar(
+            BATCHED_TEST_TIME_S + 1, AVS_TIME_S));
+    expect_batched_test_notify_read(anjay, 515);
+    anjay_sched_run(anjay);
+
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    _anjay_mock_clock_reset(avs_time_monotonic_from_scalar(
+            BATCHED_TEST_TIME_S + 2, AVS_TIME_S));
+    expect_batched_test_notify_read(anjay, 516);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 2);
+
+    // reactivate the server
+    connection->conn_socket_ = socket14;
+    _anjay_observe_gc(anjay);
+    anjay->current_connection.server = anjay->servers->servers;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_PRIMARY;
+    _anjay_observe_sched_flush(anjay->current_connection);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    // both values go in a single payload, each with its own timestamp
+    const coap_test_msg_t *notify_response = COAP_MSG(
+            CON, CONTENT, ID_TOKEN(MSG_ID_BASE, "SuccsTkn"), OBSERVE(1),
+            CONTENT_FORMAT(OMA_LWM2M_JSON),
+            PAYLOAD("{\"bn\":\"/42/69/4\",\"e\":[{\"t\":1600000001,"
+                    "\"v\":515},{\"t\":1600000002,\"v\":516}]}"));
+    avs_unit_mocksock_expect_output(mocksocks[0], notify_response->content,
+                                    notify_response->length);
     anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    // the batched value counts against the queue limit until it is delivered,
+    // but neither of the values being sent may be dropped
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 2);
+    AVS_UNIT_ASSERT_TRUE(anjay->observe.unsent_queue.next
+                         == &anjay->observe.unsent_queue);
+
+    const coap_test_msg_t *notify_ack =
+            COAP_MSG(ACK, EMPTY, ID(MSG_ID_BASE), NO_PAYLOAD);
+    avs_unit_mocksock_input(mocksocks[0], notify_ack->content,
+                            notify_ack->length);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    anjay_serve(anjay, mocksocks[0]);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
 
     DM_TEST_FINISH;
 }
@@ -1876,8 +2445,6 @@ AVS_UNIT_TEST(notify, no_storing_when_disabled) {
     anjay_sched_run(anjay);
 
     // second notification
-    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
-    DM_TEST_EXPECT_READ_NULL_ATTRS(34, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
 
@@ -1955,7 +2522,6 @@ AVS_UNIT_TEST(notify, storing_on_send_error) {
     anjay_sched_run(anjay);
 
     // second notification
-    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
 
@@ -2053,7 +2619,6 @@ AVS_UNIT_TEST(notify, no_storing_on_send_error) {
     anjay_sched_run(anjay);
 
     // second notification
-    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
 
@@ -2126,7 +2691,6 @@ static void storing_of_errors_test_impl(bool storing_resource_value) {
     anjay_sched_run(anjay);
 
     // second notification - should not actually do anything
-    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
     AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
     anjay_sched_run(anjay);
 
@@ -2161,3 +2725,526 @@ AVS_UNIT_TEST(notify, no_storing_of_errors) {
     // errors, regardless of the actual setting.
     storing_of_errors_test_impl(false);
 }
+
+AVS_UNIT_TEST(notify, read_cache_cleared_on_next_sched_pass) {
+    DM_TEST_INIT_WITH_SSIDS(14, 34);
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(42, 69, 4);
+    anjay_batch_t *batch14 = NULL;
+    anjay_batch_t *batch34 = NULL;
+
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 14,
+                                                   &batch14));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->observe.read_cache);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->observe.read_cache_job);
+
+    // value read for server 14 is reused
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 34,
+                                                   &batch34));
+    AVS_UNIT_ASSERT_TRUE(batch14 == batch34);
+    _anjay_batch_release(&batch14);
+    _anjay_batch_release(&batch34);
+
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_NULL(anjay->observe.read_cache);
+    AVS_UNIT_ASSERT_NULL(anjay->observe.read_cache_job);
+
+    // the next pass reads the value again
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 515));
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 34,
+                                                   &batch34));
+    _anjay_batch_release(&batch34);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, read_cache_cleared_on_notify_changed) {
+    DM_TEST_INIT_WITH_SSIDS(14, 34);
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(42, 69, 4);
+    anjay_batch_t *batch = NULL;
+
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 14,
+                                                   &batch));
+    _anjay_batch_release(&batch);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->observe.read_cache);
+
+    // make sure that it is the notification that clears the cache, and not
+    // the end of the scheduler pass
+    avs_sched_del(&anjay->observe.read_cache_job);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_NULL(anjay->observe.read_cache);
+
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 515));
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 34,
+                                                   &batch));
+    _anjay_batch_release(&batch);
+
+    DM_TEST_FINISH;
+}
+
+#ifdef WITH_ACCESS_CONTROL
+static int
+fake_access_control_list_instances(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    anjay_dm_emit(ctx, 0);
+    return 0;
+}
+
+static int
+fake_access_control_list_resources(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid,
+                                   anjay_dm_resource_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_OID, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_OIID, ANJAY_DM_RES_R,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_ACL, ANJAY_DM_RES_RWM,
+                      ANJAY_DM_RES_PRESENT);
+    anjay_dm_emit_res(ctx, ANJAY_DM_RID_ACCESS_CONTROL_OWNER, ANJAY_DM_RES_RW,
+                      ANJAY_DM_RES_PRESENT);
+    return 0;
+}
+
+static int fake_access_control_list_resource_instances(
+        anjay_t *anjay,
+        const anjay_dm_object_def_t *const *obj_ptr,
+        anjay_iid_t iid,
+        anjay_rid_t rid,
+        anjay_dm_list_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+    (void) rid;
+    anjay_dm_emit(ctx, 14);
+    return 0;
+}
+
+/**
+ * Single Access Control Instance for /42/69, owned by SSID 14, which grants
+ * Read access to SSID 14 only.
+ */
+static int fake_access_control_read(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj_ptr,
+                                    anjay_iid_t iid,
+                                    anjay_rid_t rid,
+                                    anjay_riid_t riid,
+                                    anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+    switch (rid) {
+    case ANJAY_DM_RID_ACCESS_CONTROL_OID:
+        return anjay_ret_i32(ctx, 42);
+    case ANJAY_DM_RID_ACCESS_CONTROL_OIID:
+        return anjay_ret_i32(ctx, 69);
+    case ANJAY_DM_RID_ACCESS_CONTROL_ACL:
+        AVS_UNIT_ASSERT_EQUAL(riid, 14);
+        return anjay_ret_i64(ctx, ANJAY_ACCESS_MASK_READ);
+    case ANJAY_DM_RID_ACCESS_CONTROL_OWNER:
+        return anjay_ret_i32(ctx, 14);
+    default:
+        return -1;
+    }
+}
+
+static const anjay_dm_object_def_t *const FAKE_ACCESS_CONTROL =
+        &(const anjay_dm_object_def_t) {
+            .oid = ANJAY_DM_OID_ACCESS_CONTROL,
+            .handlers = {
+                .list_instances = fake_access_control_list_instances,
+                .list_resources = fake_access_control_list_resources,
+                .resource_read = fake_access_control_read,
+                .list_resource_instances =
+                        fake_access_control_list_resource_instances
+            }
+        };
+
+AVS_UNIT_TEST(notify, read_cache_checks_access) {
+    DM_TEST_INIT_WITH_SSIDS(14, 34);
+    // registered after initialization, and the scheduler is never run, so
+    // that Access Control synchronization does not touch the mock objects
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_register_object(anjay, &FAKE_ACCESS_CONTROL));
+    const anjay_uri_path_t path = MAKE_RESOURCE_PATH(42, 69, 4);
+    anjay_batch_t *batch = NULL;
+
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 14,
+                                                   &batch));
+    _anjay_batch_release(&batch);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->observe.read_cache);
+
+    // server 34 has no Read access to /42/69, even though the value is cached
+    AVS_UNIT_ASSERT_EQUAL(read_notification_path(anjay, &path,
+                                                 ANJAY_ACTION_READ, 34, &batch),
+                          ANJAY_ERR_UNAUTHORIZED);
+    AVS_UNIT_ASSERT_NULL(batch);
+
+    // ...while server 14 still gets the cached value
+    AVS_UNIT_ASSERT_SUCCESS(read_notification_path(anjay, &path,
+                                                   ANJAY_ACTION_READ, 14,
+                                                   &batch));
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+    _anjay_batch_release(&batch);
+
+    DM_TEST_FINISH;
+}
+#endif // WITH_ACCESS_CONTROL
+
+#ifdef ANJAY_OBSERVE_PERSISTENCE
+static const anjay_dm_internal_r_attrs_t PERSISTENCE_TEST_ATTRS = {
+    .standard = {
+        .common = {
+            .min_period = 1,
+            .max_period = 10,
+            .min_eval_period = ANJAY_ATTRIB_PERIOD_NONE,
+            .max_eval_period = ANJAY_ATTRIB_PERIOD_NONE
+        },
+        .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+        .less_than = ANJAY_ATTRIB_VALUE_NONE,
+        .step = ANJAY_ATTRIB_VALUE_NONE
+    }
+};
+
+static const avs_coap_token_t PERSISTENCE_TEST_TOKEN = {
+    .size = 4,
+    .bytes = "Res4"
+};
+
+/**
+ * Observes /42/69/4 on SSID 14, makes two notifications fail to send so that
+ * they stay queued, and persists the resulting state into @p out.
+ */
+static void persist_observe_test_state(avs_stream_t *out) {
+    DM_TEST_INIT_WITH_SSIDS(14);
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID_TOKEN(0x69ED, "Res4"),
+                    OBSERVE(0), PATH("42", "69", "4"));
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 514));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &PERSISTENCE_TEST_ATTRS);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT,
+                            ID_TOKEN(0x69ED, "Res4"), CONTENT_FORMAT(PLAINTEXT),
+                            OBSERVE(0), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    // pmax expires twice; each time the oldest queued value fails to send
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &PERSISTENCE_TEST_ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 515));
+    avs_unit_mocksock_output_fail(mocksocks[0], avs_errno(AVS_EMSGSIZE));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    anjay_sched_run(anjay);
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &PERSISTENCE_TEST_ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 516));
+    avs_unit_mocksock_output_fail(mocksocks[0], avs_errno(AVS_EMSGSIZE));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    anjay_sched_run(anjay);
+
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 2);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_observe_persist(anjay, out));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(observe_persistence, round_trip) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    persist_observe_test_state(stream);
+
+    ////// RESTORE //////
+    DM_TEST_INIT_WITHOUT_SERVER;
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(60, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_observe_restore(anjay, stream));
+    avs_stream_cleanup(&stream);
+    // nothing is applied until the connection is brought online
+    AVS_UNIT_ASSERT_NULL(anjay->observe.connection_entries);
+
+    // attributes are read again to schedule the pmax trigger
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &PERSISTENCE_TEST_ATTRS);
+    avs_net_socket_t *mocksock = _anjay_test_dm_install_socket(anjay, 14);
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(
+            mocksock, avs_time_duration_from_scalar(1, AVS_TIME_S));
+    avs_unit_mocksock_enable_inner_mtu_getopt(mocksock, 1252);
+    avs_unit_mocksock_enable_state_getopt(mocksock);
+    assert_observe_consistency(anjay);
+    assert_observe_size(anjay, 1);
+
+    anjay_observe_connection_entry_t *conn =
+            anjay->observe.connection_entries;
+    AVS_RBTREE_ELEM(anjay_observation_t) observation =
+            AVS_RBTREE_FIND(conn->observations,
+                            _anjay_observation_query(&PERSISTENCE_TEST_TOKEN));
+    AVS_UNIT_ASSERT_NOT_NULL(observation);
+    AVS_UNIT_ASSERT_EQUAL(observation->action, ANJAY_ACTION_READ);
+    AVS_UNIT_ASSERT_EQUAL(observation->paths_count, 1);
+    AVS_UNIT_ASSERT_TRUE(_anjay_uri_path_equal(&observation->paths[0],
+                                               &MAKE_RESOURCE_PATH(42, 69, 4)));
+    AVS_UNIT_ASSERT_EQUAL(
+            observation->last_confirmable.since_real_epoch.seconds, 1000);
+    AVS_UNIT_ASSERT_EQUAL(
+            observation->last_sent->timestamp.since_real_epoch.seconds, 1000);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(&observation->notify_timer));
+
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 2);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(conn->unsent), 2);
+    AVS_UNIT_ASSERT_TRUE(conn->unsent->ref == observation);
+    AVS_UNIT_ASSERT_EQUAL(conn->unsent->timestamp.since_real_epoch.seconds,
+                          1010);
+    AVS_UNIT_ASSERT_TRUE(observation->last_unsent
+                         == AVS_LIST_NEXT(conn->unsent));
+    AVS_UNIT_ASSERT_EQUAL(
+            observation->last_unsent->timestamp.since_real_epoch.seconds, 1020);
+
+    ////// QUEUED NOTIFICATIONS //////
+    // Observe option values continue from the ones used before persisting
+    anjay->current_connection.server = anjay->servers->servers;
+    anjay->current_connection.conn_type = ANJAY_CONNECTION_PRIMARY;
+    _anjay_observe_sched_flush(anjay->current_connection);
+    memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
+
+    const coap_test_msg_t *notify_response =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE, "Res4"), OBSERVE(3),
+                     CONTENT_FORMAT(PLAINTEXT), PAYLOAD("515"));
+    avs_unit_mocksock_expect_output(mocksock, notify_response->content,
+                                    notify_response->length);
+    anjay_sched_run(anjay);
+
+    const coap_test_msg_t *notify_response2 =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 1, "Res4"),
+                     OBSERVE(4), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("516"));
+    avs_unit_mocksock_expect_output(mocksock, notify_response2->content,
+                                    notify_response2->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    AVS_UNIT_ASSERT_EQUAL(anjay->observe.unsent_count, 0);
+
+    ////// NOTIFICATION AFTER RESTORE //////
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &PERSISTENCE_TEST_ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    anjay_sched_run(anjay);
+
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(1, AVS_TIME_S));
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &PERSISTENCE_TEST_ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 517));
+    const coap_test_msg_t *notify_response3 =
+            COAP_MSG(NON, CONTENT, ID_TOKEN(MSG_ID_BASE + 2, "Res4"),
+                     OBSERVE(5), CONTENT_FORMAT(PLAINTEXT), PAYLOAD("517"));
+    avs_unit_mocksock_expect_output(mocksock, notify_response3->content,
+                                    notify_response3->length);
+    anjay_sched_run(anjay);
+    assert_observe_consistency(anjay);
+    assert_observe(anjay, 14, &PERSISTENCE_TEST_TOKEN,
+                   &MAKE_RESOURCE_PATH(42, 69, 4),
+                   &(const anjay_msg_details_t) {
+                       .msg_code = AVS_COAP_CODE_CONTENT,
+                       .format = AVS_COAP_FORMAT_PLAINTEXT
+                   },
+                   "517", 3);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(observe_persistence, truncated_stream) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    persist_observe_test_state(stream);
+    void *data = NULL;
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(stream, &data, &size));
+    avs_stream_cleanup(&stream);
+
+    DM_TEST_INIT_WITHOUT_SERVER;
+    avs_stream_inbuf_t in = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+    avs_stream_inbuf_set_buffer(&in, data, size);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_observe_restore(anjay, (avs_stream_t *) &in));
+    AVS_LIST(anjay_observe_restored_server_t) restored =
+            anjay->observe.restored;
+    AVS_UNIT_ASSERT_NOT_NULL(restored);
+
+    // a failed restore leaves previously restored state untouched
+    for (size_t length = 0; length < size; ++length) {
+        avs_stream_inbuf_set_buffer(&in, data, length);
+        AVS_UNIT_ASSERT_FAILED(
+                anjay_observe_restore(anjay, (avs_stream_t *) &in));
+        AVS_UNIT_ASSERT_TRUE(anjay->observe.restored == restored);
+    }
+    avs_free(data);
+
+    DM_TEST_FINISH;
+}
+
+// The functions below write data in the format used by observe_persistence.c,
+// so that malformed connection data can be fed to anjay_observe_restore().
+
+static void write_persisted_connection(avs_stream_t *out,
+                                       void *data,
+                                       size_t size) {
+    avs_persistence_context_t ctx = avs_persistence_store_context_create(out);
+    uint8_t version = 0;
+    bool more = true;
+    anjay_ssid_t ssid = 14;
+    anjay_registration_info_t registration_info;
+    memset(&registration_info, 0, sizeof(registration_info));
+    uint32_t conn_count = 1;
+    uint8_t conn_type = ANJAY_CONNECTION_PRIMARY;
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_magic_string(&ctx, "OBS"));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_version(
+            &ctx, &version, (const uint8_t[]) { 0 }, 1));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_bool(&ctx, &more));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u16(&ctx, &ssid));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_registration_info_persistence(&ctx, &registration_info));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(&ctx, &conn_count));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u8(&ctx, &conn_type));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_sized_buffer(&ctx, &data, &size));
+    more = false;
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_bool(&ctx, &more));
+}
+
+static void write_persisted_value(avs_persistence_context_t *ctx,
+                                  uint32_t values_count) {
+    uint8_t msg_code = AVS_COAP_CODE_CONTENT;
+    uint16_t format = AVS_COAP_FORMAT_PLAINTEXT;
+    uint8_t reliability_hint = AVS_COAP_NOTIFY_PREFER_NON_CONFIRMABLE;
+    avs_time_real_t timestamp = avs_time_real_from_scalar(1000, AVS_TIME_S);
+    anjay_batch_builder_t *builder = _anjay_batch_builder_new();
+    AVS_UNIT_ASSERT_NOT_NULL(builder);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_add_int(
+            builder, &MAKE_RESOURCE_PATH(42, 69, 4), AVS_TIME_REAL_INVALID,
+            514));
+    anjay_batch_t *batch = _anjay_batch_builder_compile(&builder);
+    AVS_UNIT_ASSERT_NOT_NULL(batch);
+
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u8(ctx, &msg_code));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u16(ctx, &format));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u8(ctx, &reliability_hint));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_persistence_time_real(ctx, &timestamp));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(ctx, &values_count));
+    for (uint32_t i = 0; i < values_count; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_batch_persist(ctx, batch));
+    }
+    _anjay_batch_release(&batch);
+}
+
+static void write_persisted_token(avs_persistence_context_t *ctx) {
+    avs_coap_token_t token = PERSISTENCE_TEST_TOKEN;
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u8(ctx, &token.size));
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_persistence_bytes(ctx, token.bytes, token.size));
+}
+
+/**
+ * Writes connection data with a single observation of /42/69/4, with
+ * @p values_count batches in its last sent value. The avs_coap part of the
+ * observation is not written, so restoring it always fails.
+ */
+static void write_observation_data(avs_stream_t *out, uint32_t values_count) {
+    avs_persistence_context_t ctx = avs_persistence_store_context_create(out);
+    uint32_t count = 1;
+    uint8_t action = ANJAY_ACTION_READ;
+    uint32_t paths_count = 1;
+    anjay_uri_path_t path = MAKE_RESOURCE_PATH(42, 69, 4);
+    avs_time_real_t last_confirmable =
+            avs_time_real_from_scalar(1000, AVS_TIME_S);
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(&ctx, &count));
+    write_persisted_token(&ctx);
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u8(&ctx, &action));
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(&ctx, &paths_count));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_persistence_uri_path(&ctx, &path));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_persistence_time_real(&ctx, &last_confirmable));
+    write_persisted_value(&ctx, values_count);
+}
+
+/**
+ * Writes connection data with no observations and a single queued value for
+ * a token that is not observed. Such data is valid; the value is dropped.
+ */
+static void write_unsent_value_data(avs_stream_t *out) {
+    avs_persistence_context_t ctx = avs_persistence_store_context_create(out);
+    uint32_t count = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(&ctx, &count));
+    count = 1;
+    AVS_UNIT_ASSERT_SUCCESS(avs_persistence_u32(&ctx, &count));
+    write_persisted_token(&ctx);
+    write_persisted_value(&ctx, 1);
+}
+
+static void restore_connection_data(void *data, size_t size) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    write_persisted_connection(stream, data, size);
+
+    DM_TEST_INIT_WITHOUT_SERVER;
+    // connection data is only parsed when the connection is brought online
+    AVS_UNIT_ASSERT_SUCCESS(anjay_observe_restore(anjay, stream));
+    avs_stream_cleanup(&stream);
+    _anjay_test_dm_install_socket(anjay, 14);
+    // whatever was restored before the error is released again, as there
+    // is no usable observation in the data
+    AVS_UNIT_ASSERT_NULL(anjay->observe.connection_entries);
+
+    DM_TEST_FINISH;
+}
+
+static void restore_all_prefixes(void (*write_data)(avs_stream_t *)) {
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    write_data(stream);
+    void *data = NULL;
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(stream, &data, &size));
+    avs_stream_cleanup(&stream);
+
+    for (size_t length = 0; length <= size; ++length) {
+        restore_connection_data(data, length);
+    }
+    avs_free(data);
+}
+
+static void write_valid_observation_data(avs_stream_t *out) {
+    write_observation_data(out, 1);
+}
+
+AVS_UNIT_TEST(observe_persistence, truncated_observation) {
+    restore_all_prefixes(write_valid_observation_data);
+}
+
+AVS_UNIT_TEST(observe_persistence, truncated_unsent_value) {
+    restore_all_prefixes(write_unsent_value_data);
+}
+
+AVS_UNIT_TEST(observe_persistence, value_count_mismatch) {
+    // two batches in the last sent value of a single-path observation
+    avs_stream_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    write_observation_data(stream, 2);
+    void *data = NULL;
+    size_t size = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_membuf_take_ownership(stream, &data, &size));
+    avs_stream_cleanup(&stream);
+
+    restore_connection_data(data, size);
+    avs_free(data);
+}
+#endif // ANJAY_OBSERVE_PERSISTENCE
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/mock_clock.h>
+
+#define TEST_TIMERS 8
+
+typedef struct {
+    avs_sched_t *sched;
+    anjay_timer_wheel_t wheel;
+    anjay_timer_t timers[TEST_TIMERS];
+    avs_time_monotonic_t start;
+    size_t fired[TEST_TIMERS * 4];
+    size_t fired_count;
+    // number of times timers[0] reschedules itself when fired
+    size_t reschedules_left;
+} timer_wheel_test_env_t;
+
+static void test_handler(anjay_timer_wheel_t *wheel, anjay_timer_t *timer) {
+    timer_wheel_test_env_t *env =
+            AVS_CONTAINER_OF(wheel, timer_wheel_test_env_t, wheel);
+    AVS_UNIT_ASSERT_FALSE(_anjay_timer_scheduled(timer));
+    AVS_UNIT_ASSERT_TRUE(env->fired_count < AVS_ARRAY_SIZE(env->fired));
+    env->fired[env->fired_count++] = (size_t) (timer - env->timers);
+    if (timer == &env->timers[0] && env->reschedules_left) {
+        --env->reschedules_left;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_timer_schedule(
+                wheel, timer,
+                avs_time_monotonic_add(timer->expiry,
+                                       avs_time_duration_from_scalar(
+                                               1, AVS_TIME_S))));
+    }
+}
+
+static void env_setup_with_granularity(timer_wheel_test_env_t *env,
+                                       avs_time_duration_t granularity) {
+    memset(env, 0, sizeof(*env));
+    env->start = avs_time_monotonic_from_scalar(1000, AVS_TIME_S);
+    _anjay_mock_clock_start(env->start);
+    AVS_UNIT_ASSERT_NOT_NULL((env->sched = avs_sched_new("timer-wheel", NULL)));
+    _anjay_timer_wheel_init(&env->wheel, env->sched, granularity,
+                            test_handler);
+}
+
+static void env_setup(timer_wheel_test_env_t *env) {
+    env_setup_with_granularity(env,
+                               avs_time_duration_from_scalar(1, AVS_TIME_S));
+}
+
+static void env_teardown(timer_wheel_test_env_t *env) {
+    for (size_t i = 0; i < TEST_TIMERS; ++i) {
+        _anjay_timer_cancel(&env->wheel, &env->timers[i]);
+    }
+    _anjay_timer_wheel_cleanup(&env->wheel);
+    avs_sched_cleanup(&env->sched);
+    _anjay_mock_clock_finish();
+}
+
+static void schedule_at(timer_wheel_test_env_t *env,
+                        size_t index,
+                        int64_t offset_ms) {
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_timer_schedule(
+            &env->wheel, &env->timers[index],
+            avs_time_monotonic_add(env->start,
+                                   avs_time_duration_from_scalar(
+                                           offset_ms, AVS_TIME_MS))));
+}
+
+static void run_at(timer_wheel_test_env_t *env, int64_t offset_ms) {
+    avs_time_duration_t advance = avs_time_monotonic_diff(
+            avs_time_monotonic_add(env->start,
+                                   avs_time_duration_from_scalar(
+                                           offset_ms, AVS_TIME_MS)),
+            avs_time_monotonic_now());
+    if (avs_time_duration_less(AVS_TIME_DURATION_ZERO, advance)) {
+        _anjay_mock_clock_advance(advance);
+    }
+    avs_sched_run(env->sched);
+}
+
+static void assert_fired(timer_wheel_test_env_t *env,
+                         const size_t *expected,
+                         size_t expected_count) {
+    AVS_UNIT_ASSERT_EQUAL(env->fired_count, expected_count);
+    for (size_t i = 0; i < expected_count; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(env->fired[i], expected[i]);
+    }
+    env->fired_count = 0;
+}
+
+#define ASSERT_FIRED(Env, ...)                                         \
+    assert_fired((Env), (const size_t[]) { __VA_ARGS__ },              \
+                 sizeof((const size_t[]) { __VA_ARGS__ }) / sizeof(size_t))
+
+#define ASSERT_NONE_FIRED(Env) AVS_UNIT_ASSERT_EQUAL((Env)->fired_count, 0)
+
+AVS_UNIT_TEST(timer_wheel, fires_in_order_across_levels) {
+    timer_wheel_test_env_t env;
+    env_setup(&env);
+
+    // level 0, level 1, level 2 and overflow, in scrambled order
+    schedule_at(&env, 3, 100000000000); // over 1000 days
+    schedule_at(&env, 1, 100000);
+    schedule_at(&env, 2, 5000000);
+    schedule_at(&env, 0, 3000);
+
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            avs_sched_time(&env.wheel.job),
+            avs_time_monotonic_add(
+                    env.start, avs_time_duration_from_scalar(3, AVS_TIME_S))));
+
+    run_at(&env, 2999);
+    ASSERT_NONE_FIRED(&env);
+    run_at(&env, 3000);
+    ASSERT_FIRED(&env, 0);
+    run_at(&env, 99999);
+    ASSERT_NONE_FIRED(&env);
+    run_at(&env, 100000);
+    ASSERT_FIRED(&env, 1);
+    run_at(&env, 5000000);
+    ASSERT_FIRED(&env, 2);
+    run_at(&env, 99999999999);
+    ASSERT_NONE_FIRED(&env);
+    run_at(&env, 100000000000);
+    ASSERT_FIRED(&env, 3);
+    AVS_UNIT_ASSERT_NULL(env.wheel.job);
+
+    env_teardown(&env);
+}
+
+AVS_UNIT_TEST(timer_wheel, whole_tick_fires_together) {
+    timer_wheel_test_env_t env;
+    env_setup(&env);
+
+    schedule_at(&env, 1, 1700);
+    schedule_at(&env, 0, 1200);
+    schedule_at(&env, 2, 2000);
+    // a single job at the end of the tick
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            avs_sched_time(&env.wheel.job),
+            avs_time_monotonic_add(
+                    env.start, avs_time_duration_from_scalar(2, AVS_TIME_S))));
+
+    // never fired early
+    run_at(&env, 1500);
+    ASSERT_NONE_FIRED(&env);
+    run_at(&env, 1999);
+    ASSERT_NONE_FIRED(&env);
+    // in order of exact expiry
+    run_at(&env, 2000);
+    ASSERT_FIRED(&env, 0, 1, 2);
+    AVS_UNIT_ASSERT_NULL(env.wheel.job);
+
+    env_teardown(&env);
+}
+
+AVS_UNIT_TEST(timer_wheel, millisecond_granularity_by_default) {
+    timer_wheel_test_env_t env;
+    env_setup_with_granularity(&env, AVS_TIME_DURATION_ZERO);
+
+    schedule_at(&env, 1, 1700);
+    schedule_at(&env, 0, 1200);
+
+    run_at(&env, 1199);
+    ASSERT_NONE_FIRED(&env);
+    run_at(&env, 1500);
+    ASSERT_FIRED(&env, 0);
+    AVS_UNIT_ASSERT_TRUE(_anjay_timer_scheduled(&env.timers[1]));
+    run_at(&env, 1699);
+    ASSERT_NONE_FIRED(&env);
+    run_at(&env, 1700);
+    ASSERT_FIRED(&env, 1);
+
+    env_teardown(&env);
+}
+
+AVS_UNIT_TEST(timer_wheel, fires_all_due_in_one_pass) {
+    timer_wheel_test_env_t env;
+    env_setup(&env);
+
+    for (size_t i = 0; i < TEST_TIMERS; ++i) {
+        schedule_at(&env, i, 10000 + 100 * (int64_t) (i % 3));
+    }
+    avs_sched_run(env.sched);
+    ASSERT_NONE_FIRED(&env);
+
+    run_at(&env, 20000);
+    ASSERT_FIRED(&env, 0, 3, 6, 1, 4, 7, 2, 5);
+    for (size_t i = 0; i < TEST_TIMERS; ++i) {
+        AVS_UNIT_ASSERT_FALSE(_anjay_timer_scheduled(&env.timers[i]));
+    }
+    AVS_UNIT_ASSERT_NULL(env.wheel.job);
+
+    env_teardown(&env);
+}
+
+AVS_UNIT_TEST(timer_wheel, cancel_and_reschedule) {
+    timer_wheel_test_env_t env;
+    env_setup(&env);
+
+    schedule_at(&env, 0, 1000);
+    schedule_at(&env, 1, 2000);
+    schedule_at(&env, 2, 3000);
+
+    _anjay_timer_cancel(&env.wheel, &env.timers[1]);
+    AVS_UNIT_ASSERT_FALSE(_anjay_timer_scheduled(&env.timers[1]));
+    AVS_UNIT_ASSERT_FALSE(
+            avs_time_monotonic_valid(_anjay_timer_expiry(&env.timers[1])));
+    // cancelling an unscheduled timer is a no-op
+    _anjay_timer_cancel(&env.wheel, &env.timers[1]);
+
+    // move timer 0 after timer 2
+    schedule_at(&env, 0, 70000);
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            _anjay_timer_expiry(&env.timers[0]),
+            avs_time_monotonic_add(env.start, avs_time_duration_from_scalar(
+                                                      70, AVS_TIME_S))));
+
+    run_at(&env, 100000);
+    ASSERT_FIRED(&env, 2, 0);
+
+    env_teardown(&env);
+}
+
+AVS_UNIT_TEST(timer_wheel, reschedule_from_handler) {
+    timer_wheel_test_env_t env;
+    env_setup(&env);
+
+    env.reschedules_left = 3;
+    schedule_at(&env, 0, 0);
+    schedule_at(&env, 1, 2500);
+
+    run_at(&env, 0);
+    ASSERT_FIRED(&env, 0);
+    run_at(&env, 1000);
+    ASSERT_FIRED(&env, 0);
+    run_at(&env, 2000);
+    ASSERT_FIRED(&env, 0);
+    run_at(&env, 3000);
+    ASSERT_FIRED(&env, 1, 0);
+    AVS_UNIT_ASSERT_FALSE(_anjay_timer_scheduled(&env.timers[0]));
+    AVS_UNIT_ASSERT_NULL(env.wheel.job);
+
+    env_teardown(&env);
+}
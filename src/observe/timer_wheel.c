@@ -0,0 +1,383 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <avsystem/commons/defs.h>
+
+#include "timer_wheel.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+// pseudo-levels for timers that are not in any slot
+#define OVERFLOW_LEVEL ANJAY_TIMER_WHEEL_LEVELS
+#define DUE_LEVEL (ANJAY_TIMER_WHEEL_LEVELS + 1)
+
+static int64_t time_to_us(avs_time_monotonic_t time) {
+    int64_t us;
+    if (avs_time_duration_to_scalar(&us, AVS_TIME_US,
+                                    time.since_monotonic_epoch)
+            || us < 0) {
+        return 0;
+    }
+    return us;
+}
+
+// index of the first tick that ends at or after @p time
+static uint64_t tick_rounded_up(const anjay_timer_wheel_t *wheel,
+                                avs_time_monotonic_t time) {
+    const int64_t us = time_to_us(time);
+    return (uint64_t) (us / wheel->granularity_us
+                       + (us % wheel->granularity_us ? 1 : 0));
+}
+
+// index of the last tick that ended at or before @p time
+static uint64_t tick_rounded_down(const anjay_timer_wheel_t *wheel,
+                                  avs_time_monotonic_t time) {
+    return (uint64_t) (time_to_us(time) / wheel->granularity_us);
+}
+
+static avs_time_monotonic_t tick_end(const anjay_timer_wheel_t *wheel,
+                                     uint64_t tick) {
+    return avs_time_monotonic_from_scalar(
+            (int64_t) tick * wheel->granularity_us, AVS_TIME_US);
+}
+
+static void list_insert(anjay_timer_t **head, anjay_timer_t *timer) {
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+}
+
+static void list_unlink(anjay_timer_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+static int lowest_bit(uint64_t value) {
+    assert(value);
+    int result = 0;
+    while (!(value & 1)) {
+        value >>= 1;
+        ++result;
+    }
+    return result;
+}
+
+static int lowest_occupied_level(const anjay_timer_wheel_t *wheel) {
+    for (int level = 0; level < ANJAY_TIMER_WHEEL_LEVELS; ++level) {
+        if (wheel->occupied[level]) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Timers are placed on the level corresponding to the most significant group
+ * of bits in which their tick differs from the current one. This guarantees
+ * that all timers on lower levels expire before any timer on higher ones, and
+ * that within a level, slots are ordered by index.
+ */
+static void place_timer(anjay_timer_wheel_t *wheel, anjay_timer_t *timer) {
+    assert(timer->tick >= wheel->current_tick);
+    const uint64_t diff = timer->tick ^ wheel->current_tick;
+    uint8_t level = 0;
+    while (level < ANJAY_TIMER_WHEEL_LEVELS
+           && (diff >> ((level + 1) * ANJAY_TIMER_WHEEL_SLOT_BITS))) {
+        ++level;
+    }
+    timer->level = level;
+    if (level == OVERFLOW_LEVEL) {
+        list_insert(&wheel->overflow, timer);
+        return;
+    }
+    timer->slot = (uint8_t) ((timer->tick >> (level
+                                              * ANJAY_TIMER_WHEEL_SLOT_BITS))
+                             & (ANJAY_TIMER_WHEEL_SLOTS - 1));
+    list_insert(&wheel->slots[level][timer->slot], timer);
+    wheel->occupied[level] |= (uint64_t) 1 << timer->slot;
+}
+
+static void remove_timer(anjay_timer_wheel_t *wheel, anjay_timer_t *timer) {
+    list_unlink(timer);
+    if (timer->level < ANJAY_TIMER_WHEEL_LEVELS
+            && !wheel->slots[timer->level][timer->slot]) {
+        wheel->occupied[timer->level] &= ~((uint64_t) 1 << timer->slot);
+    }
+}
+
+static anjay_timer_t *pop_front(anjay_timer_t **head) {
+    anjay_timer_t *timer = *head;
+    if (timer) {
+        list_unlink(timer);
+    }
+    return timer;
+}
+
+static void redistribute_overflow(anjay_timer_wheel_t *wheel) {
+    anjay_timer_t *timers = wheel->overflow;
+    wheel->overflow = NULL;
+    if (timers) {
+        timers->pprev = &timers;
+    }
+    anjay_timer_t *timer;
+    while ((timer = pop_front(&timers))) {
+        place_timer(wheel, timer);
+    }
+}
+
+static void set_current_tick(anjay_timer_wheel_t *wheel, uint64_t tick) {
+    assert(tick >= wheel->current_tick);
+    const uint64_t old_tick = wheel->current_tick;
+    wheel->current_tick = tick;
+    if ((old_tick ^ tick)
+            >> (ANJAY_TIMER_WHEEL_LEVELS * ANJAY_TIMER_WHEEL_SLOT_BITS)) {
+        // may only happen if all levels are empty
+        redistribute_overflow(wheel);
+    }
+}
+
+/**
+ * Moves all timers from ticks that ended at @p now or earlier to the due list,
+ * cascading timers from higher levels as necessary.
+ */
+static void collect_due(anjay_timer_wheel_t *wheel, avs_time_monotonic_t now) {
+    const uint64_t now_tick =
+            AVS_MAX(tick_rounded_down(wheel, now), wheel->current_tick);
+    while (true) {
+        const int level = lowest_occupied_level(wheel);
+        if (level < 0) {
+            anjay_timer_t *timer = wheel->overflow;
+            if (!timer) {
+                break;
+            }
+            uint64_t min_tick = timer->tick;
+            for (; timer; timer = timer->next) {
+                min_tick = AVS_MIN(min_tick, timer->tick);
+            }
+            if (min_tick > now_tick) {
+                break;
+            }
+            // overflowed timers always differ from the current tick on the
+            // most significant bits, so this redistributes them
+            set_current_tick(wheel, min_tick);
+            continue;
+        }
+
+        const int slot = lowest_bit(wheel->occupied[level]);
+        const unsigned shift = (unsigned) level * ANJAY_TIMER_WHEEL_SLOT_BITS;
+        const uint64_t block_mask =
+                ((uint64_t) 1 << (shift + ANJAY_TIMER_WHEEL_SLOT_BITS)) - 1;
+        const uint64_t slot_tick = (wheel->current_tick & ~block_mask)
+                                   | ((uint64_t) slot << shift);
+        if (slot_tick > now_tick) {
+            break;
+        }
+        set_current_tick(wheel, slot_tick);
+
+        anjay_timer_t *timers = wheel->slots[level][slot];
+        wheel->slots[level][slot] = NULL;
+        wheel->occupied[level] &= ~((uint64_t) 1 << slot);
+        timers->pprev = &timers;
+
+        anjay_timer_t *timer;
+        while ((timer = pop_front(&timers))) {
+            if (level == 0) {
+                // the whole tick is handled at once
+                timer->level = DUE_LEVEL;
+                list_insert(&wheel->due, timer);
+            } else {
+                // cascades timers from higher levels
+                place_timer(wheel, timer);
+            }
+        }
+    }
+    set_current_tick(wheel, now_tick);
+}
+
+static anjay_timer_t *merge_by_expiry(anjay_timer_t *left,
+                                      anjay_timer_t *right) {
+    anjay_timer_t *result = NULL;
+    anjay_timer_t **tail = &result;
+    while (left && right) {
+        anjay_timer_t **min =
+                avs_time_monotonic_before(right->expiry, left->expiry)
+                        ? &right
+                        : &left;
+        *tail = *min;
+        tail = &(*min)->next;
+        *min = (*min)->next;
+    }
+    *tail = left ? left : right;
+    return result;
+}
+
+static anjay_timer_t *sort_by_expiry(anjay_timer_t *list) {
+    if (!list || !list->next) {
+        return list;
+    }
+    anjay_timer_t *slow = list;
+    for (anjay_timer_t *fast = list->next; fast && fast->next;
+         fast = fast->next->next) {
+        slow = slow->next;
+    }
+    anjay_timer_t *second_half = slow->next;
+    slow->next = NULL;
+    return merge_by_expiry(sort_by_expiry(list), sort_by_expiry(second_half));
+}
+
+/**
+ * Slots are not ordered, so due timers are sorted before firing, to fire them
+ * in the same order as separate scheduler jobs would.
+ */
+static void sort_due(anjay_timer_wheel_t *wheel) {
+    wheel->due = sort_by_expiry(wheel->due);
+    for (anjay_timer_t **pprev = &wheel->due; *pprev;
+         pprev = &(*pprev)->next) {
+        (*pprev)->pprev = pprev;
+    }
+}
+
+/**
+ * Returns the end of the earliest occupied tick, or AVS_TIME_MONOTONIC_INVALID
+ * if there are no timers.
+ */
+static avs_time_monotonic_t
+earliest_tick_end(const anjay_timer_wheel_t *wheel) {
+    const anjay_timer_t *timer = wheel->overflow;
+    const int level = lowest_occupied_level(wheel);
+    if (level >= 0) {
+        timer = wheel->slots[level][lowest_bit(wheel->occupied[level])];
+    }
+    if (!timer) {
+        return AVS_TIME_MONOTONIC_INVALID;
+    }
+    uint64_t min_tick = timer->tick;
+    for (; timer; timer = timer->next) {
+        min_tick = AVS_MIN(min_tick, timer->tick);
+    }
+    return tick_end(wheel, min_tick);
+}
+
+static void wheel_job(avs_sched_t *sched, const void *wheel_ptr);
+
+static int reschedule_job(anjay_timer_wheel_t *wheel,
+                          avs_time_monotonic_t instant) {
+    if (!avs_time_monotonic_valid(instant)) {
+        avs_sched_del(&wheel->job);
+        return 0;
+    }
+    if (wheel->job
+            && !avs_time_monotonic_before(instant,
+                                          avs_sched_time(&wheel->job))) {
+        return 0;
+    }
+    avs_sched_del(&wheel->job);
+    return AVS_SCHED_AT(wheel->sched, &wheel->job, instant, wheel_job, &wheel,
+                        sizeof(wheel));
+}
+
+static void wheel_job(avs_sched_t *sched, const void *wheel_ptr) {
+    (void) sched;
+    anjay_timer_wheel_t *wheel = *(anjay_timer_wheel_t *const *) wheel_ptr;
+    assert(!wheel->destroyed_flag);
+
+    collect_due(wheel, avs_time_monotonic_now());
+    sort_due(wheel);
+
+    // the handler may destroy the wheel, e.g. by closing the connection
+    bool destroyed = false;
+    wheel->destroyed_flag = &destroyed;
+    anjay_timer_t *timer;
+    while ((timer = pop_front(&wheel->due))) {
+        wheel->handler(wheel, timer);
+        if (destroyed) {
+            return;
+        }
+    }
+    wheel->destroyed_flag = NULL;
+
+    avs_sched_del(&wheel->job);
+    if (reschedule_job(wheel, earliest_tick_end(wheel))) {
+        // there is no way to report the error; retry as soon as possible
+        AVS_SCHED_NOW(wheel->sched, &wheel->job, wheel_job, &wheel,
+                      sizeof(wheel));
+    }
+}
+
+void _anjay_timer_wheel_init(anjay_timer_wheel_t *wheel,
+                             avs_sched_t *sched,
+                             avs_time_duration_t granularity,
+                             anjay_timer_handler_t *handler) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->sched = sched;
+    wheel->handler = handler;
+    if (avs_time_duration_to_scalar(&wheel->granularity_us, AVS_TIME_US,
+                                    granularity)
+            || wheel->granularity_us < 1000) {
+        wheel->granularity_us = 1000;
+    }
+    wheel->current_tick = tick_rounded_down(wheel, avs_time_monotonic_now());
+}
+
+void _anjay_timer_wheel_cleanup(anjay_timer_wheel_t *wheel) {
+    assert(lowest_occupied_level(wheel) < 0);
+    assert(!wheel->overflow);
+    assert(!wheel->due);
+    avs_sched_del(&wheel->job);
+    if (wheel->destroyed_flag) {
+        *wheel->destroyed_flag = true;
+        wheel->destroyed_flag = NULL;
+    }
+}
+
+int _anjay_timer_schedule(anjay_timer_wheel_t *wheel,
+                          anjay_timer_t *timer,
+                          avs_time_monotonic_t expiry) {
+    assert(avs_time_monotonic_valid(expiry));
+    _anjay_timer_cancel(wheel, timer);
+    timer->expiry = expiry;
+    timer->tick = AVS_MAX(tick_rounded_up(wheel, expiry), wheel->current_tick);
+    place_timer(wheel, timer);
+    // while firing timers, the job is rescheduled after the whole pass
+    if (!wheel->destroyed_flag
+            && reschedule_job(wheel, tick_end(wheel, timer->tick))) {
+        remove_timer(wheel, timer);
+        return -1;
+    }
+    return 0;
+}
+
+void _anjay_timer_cancel(anjay_timer_wheel_t *wheel, anjay_timer_t *timer) {
+    if (_anjay_timer_scheduled(timer)) {
+        remove_timer(wheel, timer);
+    }
+}
+
+#ifdef ANJAY_TEST
+#    include "test/timer_wheel.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_OBSERVE_TIMER_WHEEL_H
+#define ANJAY_OBSERVE_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <avsystem/commons/sched.h>
+#include <avsystem/commons/time.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Hierarchical timing wheel, used for observation timers instead of scheduling
+ * a separate avs_sched_t job for each of them.
+ *
+ * Timers are kept in buckets of ticks of configurable length, so inserting and
+ * cancelling them is O(1), and only a single scheduler job per wheel is ever
+ * active. Expiry times are rounded up to the end of the tick they fall into -
+ * timers never fire early, but may fire up to one tick late. The job runs at
+ * the end of the earliest occupied tick and fires all timers from that tick,
+ * and any earlier ones, in a single pass.
+ *
+ * Level 0 has ANJAY_TIMER_WHEEL_SLOTS slots of one tick each, and each next
+ * level has the same number of slots, each spanning a whole rotation of the
+ * previous level. Timers further in the future than the last level can cover
+ * are kept in an unsorted overflow list.
+ */
+#define ANJAY_TIMER_WHEEL_SLOT_BITS 6
+#define ANJAY_TIMER_WHEEL_SLOTS (1 << ANJAY_TIMER_WHEEL_SLOT_BITS)
+#define ANJAY_TIMER_WHEEL_LEVELS 4
+
+typedef struct anjay_timer_struct {
+    struct anjay_timer_struct *next;
+    // NULL if the timer is not scheduled
+    struct anjay_timer_struct **pprev;
+    avs_time_monotonic_t expiry;
+    // index of the tick at the end of which the timer fires
+    uint64_t tick;
+    // values of ANJAY_TIMER_WHEEL_LEVELS and above denote the overflow and
+    // due lists
+    uint8_t level;
+    uint8_t slot;
+} anjay_timer_t;
+
+typedef struct anjay_timer_wheel_struct anjay_timer_wheel_t;
+
+typedef void anjay_timer_handler_t(anjay_timer_wheel_t *wheel,
+                                   anjay_timer_t *timer);
+
+struct anjay_timer_wheel_struct {
+    avs_sched_t *sched;
+    anjay_timer_handler_t *handler;
+    avs_sched_handle_t job;
+    // length of a single tick, in microseconds
+    int64_t granularity_us;
+
+    // all timers with ticks earlier than this have already been fired
+    uint64_t current_tick;
+    uint64_t occupied[ANJAY_TIMER_WHEEL_LEVELS];
+    anjay_timer_t *slots[ANJAY_TIMER_WHEEL_LEVELS][ANJAY_TIMER_WHEEL_SLOTS];
+    anjay_timer_t *overflow;
+    // timers already detected as expired, to be fired by the current pass
+    anjay_timer_t *due;
+    // non-NULL only while timers are being fired; set to true if the wheel
+    // is cleaned up by one of the handlers
+    bool *destroyed_flag;
+};
+
+/**
+ * Initializes an empty wheel. @p handler will be called from a job scheduled
+ * in @p sched for each expired timer; the timer is no longer scheduled at that
+ * point, so the handler may reschedule it.
+ *
+ * @p granularity is the length of a single tick. Values shorter than one
+ * millisecond (including invalid ones) are treated as one millisecond.
+ *
+ * The wheel MUST NOT be moved in memory after initialization.
+ */
+void _anjay_timer_wheel_init(anjay_timer_wheel_t *wheel,
+                             avs_sched_t *sched,
+                             avs_time_duration_t granularity,
+                             anjay_timer_handler_t *handler);
+
+/**
+ * Cancels the scheduler job of the wheel. All timers need to be cancelled
+ * before.
+ */
+void _anjay_timer_wheel_cleanup(anjay_timer_wheel_t *wheel);
+
+/**
+ * Schedules (or reschedules, if already scheduled) @p timer to fire at the end
+ * of the tick that contains @p expiry . Expiry times in the past cause the
+ * timer to fire during the next scheduler run.
+ *
+ * @returns 0 on success, or a negative value if the scheduler job could not be
+ *          scheduled. The timer is not scheduled in that case.
+ */
+int _anjay_timer_schedule(anjay_timer_wheel_t *wheel,
+                          anjay_timer_t *timer,
+                          avs_time_monotonic_t expiry);
+
+/**
+ * Cancels @p timer . Does nothing if it is not scheduled.
+ */
+void _anjay_timer_cancel(anjay_timer_wheel_t *wheel, anjay_timer_t *timer);
+
+static inline bool _anjay_timer_scheduled(const anjay_timer_t *timer) {
+    return timer->pprev != NULL;
+}
+
+/**
+ * Returns the time at which @p timer will fire, or AVS_TIME_MONOTONIC_INVALID
+ * if it is not scheduled.
+ */
+static inline avs_time_monotonic_t
+_anjay_timer_expiry(const anjay_timer_t *timer) {
+    return _anjay_timer_scheduled(timer) ? timer->expiry
+                                         : AVS_TIME_MONOTONIC_INVALID;
+}
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_OBSERVE_TIMER_WHEEL_H */
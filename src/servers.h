@@ -193,6 +193,19 @@ void _anjay_servers_cleanup(anjay_t *anjay);
  */
 void _anjay_servers_cleanup_inactive(anjay_t *anjay);
 
+/**
+ * Drops the cached list of Objects and Object Instances sent in the Register
+ * and Update messages (see query_dm() in register.c), forcing it to be
+ * regenerated from the data model the next time it is needed.
+ *
+ * The payload is shared between all servers. It only depends on the set of
+ * registered Objects and the sets of their Instances, so it is called from
+ * anjay_register_object(), anjay_unregister_object() and from the notify
+ * subsystem whenever an instance set change is reported. Changes in Resource
+ * values do not affect it.
+ */
+void _anjay_servers_invalidate_registration_payload(anjay_t *anjay);
+
 typedef int anjay_servers_foreach_ssid_handler_t(anjay_t *anjay,
                                                  anjay_ssid_t ssid,
                                                  void *data);
@@ -424,6 +437,32 @@ void _anjay_server_update_registration_info(
         bool queue_mode,
         anjay_update_parameters_t *move_params);
 
+void _anjay_registration_info_cleanup(anjay_registration_info_t *info);
+
+/**
+ * Replaces the registration information of a server that has just been
+ * connected with @p move_info , so that the registration is resumed using an
+ * Update message (or a Register, if the lifetime passed in the meantime)
+ * instead of being created anew. Ownership of the data in @p move_info is
+ * taken, and it is zeroed out.
+ *
+ * This is used when restoring the client state after a restart - see
+ * anjay_observe_restore().
+ */
+void _anjay_server_resume_registration(anjay_server_info_t *server,
+                                       anjay_registration_info_t *move_info);
+
+#ifdef WITH_AVS_PERSISTENCE
+/**
+ * Stores or restores (depending on the direction of @p ctx) the registration
+ * information. The session token is not stored, as it is only meaningful
+ * within a single process.
+ */
+avs_error_t
+_anjay_registration_info_persistence(avs_persistence_context_t *ctx,
+                                     anjay_registration_info_t *info);
+#endif // WITH_AVS_PERSISTENCE
+
 /**
  * Handles a critical error (including network communication error) on the
  * primary connection of the server. Effectively disables the server, and might
@@ -142,6 +142,7 @@ void _anjay_server_on_refreshed(anjay_server_info_t *server,
         // failure to schedule a job. Not much that we can do about it then.
     } else {
         assert(avs_is_ok(err));
+        _anjay_observe_resume_registration(server);
         _anjay_server_ensure_valid_registration(server);
     }
 }
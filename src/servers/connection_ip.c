@@ -19,6 +19,7 @@
 #include <avsystem/commons/errno.h>
 #include <avsystem/commons/utils.h>
 
+#include <avsystem/coap/streaming.h>
 #include <avsystem/coap/udp.h>
 
 #include <inttypes.h>
@@ -114,11 +115,19 @@ static int ensure_udp_coap_context(anjay_t *anjay,
     if (!connection->coap_ctx) {
         connection->coap_ctx = avs_coap_udp_ctx_create(
                 anjay->sched, &anjay->udp_tx_params, anjay->in_shared_buffer,
-                anjay->out_shared_buffer, anjay->udp_response_cache);
+                anjay->out_shared_buffer, anjay->udp_response_cache,
+                anjay->udp_notify_cache_size);
         if (!connection->coap_ctx) {
             anjay_log(ERROR, _("could not create CoAP/UDP context"));
             return -1;
         }
+        if (avs_is_err(avs_coap_streaming_set_request_limits(
+                    connection->coap_ctx, anjay->coap_max_buffered_payload_size,
+                    anjay->coap_max_pending_requests))) {
+            anjay_log(ERROR, _("could not set CoAP request limits"));
+            avs_coap_ctx_cleanup(&connection->coap_ctx);
+            return -1;
+        }
     }
     return 0;
 }
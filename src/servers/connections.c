@@ -116,9 +116,17 @@ avs_error_t _anjay_server_connection_internal_bring_online(
     }
 
     avs_error_t err = avs_errno(AVS_ENOMEM);
-    if (def->ensure_coap_context(server->anjay, connection)
-            || avs_is_err((
-                       err = def->connect_socket(server->anjay, connection)))) {
+    if (!def->ensure_coap_context(server->anjay, connection)) {
+        if (!avs_coap_ctx_has_socket(connection->coap_ctx)) {
+            // observations can only be restored into a fresh CoAP context
+            _anjay_observe_restore_connection((anjay_connection_ref_t) {
+                .server = server,
+                .conn_type = conn_type
+            });
+        }
+        err = def->connect_socket(server->anjay, connection);
+    }
+    if (avs_is_err(err)) {
         connection->state = ANJAY_SERVER_CONNECTION_ERROR;
         _anjay_coap_ctx_cleanup(server->anjay, &connection->coap_ctx);
 
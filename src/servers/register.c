@@ -17,9 +17,12 @@
 #include <anjay_config.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <avsystem/commons/errno.h>
+#include <avsystem/commons/memory.h>
 #include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/utils.h>
 
 #include <avsystem/coap/async_client.h>
 #include <avsystem/coap/code.h>
@@ -311,7 +314,7 @@ static int query_dm_object(anjay_t *anjay,
     return 0;
 }
 
-static int query_dm(anjay_t *anjay, char **out) {
+static int build_registration_payload(anjay_t *anjay, char **out) {
     assert(out);
     assert(!*out);
     avs_stream_t *stream = avs_stream_membuf_create();
@@ -339,6 +342,27 @@ static int query_dm(anjay_t *anjay, char **out) {
     return retval;
 }
 
+static int query_dm(anjay_t *anjay, char **out) {
+    assert(out);
+    assert(!*out);
+    char **cache = &anjay->servers->registration_payload;
+    if (!*cache && build_registration_payload(anjay, cache)) {
+        return -1;
+    }
+    if (!(*out = avs_strdup(*cache))) {
+        anjay_log(ERROR, _("out of memory"));
+        return -1;
+    }
+    return 0;
+}
+
+void _anjay_servers_invalidate_registration_payload(anjay_t *anjay) {
+    if (anjay->servers) {
+        avs_free(anjay->servers->registration_payload);
+        anjay->servers->registration_payload = NULL;
+    }
+}
+
 static void update_parameters_cleanup(anjay_update_parameters_t *params) {
     avs_free(params->dm);
     params->dm = NULL;
@@ -1097,6 +1121,95 @@ static avs_time_real_t get_registration_expire_time(int64_t lifetime_s) {
                                                            AVS_TIME_S));
 }
 
+void _anjay_server_resume_registration(anjay_server_info_t *server,
+                                       anjay_registration_info_t *move_info) {
+    assert(_anjay_server_active(server));
+    anjay_registration_info_t *info = &server->registration_info;
+    _anjay_registration_info_cleanup(info);
+    *info = *move_info;
+    memset(move_info, 0, sizeof(*move_info));
+    info->session_token = _anjay_server_primary_session_token(server);
+    // the network address of the client has most likely changed, the server
+    // needs to be informed about it even if no parameters changed
+    info->update_forced = true;
+}
+
+#ifdef WITH_AVS_PERSISTENCE
+static avs_error_t
+persistence_string_list(avs_persistence_context_t *ctx,
+                        AVS_LIST(const anjay_string_t) *list_ptr) {
+    uint32_t count = (uint32_t) AVS_LIST_SIZE(*list_ptr);
+    avs_error_t err = avs_persistence_u32(ctx, &count);
+    if (avs_is_err(err)) {
+        return err;
+    }
+    if (avs_persistence_direction(ctx) == AVS_PERSISTENCE_STORE) {
+        AVS_LIST(const anjay_string_t) it;
+        AVS_LIST_FOREACH(it, *list_ptr) {
+            char *str = (char *) (intptr_t) it->c_str;
+            if (avs_is_err((err = avs_persistence_string(ctx, &str)))) {
+                return err;
+            }
+        }
+        return AVS_OK;
+    }
+
+    assert(!*list_ptr);
+    AVS_LIST(const anjay_string_t) *tail = list_ptr;
+    while (count--) {
+        char *str = NULL;
+        if (avs_is_err((err = avs_persistence_string(ctx, &str)))) {
+            return err;
+        }
+        if (!str) {
+            return avs_errno(AVS_EBADMSG);
+        }
+        const size_t size = strlen(str) + 1;
+        AVS_LIST(anjay_string_t) element =
+                (AVS_LIST(anjay_string_t)) AVS_LIST_NEW_BUFFER(size);
+        if (element) {
+            memcpy(element->c_str, str, size);
+            AVS_LIST_INSERT(tail, element);
+            AVS_LIST_ADVANCE_PTR(&tail);
+        }
+        avs_free(str);
+        if (!element) {
+            anjay_log(ERROR, _("out of memory"));
+            return avs_errno(AVS_ENOMEM);
+        }
+    }
+    return AVS_OK;
+}
+
+avs_error_t
+_anjay_registration_info_persistence(avs_persistence_context_t *ctx,
+                                     anjay_registration_info_t *info) {
+    uint8_t lwm2m_version = (uint8_t) info->lwm2m_version;
+    avs_error_t err;
+    (void) (avs_is_err((err = persistence_string_list(ctx,
+                                                      &info->endpoint_path)))
+            || avs_is_err((err = avs_persistence_u8(ctx, &lwm2m_version)))
+            || avs_is_err((err = avs_persistence_bool(ctx, &info->queue_mode)))
+            || avs_is_err((err = _anjay_persistence_time_real(
+                                   ctx, &info->expire_time)))
+            || avs_is_err((err = avs_persistence_i64(
+                                   ctx, &info->last_update_params.lifetime_s)))
+            || avs_is_err((err = avs_persistence_string(
+                                   ctx, &info->last_update_params.dm)))
+            || avs_is_err((err = avs_persistence_bytes(
+                                   ctx, info->last_update_params.binding_mode,
+                                   sizeof(info->last_update_params
+                                                  .binding_mode)))));
+    if (avs_is_ok(err)
+            && avs_persistence_direction(ctx) == AVS_PERSISTENCE_RESTORE) {
+        info->lwm2m_version = (anjay_lwm2m_version_t) lwm2m_version;
+        info->last_update_params.binding_mode
+                [sizeof(info->last_update_params.binding_mode) - 1] = '\0';
+    }
+    return err;
+}
+#endif // WITH_AVS_PERSISTENCE
+
 void _anjay_server_update_registration_info(
         anjay_server_info_t *server,
         AVS_LIST(const anjay_string_t) *move_endpoint_path,
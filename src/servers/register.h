@@ -27,8 +27,6 @@
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
-void _anjay_registration_info_cleanup(anjay_registration_info_t *info);
-
 void _anjay_registration_exchange_state_cleanup(
         anjay_registration_async_exchange_state_t *state);
 
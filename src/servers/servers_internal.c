@@ -73,6 +73,8 @@ void _anjay_servers_internal_cleanup(anjay_servers_t *servers) {
         _anjay_server_cleanup(servers->servers);
     }
     AVS_LIST_CLEAR(&servers->public_sockets);
+    avs_free(servers->registration_payload);
+    servers->registration_payload = NULL;
 }
 
 void _anjay_servers_deregister(anjay_t *anjay) {
@@ -46,6 +46,13 @@ struct anjay_servers_struct {
      * without requiring the user to clean it up.
      */
     AVS_LIST(anjay_socket_entry_t) public_sockets;
+
+    /**
+     * Cached link-format list of Objects and Object Instances, as sent in the
+     * Register and Update messages. NULL if it needs to be regenerated. See
+     * _anjay_servers_invalidate_registration_payload() for details.
+     */
+    char *registration_payload;
 };
 
 typedef struct {
@@ -547,6 +547,49 @@ AVS_UNIT_TEST(dm_write, resource) {
     DM_TEST_FINISH;
 }
 
+AVS_UNIT_TEST(dm_write, resource_larger_than_buffer) {
+#define PAYLOAD_STR "Lorem ipsum dolor sit amet, consectetur adipiscing elit"
+    DM_TEST_INIT_WITH_CONFIG(.coap_max_buffered_payload_size = 16);
+    // The first chunk fills the buffer exactly, the second one crosses its
+    // limit, so the write handler is called before the rest is received.
+    DM_TEST_REQUEST(mocksocks[0], CON, PUT, ID(0xFA3E), PATH("42", "514", "4"),
+                    CONTENT_FORMAT(PLAINTEXT), BLOCK1(0, 16, PAYLOAD_STR));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTINUE, ID(0xFA3E),
+                            BLOCK1_RES(0, 16, true));
+    DM_TEST_REQUEST(mocksocks[0], CON, PUT, ID(0xFA3F), PATH("42", "514", "4"),
+                    CONTENT_FORMAT(PLAINTEXT), BLOCK1(1, 16, PAYLOAD_STR));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTINUE, ID(0xFA3F),
+                            BLOCK1_RES(1, 16, true));
+    DM_TEST_REQUEST(mocksocks[0], CON, PUT, ID(0xFA40), PATH("42", "514", "4"),
+                    CONTENT_FORMAT(PLAINTEXT), BLOCK1(2, 16, PAYLOAD_STR));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTINUE, ID(0xFA40),
+                            BLOCK1_RES(2, 16, true));
+    DM_TEST_REQUEST(mocksocks[0], CON, PUT, ID(0xFA41), PATH("42", "514", "4"),
+                    CONTENT_FORMAT(PLAINTEXT), BLOCK1(3, 16, PAYLOAD_STR));
+    _anjay_mock_dm_expect_list_instances(
+            anjay, &OBJ, 0,
+            (const anjay_iid_t[]) { 14, 42, 69, 514, ANJAY_ID_INVALID });
+    _anjay_mock_dm_expect_list_resources(
+            anjay, &OBJ, 514, 0,
+            (const anjay_mock_dm_res_entry_t[]) {
+                    { 0, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    { 1, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    { 2, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    { 3, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    { 4, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    { 5, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    { 6, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+                    ANJAY_MOCK_DM_RES_END });
+    _anjay_mock_dm_expect_resource_write(anjay, &OBJ, 514, 4, ANJAY_ID_INVALID,
+                                         ANJAY_MOCK_DM_STRING(0, PAYLOAD_STR),
+                                         0);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CHANGED, ID(0xFA41),
+                            BLOCK1_RES(3, 16, false));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+#undef PAYLOAD_STR
+}
+
 AVS_UNIT_TEST(dm_write, resource_unsupported_format) {
     DM_TEST_INIT;
     DM_TEST_REQUEST(mocksocks[0], CON, PUT, ID(0xFA3E), PATH("42", "514", "4"),
@@ -2053,6 +2096,60 @@ AVS_UNIT_TEST(dm_create, multiple_iids) {
     DM_TEST_FINISH;
 }
 
+static int iid_hooks_instance_present(anjay_t *anjay,
+                                      const anjay_dm_object_def_t *const *obj_ptr,
+                                      anjay_iid_t iid) {
+    (void) anjay;
+    (void) obj_ptr;
+    return iid < 100;
+}
+
+static int
+iid_hooks_instance_select_free_iid(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t *out_iid) {
+    (void) anjay;
+    (void) obj_ptr;
+    *out_iid = 100;
+    return 0;
+}
+
+static const anjay_dm_object_def_t *const OBJ_WITH_IID_HOOKS =
+        &(const anjay_dm_object_def_t) {
+            .oid = 42,
+            .handlers = {
+                ANJAY_MOCK_DM_HANDLERS,
+                .instance_present = iid_hooks_instance_present,
+                .instance_select_free_iid = iid_hooks_instance_select_free_iid
+            }
+        };
+
+AVS_UNIT_TEST(dm_create, no_iid_with_hook) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_IID_HOOKS, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    DM_TEST_REQUEST(mocksocks[0], CON, POST, ID(0xFA3E), PATH("42"),
+                    CONTENT_FORMAT(OMA_LWM2M_TLV), NO_PAYLOAD);
+    // no list_instances call expected
+    _anjay_mock_dm_expect_instance_create(anjay, &OBJ_WITH_IID_HOOKS, 100, 0);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CREATED, ID(0xFA3E),
+                            LOCATION_PATH("42", "100"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_create, already_exists_with_hook) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_IID_HOOKS, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    DM_TEST_REQUEST(mocksocks[0], CON, POST, ID(0xFA3E), PATH("42"),
+                    CONTENT_FORMAT(OMA_LWM2M_TLV),
+                    PAYLOAD("\x00"
+                            "\x45"));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, BAD_REQUEST, ID(0xfa3e),
+                            NO_PAYLOAD);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(dm_delete, success) {
     DM_TEST_INIT;
     DM_TEST_REQUEST(mocksocks[0], CON, DELETE, ID(0xFA3E), PATH("42", "34"));
@@ -2094,6 +2191,20 @@ AVS_UNIT_TEST(dm_delete, not_exists) {
     DM_TEST_FINISH;
 }
 
+AVS_UNIT_TEST(dm_delete, with_hook) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_IID_HOOKS, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    DM_TEST_REQUEST(mocksocks[0], CON, DELETE, ID(0xFA3E), PATH("42", "34"));
+    _anjay_mock_dm_expect_instance_remove(anjay, &OBJ_WITH_IID_HOOKS, 34, 0);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, DELETED, ID(0xfa3e), NO_PAYLOAD);
+    DM_TEST_REQUEST(mocksocks[0], CON, DELETE, ID(0xFA3F), PATH("42", "134"));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, NOT_FOUND, ID(0xfa3f),
+                            NO_PAYLOAD);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(dm_delete, failure) {
     DM_TEST_INIT;
     DM_TEST_REQUEST(mocksocks[0], CON, DELETE, ID(0xFA3E), PATH("42", "84"));
@@ -3148,3 +3259,161 @@ AVS_UNIT_TEST(dm_res_read, objlnk) {
 
     DM_TEST_FINISH;
 }
+
+typedef struct {
+    anjay_oid_t oids[32];
+    size_t count;
+    anjay_oid_t break_after;
+} collected_oids_t;
+
+static int collect_oid(anjay_t *anjay,
+                       const anjay_dm_object_def_t *const *obj,
+                       void *collected_) {
+    (void) anjay;
+    collected_oids_t *collected = (collected_oids_t *) collected_;
+    AVS_UNIT_ASSERT_TRUE(collected->count < AVS_ARRAY_SIZE(collected->oids));
+    collected->oids[collected->count++] = (*obj)->oid;
+    return (*obj)->oid == collected->break_after ? ANJAY_FOREACH_BREAK : 0;
+}
+
+static collected_oids_t collect_oids(anjay_t *anjay, anjay_oid_t break_after) {
+    collected_oids_t collected = {
+        .break_after = break_after
+    };
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dm_foreach_object(anjay, collect_oid, &collected));
+    return collected;
+}
+
+AVS_UNIT_TEST(dm_objects, foreach_in_oid_order) {
+    DM_TEST_INIT;
+
+    static const anjay_dm_object_def_t DEF_300 = {
+        .oid = 300,
+        .handlers = { ANJAY_MOCK_DM_HANDLERS }
+    };
+    static const anjay_dm_object_def_t DEF_7 = {
+        .oid = 7,
+        .handlers = { ANJAY_MOCK_DM_HANDLERS }
+    };
+    static const anjay_dm_object_def_t DEF_150 = {
+        .oid = 150,
+        .handlers = { ANJAY_MOCK_DM_HANDLERS }
+    };
+    const anjay_dm_object_def_t *const def_300 = &DEF_300;
+    const anjay_dm_object_def_t *const def_7 = &DEF_7;
+    const anjay_dm_object_def_t *const def_150 = &DEF_150;
+
+    const size_t initial_count = collect_oids(anjay, ANJAY_ID_INVALID).count;
+
+    // registration order does not affect iteration order
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &def_300));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &def_7));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &def_150));
+    AVS_UNIT_ASSERT_FAILED(anjay_register_object(anjay, &def_150));
+
+    collected_oids_t collected = collect_oids(anjay, ANJAY_ID_INVALID);
+    AVS_UNIT_ASSERT_EQUAL(collected.count, initial_count + 3);
+    for (size_t i = 1; i < collected.count; ++i) {
+        AVS_UNIT_ASSERT_TRUE(collected.oids[i - 1] < collected.oids[i]);
+    }
+    AVS_UNIT_ASSERT_EQUAL(collected.oids[collected.count - 1], 300);
+    AVS_UNIT_ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 150) == &def_150);
+
+    // ANJAY_FOREACH_BREAK stops right after the given Object
+    collected = collect_oids(anjay, 150);
+    AVS_UNIT_ASSERT_EQUAL(collected.oids[collected.count - 1], 150);
+    AVS_UNIT_ASSERT_EQUAL(collected.count, initial_count + 2);
+
+    // an unregistered Object disappears from both lookup and iteration
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &def_150));
+    AVS_UNIT_ASSERT_NULL(_anjay_dm_find_object_by_oid(anjay, 150));
+    collected = collect_oids(anjay, ANJAY_ID_INVALID);
+    AVS_UNIT_ASSERT_EQUAL(collected.count, initial_count + 2);
+    for (size_t i = 0; i < collected.count; ++i) {
+        AVS_UNIT_ASSERT_NOT_EQUAL(collected.oids[i], 150);
+    }
+
+    // and may be registered again
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &def_150));
+    AVS_UNIT_ASSERT_TRUE(_anjay_dm_find_object_by_oid(anjay, 150) == &def_150);
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &def_150));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &def_7));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &def_300));
+
+    DM_TEST_FINISH;
+}
+
+static const anjay_dm_resource_def_t STATIC_RESOURCES[] = {
+    { 0, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT },
+    { 1, ANJAY_DM_RES_RW, ANJAY_DM_RES_ABSENT },
+    { 4, ANJAY_DM_RES_RW, ANJAY_DM_RES_PRESENT },
+    { 7, ANJAY_DM_RES_E, ANJAY_DM_RES_PRESENT }
+};
+
+static const anjay_dm_object_def_t *const OBJ_WITH_STATIC_RESOURCES =
+        &(const anjay_dm_object_def_t) {
+            .oid = 42,
+            .handlers = { ANJAY_MOCK_DM_HANDLERS },
+            .resources = STATIC_RESOURCES,
+            .resources_count = AVS_ARRAY_SIZE(STATIC_RESOURCES)
+        };
+
+AVS_UNIT_TEST(dm_static_resources, read_resource) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_STATIC_RESOURCES, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    DM_TEST_REQUEST(mocksocks[0], CON, GET, ID(0xFA3E), PATH("42", "69", "4"),
+                    NO_PAYLOAD);
+    _anjay_mock_dm_expect_list_instances(
+            anjay, &OBJ_WITH_STATIC_RESOURCES, 0,
+            (const anjay_iid_t[]) { 14, 42, 69, ANJAY_ID_INVALID });
+    // no list_resources call expected
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ_WITH_STATIC_RESOURCES, 69,
+                                        4, ANJAY_ID_INVALID, 0,
+                                        ANJAY_MOCK_DM_INT(0, 514));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], ACK, CONTENT, ID(0xFA3E),
+                            CONTENT_FORMAT(PLAINTEXT), PAYLOAD("514"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_static_resources, kind_and_presence) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_STATIC_RESOURCES, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(STATIC_RESOURCES); ++i) {
+        anjay_dm_resource_kind_t kind;
+        anjay_dm_resource_presence_t presence;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_dm_resource_kind_and_presence(
+                anjay, &OBJ_WITH_STATIC_RESOURCES, 0, STATIC_RESOURCES[i].rid,
+                &kind, &presence));
+        AVS_UNIT_ASSERT_EQUAL(kind, STATIC_RESOURCES[i].kind);
+        AVS_UNIT_ASSERT_EQUAL(presence, STATIC_RESOURCES[i].presence);
+    }
+    const anjay_rid_t missing[] = { 2, 3, 5, 8, 65534 };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(missing); ++i) {
+        AVS_UNIT_ASSERT_EQUAL(
+                _anjay_dm_resource_kind_and_presence(
+                        anjay, &OBJ_WITH_STATIC_RESOURCES, 0, missing[i], NULL,
+                        NULL),
+                ANJAY_ERR_NOT_FOUND);
+    }
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_static_resources, unsorted_table_rejected) {
+    DM_TEST_INIT;
+    static const anjay_dm_resource_def_t unsorted[] = {
+        { 1, ANJAY_DM_RES_R, ANJAY_DM_RES_PRESENT },
+        { 1, ANJAY_DM_RES_W, ANJAY_DM_RES_PRESENT }
+    };
+    static const anjay_dm_object_def_t def = {
+        .oid = 1337,
+        .handlers = { ANJAY_MOCK_DM_HANDLERS },
+        .resources = unsorted,
+        .resources_count = AVS_ARRAY_SIZE(unsorted)
+    };
+    static const anjay_dm_object_def_t *const def_ptr = &def;
+    AVS_UNIT_ASSERT_FAILED(anjay_register_object(anjay, &def_ptr));
+    DM_TEST_FINISH;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017-2020 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <anjay_config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/dm.h>
+
+static void
+assert_resources_changed(const anjay_notify_queue_object_entry_t *entry,
+                         const anjay_notify_queue_resource_entry_t *expected,
+                         size_t expected_count) {
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_SIZE(entry->resources_changed),
+                          expected_count);
+    size_t i = 0;
+    AVS_RBTREE_ELEM(anjay_notify_queue_resource_entry_t) it;
+    AVS_RBTREE_FOREACH(it, entry->resources_changed) {
+        AVS_UNIT_ASSERT_EQUAL(it->iid, expected[i].iid);
+        AVS_UNIT_ASSERT_EQUAL(it->rid, expected[i].rid);
+        ++i;
+    }
+}
+
+AVS_UNIT_TEST(notify_queue, resource_changes_sorted_and_deduplicated) {
+    anjay_notify_queue_t queue = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_resource_change(&queue, 42, 3, 1));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_resource_change(&queue, 42, 1, 7));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_resource_change(&queue, 7, 0, 0));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_resource_change(&queue, 42, 3, 0));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_resource_change(&queue, 42, 1, 7));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_resource_change(&queue, 42, 3, 1));
+
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(queue), 2);
+    AVS_UNIT_ASSERT_EQUAL(queue->oid, 7);
+    assert_resources_changed(queue,
+                             (const anjay_notify_queue_resource_entry_t[]) {
+                                     { 0, 0 } },
+                             1);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_NEXT(queue)->oid, 42);
+    assert_resources_changed(AVS_LIST_NEXT(queue),
+                             (const anjay_notify_queue_resource_entry_t[]) {
+                                     { 1, 7 }, { 3, 0 }, { 3, 1 } },
+                             3);
+    _anjay_notify_clear_queue(&queue);
+    AVS_UNIT_ASSERT_NULL(queue);
+}
+
+AVS_UNIT_TEST(notify_queue, instance_set_change_without_resources) {
+    anjay_notify_queue_t queue = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_created(&queue, 42, 5));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(queue), 1);
+    AVS_UNIT_ASSERT_TRUE(queue->instance_set_changes.instance_set_changed);
+    AVS_UNIT_ASSERT_NOT_NULL(queue->resources_changed);
+    AVS_UNIT_ASSERT_NULL(AVS_RBTREE_FIRST(queue->resources_changed));
+    _anjay_notify_clear_queue(&queue);
+}
+
+static void discard_scheduled_notify(anjay_t *anjay) {
+    avs_sched_del(&anjay->scheduled_notify.handle);
+    _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
+}
+
+AVS_UNIT_TEST(notify_changed_many, all_queued_and_scheduled) {
+    DM_TEST_INIT;
+    const anjay_notify_resource_t resources[] = {
+        { 42, 3, 1 }, { 42, 1, 7 }, { 7, 0, 0 }, { 42, 3, 1 }
+    };
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed_many(
+            anjay, resources, AVS_ARRAY_SIZE(resources)));
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->scheduled_notify.handle);
+
+    anjay_notify_queue_t queue = anjay->scheduled_notify.queue;
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(queue), 2);
+    AVS_UNIT_ASSERT_EQUAL(queue->oid, 7);
+    assert_resources_changed(queue,
+                             (const anjay_notify_queue_resource_entry_t[]) {
+                                     { 0, 0 } },
+                             1);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_NEXT(queue)->oid, 42);
+    assert_resources_changed(AVS_LIST_NEXT(queue),
+                             (const anjay_notify_queue_resource_entry_t[]) {
+                                     { 1, 7 }, { 3, 1 } },
+                             2);
+
+    discard_scheduled_notify(anjay);
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify_changed_many, empty) {
+    DM_TEST_INIT;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed_many(anjay, NULL, 0));
+    AVS_UNIT_ASSERT_NULL(anjay->scheduled_notify.queue);
+    AVS_UNIT_ASSERT_NULL(anjay->scheduled_notify.handle);
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify_changed_many, partial_failure) {
+    DM_TEST_INIT;
+    const anjay_notify_resource_t resources[] = {
+        { 42, 1, 7 }, { 42, 2, ANJAY_ID_INVALID }, { 43, 0, 0 }
+    };
+    AVS_UNIT_ASSERT_FAILED(anjay_notify_changed_many(
+            anjay, resources, AVS_ARRAY_SIZE(resources)));
+
+    // the change preceding the invalid entry is still reported, the ones
+    // following it are not
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->scheduled_notify.handle);
+    anjay_notify_queue_t queue = anjay->scheduled_notify.queue;
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(queue), 1);
+    AVS_UNIT_ASSERT_EQUAL(queue->oid, 42);
+    assert_resources_changed(queue,
+                             (const anjay_notify_queue_resource_entry_t[]) {
+                                     { 1, 7 } },
+                             1);
+
+    discard_scheduled_notify(anjay);
+    DM_TEST_FINISH;
+}
@@ -376,6 +376,23 @@ int _anjay_copy_tls_ciphersuites(avs_net_socket_tls_ciphersuites_t *dest,
     return 0;
 }
 
+#ifdef WITH_AVS_PERSISTENCE
+avs_error_t _anjay_persistence_time_real(avs_persistence_context_t *ctx,
+                                         avs_time_real_t *value) {
+    int64_t seconds = value->since_real_epoch.seconds;
+    // nanoseconds are negative for invalid timestamps, hence the cast
+    uint32_t nanoseconds = (uint32_t) value->since_real_epoch.nanoseconds;
+    avs_error_t err;
+    (void) (avs_is_err((err = avs_persistence_i64(ctx, &seconds)))
+            || avs_is_err((err = avs_persistence_u32(ctx, &nanoseconds))));
+    if (avs_is_ok(err)) {
+        value->since_real_epoch.seconds = seconds;
+        value->since_real_epoch.nanoseconds = (int32_t) nanoseconds;
+    }
+    return err;
+}
+#endif // WITH_AVS_PERSISTENCE
+
 #ifdef ANJAY_TEST
 #    include "test/utils.c"
 #endif // ANJAY_TEST
@@ -59,17 +59,20 @@ avs_net_socket_t *_anjay_test_dm_install_socket(anjay_t *anjay,
     AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "", ""));
     anjay->servers->servers->registration_info.expire_time.since_real_epoch
             .seconds = INT64_MAX;
-    anjay_server_connection_t *connection =
-            _anjay_get_server_connection((const anjay_connection_ref_t) {
-                .server = anjay->servers->servers,
-                .conn_type = ANJAY_CONNECTION_PRIMARY
-            });
+    const anjay_connection_ref_t ref = {
+        .server = anjay->servers->servers,
+        .conn_type = ANJAY_CONNECTION_PRIMARY
+    };
+    anjay_server_connection_t *connection = _anjay_get_server_connection(ref);
     AVS_UNIT_ASSERT_NOT_NULL(connection);
     connection->conn_socket_ = socket;
     connection->coap_ctx = avs_coap_udp_ctx_create(
-            anjay->sched, &AVS_COAP_DEFAULT_UDP_TX_PARAMS,
-            anjay->in_shared_buffer, anjay->out_shared_buffer,
-            anjay->udp_response_cache);
+            anjay->sched, &anjay->udp_tx_params, anjay->in_shared_buffer,
+            anjay->out_shared_buffer, anjay->udp_response_cache,
+            anjay->udp_notify_cache_size);
+    // same order as in _anjay_server_connection_internal_bring_online();
+    // does nothing unless anjay_observe_restore() has been called
+    _anjay_observe_restore_connection(ref);
     AVS_UNIT_ASSERT_SUCCESS(
             avs_coap_ctx_set_socket(connection->coap_ctx, socket));
 
@@ -27,7 +27,18 @@ from xml.etree.ElementTree import Element
 from typing import Mapping, Tuple, Optional
 from jinja2 import Environment
 
-C_OBJDEF_TEMPLATE = """\
+RESOURCES_TEMPLATE = """\
+{% if static_resources %}
+static const anjay_dm_resource_def_t RESOURCES[] = {
+{% for res in resources %}
+    { {{ res.name_upper }}, {{ res.kind_enum }}, ANJAY_DM_RES_PRESENT }{{ "" if loop.last else "," }}
+{% endfor %}
+};
+
+{% endif %}
+"""
+
+C_OBJDEF_TEMPLATE = RESOURCES_TEMPLATE + """\
 static const anjay_dm_object_def_t OBJ_DEF = {
     .oid = {{ oid }},
     .handlers = {
@@ -38,11 +49,17 @@ static const anjay_dm_object_def_t OBJ_DEF = {
         {{ '.%s = %s' % handler }}{{ "" if loop.last else "," }}
 {% endif %}
 {% endfor %}
+{% if static_resources %}
+    },
+    .resources = RESOURCES,
+    .resources_count = AVS_ARRAY_SIZE(RESOURCES)
+{% else %}
     }
+{% endif %}
 };
 """
 
-CXX_OBJDEF_TEMPLATE = """\
+CXX_OBJDEF_TEMPLATE = RESOURCES_TEMPLATE + """\
 namespace {
 
 struct ObjDef : public anjay_dm_object_def_t {
@@ -56,6 +73,11 @@ struct ObjDef : public anjay_dm_object_def_t {
         {{ 'handlers.%s = %s;' % handler }}
 {% endif %}
 {% endfor %}
+{% if static_resources %}
+
+        resources = RESOURCES;
+        resources_count = AVS_ARRAY_SIZE(RESOURCES);
+{% endif %}
     }
 } const OBJ_DEF;
 
@@ -231,6 +253,7 @@ static int instance_reset(anjay_t *anjay,
 }
 
 {% endif %}
+{% if not static_resources %}
 static int list_resources(anjay_t *anjay,
                           const anjay_dm_object_def_t *const *obj_ptr,
                           anjay_iid_t iid,
@@ -246,6 +269,7 @@ static int list_resources(anjay_t *anjay,
     return 0;
 }
 
+{% endif %}
 {% if obj.has_any_readable_resources %}
 static int resource_read(anjay_t *anjay,
                          const anjay_dm_object_def_t *const *obj_ptr,
@@ -611,9 +635,12 @@ class ObjectDef(collections.namedtuple('ObjectDef',
                                     key=operator.attrgetter('rid')))
 
 
-def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
+def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool, list_resources: bool = False):
     tree = ElementTree.fromstring(obj_ddf_xml)
     obj = ObjectDef.from_etree(tree.find('Object'))
+    # C does not allow empty arrays, so Objects without any Resources always
+    # get a list_resources handler
+    static_resources = not list_resources and len(obj.resources) > 0
 
     jinja_env = Environment(trim_blocks=True)
 
@@ -629,7 +656,8 @@ def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
         handlers.append(('instance_reset', 'instance_reset'))
 
     handlers.append('')
-    handlers.append(('list_resources', 'list_resources'))
+    if not static_resources:
+        handlers.append(('list_resources', 'list_resources'))
     if obj.has_any_readable_resources:
         handlers.append(('resource_read', 'resource_read'))
     if obj.has_any_writable_resources:
@@ -650,7 +678,8 @@ def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
 
     cdef = (jinja_env
                 .from_string(CXX_OBJDEF_TEMPLATE if cxx else C_OBJDEF_TEMPLATE)
-                .render(oid=obj.oid, resources=obj.resources, handlers=handlers))
+                .render(oid=obj.oid, resources=obj.resources, handlers=handlers,
+                        static_resources=static_resources))
 
     return (jinja_env.from_string(TEMPLATE)
                 .render(obj=obj,
@@ -660,6 +689,7 @@ def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
                         obj_repr_type=obj.name_snake + '_t',
                         obj_inst_tag=obj.name_snake + '_instance_struct',
                         obj_inst_type=obj.name_snake + '_instance_t',
+                        static_resources=static_resources,
                         cdef=cdef))
 
 
@@ -668,6 +698,9 @@ if __name__ == '__main__':
     parser.add_argument('-i', '--input', help='Input filename or - to read from stdin')
     parser.add_argument('-o', '--output', default='/dev/stdout', help='Output filename (default: stdout)')
     parser.add_argument('-x', '--c++', dest='cxx', action='store_true', help='Generate C++ code (default: C)')
+    parser.add_argument('-l', '--list-resources', action='store_true',
+                        help='Generate a list_resources handler instead of a static Resource table, e.g. if presence '
+                             'of Resources varies between Instances')
 
     args = parser.parse_args()
     if args.input == '-':
@@ -680,7 +713,7 @@ if __name__ == '__main__':
         sys.exit(1)
 
     with open(args.input) as f:
-        boilerplate = generate_object_boilerplate(f.read(), args.cxx)
+        boilerplate = generate_object_boilerplate(f.read(), args.cxx, args.list_resources)
 
     with open(args.output, 'w') as f:
         print(boilerplate, file=f)